@@ -0,0 +1,123 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_ALIAS_TABLE_HPP
+#define ECOEVOLITY_ALIAS_TABLE_HPP
+
+#include <vector>
+#include <sstream>
+
+#include "rng.hpp"
+#include "error.hpp"
+#include "assert.hpp"
+
+
+/**
+ * Walker's alias table for drawing from a discrete distribution in constant
+ * time.
+ *
+ * Building the table is linear in the number of categories, so it pays off
+ * when many draws are taken from the same distribution (e.g., all the sites
+ * of a simulated dataset that share a sample configuration). The weights do
+ * not need to be normalized.
+ */
+class AliasTable {
+    private:
+        std::vector<double> probabilities_;
+        std::vector<unsigned int> aliases_;
+
+    public:
+        AliasTable() { }
+        AliasTable(const std::vector<double> & weights) {
+            this->build(weights);
+        }
+
+        void build(const std::vector<double> & weights) {
+            const unsigned int n = weights.size();
+            if (n < 1) {
+                throw EcoevolityError(
+                        "AliasTable::build(): No weights were provided");
+            }
+            double sum = 0.0;
+            for (auto w : weights) {
+                if (w < 0.0) {
+                    std::ostringstream message;
+                    message << "AliasTable::build(): Negative weight: " << w;
+                    throw EcoevolityError(message.str());
+                }
+                sum += w;
+            }
+            if (! (sum > 0.0)) {
+                throw EcoevolityError(
+                        "AliasTable::build(): Weights sum to zero");
+            }
+            this->probabilities_.resize(n);
+            this->aliases_.resize(n);
+            std::vector<unsigned int> small;
+            std::vector<unsigned int> large;
+            for (unsigned int i = 0; i < n; ++i) {
+                this->probabilities_[i] = (weights[i] * n) / sum;
+                this->aliases_[i] = i;
+                if (this->probabilities_[i] < 1.0) {
+                    small.push_back(i);
+                }
+                else {
+                    large.push_back(i);
+                }
+            }
+            while ((! small.empty()) && (! large.empty())) {
+                unsigned int s = small.back();
+                small.pop_back();
+                unsigned int l = large.back();
+                this->aliases_[s] = l;
+                this->probabilities_[l] -= (1.0 - this->probabilities_[s]);
+                if (this->probabilities_[l] < 1.0) {
+                    large.pop_back();
+                    small.push_back(l);
+                }
+            }
+            // Whatever is left over is only off from 1 by rounding error
+            for (auto i : small) {
+                this->probabilities_[i] = 1.0;
+            }
+            for (auto i : large) {
+                this->probabilities_[i] = 1.0;
+            }
+        }
+
+        unsigned int size() const {
+            return this->probabilities_.size();
+        }
+
+        unsigned int draw(RandomNumberGenerator & rng) const {
+            ECOEVOLITY_ASSERT(this->probabilities_.size() > 0);
+            const unsigned int n = this->probabilities_.size();
+            double x = rng.uniform_real() * n;
+            unsigned int i = (unsigned int)x;
+            if (i >= n) {
+                i = n - 1;
+            }
+            if ((x - i) < this->probabilities_[i]) {
+                return i;
+            }
+            return this->aliases_[i];
+        }
+};
+
+#endif
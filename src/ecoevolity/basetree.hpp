@@ -23,6 +23,7 @@
 #include <ncl/nxsmultiformat.h>
 
 #include "split.hpp"
+#include "nexus_stream.hpp"
 #include "parameter.hpp"
 #include "probability.hpp"
 #include "error.hpp"
@@ -352,6 +353,61 @@ class BaseTree {
             this->set_root(root);
         }
 
+        void build_from_newick_tree_(
+                const NewickTree & newick_tree,
+                double ultrametricity_tolerance = 1e-6) {
+            if (! newick_tree.is_ultrametric(ultrametricity_tolerance)) {
+                throw EcoevolityError("Input tree not ultrametric");
+            }
+            std::vector<std::string> leaf_labels;
+            for (unsigned int i = 0; i < newick_tree.get_number_of_nodes(); ++i) {
+                if (newick_tree.get_node(i).children.empty()) {
+                    leaf_labels.push_back(newick_tree.get_node(i).label);
+                }
+            }
+            // Sort labels to ensure we always give the same label the same
+            // leaf node index
+            std::sort(leaf_labels.begin(), leaf_labels.end());
+            std::unordered_map<std::string, int> leaf_label_to_index_map;
+            leaf_label_to_index_map.reserve(leaf_labels.size());
+            for (unsigned int i = 0; i < leaf_labels.size(); ++i) {
+                if (leaf_label_to_index_map.count(leaf_labels.at(i)) > 0) {
+                    throw EcoevolityError("Leaf label \'" + leaf_labels.at(i) +
+                            "\' appears more than once in tree");
+                }
+                leaf_label_to_index_map[leaf_labels.at(i)] = i;
+            }
+            const NewickTree::Node & newick_root = newick_tree.get_root();
+            if (newick_root.children.empty()) {
+                throw EcoevolityError("Input tree has no internal nodes");
+            }
+            std::map<std::string, std::string> root_info;
+            this->parse_node_comments_(newick_root, root_info);
+            // As when parsing with NCL, use the heights and height indices in
+            // the comments if the root has them
+            bool using_height_comments = (root_info.count("height_index") > 0);
+            std::map<unsigned int, std::shared_ptr<PositiveRealParameter> > indices_to_heights;
+            int next_internal_index = leaf_labels.size();
+
+            std::shared_ptr<NodeType> root = this->create_internal_node_(
+                    newick_tree,
+                    0,
+                    indices_to_heights,
+                    using_height_comments,
+                    next_internal_index);
+            ++next_internal_index;
+
+            this->add_child_nodes_(newick_tree,
+                    0,
+                    root,
+                    next_internal_index,
+                    indices_to_heights,
+                    leaf_label_to_index_map,
+                    using_height_comments);
+
+            this->set_root(root);
+        }
+
         bool parsed_tree_is_ultrametric_(const NxsSimpleTree & simple_tree,
                 double proportional_tolerance = 1e-6) {
             std::vector< std::vector<double> > pairwise_dists = simple_tree.GetDblPathDistances(false);
@@ -424,20 +480,70 @@ class BaseTree {
             }
         }
 
+        void add_child_nodes_(const NewickTree & newick_tree,
+                const unsigned int parent_newick_index,
+                std::shared_ptr<NodeType> parent_node,
+                int & next_internal_index,
+                std::map<unsigned int, std::shared_ptr<PositiveRealParameter> > & indices_to_heights,
+                std::unordered_map<std::string, int> & leaf_label_to_index_map,
+                const bool using_height_comments) {
+            for (auto child_idx : newick_tree.get_node(parent_newick_index).children) {
+                const NewickTree::Node & child = newick_tree.get_node(child_idx);
+                if (child.children.empty()) {
+                    std::map<std::string, std::string> comment_map;
+                    this->parse_node_comments_(child, comment_map);
+                    parent_node->add_child(this->create_leaf_node_(
+                            child.label,
+                            comment_map,
+                            leaf_label_to_index_map));
+                }
+                else {
+                    std::shared_ptr<NodeType> node = this->create_internal_node_(
+                            newick_tree,
+                            child_idx,
+                            indices_to_heights,
+                            using_height_comments,
+                            next_internal_index);
+                    ++next_internal_index;
+                    parent_node->add_child(node);
+                    this->add_child_nodes_(newick_tree, child_idx,
+                            node,
+                            next_internal_index,
+                            indices_to_heights,
+                            leaf_label_to_index_map,
+                            using_height_comments);
+                }
+            }
+        }
+
         void parse_node_comments_(
                 const NxsSimpleNode * ncl_node,
                 std::map<std::string, std::string> & comment_map) {
             NxsSimpleEdge ncl_edge = ncl_node->GetEdgeToParent();
             for (auto nxs_comment : ncl_edge.GetUnprocessedComments()) {
-                std::string raw_comment = string_util::strip(nxs_comment.GetText());
-                if (string_util::startswith(raw_comment, "&")) {
-                    std::string comment = raw_comment.substr(1);
-                    string_util::parse_map(
-                            comment,
-                            comment_map,
-                            ',',
-                            '=');
-                }
+                this->parse_node_comment_(nxs_comment.GetText(), comment_map);
+            }
+        }
+
+        void parse_node_comments_(
+                const NewickTree::Node & newick_node,
+                std::map<std::string, std::string> & comment_map) {
+            for (auto & text : newick_node.comments) {
+                this->parse_node_comment_(text, comment_map);
+            }
+        }
+
+        void parse_node_comment_(
+                const std::string & text,
+                std::map<std::string, std::string> & comment_map) {
+            std::string raw_comment = string_util::strip(text);
+            if (string_util::startswith(raw_comment, "&")) {
+                std::string comment = raw_comment.substr(1);
+                string_util::parse_map(
+                        comment,
+                        comment_map,
+                        ',',
+                        '=');
             }
         }
 
@@ -450,6 +556,14 @@ class BaseTree {
             this->parse_node_comments_(ncl_node, comment_map);
             NxsString leaf_label = taxa_block->GetTaxonLabel(ncl_node->GetTaxonIndex());
             // std::cout << leaf_label << "\n";
+            return this->create_leaf_node_(leaf_label, comment_map,
+                    leaf_label_to_index_map);
+        }
+
+        std::shared_ptr<NodeType> create_leaf_node_(
+                const std::string & leaf_label,
+                std::map<std::string, std::string> & comment_map,
+                std::unordered_map<std::string, int> & leaf_label_to_index_map) {
             std::shared_ptr<NodeType> leaf = std::make_shared<NodeType>(
                     leaf_label_to_index_map[leaf_label],
                     leaf_label,
@@ -467,7 +581,51 @@ class BaseTree {
             ECOEVOLITY_ASSERT(ncl_node->GetFirstChild());
             std::map<std::string, std::string> comment_map;
             this->parse_node_comments_(ncl_node, comment_map);
-            double height;
+            double height = 0.0;
+            if (! using_height_comments) {
+                // Need to get height from edge lengths
+                height = this->get_simple_node_height_(ncl_node);
+            }
+            return this->create_internal_node_(comment_map,
+                    height,
+                    indices_to_heights,
+                    using_height_comments,
+                    internal_index);
+        }
+
+        std::shared_ptr<NodeType> create_internal_node_(
+                const NewickTree & newick_tree,
+                const unsigned int newick_index,
+                std::map<unsigned int, std::shared_ptr<PositiveRealParameter> > & indices_to_heights,
+                const bool using_height_comments,
+                const unsigned int internal_index) {
+            std::map<std::string, std::string> comment_map;
+            this->parse_node_comments_(newick_tree.get_node(newick_index),
+                    comment_map);
+            double height = 0.0;
+            if (! using_height_comments) {
+                // Need to get height from edge lengths (along the first
+                // descendants to a leaf)
+                unsigned int i = newick_index;
+                while (! newick_tree.get_node(i).children.empty()) {
+                    i = newick_tree.get_node(i).children.front();
+                    height += newick_tree.get_node(i).edge_length;
+                }
+            }
+            return this->create_internal_node_(comment_map,
+                    height,
+                    indices_to_heights,
+                    using_height_comments,
+                    internal_index);
+        }
+
+        // If not using height comments, 'height' is the height of the node
+        std::shared_ptr<NodeType> create_internal_node_(
+                std::map<std::string, std::string> & comment_map,
+                double height,
+                std::map<unsigned int, std::shared_ptr<PositiveRealParameter> > & indices_to_heights,
+                const bool using_height_comments,
+                const unsigned int internal_index) {
             unsigned int height_index;
             if (using_height_comments) {
                 std::stringstream h_converter(comment_map["height"]);
@@ -481,10 +639,6 @@ class BaseTree {
                             i_converter.str() + "\'");
                 }
             }
-            else {
-                // Need to get height from edge lengths
-                height = this->get_simple_node_height_(ncl_node);
-            }
             std::shared_ptr<NodeType> node = std::make_shared<NodeType>(
                     internal_index,
                     height);
@@ -560,6 +714,15 @@ class BaseTree {
                 this->scale_tree(multiplier);
             }
         }
+        BaseTree(const NewickTree & newick_tree,
+                const double ultrametricity_tolerance,
+                const double multiplier = -1.0) {
+            this->build_from_newick_tree_(newick_tree,
+                    ultrametricity_tolerance);
+            if (multiplier > 0.0) {
+                this->scale_tree(multiplier);
+            }
+        }
 
         typedef std::shared_ptr<NodeType> NodePtr;
 
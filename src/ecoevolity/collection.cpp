@@ -764,12 +764,31 @@ void BaseComparisonPopulationTreeCollection::mcmc(
 
     std::cout << "State log path: " << this->get_state_log_path() << std::endl;
     std::cout << "Operator log path: " << this->get_operator_log_path() << std::endl;
+
+    this->mcmc(rng,
+            chain_length,
+            sample_frequency,
+            state_log_stream,
+            operator_log_stream,
+            std::cout);
+
+    state_log_stream.close();
+    operator_log_stream.close();
+}
+
+void BaseComparisonPopulationTreeCollection::mcmc(
+        RandomNumberGenerator& rng,
+        unsigned int chain_length,
+        unsigned int sample_frequency,
+        std::ostream& state_log_stream,
+        std::ostream& operator_log_stream,
+        std::ostream& screen_stream) {
     
     state_log_stream.precision(this->get_logging_precision());
     operator_log_stream.precision(this->get_logging_precision());
 
     this->write_state_log_header(state_log_stream);
-    this->write_state_log_header(std::cout, true);
+    this->write_state_log_header(screen_stream, true);
 
     this->make_trees_dirty();
     this->compute_log_likelihood_and_prior(true);
@@ -792,7 +811,7 @@ void BaseComparisonPopulationTreeCollection::mcmc(
         throw EcoevolityError(message.str());
     }
     this->log_state(state_log_stream, 0);
-    this->log_state(std::cout, 0, true);
+    this->log_state(screen_stream, 0, true);
 
     unsigned int gen;
     unsigned int gen_of_last_state_log = 0;
@@ -806,7 +825,7 @@ void BaseComparisonPopulationTreeCollection::mcmc(
             gen_of_last_state_log = gen;
             // Log every 10th sample to std out
             if ((gen + 1) % (sample_frequency * 10) == 0) {
-                this->log_state(std::cout, gen + 1, true);
+                this->log_state(screen_stream, gen + 1, true);
                 // Log operator performance every 100 samples
                 if ((gen + 1) % (sample_frequency * 100) == 0) {
                     operator_log_stream << "generation " << gen + 1 << ":\n";
@@ -830,8 +849,6 @@ void BaseComparisonPopulationTreeCollection::mcmc(
                             << " is " << chain_ln_likelihood
                             << "; expected " << expected_ln_likelihood
                             << "; last operator " << op.get_name();
-                    state_log_stream.close();
-                    operator_log_stream.close();
                     throw EcoevolityError(message.str());
                 }
             }
@@ -840,17 +857,15 @@ void BaseComparisonPopulationTreeCollection::mcmc(
     // Make sure last generation is reported
     if (gen > (gen_of_last_state_log + 1)) {
         this->log_state(state_log_stream, gen + 1);
-        this->log_state(std::cout, gen + 1, true);
+        this->log_state(screen_stream, gen + 1, true);
     }
     if (gen > (gen_of_last_operator_log + 1)) {
         operator_log_stream << "generation " << gen + 1 << ":\n";
         this->operator_schedule_.write_operator_rates(operator_log_stream);
     }
-    std::cout << "\nOperator stats:\n";
-    this->operator_schedule_.write_operator_rates(std::cout);
-    std::cout << "\n";
-    state_log_stream.close();
-    operator_log_stream.close();
+    screen_stream << "\nOperator stats:\n";
+    this->operator_schedule_.write_operator_rates(screen_stream);
+    screen_stream << "\n";
 }
 
 void BaseComparisonPopulationTreeCollection::write_summary(
@@ -1009,6 +1024,23 @@ void BaseComparisonPopulationTreeCollection::draw_from_prior(RandomNumberGenerat
     }
 }
 
+void BaseComparisonPopulationTreeCollection::log_prior_samples(
+        RandomNumberGenerator& rng,
+        unsigned int number_of_samples,
+        std::ostream& out,
+        unsigned int first_generation) {
+    std::ostringstream row;
+    row.precision(out.precision());
+    for (unsigned int i = 0; i < number_of_samples; ++i) {
+        this->draw_from_prior(rng);
+        // log_state ends each row with std::endl, so log to a string stream
+        // to avoid flushing out after every row
+        row.str("");
+        this->log_state(row, first_generation + i);
+        out << row.str();
+    }
+}
+
 std::map<std::string, BiallelicData> BaseComparisonPopulationTreeCollection::simulate_biallelic_data_sets(
         RandomNumberGenerator& rng,
         float singleton_sample_probability,
@@ -1069,7 +1101,8 @@ ComparisonPopulationTreeCollection::ComparisonPopulationTreeCollection(
         bool strict_on_constant_sites,
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info
+        bool store_seq_loci_info,
+        unsigned int nthreads
         ) : BaseComparisonPopulationTreeCollection() {
     this->state_log_path_ = settings.get_state_log_path();
     this->operator_log_path_ = settings.get_operator_log_path();
@@ -1090,7 +1123,8 @@ ComparisonPopulationTreeCollection::ComparisonPopulationTreeCollection(
             strict_on_constant_sites,
             strict_on_missing_sites,
             strict_on_triallelic_sites,
-            store_seq_loci_info);
+            store_seq_loci_info,
+            nthreads);
     this->stored_node_heights_.reserve(this->trees_.size());
     this->stored_node_height_indices_.reserve(this->trees_.size());
     if (settings.event_model_is_fixed()) {
@@ -1105,23 +1139,34 @@ void ComparisonPopulationTreeCollection::init_trees(
         bool strict_on_constant_sites,
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info
+        bool store_seq_loci_info,
+        unsigned int nthreads
         ) {
+    std::vector< std::shared_ptr<ComparisonPopulationTree> > loaded_trees;
+    std::vector<std::exception_ptr> load_errors;
+    load_comparison_data(comparison_settings,
+            loaded_trees,
+            load_errors,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            store_seq_loci_info,
+            nthreads);
     std::unordered_set<std::string> population_labels;
     double fresh_height;
     for (unsigned int tree_idx = 0;
             tree_idx < comparison_settings.size();
             ++tree_idx) {
+        loaded_trees.at(tree_idx)->flush_warnings();
+        if (load_errors.at(tree_idx)) {
+            std::rethrow_exception(load_errors.at(tree_idx));
+        }
         fresh_height = this->node_height_prior_->draw(rng);
         std::shared_ptr<PositiveRealParameter> new_height_parameter = std::make_shared<PositiveRealParameter>(this->node_height_prior_, fresh_height);
-        std::shared_ptr<PopulationTree> new_tree = std::make_shared<ComparisonPopulationTree>(
+        loaded_trees.at(tree_idx)->init_comparison_parameters(
                 comparison_settings.at(tree_idx),
-                rng,
-                strict_on_constant_sites,
-                strict_on_missing_sites,
-                strict_on_triallelic_sites,
-                store_seq_loci_info
-                );
+                rng);
+        std::shared_ptr<PopulationTree> new_tree = loaded_trees.at(tree_idx);
         for (auto const& pop_label: new_tree->get_population_labels()) {
             auto p = population_labels.insert(pop_label);
             if (! p.second) {
@@ -1158,7 +1203,8 @@ ComparisonRelativeRootPopulationTreeCollection::ComparisonRelativeRootPopulation
         bool strict_on_constant_sites,
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info
+        bool store_seq_loci_info,
+        unsigned int nthreads
         ) : BaseComparisonPopulationTreeCollection() {
     this->state_log_path_ = settings.get_state_log_path();
     this->operator_log_path_ = settings.get_operator_log_path();
@@ -1179,7 +1225,8 @@ ComparisonRelativeRootPopulationTreeCollection::ComparisonRelativeRootPopulation
             strict_on_constant_sites,
             strict_on_missing_sites,
             strict_on_triallelic_sites,
-            store_seq_loci_info);
+            store_seq_loci_info,
+            nthreads);
     this->stored_node_heights_.reserve(this->trees_.size());
     this->stored_node_height_indices_.reserve(this->trees_.size());
     if (settings.event_model_is_fixed()) {
@@ -1194,23 +1241,34 @@ void ComparisonRelativeRootPopulationTreeCollection::init_trees(
         bool strict_on_constant_sites,
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info
+        bool store_seq_loci_info,
+        unsigned int nthreads
         ) {
+    std::vector< std::shared_ptr<ComparisonRelativeRootPopulationTree> > loaded_trees;
+    std::vector<std::exception_ptr> load_errors;
+    load_comparison_data(comparison_settings,
+            loaded_trees,
+            load_errors,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            store_seq_loci_info,
+            nthreads);
     std::unordered_set<std::string> population_labels;
     double fresh_height;
     for (unsigned int tree_idx = 0;
             tree_idx < comparison_settings.size();
             ++tree_idx) {
+        loaded_trees.at(tree_idx)->flush_warnings();
+        if (load_errors.at(tree_idx)) {
+            std::rethrow_exception(load_errors.at(tree_idx));
+        }
         fresh_height = this->node_height_prior_->draw(rng);
         std::shared_ptr<PositiveRealParameter> new_height_parameter = std::make_shared<PositiveRealParameter>(this->node_height_prior_, fresh_height);
-        std::shared_ptr<PopulationTree> new_tree = std::make_shared<ComparisonRelativeRootPopulationTree>(
+        loaded_trees.at(tree_idx)->init_comparison_parameters(
                 comparison_settings.at(tree_idx),
-                rng,
-                strict_on_constant_sites,
-                strict_on_missing_sites,
-                strict_on_triallelic_sites,
-                store_seq_loci_info
-                );
+                rng);
+        std::shared_ptr<PopulationTree> new_tree = loaded_trees.at(tree_idx);
         for (auto const& pop_label: new_tree->get_population_labels()) {
             auto p = population_labels.insert(pop_label);
             if (! p.second) {
@@ -1247,7 +1305,8 @@ ComparisonDirichletPopulationTreeCollection::ComparisonDirichletPopulationTreeCo
         bool strict_on_constant_sites,
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info
+        bool store_seq_loci_info,
+        unsigned int nthreads
         ) : BaseComparisonPopulationTreeCollection() {
     this->state_log_path_ = settings.get_state_log_path();
     this->operator_log_path_ = settings.get_operator_log_path();
@@ -1268,7 +1327,8 @@ ComparisonDirichletPopulationTreeCollection::ComparisonDirichletPopulationTreeCo
             strict_on_constant_sites,
             strict_on_missing_sites,
             strict_on_triallelic_sites,
-            store_seq_loci_info);
+            store_seq_loci_info,
+            nthreads);
     this->stored_node_heights_.reserve(this->trees_.size());
     this->stored_node_height_indices_.reserve(this->trees_.size());
     if (settings.event_model_is_fixed()) {
@@ -1283,23 +1343,34 @@ void ComparisonDirichletPopulationTreeCollection::init_trees(
         bool strict_on_constant_sites,
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info
+        bool store_seq_loci_info,
+        unsigned int nthreads
         ) {
+    std::vector< std::shared_ptr<ComparisonDirichletPopulationTree> > loaded_trees;
+    std::vector<std::exception_ptr> load_errors;
+    load_comparison_data(comparison_settings,
+            loaded_trees,
+            load_errors,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            store_seq_loci_info,
+            nthreads);
     std::unordered_set<std::string> population_labels;
     double fresh_height;
     for (unsigned int tree_idx = 0;
             tree_idx < comparison_settings.size();
             ++tree_idx) {
+        loaded_trees.at(tree_idx)->flush_warnings();
+        if (load_errors.at(tree_idx)) {
+            std::rethrow_exception(load_errors.at(tree_idx));
+        }
         fresh_height = this->node_height_prior_->draw(rng);
         std::shared_ptr<PositiveRealParameter> new_height_parameter = std::make_shared<PositiveRealParameter>(this->node_height_prior_, fresh_height);
-        std::shared_ptr<PopulationTree> new_tree = std::make_shared<ComparisonDirichletPopulationTree>(
+        loaded_trees.at(tree_idx)->init_comparison_parameters(
                 comparison_settings.at(tree_idx),
-                rng,
-                strict_on_constant_sites,
-                strict_on_missing_sites,
-                strict_on_triallelic_sites,
-                store_seq_loci_info
-                );
+                rng);
+        std::shared_ptr<PopulationTree> new_tree = loaded_trees.at(tree_idx);
         for (auto const& pop_label: new_tree->get_population_labels()) {
             auto p = population_labels.insert(pop_label);
             if (! p.second) {
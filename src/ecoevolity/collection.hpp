@@ -21,6 +21,12 @@
 #define ECOEVOLITY_COLLECTION_HPP
 
 #include <unordered_set>
+#include <exception>
+
+#ifdef BUILD_WITH_THREADS
+#include <atomic>
+#include <future>
+#endif
 
 #include "data.hpp"
 #include "node.hpp"
@@ -61,6 +67,86 @@ class BaseComparisonPopulationTreeCollection {
 
         void remove_height(unsigned int height_index);
 
+        /**
+         * Parse and vet the data of every comparison.
+         *
+         * When more than one thread is available, comparisons are loaded
+         * concurrently, with each worker taking the next unloaded comparison.
+         * Warnings are buffered in each tree, and any exception is stored at
+         * the index of its comparison, so the caller can report both in the
+         * order of the comparisons, as if they had been loaded serially.
+         */
+        template<class TreeType, class SettingsType>
+        static void load_comparison_data(
+                const std::vector<SettingsType> & comparison_settings,
+                std::vector< std::shared_ptr<TreeType> > & trees,
+                std::vector<std::exception_ptr> & errors,
+                bool strict_on_constant_sites,
+                bool strict_on_missing_sites,
+                bool strict_on_triallelic_sites,
+                bool store_seq_loci_info,
+                unsigned int nthreads) {
+            const unsigned int number_of_comparisons = comparison_settings.size();
+            trees.clear();
+            trees.reserve(number_of_comparisons);
+            for (unsigned int i = 0; i < number_of_comparisons; ++i) {
+                trees.push_back(std::make_shared<TreeType>());
+                trees.back()->buffer_warnings();
+            }
+            errors.assign(number_of_comparisons, nullptr);
+            unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+            number_of_workers = std::max(1u,
+                    std::min(nthreads, number_of_comparisons));
+#endif
+            // Threads left over are used to parse the larger alignments
+            const unsigned int nthreads_per_comparison = std::max(1u,
+                    nthreads / number_of_workers);
+            auto load = [&](unsigned int i) {
+                try {
+                    trees.at(i)->init_comparison_data(
+                            comparison_settings.at(i),
+                            strict_on_constant_sites,
+                            strict_on_missing_sites,
+                            strict_on_triallelic_sites,
+                            store_seq_loci_info,
+                            nthreads_per_comparison);
+                }
+                catch (...) {
+                    errors.at(i) = std::current_exception();
+                }
+            };
+            if (number_of_workers < 2) {
+                for (unsigned int i = 0; i < number_of_comparisons; ++i) {
+                    load(i);
+                    if (errors.at(i)) {
+                        // Nothing after a failed comparison gets reported
+                        return;
+                    }
+                }
+                return;
+            }
+#ifdef BUILD_WITH_THREADS
+            std::atomic<unsigned int> next_index(0);
+            auto work = [&]() {
+                unsigned int i;
+                while ((i = next_index++) < number_of_comparisons) {
+                    load(i);
+                }
+            };
+            std::vector< std::future<void> > workers;
+            workers.reserve(number_of_workers - 1);
+            for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+                workers.push_back(std::async(std::launch::async, work));
+            }
+            // Use the main thread as the last worker
+            work();
+            for (auto & w : workers) {
+                w.get();
+            }
+#endif
+        }
+
     public:
         BaseComparisonPopulationTreeCollection() { }
 
@@ -302,12 +388,38 @@ class BaseComparisonPopulationTreeCollection {
                 unsigned int chain_length,
                 unsigned int sample_frequency);
 
+        /**
+         * Run the chain, logging sampled states to `state_log_stream` and
+         * operator performance to `operator_log_stream`, rather than to the
+         * log files. A short summary of every 10th sample is written to
+         * `screen_stream`. This allows a chain to be run (and its samples
+         * summarized) in memory.
+         */
+        void mcmc(RandomNumberGenerator& rng,
+                unsigned int chain_length,
+                unsigned int sample_frequency,
+                std::ostream& state_log_stream,
+                std::ostream& operator_log_stream,
+                std::ostream& screen_stream);
+
         void write_summary(
                 std::ostream& out,
                 unsigned int indent_level = 0) const;
 
         void draw_heights_from_prior(RandomNumberGenerator& rng);
         void draw_from_prior(RandomNumberGenerator& rng);
+        /**
+         * Draw `number_of_samples` states from the prior, logging each one to
+         * `out` as a row of the state log, numbered from `first_generation`.
+         *
+         * Rows are written without flushing `out`, so drawing into a string
+         * stream lets blocks of prior samples be drawn independently (e.g.,
+         * by different threads) and written in order afterwards.
+         */
+        void log_prior_samples(RandomNumberGenerator& rng,
+                unsigned int number_of_samples,
+                std::ostream& out,
+                unsigned int first_generation = 1);
 
         std::map<std::string, BiallelicData> simulate_biallelic_data_sets(
                 RandomNumberGenerator& rng,
@@ -386,7 +498,8 @@ class ComparisonPopulationTreeCollection: public BaseComparisonPopulationTreeCol
                 bool strict_on_constant_sites = true,
                 bool strict_on_missing_sites = true,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
     protected:
@@ -396,7 +509,8 @@ class ComparisonPopulationTreeCollection: public BaseComparisonPopulationTreeCol
                 bool strict_on_constant_sites = true,
                 bool strict_on_missing_sites = true,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 };
 
@@ -410,7 +524,8 @@ class ComparisonRelativeRootPopulationTreeCollection: public BaseComparisonPopul
                 bool strict_on_constant_sites = true,
                 bool strict_on_missing_sites = true,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
     protected:
@@ -420,7 +535,8 @@ class ComparisonRelativeRootPopulationTreeCollection: public BaseComparisonPopul
                 bool strict_on_constant_sites = true,
                 bool strict_on_missing_sites = true,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 };
 
@@ -434,7 +550,8 @@ class ComparisonDirichletPopulationTreeCollection: public BaseComparisonPopulati
                 bool strict_on_constant_sites = true,
                 bool strict_on_missing_sites = true,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
     protected:
@@ -444,7 +561,8 @@ class ComparisonDirichletPopulationTreeCollection: public BaseComparisonPopulati
                 bool strict_on_constant_sites = true,
                 bool strict_on_missing_sites = true,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 };
 
@@ -20,6 +20,319 @@
 #include "data.hpp"
 
 
+BiallelicPatternTally::BiallelicPatternTally(
+        unsigned int number_of_populations,
+        bool storing_site_pattern_indices) {
+    this->number_of_populations_ = number_of_populations;
+    this->storing_site_pattern_indices_ = storing_site_pattern_indices;
+    this->key_.assign(2 * number_of_populations, 0);
+}
+
+void BiallelicPatternTally::add_site() {
+    ECOEVOLITY_ASSERT(this->key_.size() == (2 * this->number_of_populations_));
+    unsigned int pattern_idx;
+    auto found = this->pattern_index_map_.find(this->key_);
+    if (found != this->pattern_index_map_.end()) {
+        pattern_idx = found->second;
+        ++this->pattern_weights[pattern_idx];
+    }
+    else {
+        pattern_idx = this->pattern_weights.size();
+        this->pattern_index_map_[this->key_] = pattern_idx;
+        this->red_allele_counts.push_back(std::vector<unsigned int>(
+                this->key_.begin(),
+                this->key_.begin() + this->number_of_populations_));
+        this->allele_counts.push_back(std::vector<unsigned int>(
+                this->key_.begin() + this->number_of_populations_,
+                this->key_.end()));
+        this->pattern_weights.push_back(1);
+    }
+    if (this->storing_site_pattern_indices_) {
+        this->site_pattern_indices.push_back(pattern_idx);
+    }
+}
+
+BiallelicDataYamlHandler::BiallelicDataYamlHandler(const std::string & path) {
+    this->path_ = path;
+}
+
+void BiallelicDataYamlHandler::OnNull(
+        const YAML::Mark & mark,
+        YAML::anchor_t anchor) {
+    this->start_node(YAML::NodeType::Null);
+}
+
+void BiallelicDataYamlHandler::OnAlias(
+        const YAML::Mark & mark,
+        YAML::anchor_t anchor) {
+    throw EcoevolityYamlDataError(
+            "YAML aliases are not supported in data files",
+            this->path_);
+}
+
+void BiallelicDataYamlHandler::OnScalar(
+        const YAML::Mark & mark,
+        const std::string & tag,
+        YAML::anchor_t anchor,
+        const std::string & value) {
+    this->scalar_mark_ = mark;
+    this->start_node(YAML::NodeType::Scalar, value);
+}
+
+void BiallelicDataYamlHandler::OnSequenceStart(
+        const YAML::Mark & mark,
+        const std::string & tag,
+        YAML::anchor_t anchor,
+        YAML::EmitterStyle::value style) {
+    this->context_stack_.push_back(
+            this->start_node(YAML::NodeType::Sequence));
+}
+
+void BiallelicDataYamlHandler::OnSequenceEnd() {
+    this->end_collection();
+}
+
+void BiallelicDataYamlHandler::OnMapStart(
+        const YAML::Mark & mark,
+        const std::string & tag,
+        YAML::anchor_t anchor,
+        YAML::EmitterStyle::value style) {
+    this->context_stack_.push_back(
+            this->start_node(YAML::NodeType::Map));
+}
+
+void BiallelicDataYamlHandler::OnMapEnd() {
+    this->end_collection();
+}
+
+BiallelicDataYamlHandler::Context BiallelicDataYamlHandler::start_node(
+        YAML::NodeType::value type,
+        const std::string & value) {
+    if (this->context_stack_.empty()) {
+        if (type != YAML::NodeType::Map) {
+            throw EcoevolityYamlDataError(
+                    "Expecting top-level of config to be a map, but found: " +
+                    YamlCppUtils::get_node_type(type),
+                    this->path_);
+        }
+        this->found_top_level_ = true;
+        this->expecting_key_ = true;
+        return Context::top_level;
+    }
+    switch (this->context_stack_.back()) {
+        case Context::top_level:
+            if (this->expecting_key_) {
+                if (type != YAML::NodeType::Scalar) {
+                    throw EcoevolityYamlDataError(
+                            "Expecting top-level keys to be scalars, but found: " +
+                            YamlCppUtils::get_node_type(type),
+                            this->path_);
+                }
+                this->key_ = value;
+                this->expecting_key_ = false;
+                return Context::ignored;
+            }
+            this->expecting_key_ = true;
+            return this->start_top_level_value(type, value);
+        case Context::population_labels:
+            if (type != YAML::NodeType::Scalar) {
+                throw EcoevolityYamlDataError(
+                        "Expecting each population label to be a scalar, but found: " +
+                        YamlCppUtils::get_node_type(type),
+                        this->path_);
+            }
+            if (! this->label_set_.insert(value).second) {
+                throw EcoevolityYamlDataError(
+                        "Duplicate population label: " + value,
+                        this->path_);
+            }
+            this->population_labels.push_back(value);
+            return Context::ignored;
+        case Context::pattern_weights:
+            if (type != YAML::NodeType::Scalar) {
+                throw EcoevolityYamlDataError(
+                        "Expecting each pattern weight to be a scalar, but found: " +
+                        YamlCppUtils::get_node_type(type),
+                        this->path_);
+            }
+            this->pattern_weights.push_back(this->parse_count(value));
+            return Context::ignored;
+        case Context::allele_count_patterns:
+            if (type != YAML::NodeType::Sequence) {
+                throw EcoevolityYamlDataError(
+                        "Expecting each allele count pattern to be a sequence, but found: " +
+                        YamlCppUtils::get_node_type(type),
+                        this->path_);
+            }
+            this->pattern_red_allele_counts_.clear();
+            this->pattern_allele_counts_.clear();
+            return Context::allele_count_pattern;
+        case Context::allele_count_pattern:
+            if (type != YAML::NodeType::Sequence) {
+                throw EcoevolityYamlDataError(
+                        "Expecting each population allele count to be a sequence, but found: " +
+                        YamlCppUtils::get_node_type(type),
+                        this->path_);
+            }
+            this->population_counts_.clear();
+            return Context::population_allele_count;
+        case Context::population_allele_count:
+            if (type != YAML::NodeType::Scalar) {
+                throw EcoevolityYamlDataError(
+                        "Expecting each allele count to be a scalar, but found: " +
+                        YamlCppUtils::get_node_type(type),
+                        this->path_);
+            }
+            this->population_counts_.push_back(this->parse_count(value));
+            return Context::ignored;
+        case Context::ignored:
+            return Context::ignored;
+    }
+    return Context::ignored;
+}
+
+BiallelicDataYamlHandler::Context BiallelicDataYamlHandler::start_top_level_value(
+        YAML::NodeType::value type,
+        const std::string & value) {
+    if (this->key_ == "markers_are_dominant") {
+        if (type != YAML::NodeType::Scalar) {
+            throw EcoevolityYamlDataError(
+                    "markers_are_dominance node should be a map, but found: " +
+                    YamlCppUtils::get_node_type(type));
+        }
+        this->markers_are_dominant = this->convert_scalar<bool>(value);
+        return Context::ignored;
+    }
+    if (this->key_ == "population_labels") {
+        this->found_population_labels_ = true;
+        if (type != YAML::NodeType::Sequence) {
+            throw EcoevolityYamlDataError(
+                    "Expecting population labels to be a sequence, but found: " +
+                    YamlCppUtils::get_node_type(type),
+                    this->path_);
+        }
+        this->population_labels.clear();
+        this->label_set_.clear();
+        return Context::population_labels;
+    }
+    if (this->key_ == "pattern_weights") {
+        this->found_pattern_weights_ = true;
+        if (type != YAML::NodeType::Sequence) {
+            throw EcoevolityYamlDataError(
+                    "Expecting pattern weights to be a sequence, but found: " +
+                    YamlCppUtils::get_node_type(type),
+                    this->path_);
+        }
+        this->pattern_weights.clear();
+        return Context::pattern_weights;
+    }
+    if (this->key_ == "allele_count_patterns") {
+        this->found_allele_count_patterns_ = true;
+        if (type != YAML::NodeType::Sequence) {
+            throw EcoevolityYamlDataError(
+                    "Expecting allele count patterns to be a sequence, but found: " +
+                    YamlCppUtils::get_node_type(type),
+                    this->path_);
+        }
+        this->red_allele_counts.clear();
+        this->allele_counts.clear();
+        this->pattern_set_.clear();
+        return Context::allele_count_patterns;
+    }
+    return Context::ignored;
+}
+
+void BiallelicDataYamlHandler::end_collection() {
+    ECOEVOLITY_ASSERT(! this->context_stack_.empty());
+    Context context = this->context_stack_.back();
+    this->context_stack_.pop_back();
+    if (context == Context::population_allele_count) {
+        if (this->population_counts_.size() != 2) {
+            std::ostringstream message;
+            message << "All population allele counts should be a sequence of 2 integers, but found one with length: "
+                    << this->population_counts_.size();
+            throw EcoevolityYamlDataError(message.str(), this->path_);
+        }
+        this->pattern_red_allele_counts_.push_back(this->population_counts_.at(0));
+        this->pattern_allele_counts_.push_back(this->population_counts_.at(1));
+    }
+    else if (context == Context::allele_count_pattern) {
+        ECOEVOLITY_ASSERT(this->pattern_red_allele_counts_.size() ==
+                this->pattern_allele_counts_.size());
+        // If the labels come after the patterns in the document, this is
+        // checked by 'finish'
+        if (this->found_population_labels_) {
+            this->check_number_of_populations(this->pattern_allele_counts_.size());
+        }
+        this->pattern_key_ = this->pattern_red_allele_counts_;
+        this->pattern_key_.insert(this->pattern_key_.end(),
+                this->pattern_allele_counts_.begin(),
+                this->pattern_allele_counts_.end());
+        if (! this->pattern_set_.insert(this->pattern_key_).second) {
+            throw EcoevolityYamlDataError("Found duplicate allele count pattern",
+                    this->path_);
+        }
+        this->red_allele_counts.push_back(this->pattern_red_allele_counts_);
+        this->allele_counts.push_back(this->pattern_allele_counts_);
+    }
+}
+
+void BiallelicDataYamlHandler::check_number_of_populations(
+        unsigned int number_of_populations) const {
+    if (number_of_populations != this->population_labels.size()) {
+        std::ostringstream message;
+        message << "There were "
+                << this->population_labels.size()
+                << " population labels, so expecting all allele count patterns to consist of counts for "
+                << this->population_labels.size()
+                << " populations, but found a pattern with counts for "
+                << number_of_populations
+                << " populations\n";
+        throw EcoevolityYamlDataError(message.str());
+    }
+}
+
+unsigned int BiallelicDataYamlHandler::parse_count(const std::string & value) const {
+    // Fast path for plain decimal integers; anything else is left to
+    // yaml-cpp, so the accepted formats are the same as for YAML::Node::as
+    if ((! value.empty()) && (value.size() < 10)) {
+        unsigned int count = 0;
+        bool is_decimal = true;
+        for (auto c : value) {
+            if ((c < '0') || (c > '9')) {
+                is_decimal = false;
+                break;
+            }
+            count = (count * 10) + (c - '0');
+        }
+        if (is_decimal) {
+            return count;
+        }
+    }
+    return this->convert_scalar<unsigned int>(value);
+}
+
+void BiallelicDataYamlHandler::finish() const {
+    if (! this->found_top_level_) {
+        throw EcoevolityYamlDataError(
+                "Expecting top-level of config to be a map, but found: " +
+                YamlCppUtils::get_node_type(YAML::NodeType::Null),
+                this->path_);
+    }
+    if (! this->found_population_labels_) {
+        throw EcoevolityYamlDataError("No population labels", this->path_);
+    }
+    if (! this->found_allele_count_patterns_) {
+        throw EcoevolityYamlDataError("No allele count patterns", this->path_);
+    }
+    if (! this->found_pattern_weights_) {
+        throw EcoevolityYamlDataError("No pattern weights", this->path_);
+    }
+    for (auto const & counts : this->allele_counts) {
+        this->check_number_of_populations(counts.size());
+    }
+}
+
 BiallelicData::BiallelicData(
         const std::vector<std::string> & population_labels,
         unsigned int haploid_sample_size_per_population,
@@ -79,7 +392,7 @@ BiallelicData::BiallelicData(
     this->appendable_ = true;
 
     this->storing_seq_loci_info_ = true;
-    this->contiguous_pattern_indices_ = std::vector<unsigned int>(number_of_sites, 0);
+    this->contiguous_pattern_indices_.assign(number_of_sites, 0);
     unsigned int end_of_locus = length_of_loci - 1;
     for (unsigned int locus_idx = 0; locus_idx < number_of_loci; ++locus_idx) {
         this->locus_end_indices_.push_back(end_of_locus);
@@ -99,14 +412,16 @@ BiallelicData::BiallelicData(
         bool genotypes_are_diploid,
         bool markers_are_dominant,
         bool validate,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->init(path,
                population_name_delimiter,
                population_name_is_prefix,
                genotypes_are_diploid,
                markers_are_dominant,
                validate,
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
 }
 
 void BiallelicData::init_from_yaml_stream(
@@ -120,6 +435,11 @@ void BiallelicData::init_from_yaml_stream(
 void BiallelicData::init_from_yaml_path(
         const std::string& path,
         bool validate) {
+    if (sim_archive::is_member_path(path)) {
+        std::istringstream member_stream(sim_archive::read_member(path));
+        this->init_from_yaml_stream(member_stream, path, validate);
+        return;
+    }
     std::ifstream in_stream;
     in_stream.open(path);
     if (! in_stream.is_open()) {
@@ -132,189 +452,32 @@ void BiallelicData::init_from_yaml_path(
 }
 
 void BiallelicData::parse_yaml_data(std::istream& yaml_stream, bool validate) {
-    YAML::Node data;
+    BiallelicDataYamlHandler handler(this->path_);
     try {
-        data = YAML::Load(yaml_stream);
+        YAML::Parser parser(yaml_stream);
+        parser.HandleNextDocument(handler);
     }
-    catch (...) {
+    catch (const YAML::ParserException &) {
         std::cerr << "ERROR: Problem with YAML-formatting of data\n";
         throw;
     }
-    this->parse_yaml_top_level(data);
-    this->update_max_allele_counts();
-    this->update_pattern_booleans();
-    if (validate) {
-        this->validate();
-    }
-}
-
-void BiallelicData::parse_yaml_top_level(const YAML::Node& top_level_node) {
-    if (! top_level_node.IsMap()) {
-        throw EcoevolityYamlDataError(
-                "Expecting top-level of config to be a map, but found: " +
-                YamlCppUtils::get_node_type(top_level_node),
-                this->path_);
-    }
-    if (! top_level_node["population_labels"]) {
-        throw EcoevolityYamlDataError("No population labels", this->path_);
-    }
-    if (! top_level_node["allele_count_patterns"]) {
-        throw EcoevolityYamlDataError("No allele count patterns", this->path_);
-    }
-    if (! top_level_node["pattern_weights"]) {
-        throw EcoevolityYamlDataError("No pattern weights", this->path_);
-    }
-    if (! top_level_node["markers_are_dominant"]) {
-        this->markers_are_dominant_ = false;
-    }
-    else {
-        this->parse_yaml_marker_dominance(top_level_node["markers_are_dominant"]);
-    }
-    this->parse_yaml_population_labels(top_level_node["population_labels"]);
-    this->parse_yaml_pattern_weights(top_level_node["pattern_weights"]);
-    this->parse_yaml_all_allele_count_patterns(top_level_node["allele_count_patterns"]);
-}
-
-void BiallelicData::parse_yaml_marker_dominance(const YAML::Node& node) {
-    if (! node.IsScalar()) {
-        throw EcoevolityYamlDataError(
-                "markers_are_dominance node should be a map, but found: " +
-                YamlCppUtils::get_node_type(node));
-    }
-    this->markers_are_dominant_ = node.as<bool>();
-}
-
-void BiallelicData::parse_yaml_population_labels(const YAML::Node& node) {
-    if (! node.IsSequence()) {
-        throw EcoevolityYamlDataError(
-                "Expecting population labels to be a sequence, but found: " +
-                YamlCppUtils::get_node_type(node),
-                this->path_);
-    }
-    this->population_labels_.clear();
+    handler.finish();
+    this->markers_are_dominant_ = handler.markers_are_dominant;
+    this->population_labels_ = std::move(handler.population_labels);
     this->pop_label_to_index_map_.clear();
-    unsigned int pop_idx = 0;
-    std::set<std::string> label_set;
-    for (YAML::const_iterator label = node.begin();
-            label != node.end();
-            ++label) {
-        std::string l = label->as<std::string>();
-        if (label_set.count(l) > 0) {
-            throw EcoevolityYamlDataError(
-                    "Duplicate population label: " + l,
-                    this->path_);
-        }
-        label_set.insert(l);
-        this->population_labels_.push_back(l);
-        this->pop_label_to_index_map_[l] = pop_idx;
-        ++pop_idx;
-    }
-}
-
-void BiallelicData::parse_yaml_pattern_weights(const YAML::Node& node) {
-    if (! node.IsSequence()) {
-        throw EcoevolityYamlDataError(
-                "Expecting pattern weights to be a sequence, but found: " +
-                YamlCppUtils::get_node_type(node),
-                this->path_);
-    }
-    this->pattern_weights_.clear();
-    for (YAML::const_iterator w = node.begin();
-            w != node.end();
-            ++w) {
-        unsigned int weight = w->as<unsigned int>();
-        this->pattern_weights_.push_back(weight);
-    }
-}
-
-void BiallelicData::parse_yaml_all_allele_count_patterns(const YAML::Node& node) {
-    if (! node.IsSequence()) {
-        throw EcoevolityYamlDataError(
-                "Expecting allele count patterns to be a sequence, but found: " +
-                YamlCppUtils::get_node_type(node),
-                this->path_);
-    }
-    this->allele_counts_.clear();
-    this->red_allele_counts_.clear();
-    std::vector<unsigned int> tmp_red_allele_counts;
-    std::vector<unsigned int> tmp_allele_counts;
-    std::vector< std::vector<unsigned int> > pattern;
-    std::set< std::vector< std::vector<unsigned int> > > pattern_set;
-    for (unsigned int pattern_idx = 0;
-            pattern_idx < node.size();
-            ++pattern_idx) {
-        YAML::Node p = node[pattern_idx];
-        this->parse_yaml_allele_count_pattern(p,
-                tmp_red_allele_counts,
-                tmp_allele_counts);
-        ECOEVOLITY_ASSERT(tmp_red_allele_counts.size() == tmp_allele_counts.size());
-        if (tmp_allele_counts.size() != this->population_labels_.size()) {
-            std::ostringstream message;
-            message << "There were "
-                    << this->population_labels_.size()
-                    << " population labels, so expecting all allele count patterns to consist of counts for "
-                    << this->population_labels_.size()
-                    << " populations, but found a pattern with counts for "
-                    << tmp_allele_counts.size()
-                    << " populations\n";
-            throw EcoevolityYamlDataError(message.str());
-        }
-        pattern = {tmp_red_allele_counts, tmp_allele_counts};
-        if (pattern_set.count(pattern) > 0) {
-            throw EcoevolityYamlDataError("Found duplicate allele count pattern",
-                    this->path_);
-        }
-        pattern_set.insert(pattern);
-        this->allele_counts_.push_back(tmp_allele_counts);
-        this->red_allele_counts_.push_back(tmp_red_allele_counts);
-    }
-}
-
-void BiallelicData::parse_yaml_allele_count_pattern(const YAML::Node& node,
-        std::vector<unsigned int> & red_allele_counts,
-        std::vector<unsigned int> & allele_counts) {
-    if (! node.IsSequence()) {
-        throw EcoevolityYamlDataError(
-                "Expecting each allele count pattern to be a sequence, but found: " +
-                YamlCppUtils::get_node_type(node),
-                this->path_);
-    }
-    red_allele_counts.clear();
-    allele_counts.clear();
     for (unsigned int pop_idx = 0;
-            pop_idx < node.size();
+            pop_idx < this->population_labels_.size();
             ++pop_idx) {
-        YAML::Node pop_counts = node[pop_idx];
-        this->parse_yaml_allele_count(pop_counts,
-                red_allele_counts,
-                allele_counts);
-    }
-}
-
-void BiallelicData::parse_yaml_allele_count(const YAML::Node& node,
-        std::vector<unsigned int> & red_allele_counts,
-        std::vector<unsigned int> & allele_counts) {
-    if (! node.IsSequence()) {
-        throw EcoevolityYamlDataError(
-                "Expecting each population allele count to be a sequence, but found: " +
-                YamlCppUtils::get_node_type(node),
-                this->path_);
-    }
-    std::vector<unsigned int> temp_counts;
-    for (YAML::const_iterator count = node.begin();
-            count != node.end();
-            ++count) {
-        unsigned int c = count->as<unsigned int>();
-        temp_counts.push_back(c);
+        this->pop_label_to_index_map_[this->population_labels_.at(pop_idx)] = pop_idx;
     }
-    if (temp_counts.size() != 2) {
-        throw EcoevolityYamlDataError(
-                "All population allele counts should be a sequence of 2 integers, but found one with length: " +
-                temp_counts.size(),
-                this->path_);
+    this->pattern_weights_ = std::move(handler.pattern_weights);
+    this->red_allele_counts_ = std::move(handler.red_allele_counts);
+    this->allele_counts_ = std::move(handler.allele_counts);
+    this->update_max_allele_counts();
+    this->update_pattern_booleans();
+    if (validate) {
+        this->validate();
     }
-    red_allele_counts.push_back(temp_counts.at(0));
-    allele_counts.push_back(temp_counts.at(1));
 }
 
 void BiallelicData::init(
@@ -324,7 +487,8 @@ void BiallelicData::init(
         bool genotypes_are_diploid,
         bool markers_are_dominant,
         bool validate,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     char pop_name_delimiter = population_name_delimiter;
     // if (population_name_delimiter == '_') {
     //     pop_name_delimiter = ' ';
@@ -465,32 +629,16 @@ void BiallelicData::init(
     }
 
 
+    std::vector<std::string> taxon_labels;
+    std::vector<unsigned int> taxon_population_indices;
+    taxon_labels.reserve(num_taxa);
     for (unsigned int taxon_idx = 0; taxon_idx < num_taxa; ++taxon_idx) {
-        NxsString seq_label = char_block->GetTaxonLabel(taxon_idx);
-        std::vector<std::string> seq_label_elements = string_util::split(
-                seq_label,
-                pop_name_delimiter);
-        ECOEVOLITY_ASSERT(! seq_label_elements.empty());
-        std::string pop_label = seq_label_elements.front();
-        if (! population_name_is_prefix) {
-            pop_label = seq_label_elements.back();
-        }
-        bool pop_label_found = false;
-        for (unsigned int pop_label_idx = 0; pop_label_idx < this->population_labels_.size(); pop_label_idx++) {
-            if (this->population_labels_[pop_label_idx] == pop_label) {
-                assert(! this->sequence_labels_[pop_label_idx].empty());
-                this->sequence_labels_[pop_label_idx].push_back(seq_label);
-                pop_label_found = true;
-            }
-        }
-        if (! pop_label_found) {
-            this->population_labels_.push_back(pop_label);
-            this->pop_label_to_index_map_[pop_label] = this->population_labels_.size() - 1;
-            std::vector<std::string> tmp_label_vector = {seq_label};
-            this->sequence_labels_.push_back(tmp_label_vector);
-        }
-        this->seq_label_to_pop_label_map_[seq_label] = pop_label;
+        taxon_labels.push_back(char_block->GetTaxonLabel(taxon_idx));
     }
+    this->init_populations(taxon_labels,
+            pop_name_delimiter,
+            population_name_is_prefix,
+            taxon_population_indices);
 
     // ECOEVOLITY_DEBUG(
     // std::cerr << "this->populations_labels_:" << std::endl;
@@ -512,15 +660,227 @@ void BiallelicData::init(
         throw EcoevolityParsingError("More than one character encoding (i.e., mixed data types) found", this->path_, 0);
     }
     const NxsDiscreteDatatypeMapper * data_type_mapper = data_type_mappers[0];
+    const NxsDiscreteStateCell highest_state_code = data_type_mapper->GetHighestStateCode();
+
+    const bool nucleotide_data = this->vet_data_type(data_type,
+            highest_state_code);
+
+    // Resolve the states of every (non-missing) state code once, so the
+    // matrix can be tallied without going through the character block (and
+    // its state-set lookups) for every cell.
+    std::vector<unsigned int> code_state_counts;
+    std::vector< std::vector<NxsDiscreteStateCell> > code_states;
+    for (NxsDiscreteStateCell code = 0; code <= highest_state_code; ++code) {
+        const std::set<NxsDiscreteStateCell> & state_set = data_type_mapper->GetStateSetForCode(code);
+        code_state_counts.push_back(state_set.size());
+        code_states.push_back(std::vector<NxsDiscreteStateCell>(
+                state_set.begin(), state_set.end()));
+    }
+
+    // Contiguous ranges of sites are tallied separately (and concurrently
+    // when we have threads) and then merged in site order, so the order of
+    // the patterns, their weights, and the site-to-pattern indices are the
+    // same regardless of the number of threads.
+    unsigned int number_of_tallies = 1;
+#ifdef BUILD_WITH_THREADS
+    // Not worth launching threads for small alignments
+    const unsigned int min_sites_per_thread = 1000;
+    if (nthreads > 1) {
+        number_of_tallies = std::min(nthreads,
+                std::max(1u, num_chars / min_sites_per_thread));
+    }
+#endif
+    std::vector<BiallelicPatternTally> tallies(number_of_tallies,
+            BiallelicPatternTally(this->get_number_of_populations(),
+                    this->storing_seq_loci_info_));
+#ifdef BUILD_WITH_THREADS
+    if (number_of_tallies > 1) {
+        const unsigned int batch_size = num_chars / number_of_tallies;
+        unsigned int start_idx = 0;
+        std::vector< std::future<void> > threads(number_of_tallies - 1);
+
+        // Launch number_of_tallies - 1 threads
+        for (unsigned int i = 0; i < (number_of_tallies - 1); ++i) {
+            threads.at(i) = std::async(
+                    std::launch::async,
+                    &BiallelicData::tally_nexus_site_patterns,
+                    this,
+                    char_block,
+                    std::cref(taxon_labels),
+                    std::cref(taxon_population_indices),
+                    std::cref(code_state_counts),
+                    std::cref(code_states),
+                    nucleotide_data,
+                    start_idx,
+                    start_idx + batch_size,
+                    std::ref(tallies.at(i)));
+            start_idx += batch_size;
+        }
+
+        // Use the main thread for the last range of sites. Any error is held
+        // until the other threads are joined, so that (as when reading
+        // serially) the invalid character in the earliest site is reported.
+        std::exception_ptr main_thread_error = nullptr;
+        try {
+            this->tally_nexus_site_patterns(
+                    char_block,
+                    taxon_labels,
+                    taxon_population_indices,
+                    code_state_counts,
+                    code_states,
+                    nucleotide_data,
+                    start_idx,
+                    num_chars,
+                    tallies.back());
+        }
+        catch (...) {
+            main_thread_error = std::current_exception();
+        }
+
+        // Join the launched threads (rethrowing errors in site order)
+        for (auto &t : threads) {
+            t.get();
+        }
+        if (main_thread_error) {
+            std::rethrow_exception(main_thread_error);
+        }
+    }
+    else {
+#endif
+        this->tally_nexus_site_patterns(
+                char_block,
+                taxon_labels,
+                taxon_population_indices,
+                code_state_counts,
+                code_states,
+                nucleotide_data,
+                0,
+                num_chars,
+                tallies.at(0));
+#ifdef BUILD_WITH_THREADS
+    }
+#endif
+    this->merge_pattern_tallies(tallies);
 
-    unsigned int ploidy_multiplier = 1;
-    if (this->genotypes_are_diploid_) {
-        ploidy_multiplier = 2;
+    nexus_reader.DeleteBlocksFromFactories();
+    this->update_max_allele_counts();
+    this->update_pattern_booleans();
+    if (validate) {
+        this->validate();
     }
-    unsigned int found_pattern_idx = 0;
-    bool pattern_was_found = false;
+}
+
+void BiallelicData::init_from_streamed_nexus(
+        std::string path, 
+        char population_name_delimiter,
+        bool population_name_is_prefix,
+        bool genotypes_are_diploid,
+        bool markers_are_dominant,
+        bool validate) {
+    this->genotypes_are_diploid_ = genotypes_are_diploid;
+    this->markers_are_dominant_ = markers_are_dominant;
+    this->path_ = path;
+
+    if ((this->markers_are_dominant_) and (this->genotypes_are_diploid_)) {
+        throw EcoevolityBiallelicDataError(
+                "Dominant markers must be coded as haploid (i.e., 0/1)",
+                this->path_);
+    }
+
+    NexusMatrixStream matrix_stream(this->path_);
+
+    const std::vector<std::string> & taxon_labels = matrix_stream.get_taxon_labels();
+    std::vector<unsigned int> taxon_population_indices;
+    this->init_populations(taxon_labels,
+            population_name_delimiter,
+            population_name_is_prefix,
+            taxon_population_indices);
+
+    const bool nucleotide_data = this->vet_data_type(
+            matrix_stream.get_data_type(),
+            matrix_stream.get_highest_state_code());
+
+    const std::vector< std::vector<NxsDiscreteStateCell> > & code_states = matrix_stream.get_code_states();
+    std::vector<unsigned int> code_state_counts;
+    code_state_counts.reserve(code_states.size());
+    for (auto const & states : code_states) {
+        code_state_counts.push_back(states.size());
+    }
+
+    // Only one block of sites is held in memory at a time; the tally grows
+    // with the number of unique patterns
+    std::vector<BiallelicPatternTally> tallies(1,
+            BiallelicPatternTally(this->get_number_of_populations(), false));
+    BiallelicPatternTally & tally = tallies.at(0);
+    const unsigned int block_size = 4096;
+    std::vector<NxsDiscreteStateCell> block_cells;
+    unsigned int block_start = 0;
+    unsigned int number_of_sites_read = matrix_stream.read_sites(block_size, block_cells);
+    while (number_of_sites_read > 0) {
+        this->tally_site_block(
+                block_cells.data(),
+                taxon_labels,
+                taxon_population_indices,
+                code_state_counts,
+                code_states,
+                nucleotide_data,
+                block_start,
+                number_of_sites_read,
+                tally);
+        block_start += number_of_sites_read;
+        number_of_sites_read = matrix_stream.read_sites(block_size, block_cells);
+    }
+    this->merge_pattern_tallies(tallies);
+
+    this->update_max_allele_counts();
+    this->update_pattern_booleans();
+    if (validate) {
+        this->validate();
+    }
+}
+
+void BiallelicData::init_populations(
+        const std::vector<std::string> & taxon_labels,
+        char population_name_delimiter,
+        bool population_name_is_prefix,
+        std::vector<unsigned int> & taxon_population_indices) {
+    taxon_population_indices.clear();
+    taxon_population_indices.reserve(taxon_labels.size());
+    for (auto const & seq_label : taxon_labels) {
+        std::vector<std::string> seq_label_elements = string_util::split(
+                seq_label,
+                population_name_delimiter);
+        ECOEVOLITY_ASSERT(! seq_label_elements.empty());
+        std::string pop_label = seq_label_elements.front();
+        if (! population_name_is_prefix) {
+            pop_label = seq_label_elements.back();
+        }
+        bool pop_label_found = false;
+        for (unsigned int pop_label_idx = 0; pop_label_idx < this->population_labels_.size(); pop_label_idx++) {
+            if (this->population_labels_[pop_label_idx] == pop_label) {
+                assert(! this->sequence_labels_[pop_label_idx].empty());
+                this->sequence_labels_[pop_label_idx].push_back(seq_label);
+                pop_label_found = true;
+            }
+        }
+        if (! pop_label_found) {
+            this->population_labels_.push_back(pop_label);
+            this->pop_label_to_index_map_[pop_label] = this->population_labels_.size() - 1;
+            std::vector<std::string> tmp_label_vector = {seq_label};
+            this->sequence_labels_.push_back(tmp_label_vector);
+        }
+        this->seq_label_to_pop_label_map_[seq_label] = pop_label;
+        // Resolve the population of each taxon once, rather than looking it
+        // up by sequence label for every cell of the matrix
+        taxon_population_indices.push_back(this->get_population_index(pop_label));
+    }
+}
+
+bool BiallelicData::vet_data_type(
+        NxsCharactersBlock::DataTypesEnum data_type,
+        NxsDiscreteStateCell highest_state_code) const {
+    bool nucleotide_data = false;
     if (data_type == NxsCharactersBlock::DataTypesEnum::standard) {
-        const NxsDiscreteStateCell highest_state_code = data_type_mapper->GetHighestStateCode();
         if (highest_state_code == 1) {
             if (this->genotypes_are_diploid_) {
                 throw EcoevolityBiallelicDataError(
@@ -538,51 +898,6 @@ void BiallelicData::init(
         else {
             throw EcoevolityParsingError("More than 3 character state codes found", this->path_, 0);
         }
-
-        for (unsigned int site_idx = 0; site_idx < num_chars; ++site_idx) {
-            std::vector<unsigned int> allele_cts (this->get_number_of_populations(), 0);
-            std::vector<unsigned int> red_allele_cts (this->get_number_of_populations(), 0);
-            for (unsigned int taxon_idx = 0; taxon_idx < num_taxa; ++taxon_idx) {
-                const NxsDiscreteStateCell state_code = char_block->GetInternalRepresentation(taxon_idx, site_idx);
-                if (state_code >= 0) {
-                    const unsigned int num_states = char_block->GetNumStates(taxon_idx, site_idx);
-                    if (num_states > 1) {
-                        throw EcoevolityInvalidCharacterError(
-                                "Invalid polymorphic character",
-                                this->path_,
-                                char_block->GetTaxonLabel(taxon_idx),
-                                site_idx);
-                    }
-                    if ((state_code > 1) && (! this->genotypes_are_diploid_)) {
-                        throw EcoevolityInvalidCharacterError(
-                                "Invalid diploid character (2) for haploid data",
-                                this->path_,
-                                char_block->GetTaxonLabel(taxon_idx),
-                                site_idx);
-                    }
-                    const unsigned int& population_idx = this->get_population_index_from_seq_label(char_block->GetTaxonLabel(taxon_idx));
-                    red_allele_cts[population_idx] += state_code;
-                    allele_cts[population_idx] += 1 * ploidy_multiplier;
-                }
-            }
-            this->get_pattern_index(pattern_was_found, found_pattern_idx,
-                    red_allele_cts,
-                    allele_cts);
-            if (pattern_was_found) {
-                this->pattern_weights_[found_pattern_idx] += 1;
-                if (this->storing_seq_loci_info_) {
-                    this->contiguous_pattern_indices_.push_back(found_pattern_idx);
-                }
-            }
-            else {
-                this->red_allele_counts_.push_back(red_allele_cts);
-                this->allele_counts_.push_back(allele_cts);
-                this->pattern_weights_.push_back(1);
-                if (this->storing_seq_loci_info_) {
-                    this->contiguous_pattern_indices_.push_back(this->pattern_weights_.size() - 1);
-                }
-            }
-        }
     }
     else if ((data_type == NxsCharactersBlock::DataTypesEnum::nucleotide) ||
              (data_type == NxsCharactersBlock::DataTypesEnum::dna) ||
@@ -592,107 +907,234 @@ void BiallelicData::init(
                     "Dominant data must be coded as 0/1 (not nucleotides)",
                     this->path_);
         }
-        for (unsigned int site_idx = 0; site_idx < num_chars; ++site_idx) {
-            std::vector<unsigned int> allele_cts (this->get_number_of_populations(), 0);
-            std::vector<unsigned int> red_allele_cts (this->get_number_of_populations(), 0);
-            NxsDiscreteStateCell red_code = -1;
-            NxsDiscreteStateCell green_code = -1;
-            bool triallelic_site = false;
+        nucleotide_data = true;
+    }
+    else {
+        throw EcoevolityBiallelicDataError("Data type not supported", this->path_);
+    }
+    return nucleotide_data;
+}
+
+void BiallelicData::tally_nexus_site_patterns(
+        const NxsCharactersBlock * char_block,
+        const std::vector<std::string> & taxon_labels,
+        const std::vector<unsigned int> & taxon_population_indices,
+        const std::vector<unsigned int> & code_state_counts,
+        const std::vector< std::vector<NxsDiscreteStateCell> > & code_states,
+        const bool nucleotide_data,
+        const unsigned int first_site_index,
+        const unsigned int end_site_index,
+        BiallelicPatternTally & tally) const {
+    const unsigned int num_taxa = taxon_labels.size();
+
+    // NCL stores the matrix by taxon, so we copy it in blocks of sites,
+    // transposing each block so that the cells of a site are contiguous. The
+    // blocks are small enough to stay in cache while the sites are tallied.
+    const unsigned int block_size = 256;
+    std::vector<NxsDiscreteStateCell> block_cells(block_size * num_taxa);
+
+    for (unsigned int block_start = first_site_index;
+            block_start < end_site_index;
+            block_start += block_size) {
+        const unsigned int block_end = std::min(block_start + block_size,
+                end_site_index);
+        for (unsigned int taxon_idx = 0; taxon_idx < num_taxa; ++taxon_idx) {
+            const NxsDiscreteStateRow & row = char_block->GetDiscreteMatrixRow(taxon_idx);
+            for (unsigned int site_idx = block_start; site_idx < block_end; ++site_idx) {
+                NxsDiscreteStateCell code = NXS_MISSING_CODE;
+                if (site_idx < row.size()) {
+                    code = row[site_idx];
+                }
+                block_cells[((site_idx - block_start) * num_taxa) + taxon_idx] = code;
+            }
+        }
+
+        this->tally_site_block(
+                block_cells.data(),
+                taxon_labels,
+                taxon_population_indices,
+                code_state_counts,
+                code_states,
+                nucleotide_data,
+                block_start,
+                block_end - block_start,
+                tally);
+    }
+}
+
+void BiallelicData::tally_site_block(
+        const NxsDiscreteStateCell * block_cells,
+        const std::vector<std::string> & taxon_labels,
+        const std::vector<unsigned int> & taxon_population_indices,
+        const std::vector<unsigned int> & code_state_counts,
+        const std::vector< std::vector<NxsDiscreteStateCell> > & code_states,
+        const bool nucleotide_data,
+        const unsigned int first_site_index,
+        const unsigned int number_of_sites,
+        BiallelicPatternTally & tally) const {
+    const unsigned int num_taxa = taxon_labels.size();
+    const unsigned int num_pops = this->get_number_of_populations();
+    unsigned int ploidy_multiplier = 1;
+    if (this->genotypes_are_diploid_) {
+        ploidy_multiplier = 2;
+    }
+
+    std::vector<unsigned int> & pattern_key = tally.get_key_buffer();
+    ECOEVOLITY_ASSERT(pattern_key.size() == (2 * num_pops));
+    unsigned int * red_allele_cts = pattern_key.data();
+    unsigned int * allele_cts = pattern_key.data() + num_pops;
+
+    for (unsigned int i = 0; i < number_of_sites; ++i) {
+        const unsigned int site_idx = first_site_index + i;
+        const NxsDiscreteStateCell * site_cells = &block_cells[i * num_taxa];
+        std::fill(pattern_key.begin(), pattern_key.end(), 0);
+        if (! nucleotide_data) {
             for (unsigned int taxon_idx = 0; taxon_idx < num_taxa; ++taxon_idx) {
-                const NxsDiscreteStateCell state_code = char_block->GetInternalRepresentation(taxon_idx, site_idx);
-                if (state_code >= 0) {
-                    const unsigned int num_states = char_block->GetNumStates(taxon_idx, site_idx);
-                    if (num_states > 3) {
-                        throw EcoevolityInvalidCharacterError(
-                                "Invalid polymorphic character with 3 or more states",
-                                this->path_,
-                                char_block->GetTaxonLabel(taxon_idx),
-                                site_idx);
-                    }
-                    if ((num_states > 1) && (! this->genotypes_are_diploid_)) {
-                        throw EcoevolityInvalidCharacterError(
-                                "Polymorphic characters are not allowed for haploid data",
-                                this->path_,
-                                char_block->GetTaxonLabel(taxon_idx),
-                                site_idx);
-                    }
-                    ECOEVOLITY_ASSERT((num_states > 0) && (num_states < 3));
-                    std::vector<NxsDiscreteStateCell> states;
-                    states.push_back(char_block->GetInternalRepresentation(taxon_idx, site_idx, 0));
-                    if (num_states > 1) {
-                        states.push_back(char_block->GetInternalRepresentation(taxon_idx, site_idx, 1));
-                    }
-                    const unsigned int& population_idx = this->get_population_index_from_seq_label(char_block->GetTaxonLabel(taxon_idx));
-                    unsigned int pm = ploidy_multiplier;
-                    if (num_states > 1) {
-                        pm = 1;
-                    }
-                    for (auto state_iter: states) {
-                        if (green_code < 0) {
-                            green_code = state_iter;
-                            allele_cts[population_idx] += 1 * pm;
-                            continue;
-                        }
-                        else if (green_code == state_iter) {
-                            allele_cts[population_idx] += 1 * pm;
-                            continue;
-                        }
-                        else if (red_code < 0) {
-                            red_code = state_iter;
-                            red_allele_cts[population_idx] += 1 * pm;
-                            allele_cts[population_idx] += 1 * pm;
-                            continue;
-                        }
-                        else if (red_code == state_iter) {
-                            red_allele_cts[population_idx] += 1 * pm;
-                            allele_cts[population_idx] += 1 * pm;
-                            continue;
-                        }
-                        // Handle 3rd or 4th alleles
-                        else {
-                            // Code 3rd or 4th alleles as red (1)
-                            red_allele_cts[population_idx] += 1 * pm;
-                            allele_cts[population_idx] += 1 * pm;
-                            triallelic_site = true;
-                            /* throw EcoevolityInvalidCharacterError( */
-                            /*         "A third character state was found", */
-                            /*         this->path_, */
-                            /*         char_block->GetTaxonLabel(taxon_idx), */
-                            /*         site_idx); */
-                        }
-                    }
+                const NxsDiscreteStateCell code = site_cells[taxon_idx];
+                // Missing or gap
+                if (code < 0) {
+                    continue;
+                }
+                const NxsDiscreteStateCell state_code = code_states[code][0];
+                if (state_code < 0) {
+                    continue;
                 }
+                const unsigned int num_states = code_state_counts[code];
+                if (num_states > 1) {
+                    throw EcoevolityInvalidCharacterError(
+                            "Invalid polymorphic character",
+                            this->path_,
+                            taxon_labels.at(taxon_idx),
+                            site_idx);
+                }
+                if ((state_code > 1) && (! this->genotypes_are_diploid_)) {
+                    throw EcoevolityInvalidCharacterError(
+                            "Invalid diploid character (2) for haploid data",
+                            this->path_,
+                            taxon_labels.at(taxon_idx),
+                            site_idx);
+                }
+                const unsigned int population_idx = taxon_population_indices[taxon_idx];
+                red_allele_cts[population_idx] += state_code;
+                allele_cts[population_idx] += 1 * ploidy_multiplier;
             }
-            if (triallelic_site) {
-                ++this->number_of_triallelic_sites_recoded_;
+            tally.add_site();
+            continue;
+        }
+
+        NxsDiscreteStateCell red_code = -1;
+        NxsDiscreteStateCell green_code = -1;
+        bool triallelic_site = false;
+        for (unsigned int taxon_idx = 0; taxon_idx < num_taxa; ++taxon_idx) {
+            const NxsDiscreteStateCell code = site_cells[taxon_idx];
+            // Missing or gap
+            if (code < 0) {
+                continue;
             }
-            this->get_pattern_index(pattern_was_found, found_pattern_idx,
-                    red_allele_cts,
-                    allele_cts);
-            if (pattern_was_found) {
-                ++this->pattern_weights_[found_pattern_idx];
-                if (this->storing_seq_loci_info_) {
-                    this->contiguous_pattern_indices_.push_back(found_pattern_idx);
-                }
+            const std::vector<NxsDiscreteStateCell> & states = code_states[code];
+            if (states[0] < 0) {
+                continue;
             }
-            else {
-                this->red_allele_counts_.push_back(red_allele_cts);
-                this->allele_counts_.push_back(allele_cts);
-                this->pattern_weights_.push_back(1);
-                if (this->storing_seq_loci_info_) {
-                    this->contiguous_pattern_indices_.push_back(this->pattern_weights_.size() - 1);
+            const unsigned int num_states = code_state_counts[code];
+            if (num_states > 3) {
+                throw EcoevolityInvalidCharacterError(
+                        "Invalid polymorphic character with 3 or more states",
+                        this->path_,
+                        taxon_labels.at(taxon_idx),
+                        site_idx);
+            }
+            if ((num_states > 1) && (! this->genotypes_are_diploid_)) {
+                throw EcoevolityInvalidCharacterError(
+                        "Polymorphic characters are not allowed for haploid data",
+                        this->path_,
+                        taxon_labels.at(taxon_idx),
+                        site_idx);
+            }
+            ECOEVOLITY_ASSERT((num_states > 0) && (num_states < 3));
+            const unsigned int population_idx = taxon_population_indices[taxon_idx];
+            unsigned int pm = ploidy_multiplier;
+            if (num_states > 1) {
+                pm = 1;
+            }
+            // At most two states (i.e., a heterozygous genotype)
+            const unsigned int num_states_to_tally = std::min(num_states, 2u);
+            for (unsigned int state_idx = 0; state_idx < num_states_to_tally; ++state_idx) {
+                const NxsDiscreteStateCell state = states[state_idx];
+                if (green_code < 0) {
+                    green_code = state;
+                    allele_cts[population_idx] += 1 * pm;
+                    continue;
+                }
+                else if (green_code == state) {
+                    allele_cts[population_idx] += 1 * pm;
+                    continue;
+                }
+                else if (red_code < 0) {
+                    red_code = state;
+                    red_allele_cts[population_idx] += 1 * pm;
+                    allele_cts[population_idx] += 1 * pm;
+                    continue;
+                }
+                else if (red_code == state) {
+                    red_allele_cts[population_idx] += 1 * pm;
+                    allele_cts[population_idx] += 1 * pm;
+                    continue;
+                }
+                // Handle 3rd or 4th alleles
+                else {
+                    // Code 3rd or 4th alleles as red (1)
+                    red_allele_cts[population_idx] += 1 * pm;
+                    allele_cts[population_idx] += 1 * pm;
+                    triallelic_site = true;
                 }
             }
         }
+        if (triallelic_site) {
+            ++tally.number_of_triallelic_sites;
+        }
+        tally.add_site();
     }
-    else {
-        throw EcoevolityBiallelicDataError("Data type not supported", this->path_);
-    }
-    nexus_reader.DeleteBlocksFromFactories();
-    this->update_max_allele_counts();
-    this->update_pattern_booleans();
-    if (validate) {
-        this->validate();
+}
+
+void BiallelicData::merge_pattern_tallies(
+        const std::vector<BiallelicPatternTally> & tallies) {
+    ECOEVOLITY_ASSERT(this->allele_counts_.size() == this->red_allele_counts_.size());
+    std::map<std::vector<unsigned int>, unsigned int> pattern_index_map;
+    std::vector<unsigned int> pattern_key;
+    for (unsigned int pattern_idx = 0; pattern_idx < this->pattern_weights_.size(); ++pattern_idx) {
+        pattern_key = this->red_allele_counts_.at(pattern_idx);
+        pattern_key.insert(pattern_key.end(),
+                this->allele_counts_.at(pattern_idx).begin(),
+                this->allele_counts_.at(pattern_idx).end());
+        pattern_index_map[pattern_key] = pattern_idx;
+    }
+    for (auto const & tally: tallies) {
+        std::vector<unsigned int> global_pattern_indices(tally.get_number_of_patterns());
+        for (unsigned int i = 0; i < tally.get_number_of_patterns(); ++i) {
+            pattern_key = tally.red_allele_counts.at(i);
+            pattern_key.insert(pattern_key.end(),
+                    tally.allele_counts.at(i).begin(),
+                    tally.allele_counts.at(i).end());
+            auto found = pattern_index_map.find(pattern_key);
+            if (found != pattern_index_map.end()) {
+                this->pattern_weights_.at(found->second) += tally.pattern_weights.at(i);
+                global_pattern_indices.at(i) = found->second;
+            }
+            else {
+                this->red_allele_counts_.push_back(tally.red_allele_counts.at(i));
+                this->allele_counts_.push_back(tally.allele_counts.at(i));
+                this->pattern_weights_.push_back(tally.pattern_weights.at(i));
+                global_pattern_indices.at(i) = this->pattern_weights_.size() - 1;
+                pattern_index_map[pattern_key] = global_pattern_indices.at(i);
+            }
+        }
+        if (this->storing_seq_loci_info_) {
+            for (auto local_idx: tally.site_pattern_indices) {
+                this->contiguous_pattern_indices_.push_back(
+                        global_pattern_indices.at(local_idx));
+            }
+        }
+        this->number_of_triallelic_sites_recoded_ += tally.number_of_triallelic_sites;
     }
 }
 
@@ -960,15 +1402,16 @@ void BiallelicData::update_has_missing_patterns() {
 
 void BiallelicData::update_has_mirrored_patterns() {
     this->has_mirrored_patterns_ = false;
-    unsigned int mirrored_idx = 0;
-    bool was_found = false;
+    // Look up the mirror of each pattern in a map, rather than searching all
+    // of the patterns for each one
+    std::map<std::vector<unsigned int>, unsigned int> pattern_index_map;
+    this->get_pattern_index_map(pattern_index_map);
+    std::vector<unsigned int> mirrored_key;
     for (unsigned int pattern_idx = 0; pattern_idx < this->get_number_of_patterns(); ++pattern_idx) {
-        const std::vector< std::vector<unsigned int> > mirrored_pattern = this->get_mirrored_pattern(pattern_idx);
-        this->get_pattern_index(was_found, mirrored_idx,
-                mirrored_pattern.at(0),
-                mirrored_pattern.at(1));
-        if ((was_found) && (mirrored_idx != pattern_idx)) {
-            ECOEVOLITY_ASSERT(mirrored_idx > pattern_idx);
+        this->get_mirrored_pattern_key(pattern_idx, mirrored_key);
+        auto found = pattern_index_map.find(mirrored_key);
+        if ((found != pattern_index_map.end()) && (found->second != pattern_idx)) {
+            ECOEVOLITY_ASSERT(found->second > pattern_idx);
             this->has_mirrored_patterns_ = true;
             return;
         }
@@ -1028,6 +1471,79 @@ void BiallelicData::get_pattern_index(
     }
 }
 
+void BiallelicData::get_pattern_key(
+        const std::vector<unsigned int> & red_allele_counts,
+        const std::vector<unsigned int> & allele_counts,
+        std::vector<unsigned int> & key) const {
+    key = red_allele_counts;
+    key.insert(key.end(), allele_counts.begin(), allele_counts.end());
+}
+
+void BiallelicData::get_mirrored_pattern_key(
+        unsigned int pattern_index,
+        std::vector<unsigned int> & key) const {
+    const std::vector<unsigned int>& allele_cts = this->get_allele_counts(pattern_index);
+    const std::vector<unsigned int>& red_cts = this->get_red_allele_counts(pattern_index);
+    key.resize(2 * red_cts.size());
+    for (unsigned int pop_idx = 0; pop_idx < red_cts.size(); ++pop_idx) {
+        key.at(pop_idx) = allele_cts.at(pop_idx) - red_cts.at(pop_idx);
+        key.at(red_cts.size() + pop_idx) = allele_cts.at(pop_idx);
+    }
+}
+
+void BiallelicData::get_pattern_index_map(
+        std::map<std::vector<unsigned int>, unsigned int> & pattern_index_map) const {
+    ECOEVOLITY_ASSERT(this->allele_counts_.size() == this->red_allele_counts_.size());
+    pattern_index_map.clear();
+    std::vector<unsigned int> pattern_key;
+    for (unsigned int pattern_idx = 0; pattern_idx < this->pattern_weights_.size(); ++pattern_idx) {
+        this->get_pattern_key(this->red_allele_counts_.at(pattern_idx),
+                this->allele_counts_.at(pattern_idx),
+                pattern_key);
+        // Keep the first index, as 'get_pattern_index' does
+        pattern_index_map.insert(std::make_pair(pattern_key, pattern_idx));
+    }
+}
+
+void BiallelicData::remove_patterns(const std::vector<bool> & removing_pattern) {
+    ECOEVOLITY_ASSERT(removing_pattern.size() == this->pattern_weights_.size());
+    // New index of each pattern that is kept
+    std::vector<unsigned int> new_indices(removing_pattern.size(), 0);
+    unsigned int number_kept = 0;
+    for (unsigned int pattern_idx = 0; pattern_idx < removing_pattern.size(); ++pattern_idx) {
+        if (removing_pattern.at(pattern_idx)) {
+            continue;
+        }
+        new_indices.at(pattern_idx) = number_kept;
+        if (number_kept != pattern_idx) {
+            this->pattern_weights_.at(number_kept) = this->pattern_weights_.at(pattern_idx);
+            this->allele_counts_.at(number_kept).swap(this->allele_counts_.at(pattern_idx));
+            this->red_allele_counts_.at(number_kept).swap(this->red_allele_counts_.at(pattern_idx));
+        }
+        ++number_kept;
+    }
+    if (number_kept == removing_pattern.size()) {
+        return;
+    }
+    this->pattern_weights_.resize(number_kept);
+    this->allele_counts_.resize(number_kept);
+    this->red_allele_counts_.resize(number_kept);
+    if (this->pattern_weights_.size() < 1) {
+        throw EcoevolityBiallelicDataError(
+                "Ran out of data while removing patterns",
+                this->path_);
+    }
+    if (this->storing_seq_loci_info_) {
+        // Sites must no longer refer to the removed patterns
+        ECOEVOLITY_DEBUG(
+            for (auto site_pattern_idx : this->contiguous_pattern_indices_) {
+                ECOEVOLITY_ASSERT(! removing_pattern.at(site_pattern_idx));
+            }
+        )
+        this->contiguous_pattern_indices_.remap(new_indices);
+    }
+}
+
 // TODO: This method is causing the following error from compiler when using
 // flag '-Wstrict-overflow=5':
 //   error: assuming signed overflow does not occur when changing X +- C1 cmp C2 to X cmp C2 -+ C1
@@ -1047,14 +1563,18 @@ void BiallelicData::remove_pattern(unsigned int pattern_index) {
     // std::cout << "Deleting pattern index " << pattern_index << "\n";
     if (this->storing_seq_loci_info_) {
         std::vector<unsigned int> site_indices_to_erase;
-        for (unsigned int site_idx = 0;
-                site_idx < this->contiguous_pattern_indices_.size();
-                ++site_idx) {
-            if (this->contiguous_pattern_indices_.at(site_idx) == pattern_index) {
+        SitePatternIndex kept_site_pattern_indices;
+        kept_site_pattern_indices.reserve(this->contiguous_pattern_indices_.size());
+        unsigned int site_idx = 0;
+        for (auto site_pattern_idx : this->contiguous_pattern_indices_) {
+            if (site_pattern_idx == pattern_index) {
                 site_indices_to_erase.push_back(site_idx);
-            } else if (this->contiguous_pattern_indices_.at(site_idx) > pattern_index) {
-                --this->contiguous_pattern_indices_.at(site_idx);
+            } else if (site_pattern_idx > pattern_index) {
+                kept_site_pattern_indices.push_back(site_pattern_idx - 1);
+            } else {
+                kept_site_pattern_indices.push_back(site_pattern_idx);
             }
+            ++site_idx;
         }
         // std::cout << "Sites to delete:\n";
         // for (unsigned int i = 0; i < site_indices_to_erase.size(); ++i) {
@@ -1066,7 +1586,9 @@ void BiallelicData::remove_pattern(unsigned int pattern_index) {
         //     std::cout << this->locus_end_indices_.at(i) << " ";
         // }
         // std::cout << "\n";
-        std::vector<unsigned int> ends_to_erase;
+        // A locus can be flagged for more than one erased site, so flag
+        // rather than list the ends to erase
+        std::vector<bool> erasing_end(this->locus_end_indices_.size(), false);
         for (int i = (site_indices_to_erase.size() - 1); i >= 0; --i) {
             for (unsigned int locus_idx = 0; locus_idx < this->locus_end_indices_.size(); ++locus_idx) {
                 if (this->locus_end_indices_.at(locus_idx) >= site_indices_to_erase.at(i)) {
@@ -1074,7 +1596,7 @@ void BiallelicData::remove_pattern(unsigned int pattern_index) {
                             ((locus_idx > 0) &&
                             (this->locus_end_indices_.at(locus_idx) <=
                             (this->locus_end_indices_.at(locus_idx - 1) + 1)))) {
-                        ends_to_erase.push_back(locus_idx);
+                        erasing_end.at(locus_idx) = true;
                     }
                     // } else {
                     //     --this->locus_end_indices_.at(locus_idx);
@@ -1085,12 +1607,15 @@ void BiallelicData::remove_pattern(unsigned int pattern_index) {
                 }
             }
         }
-        for (int i = (ends_to_erase.size() - 1); i >= 0; --i) {
-            this->locus_end_indices_.erase(this->locus_end_indices_.begin() + ends_to_erase.at(i));
-        }
-        for (int i = (site_indices_to_erase.size() - 1); i >= 0; --i) {
-            this->contiguous_pattern_indices_.erase(this->contiguous_pattern_indices_.begin() + site_indices_to_erase.at(i));
+        unsigned int number_of_ends_kept = 0;
+        for (unsigned int locus_idx = 0; locus_idx < this->locus_end_indices_.size(); ++locus_idx) {
+            if (! erasing_end.at(locus_idx)) {
+                this->locus_end_indices_.at(number_of_ends_kept) = this->locus_end_indices_.at(locus_idx);
+                ++number_of_ends_kept;
+            }
         }
+        this->locus_end_indices_.resize(number_of_ends_kept);
+        this->contiguous_pattern_indices_ = kept_site_pattern_indices;
         // ECOEVOLITY_ASSERT(this->contiguous_pattern_indices_.size() == this->get_number_of_sites())
         // std::cout << "AFTER: Locus ends:\n";
         // for (unsigned int i = 0; i < this->locus_end_indices_.size(); ++i) {
@@ -1177,46 +1702,29 @@ const std::vector< std::vector<unsigned int> > BiallelicData::get_mirrored_patte
     return mirrored_counts;
 }
 
-void BiallelicData::fold_first_mirrored_pattern(
-        bool& was_folded,
-        unsigned int& folded_index) {
-    was_folded = false;
-    folded_index = 0;
-    unsigned int mirrored_idx = 0;
-    bool was_found = false;
-    for (unsigned int pattern_idx = 0; pattern_idx < this->get_number_of_patterns(); ++pattern_idx) {
-        const std::vector< std::vector<unsigned int> > mirrored_pattern = this->get_mirrored_pattern(pattern_idx);
-        this->get_pattern_index(was_found, mirrored_idx, mirrored_pattern.at(0),
-                mirrored_pattern.at(1));
-        if (! was_found) {
-            continue;
-        }
-        if (mirrored_idx == pattern_idx) {
-            continue;
-        }
-        ECOEVOLITY_ASSERT(mirrored_idx > pattern_idx);
-        this->pattern_weights_.at(pattern_idx) += this->pattern_weights_.at(mirrored_idx);
-        if (this->storing_seq_loci_info_) {
-            for (unsigned int site_idx = 0;
-                    site_idx < this->contiguous_pattern_indices_.size();
-                    ++site_idx) {
-                if (this->contiguous_pattern_indices_.at(site_idx) == mirrored_idx) {
-                    this->contiguous_pattern_indices_.at(site_idx) = pattern_idx;
-                }
-            }
-        }
-        this->remove_pattern(mirrored_idx);
-        folded_index = mirrored_idx;
-        was_folded = true;
-        return;
-    }
-}
-
 unsigned int BiallelicData::remove_constant_patterns(const bool validate) {
     unsigned int number_removed = 0;
     unsigned int return_idx = 0;
     bool was_found = false;
-    while (true) {
+    // Without locus info, all of the patterns can be removed in one pass
+    std::vector<unsigned int> no_red_pattern (this->get_number_of_populations(), 0);
+    std::vector<bool> removing_pattern(this->get_number_of_patterns(), false);
+    for (unsigned int pattern_idx = 0;
+            (! this->storing_seq_loci_info_) && (pattern_idx < this->get_number_of_patterns());
+            ++pattern_idx) {
+        if (this->get_red_allele_counts(pattern_idx) == no_red_pattern) {
+            this->number_of_constant_green_sites_removed_ += this->get_pattern_weight(pattern_idx);
+            removing_pattern.at(pattern_idx) = true;
+            number_removed += 1;
+        }
+        else if (this->get_red_allele_counts(pattern_idx) == this->get_allele_counts(pattern_idx)) {
+            this->number_of_constant_red_sites_removed_ += this->get_pattern_weight(pattern_idx);
+            removing_pattern.at(pattern_idx) = true;
+            number_removed += 1;
+        }
+    }
+    this->remove_patterns(removing_pattern);
+    while (this->storing_seq_loci_info_) {
         this->remove_first_constant_pattern(was_found, return_idx);
         if (! was_found) {
             break;
@@ -1235,7 +1743,22 @@ unsigned int BiallelicData::remove_missing_population_patterns(const bool valida
     unsigned int number_removed = 0;
     unsigned int return_idx = 0;
     bool was_found = false;
-    while (true) {
+    // Without locus info, all of the patterns can be removed in one pass
+    std::vector<bool> removing_pattern(this->get_number_of_patterns(), false);
+    for (unsigned int pattern_idx = 0;
+            (! this->storing_seq_loci_info_) && (pattern_idx < this->get_number_of_patterns());
+            ++pattern_idx) {
+        for (auto count : this->get_allele_counts(pattern_idx)) {
+            if (count == 0) {
+                this->number_of_missing_population_sites_removed_ += this->get_pattern_weight(pattern_idx);
+                removing_pattern.at(pattern_idx) = true;
+                number_removed += 1;
+                break;
+            }
+        }
+    }
+    this->remove_patterns(removing_pattern);
+    while (this->storing_seq_loci_info_) {
         this->remove_first_missing_population_pattern(was_found, return_idx);
         if (! was_found) {
             break;
@@ -1254,7 +1777,23 @@ unsigned int BiallelicData::remove_missing_patterns(const bool validate) {
     unsigned int number_removed = 0;
     unsigned int return_idx = 0;
     bool was_found = false;
-    while (true) {
+    // Without locus info, all of the patterns can be removed in one pass
+    std::vector<bool> removing_pattern(this->get_number_of_patterns(), false);
+    for (unsigned int pattern_idx = 0;
+            (! this->storing_seq_loci_info_) && (pattern_idx < this->get_number_of_patterns());
+            ++pattern_idx) {
+        unsigned int n_sampled = 0;
+        for (auto count : this->get_allele_counts(pattern_idx)) {
+            n_sampled += count;
+        }
+        if (n_sampled == 0) {
+            this->number_of_missing_sites_removed_ += this->get_pattern_weight(pattern_idx);
+            removing_pattern.at(pattern_idx) = true;
+            number_removed += 1;
+        }
+    }
+    this->remove_patterns(removing_pattern);
+    while (this->storing_seq_loci_info_) {
         this->remove_first_missing_pattern(was_found, return_idx);
         if (! was_found) {
             break;
@@ -1276,15 +1815,39 @@ unsigned int BiallelicData::fold_patterns(const bool validate) {
                 this->path_);
     }
     unsigned int number_removed = 0;
-    unsigned int return_idx = 0;
-    bool was_found = false;
-    while (true) {
-        this->fold_first_mirrored_pattern(was_found, return_idx);
-        if (! was_found) {
-            break;
+    // Each pattern absorbs its mirror (if the mirror comes later), so the
+    // mirrors can all be found in one pass and removed together
+    std::map<std::vector<unsigned int>, unsigned int> pattern_index_map;
+    this->get_pattern_index_map(pattern_index_map);
+    std::vector<bool> removing_pattern(this->get_number_of_patterns(), false);
+    std::vector<unsigned int> mirrored_key;
+    for (unsigned int pattern_idx = 0; pattern_idx < this->get_number_of_patterns(); ++pattern_idx) {
+        if (removing_pattern.at(pattern_idx)) {
+            continue;
         }
+        this->get_mirrored_pattern_key(pattern_idx, mirrored_key);
+        auto found = pattern_index_map.find(mirrored_key);
+        if ((found == pattern_index_map.end()) || (found->second == pattern_idx)) {
+            continue;
+        }
+        const unsigned int mirrored_idx = found->second;
+        ECOEVOLITY_ASSERT(mirrored_idx > pattern_idx);
+        this->pattern_weights_.at(pattern_idx) += this->pattern_weights_.at(mirrored_idx);
+        removing_pattern.at(mirrored_idx) = true;
         number_removed += 1;
     }
+    if (this->storing_seq_loci_info_ && (number_removed > 0)) {
+        std::vector<unsigned int> absorbing_indices(this->get_number_of_patterns());
+        for (unsigned int pattern_idx = 0; pattern_idx < this->get_number_of_patterns(); ++pattern_idx) {
+            absorbing_indices.at(pattern_idx) = pattern_idx;
+            if (removing_pattern.at(pattern_idx)) {
+                this->get_mirrored_pattern_key(pattern_idx, mirrored_key);
+                absorbing_indices.at(pattern_idx) = pattern_index_map.at(mirrored_key);
+            }
+        }
+        this->contiguous_pattern_indices_.remap(absorbing_indices);
+    }
+    this->remove_patterns(removing_pattern);
     for (unsigned int pattern_idx = 0; pattern_idx < this->get_number_of_patterns(); ++pattern_idx) {
         const std::vector< std::vector<unsigned int> > mirrored_pattern = this->get_mirrored_pattern(pattern_idx);
         const std::vector<unsigned int>& green_cts = mirrored_pattern.at(0);
@@ -1519,23 +2082,78 @@ std::vector< std::vector<std::string> > BiallelicData::get_alignment() const {
     return alignment;
 }
 
+void BiallelicData::get_alignment_row_states(
+        unsigned int population_index,
+        unsigned int row_index,
+        std::vector<char> & pattern_states) const {
+    // Within a population, rows are filled with the green ('0') alleles of
+    // each pattern first, then the red ('1') alleles, and any remaining rows
+    // are missing
+    unsigned int npatterns = this->get_number_of_patterns();
+    pattern_states.resize(npatterns);
+    for (unsigned int pattern_idx = 0; pattern_idx < npatterns; ++pattern_idx) {
+        unsigned int n_alleles = this->allele_counts_[pattern_idx][population_index];
+        unsigned int n_zero_alleles = n_alleles - this->red_allele_counts_[pattern_idx][population_index];
+        if (row_index < n_zero_alleles) {
+            pattern_states[pattern_idx] = '0';
+        }
+        else if (row_index < n_alleles) {
+            pattern_states[pattern_idx] = '1';
+        }
+        else {
+            pattern_states[pattern_idx] = '?';
+        }
+    }
+}
+
+void BiallelicData::write_alignment_row(
+        std::ostream& out,
+        const std::vector<char> & pattern_states,
+        std::string & buffer) const {
+    const std::size_t max_buffer_size = 1 << 16;
+    buffer.clear();
+    if (this->storing_seq_loci_info_) {
+        // Maintain the order of the site patterns
+        for (auto pattern_idx : this->contiguous_pattern_indices_) {
+            buffer.push_back(pattern_states[pattern_idx]);
+            if (buffer.size() >= max_buffer_size) {
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+    }
+    else {
+        for (unsigned int pattern_idx = 0;
+                pattern_idx < pattern_states.size();
+                ++pattern_idx) {
+            buffer.append(this->pattern_weights_[pattern_idx],
+                    pattern_states[pattern_idx]);
+            if (buffer.size() >= max_buffer_size) {
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+    }
+    out.write(buffer.data(), buffer.size());
+}
+
 void BiallelicData::write_alignment(
         std::ostream& out,
         char population_name_delimiter) const {
-    unsigned int count = 0;
-    std::vector < std::vector<std::string> > alignment = this->get_alignment();
-    unsigned int pop_idx = 0;
-    for (auto rows: alignment) {
-        unsigned int row_idx = 0;
-        std::string pop_label = this->get_population_label(pop_idx);
-        for (auto row: rows) {
+    std::vector<char> pattern_states;
+    std::string buffer;
+    for (unsigned int pop_idx = 0;
+            pop_idx < this->get_number_of_populations();
+            ++pop_idx) {
+        const std::string & pop_label = this->get_population_label(pop_idx);
+        unsigned int max_allele_count = this->get_max_allele_count(pop_idx);
+        for (unsigned int row_idx = 0; row_idx < max_allele_count; ++row_idx) {
+            this->get_alignment_row_states(pop_idx, row_idx, pattern_states);
             out << "\'" << pop_label << population_name_delimiter
-                << string_util::pad_int(row_idx, 4) << "\'  "
-                << row << std::endl;
-            ++row_idx;
-            ++count;
+                << string_util::pad_int(row_idx, 4) << "\'  ";
+            this->write_alignment_row(out, pattern_states, buffer);
+            out << "\n";
         }
-        ++pop_idx;
     }
 }
 
@@ -26,11 +26,16 @@
 #include <assert.h>
 #include <unordered_map>
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include <ncl/nxsmultiformat.h>
 
+#ifdef BUILD_WITH_THREADS
+#include <future>
+#endif
+
 #include "yaml_util.hpp"
 
 #include "string_util.hpp"
@@ -38,6 +43,147 @@
 #include "assert.hpp"
 #include "error.hpp"
 #include "math_util.hpp"
+#include "nexus_stream.hpp"
+#include "site_pattern_index.hpp"
+#include "sim_archive.hpp"
+
+/**
+ * Class for tallying the biallelic site patterns of a contiguous range of
+ * sites.
+ *
+ * Patterns are stored in the order they are first encountered. Each pattern
+ * is keyed by the red allele counts followed by the total allele counts, so
+ * looking up a pattern does not require a scan of all the patterns found so
+ * far. BiallelicData::init uses one of these for each range of sites it
+ * tallies (possibly concurrently), and then merges them in site order.
+ */
+class BiallelicPatternTally {
+    public:
+        BiallelicPatternTally() { }
+        BiallelicPatternTally(unsigned int number_of_populations,
+                bool storing_site_pattern_indices = false);
+
+        std::vector< std::vector<unsigned int> > red_allele_counts;
+        std::vector< std::vector<unsigned int> > allele_counts;
+        std::vector<unsigned int> pattern_weights;
+        std::vector<unsigned int> site_pattern_indices;
+        unsigned int number_of_triallelic_sites = 0;
+
+        /**
+         * Tally the pattern currently stored in the key buffer.
+         *
+         * The first half of the buffer returned by get_key_buffer should hold
+         * the red allele counts and the second half the total allele counts of
+         * the site.
+         */
+        void add_site();
+
+        std::vector<unsigned int> & get_key_buffer() {
+            return this->key_;
+        }
+        unsigned int get_number_of_patterns() const {
+            return this->pattern_weights.size();
+        }
+
+    private:
+        unsigned int number_of_populations_ = 0;
+        bool storing_site_pattern_indices_ = false;
+        std::vector<unsigned int> key_;
+        std::map<std::vector<unsigned int>, unsigned int> pattern_index_map_;
+};
+
+/**
+ * Event handler for streaming YAML-formatted allele count patterns.
+ *
+ * Rather than loading the whole document into a tree of YAML::Node objects
+ * and then walking it, BiallelicData::parse_yaml_data feeds the events of a
+ * YAML::Parser to this handler, which validates and stores the labels,
+ * patterns and weights as they are encountered. This way, the memory needed
+ * is bounded by the patterns themselves.
+ */
+class BiallelicDataYamlHandler : public YAML::EventHandler {
+    public:
+        BiallelicDataYamlHandler(const std::string & path);
+
+        bool markers_are_dominant = false;
+        std::vector<std::string> population_labels;
+        std::vector<unsigned int> pattern_weights;
+        std::vector< std::vector<unsigned int> > red_allele_counts;
+        std::vector< std::vector<unsigned int> > allele_counts;
+
+        void OnDocumentStart(const YAML::Mark & mark) { }
+        void OnDocumentEnd() { }
+        void OnNull(const YAML::Mark & mark, YAML::anchor_t anchor);
+        void OnAlias(const YAML::Mark & mark, YAML::anchor_t anchor);
+        void OnScalar(const YAML::Mark & mark,
+                const std::string & tag,
+                YAML::anchor_t anchor,
+                const std::string & value);
+        void OnSequenceStart(const YAML::Mark & mark,
+                const std::string & tag,
+                YAML::anchor_t anchor,
+                YAML::EmitterStyle::value style);
+        void OnSequenceEnd();
+        void OnMapStart(const YAML::Mark & mark,
+                const std::string & tag,
+                YAML::anchor_t anchor,
+                YAML::EmitterStyle::value style);
+        void OnMapEnd();
+
+        /**
+         * Check for the parts of the document that can only be vetted once
+         * all of it has been parsed (e.g., missing keys, or patterns that
+         * preceded the population labels).
+         */
+        void finish() const;
+
+    private:
+        enum class Context {
+            top_level,
+            population_labels,
+            pattern_weights,
+            allele_count_patterns,
+            allele_count_pattern,
+            population_allele_count,
+            ignored
+        };
+
+        std::string path_;
+        std::vector<Context> context_stack_;
+        bool found_top_level_ = false;
+        bool found_population_labels_ = false;
+        bool found_allele_count_patterns_ = false;
+        bool found_pattern_weights_ = false;
+        bool expecting_key_ = true;
+        std::string key_;
+        std::set<std::string> label_set_;
+        std::set< std::vector<unsigned int> > pattern_set_;
+        std::vector<unsigned int> pattern_key_;
+        std::vector<unsigned int> pattern_red_allele_counts_;
+        std::vector<unsigned int> pattern_allele_counts_;
+        std::vector<unsigned int> population_counts_;
+        YAML::Mark scalar_mark_;
+
+        Context start_node(YAML::NodeType::value type,
+                const std::string & value = "");
+        Context start_top_level_value(YAML::NodeType::value type,
+                const std::string & value);
+        void end_collection();
+        void check_number_of_populations(
+                unsigned int number_of_populations) const;
+        unsigned int parse_count(const std::string & value) const;
+
+        template<typename T>
+        T convert_scalar(const std::string & value) const {
+            try {
+                return YAML::Node(value).as<T>();
+            }
+            catch (const YAML::BadConversion &) {
+                // Report where in the document the bad value is
+                throw YAML::TypedBadConversion<T>(this->scalar_mark_);
+            }
+        }
+};
 
 /**
  * Class for storing biallelic site patterns.
@@ -63,14 +209,29 @@ class BiallelicData {
                 bool genotypes_are_diploid = true,
                 bool markers_are_dominant = false,
                 bool validate = true,
-                bool store_seq_loci_info = false);
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1);
         void init(const std::string path,
                 char population_name_delimiter = ' ',
                 bool population_name_is_prefix = true,
                 bool genotypes_are_diploid = true,
                 bool markers_are_dominant = false,
                 bool validate = true,
-                bool store_seq_loci_info = false);
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1);
+        /**
+         * Initialize from a NEXUS file by streaming its matrix in blocks of
+         * sites (see NexusMatrixStream), rather than reading it into memory
+         * with NCL. Memory is proportional to the number of site patterns,
+         * rather than the size of the alignment. Charsets are not read, so
+         * locus information is not stored.
+         */
+        void init_from_streamed_nexus(const std::string path,
+                char population_name_delimiter = ' ',
+                bool population_name_is_prefix = true,
+                bool genotypes_are_diploid = true,
+                bool markers_are_dominant = false,
+                bool validate = true);
         void init_from_yaml_stream(
                 std::istream& stream,
                 const std::string& path,
@@ -166,6 +327,13 @@ class BiallelicData {
                 char population_name_delimiter) const;
         void write_charsets(
                 std::ostream& out) const;
+        /**
+         * Write the rows of the alignment implied by the patterns.
+         *
+         * Rows are written one at a time straight from the allele counts of
+         * each pattern (and, for linked data, the site to pattern index), so
+         * the full alignment returned by get_alignment is never built.
+         */
         void write_alignment(
                 std::ostream& out,
                 char population_name_delimiter) const;
@@ -184,7 +352,7 @@ class BiallelicData {
         const std::vector<unsigned int>& get_pattern_weights() const {
             return this->pattern_weights_;
         }
-        const std::vector<unsigned int>& get_contiguous_pattern_indices() const {
+        const SitePatternIndex& get_contiguous_pattern_indices() const {
             return this->contiguous_pattern_indices_;
         }
         const std::vector<unsigned int>& get_locus_end_indices() const {
@@ -271,10 +439,28 @@ class BiallelicData {
 
         bool storing_seq_loci_info_ = false;
         std::vector<unsigned int> locus_end_indices_;
-        std::vector<unsigned int> contiguous_pattern_indices_;
+        SitePatternIndex contiguous_pattern_indices_;
 
         //Methods
+        void get_alignment_row_states(
+                unsigned int population_index,
+                unsigned int row_index,
+                std::vector<char> & pattern_states) const;
+        void write_alignment_row(
+                std::ostream& out,
+                const std::vector<char> & pattern_states,
+                std::string & buffer) const;
         void remove_pattern(unsigned int pattern_index);
+        void remove_patterns(const std::vector<bool> & removing_pattern);
+        void get_pattern_key(
+                const std::vector<unsigned int> & red_allele_counts,
+                const std::vector<unsigned int> & allele_counts,
+                std::vector<unsigned int> & key) const;
+        void get_mirrored_pattern_key(
+                unsigned int pattern_index,
+                std::vector<unsigned int> & key) const;
+        void get_pattern_index_map(
+                std::map<std::vector<unsigned int>, unsigned int> & pattern_index_map) const;
         void update_has_missing_population_patterns();
         void update_has_missing_patterns();
         void update_has_constant_patterns();
@@ -289,22 +475,39 @@ class BiallelicData {
         void remove_first_missing_pattern(
                 bool& was_removed,
                 unsigned int& removed_index);
-        void fold_first_mirrored_pattern(
-                bool& was_folded,
-                unsigned int& folded_index);
         
+        void init_populations(
+                const std::vector<std::string> & taxon_labels,
+                char population_name_delimiter,
+                bool population_name_is_prefix,
+                std::vector<unsigned int> & taxon_population_indices);
+        bool vet_data_type(
+                NxsCharactersBlock::DataTypesEnum data_type,
+                NxsDiscreteStateCell highest_state_code) const;
+        void tally_site_block(
+                const NxsDiscreteStateCell * block_cells,
+                const std::vector<std::string> & taxon_labels,
+                const std::vector<unsigned int> & taxon_population_indices,
+                const std::vector<unsigned int> & code_state_counts,
+                const std::vector< std::vector<NxsDiscreteStateCell> > & code_states,
+                const bool nucleotide_data,
+                const unsigned int first_site_index,
+                const unsigned int number_of_sites,
+                BiallelicPatternTally & tally) const;
+        void tally_nexus_site_patterns(
+                const NxsCharactersBlock * char_block,
+                const std::vector<std::string> & taxon_labels,
+                const std::vector<unsigned int> & taxon_population_indices,
+                const std::vector<unsigned int> & code_state_counts,
+                const std::vector< std::vector<NxsDiscreteStateCell> > & code_states,
+                const bool nucleotide_data,
+                const unsigned int first_site_index,
+                const unsigned int end_site_index,
+                BiallelicPatternTally & tally) const;
+        void merge_pattern_tallies(
+                const std::vector<BiallelicPatternTally> & tallies);
+
         void parse_yaml_data(std::istream& yaml_stream, bool validate = true);
-        void parse_yaml_top_level(const YAML::Node& top_level_node);
-        void parse_yaml_marker_dominance(const YAML::Node& node);
-        void parse_yaml_population_labels(const YAML::Node& node);
-        void parse_yaml_pattern_weights(const YAML::Node& node);
-        void parse_yaml_all_allele_count_patterns(const YAML::Node& node);
-        void parse_yaml_allele_count_pattern(const YAML::Node& node,
-                std::vector<unsigned int> & red_allele_counts,
-                std::vector<unsigned int> & allele_counts);
-        void parse_yaml_allele_count(const YAML::Node& node,
-                std::vector<unsigned int> & red_allele_counts,
-                std::vector<unsigned int> & allele_counts);
 };
 
 #endif
@@ -25,7 +25,7 @@ void write_dpprobs_splash(std::ostream& out) {
     v += PROJECT_DETAILED_VERSION;
     out << string_util::banner('=') << "\n" 
         << string_util::center("DPprobs") << "\n"
-        << string_util::center("Simulating Dirichlet process probabilities") << "\n\n"
+        << string_util::center("Dirichlet process probabilities") << "\n\n"
         << string_util::center("Part of:") << "\n"
         << string_util::center(PROJECT_NAME) << "\n"
         << string_util::center(v) << "\n"
@@ -45,7 +45,7 @@ int dpprobs_main(int argc, char * argv[]) {
     const std::string version = version_ss.str();
 
     const std::string description =
-        "DPprobs: Simulating Dirichlet Process probabilites";
+        "DPprobs: Dirichlet Process probabilites";
     // const std::string epilog =
     //     "Epilog goes here...";
 
@@ -59,13 +59,22 @@ int dpprobs_main(int argc, char * argv[]) {
             .action("store")
             .type("long")
             .dest("seed")
-            .help("Seed for random number generator. Default: Set from clock.");
+            .help("Seed for random number generator. Only used with "
+                  "\'--simulate\'. Default: Set from clock.");
     parser.add_option("-n", "--number-of-samples")
             .action("store")
             .type("unsigned int")
             .dest("number_of_samples")
             .set_default("100000")
-            .help("Number of simulation samples. Default: 100000.");
+            .help("Number of simulation samples. Only used with "
+                  "\'--simulate\'. Default: 100000.");
+    parser.add_option("--simulate")
+            .action("store_true")
+            .dest("simulate")
+            .help("Approximate the probabilities by simulating from the "
+                  "process. By default, the probabilities are calculated "
+                  "exactly, integrating over any priors on the concentration "
+                  "and discount parameters numerically.");
     parser.add_option("-p", "--parameter").choices({"concentration", "mean"})
             .dest("parameter")
             .set_default("mean")
@@ -291,8 +300,11 @@ int dpprobs_main(int argc, char * argv[]) {
     else {
         throw EcoevolityError("Unexpected model prior.");
     }
-    std::cerr << "Seed = " << seed << std::endl;
-    std::cerr << "Number of samples = " << nreps << std::endl;
+    const bool simulating = options.get("simulate");
+    if (simulating) {
+        std::cerr << "Seed = " << seed << std::endl;
+        std::cerr << "Number of samples = " << nreps << std::endl;
+    }
     std::cerr << "Number of elements = " << number_of_elements << std::endl;
     if (concentration_is_fixed) {
         std::cerr << "Concentration = " << concentration << std::endl;
@@ -318,43 +330,76 @@ int dpprobs_main(int argc, char * argv[]) {
     time_t finish;
     time(&start);
 
-    unsigned int total = 0;
-    std::vector<unsigned int> elements (number_of_elements, 0);
-    std::map<unsigned int, unsigned int> number_of_categories_counts;
-    for (unsigned int i = 1; i <= number_of_elements; ++i) {
-        number_of_categories_counts[i] = 0;
-    }
-    unsigned int number_of_categories;
-    for (unsigned int i = 0; i < nreps; ++i) {
-        if (! concentration_is_fixed) {
-            concentration = rng.gamma(shape, scale);
+    if (! simulating) {
+        HyperpriorQuadrature concentration_quadrature =
+                concentration_is_fixed ?
+                HyperpriorQuadrature(concentration) :
+                HyperpriorQuadrature(gamma_concentration);
+        HyperpriorQuadrature discount_quadrature =
+                discount_is_fixed ?
+                HyperpriorQuadrature(discount) :
+                HyperpriorQuadrature(beta_dist_discount);
+        ModelPriorProbabilities prior_probs(number_of_elements,
+                model_prior,
+                concentration_quadrature,
+                discount_quadrature);
+        if ((! concentration_is_fixed) || (! discount_is_fixed)) {
+            std::cerr << "Mean number of categories integrated over priors = "
+                      << prior_probs.get_expected_number_of_categories()
+                      << std::endl;
         }
-        if (! discount_is_fixed) {
-            discount = rng.beta(discount_alpha, discount_beta);
+
+        std::cerr << "\nProbabilities of the number of categories:\n";
+        std::cerr << string_util::banner('-') << "\n";
+        for (unsigned int k = 1; k <= number_of_elements; ++k) {
+            std::cout << "p(ncats = "
+                      << std::setw(ncats_padding) << std::right << k
+                      << ") = "
+                      << std::setw(12) << std::left
+                      << prior_probs.get_number_of_categories_probability(k)
+                      << " (n = " << stirling2_float(number_of_elements, k)
+                      << ")\n";
         }
-        number_of_categories = rng.pitman_yor_process(elements, concentration, discount);
-        ++number_of_categories_counts[number_of_categories];
-        total += number_of_categories;
     }
+    else {
+        unsigned int total = 0;
+        std::vector<unsigned int> elements (number_of_elements, 0);
+        std::map<unsigned int, unsigned int> number_of_categories_counts;
+        for (unsigned int i = 1; i <= number_of_elements; ++i) {
+            number_of_categories_counts[i] = 0;
+        }
+        unsigned int number_of_categories;
+        for (unsigned int i = 0; i < nreps; ++i) {
+            if (! concentration_is_fixed) {
+                concentration = rng.gamma(shape, scale);
+            }
+            if (! discount_is_fixed) {
+                discount = rng.beta(discount_alpha, discount_beta);
+            }
+            number_of_categories = rng.pitman_yor_process(elements, concentration, discount);
+            ++number_of_categories_counts[number_of_categories];
+            total += number_of_categories;
+        }
 
-    double sample_mean_ncats = (double)total / (double)nreps;
-    std::cerr << "Sample mean number of categories = " << sample_mean_ncats << std::endl;
+        double sample_mean_ncats = (double)total / (double)nreps;
+        std::cerr << "Sample mean number of categories = " << sample_mean_ncats << std::endl;
 
-    unsigned int tally = 0;
-    for (auto const & kv: number_of_categories_counts) {
-        tally += kv.second;
-    }
-    ECOEVOLITY_ASSERT(tally == nreps);
+        unsigned int tally = 0;
+        for (auto const & kv: number_of_categories_counts) {
+            tally += kv.second;
+        }
+        ECOEVOLITY_ASSERT(tally == nreps);
 
-    std::cerr << "\nEstimated probabilities of the number of categories:\n";
-    std::cerr << string_util::banner('-') << "\n";
-    for (auto const & kv: number_of_categories_counts) {
-        std::cout << "p(ncats = "
-                  << std::setw(ncats_padding) << std::right << kv.first
-                  << ") = "
-                  << std::setw(12) << std::left << kv.second / (double)nreps
-                  << " (n = " << stirling2_float(number_of_elements, kv.first)
-                  << ")\n";
+        std::cerr << "\nEstimated probabilities of the number of categories:\n";
+        std::cerr << string_util::banner('-') << "\n";
+        for (auto const & kv: number_of_categories_counts) {
+            std::cout << "p(ncats = "
+                      << std::setw(ncats_padding) << std::right << kv.first
+                      << ") = "
+                      << std::setw(12) << std::left << kv.second / (double)nreps
+                      << " (n = " << stirling2_float(number_of_elements, kv.first)
+                      << ")\n";
+        }
     }
     std::cerr << string_util::banner('-') << "\n\n";
 
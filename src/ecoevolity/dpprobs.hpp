@@ -32,6 +32,7 @@
 #include "probability.hpp"
 #include "string_util.hpp"
 #include "options.hpp"
+#include "model_prior_probability.hpp"
 
 
 void write_dpprobs_splash(std::ostream& out);
@@ -78,10 +78,12 @@ int ecoevolity_main(int argc, char * argv[]) {
             .type("unsigned int")
             .dest("nthreads")
             .set_default("1")
-            .help("Number of threads to use for likelihood calculations. "
+            .help("Number of threads to use for loading the alignments "
+                  "and for likelihood calculations. "
                   "Default: 1 (no multithreading). If you are using "
                   "the \'--ignore-data\' option, no likelihood calculations "
-                  "will be performed, and so no multithreading is used.");
+                  "will be performed, and so multithreading is only used "
+                  "for loading the alignments.");
 #endif
     parser.add_option("--prefix")
             .action("store")
@@ -168,11 +170,14 @@ int ecoevolity_main(int argc, char * argv[]) {
         throw EcoevolityError("Too many arguments; only one config file is allowed");
     }
     const std::string config_path = args.at(0);
-    if (! path::exists(config_path)) {
+    // The config can also be that of a replicate in a simulation archive
+    // written by simcoevolity
+    const bool config_is_archived = sim_archive::is_member_path(config_path);
+    if ((! config_is_archived) && (! path::exists(config_path))) {
         throw EcoevolityError("Config file \'" + config_path +
                 "\' does not exist");
     }
-    if (! path::isfile(config_path)) {
+    if ((! config_is_archived) && (! path::isfile(config_path))) {
         throw EcoevolityError("Config path \'" + config_path +
                 "\' is not a regular file");
     }
@@ -191,7 +196,9 @@ int ecoevolity_main(int argc, char * argv[]) {
             rng,
             strict_on_constant_sites,
             strict_on_missing_sites,
-            strict_on_triallelic_sites);
+            strict_on_triallelic_sites,
+            false, // store_seq_loci_info
+            nthreads);
 
     if (ignore_data) {
         comparisons.ignore_data();
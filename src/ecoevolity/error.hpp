@@ -220,6 +220,17 @@ class EcoevolityYamlDataError: public EcoevolityBaseError {
             EcoevolityBaseError("EcoevolityYamlDataError", message, file_path) { }
 };
 
+class EcoevolitySimulationArchiveError: public EcoevolityBaseError {
+    public:
+        EcoevolitySimulationArchiveError(
+                const std::string & message) :
+            EcoevolityBaseError("EcoevolitySimulationArchiveError", message) { }
+        EcoevolitySimulationArchiveError(
+                const std::string & message,
+                const std::string & file_path) :
+            EcoevolityBaseError("EcoevolitySimulationArchiveError", message, file_path) { }
+};
+
 class EcoevolitySpreadsheetError: public EcoevolityBaseError {
     public:
         EcoevolitySpreadsheetError(
@@ -0,0 +1,419 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_FLAT_GENE_TREE_HPP
+#define ECOEVOLITY_FLAT_GENE_TREE_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+#include "rng.hpp"
+#include "assert.hpp"
+
+
+/**
+ * Gene tree stored as flat arrays, for simulating data.
+ *
+ * Nodes are identified by their position in the arrays. A node is always
+ * added after its children, so the last node is the root and iterating
+ * backward over the nodes visits every parent before its children. The
+ * arrays keep their capacity when the tree is cleared, so one instance can
+ * be reused for every site (or locus) of a simulated dataset without
+ * allocating.
+ *
+ * The tree also holds the buffers of uncoalesced lineages for each branch of
+ * the population tree, indexed by the population node index, which are
+ * reused in the same way.
+ *
+ * Linked sites that share the gene tree can be simulated in blocks of up to
+ * 64 sites, with the states of each node packed into one 64-bit word (bit
+ * 'i' is site 'i' of the block). The red allele counts of each population
+ * are then tallied for the whole block with bit-sliced counters.
+ */
+class FlatGeneTree {
+    private:
+        std::vector<int> parents_;
+        std::vector<double> heights_;
+        std::vector<int> population_indices_;
+        std::vector<int> character_states_;
+        // Probability of a change along the branch above each node, scaled
+        // by the stationary frequency of the state being changed to
+        std::vector<double> change_probabilities_;
+        std::vector<unsigned int> leaves_;
+        std::vector< std::vector<unsigned int> > branch_lineages_;
+        double freq_0_ = 0.5;
+
+        // State of a block of linked sites for each node
+        std::vector<uint64_t> character_blocks_;
+        // Bit-sliced red allele counts of each population for the block;
+        // word 'b' holds bit 'b' of the count of every site
+        std::vector< std::vector<uint64_t> > red_count_planes_;
+        std::vector<unsigned int> block_allele_counts_;
+        std::vector<uint64_t> pending_individual_;
+        std::vector<bool> has_pending_individual_;
+        unsigned int block_size_ = 0;
+        unsigned int block_position_ = 0;
+
+        /**
+         * Draw a word in which each of the first 'number_of_bits' bits is
+         * set with probability 'p'.
+         *
+         * The gaps between set bits are geometric, so only one uniform
+         * deviate is needed per set bit (plus one), rather than one per bit.
+         */
+        static uint64_t draw_bernoulli_word(
+                const double p,
+                const unsigned int number_of_bits,
+                RandomNumberGenerator & rng) {
+            const uint64_t all_bits = (number_of_bits >= 64) ?
+                    ~((uint64_t)0) :
+                    ((((uint64_t)1) << number_of_bits) - 1);
+            if (p <= 0.0) {
+                return 0;
+            }
+            if (p >= 1.0) {
+                return all_bits;
+            }
+            if (p > 0.5) {
+                return all_bits & ~FlatGeneTree::draw_bernoulli_word(
+                        1.0 - p, number_of_bits, rng);
+            }
+            const double log_q = std::log1p(-p);
+            uint64_t word = 0;
+            unsigned int position = 0;
+            while (position < number_of_bits) {
+                double gap = std::floor(std::log(rng.uniform_real()) / log_q);
+                if (gap >= (double)(number_of_bits - position)) {
+                    break;
+                }
+                position += (unsigned int)gap;
+                word |= ((uint64_t)1) << position;
+                ++position;
+            }
+            return word;
+        }
+
+        void add_to_red_count(unsigned int population_index, uint64_t word) {
+            std::vector<uint64_t> & planes = this->red_count_planes_[population_index];
+            for (unsigned int b = 0; (b < planes.size()) && (word != 0); ++b) {
+                uint64_t carry = planes[b] & word;
+                planes[b] ^= word;
+                word = carry;
+            }
+            if (word != 0) {
+                planes.push_back(word);
+            }
+        }
+
+    public:
+        FlatGeneTree() { }
+
+        void clear(unsigned int number_of_branches) {
+            this->parents_.clear();
+            this->heights_.clear();
+            this->population_indices_.clear();
+            this->character_states_.clear();
+            this->change_probabilities_.clear();
+            this->leaves_.clear();
+            this->block_size_ = 0;
+            this->block_position_ = 0;
+            if (this->branch_lineages_.size() < number_of_branches) {
+                this->branch_lineages_.resize(number_of_branches);
+            }
+            for (auto & lineages : this->branch_lineages_) {
+                lineages.clear();
+            }
+        }
+
+        unsigned int get_node_count() const {
+            return this->parents_.size();
+        }
+        unsigned int get_leaf_node_count() const {
+            return this->leaves_.size();
+        }
+        unsigned int get_root_index() const {
+            ECOEVOLITY_ASSERT(this->parents_.size() > 0);
+            return this->parents_.size() - 1;
+        }
+
+        int get_parent(unsigned int node_index) const {
+            return this->parents_.at(node_index);
+        }
+        double get_height(unsigned int node_index) const {
+            return this->heights_.at(node_index);
+        }
+        int get_population_index(unsigned int node_index) const {
+            return this->population_indices_.at(node_index);
+        }
+        int get_character_state(unsigned int node_index) const {
+            return this->character_states_.at(node_index);
+        }
+        const std::vector<unsigned int> & get_leaves() const {
+            return this->leaves_;
+        }
+
+        std::vector<unsigned int> & get_branch_lineages(unsigned int branch_index) {
+            return this->branch_lineages_.at(branch_index);
+        }
+
+        unsigned int add_leaf(int population_index, double height = 0.0) {
+            unsigned int idx = this->parents_.size();
+            this->parents_.push_back(-1);
+            this->heights_.push_back(height);
+            this->population_indices_.push_back(population_index);
+            this->leaves_.push_back(idx);
+            return idx;
+        }
+
+        unsigned int add_parent(
+                unsigned int child1,
+                unsigned int child2,
+                double height,
+                int population_index) {
+            unsigned int idx = this->parents_.size();
+            ECOEVOLITY_ASSERT(child1 < idx);
+            ECOEVOLITY_ASSERT(child2 < idx);
+            ECOEVOLITY_ASSERT(this->parents_[child1] < 0);
+            ECOEVOLITY_ASSERT(this->parents_[child2] < 0);
+            this->parents_.push_back(-1);
+            this->heights_.push_back(height);
+            this->population_indices_.push_back(population_index);
+            this->parents_[child1] = idx;
+            this->parents_[child2] = idx;
+            return idx;
+        }
+
+        /**
+         * Compute the transition probabilities of the CTMC for a binary
+         * character along every branch.
+         *
+         * These only depend on the gene tree, so for linked sites they only
+         * need to be computed once per locus.
+         */
+        void compute_binary_transition_probabilities(
+                const double u,
+                const double v) {
+            this->freq_0_ = u / (u + v);
+            unsigned int nnodes = this->parents_.size();
+            this->change_probabilities_.resize(nnodes);
+            this->character_states_.resize(nnodes);
+            for (unsigned int i = 0; i < nnodes; ++i) {
+                int parent = this->parents_[i];
+                if (parent < 0) {
+                    this->change_probabilities_[i] = 0.0;
+                    continue;
+                }
+                double t = this->heights_[parent] - this->heights_[i];
+                this->change_probabilities_[i] = 1.0 - std::exp(-(u + v) * t);
+            }
+            this->block_size_ = 0;
+            this->block_position_ = 0;
+        }
+
+        /**
+         * Draw the character state of every node, from the root to the
+         * leaves.
+         */
+        void simulate_binary_character(RandomNumberGenerator & rng) {
+            ECOEVOLITY_ASSERT(this->change_probabilities_.size() == this->parents_.size());
+            const double freq_0 = this->freq_0_;
+            const double freq_1 = 1.0 - freq_0;
+            for (int i = (int)this->parents_.size() - 1; i >= 0; --i) {
+                double u = rng.uniform_real();
+                int parent = this->parents_[i];
+                if (parent < 0) {
+                    this->character_states_[i] = (u < freq_0) ? 0 : 1;
+                    continue;
+                }
+                double r = this->change_probabilities_[i];
+                if (this->character_states_[parent] == 0) {
+                    this->character_states_[i] = (u < (1.0 - (freq_1 * r))) ? 0 : 1;
+                }
+                else {
+                    this->character_states_[i] = (u < (freq_0 * r)) ? 0 : 1;
+                }
+            }
+        }
+
+        void get_allele_counts(
+                std::vector<unsigned int>& allele_counts,
+                std::vector<unsigned int>& red_allele_counts) const {
+            for (auto leaf : this->leaves_) {
+                int pop_idx = this->population_indices_[leaf];
+                ++allele_counts.at(pop_idx);
+                if (this->character_states_[leaf] == 1) {
+                    ++red_allele_counts.at(pop_idx);
+                }
+            }
+        }
+
+        /**
+         * Allele counts for dominant markers.
+         *
+         * The leaves of each population are added consecutively, so each
+         * pair of consecutive leaves of a population is treated as the two
+         * gene copies of one individual.
+         */
+        void get_allele_counts(
+                std::vector<unsigned int>& allele_counts,
+                std::vector<unsigned int>& red_allele_counts,
+                std::vector<int>& last_allele) const {
+            for (auto leaf : this->leaves_) {
+                int pop_idx = this->population_indices_[leaf];
+                int state = this->character_states_[leaf];
+                if (last_allele.at(pop_idx) < 0) {
+                    last_allele.at(pop_idx) = state;
+                    continue;
+                }
+                if ((last_allele.at(pop_idx) == 1) || (state == 1)) {
+                    ++red_allele_counts.at(pop_idx);
+                }
+                ++allele_counts.at(pop_idx);
+                last_allele.at(pop_idx) = -1;
+            }
+        }
+
+        /**
+         * Draw the character states of every node for a block of
+         * 'number_of_sites' (at most 64) linked sites, and tally the red
+         * allele counts of each population for every site of the block.
+         *
+         * Along each branch, a site changes with probability 1 - exp(-(u+v)t)
+         * and, when it does, its new state is drawn from the stationary
+         * frequencies. This is the same process as
+         * simulate_binary_character, but only the sites that change need a
+         * random deviate.
+         */
+        void simulate_binary_character_block(
+                RandomNumberGenerator & rng,
+                unsigned int number_of_sites,
+                bool markers_are_dominant = false) {
+            ECOEVOLITY_ASSERT(this->change_probabilities_.size() == this->parents_.size());
+            ECOEVOLITY_ASSERT(number_of_sites > 0);
+            if (number_of_sites > 64) {
+                number_of_sites = 64;
+            }
+            const double freq_1 = 1.0 - this->freq_0_;
+            const unsigned int nnodes = this->parents_.size();
+            this->character_blocks_.resize(nnodes);
+            for (int i = (int)nnodes - 1; i >= 0; --i) {
+                int parent = this->parents_[i];
+                if (parent < 0) {
+                    this->character_blocks_[i] = FlatGeneTree::draw_bernoulli_word(
+                            freq_1, number_of_sites, rng);
+                    continue;
+                }
+                uint64_t changes = FlatGeneTree::draw_bernoulli_word(
+                        this->change_probabilities_[i], number_of_sites, rng);
+                uint64_t parent_states = this->character_blocks_[parent];
+                if (changes == 0) {
+                    this->character_blocks_[i] = parent_states;
+                    continue;
+                }
+                // Draw the new state only for the sites that changed
+                uint64_t new_states = 0;
+                uint64_t remaining = changes;
+                while (remaining != 0) {
+                    uint64_t lowest = remaining & (~remaining + 1);
+                    if (rng.uniform_real() < freq_1) {
+                        new_states |= lowest;
+                    }
+                    remaining ^= lowest;
+                }
+                this->character_blocks_[i] = (parent_states & ~changes) |
+                        (new_states & changes);
+            }
+
+            unsigned int npops = 0;
+            for (auto leaf : this->leaves_) {
+                if ((unsigned int)this->population_indices_[leaf] >= npops) {
+                    npops = this->population_indices_[leaf] + 1;
+                }
+            }
+            if (this->red_count_planes_.size() < npops) {
+                this->red_count_planes_.resize(npops);
+            }
+            for (auto & planes : this->red_count_planes_) {
+                planes.clear();
+            }
+            this->block_allele_counts_.assign(npops, 0);
+            this->pending_individual_.assign(npops, 0);
+            this->has_pending_individual_.assign(npops, false);
+            for (auto leaf : this->leaves_) {
+                int pop_idx = this->population_indices_[leaf];
+                uint64_t states = this->character_blocks_[leaf];
+                if (markers_are_dominant) {
+                    // Consecutive gene copies of a population are the two
+                    // copies of an individual, which is red if either is
+                    if (! this->has_pending_individual_[pop_idx]) {
+                        this->pending_individual_[pop_idx] = states;
+                        this->has_pending_individual_[pop_idx] = true;
+                        continue;
+                    }
+                    states |= this->pending_individual_[pop_idx];
+                    this->has_pending_individual_[pop_idx] = false;
+                }
+                ++this->block_allele_counts_[pop_idx];
+                this->add_to_red_count(pop_idx, states);
+            }
+            this->block_size_ = number_of_sites;
+            this->block_position_ = 0;
+        }
+
+        unsigned int get_number_of_block_sites_remaining() const {
+            return this->block_size_ - this->block_position_;
+        }
+
+        /**
+         * Add the allele counts of the next site of the current block to
+         * 'allele_counts' and 'red_allele_counts', and move on to the
+         * following site.
+         */
+        void get_next_block_site_allele_counts(
+                std::vector<unsigned int>& allele_counts,
+                std::vector<unsigned int>& red_allele_counts) {
+            ECOEVOLITY_ASSERT(this->block_position_ < this->block_size_);
+            const unsigned int site = this->block_position_;
+            for (unsigned int pop_idx = 0;
+                    pop_idx < this->block_allele_counts_.size();
+                    ++pop_idx) {
+                const std::vector<uint64_t> & planes = this->red_count_planes_[pop_idx];
+                unsigned int count = 0;
+                for (unsigned int b = 0; b < planes.size(); ++b) {
+                    count |= (unsigned int)((planes[b] >> site) & 1) << b;
+                }
+                allele_counts.at(pop_idx) += this->block_allele_counts_[pop_idx];
+                red_allele_counts.at(pop_idx) += count;
+            }
+            ++this->block_position_;
+        }
+
+        /**
+         * State of a node at a site of the current block.
+         */
+        int get_block_character_state(
+                unsigned int node_index,
+                unsigned int site_index) const {
+            ECOEVOLITY_ASSERT(site_index < this->block_size_);
+            return (int)((this->character_blocks_.at(node_index) >> site_index) & 1);
+        }
+};
+
+#endif
@@ -2089,8 +2089,6 @@ class NeighborHeightNodeSwapAll : public NeighborHeightNodeSwap<TreeType> {
 template<class TreeType>
 class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeType, Op> {
     protected:
-        std::unordered_map<unsigned int, long double> stirling2_numbers;
-        std::unordered_map<unsigned int, long double> bell_numbers;
         double beta_a_ = 1.0;
         double beta_b_ = 1.0;
 
@@ -2124,18 +2122,19 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
             return BaseGeneralTreeOperatorTemplate::OperatorScopeEnum::topology;
         }
 
-        double get_stirling2(unsigned int n) {
-            if (this->stirling2_numbers.count(n) < 1) {
-                this->stirling2_numbers[n] = stirling2_float(n, 2);
-            }
-            return this->stirling2_numbers[n];
+        // Stirling and Bell numbers come from the shared log-space table, so
+        // they do not overflow for large trees
+        double get_ln_stirling2(unsigned int n) const {
+            return ln_stirling2(n, 2);
         }
 
-        long double get_bell_number(unsigned int n) {
-            if (this->bell_numbers.count(n) < 1) {
-                this->bell_numbers[n] = bell_float(n);
-            }
-            return this->bell_numbers[n];
+        double get_ln_bell_number(unsigned int n) const {
+            return ln_bell_number(n);
+        }
+
+        // ln(x + c) from ln(x)
+        static double get_ln_plus_constant(double ln_x, double c) {
+            return ln_x + std::log1p(c * std::exp(-ln_x));
         }
 
         bool is_operable(TreeType * tree) const {
@@ -2466,8 +2465,8 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
             if (number_of_mapped_nodes == 1) {
                 // We have the special case of only a single polytomy
                 ECOEVOLITY_ASSERT(moving_polytomy_sizes.size() == 1);
-                double ln_bell_num_minus_2 = std::log(
-                        this->get_bell_number(moving_polytomy_sizes.at(0)) - 2.0);
+                double ln_bell_num_minus_2 = this->get_ln_plus_constant(
+                        this->get_ln_bell_number(moving_polytomy_sizes.at(0)), -2.0);
                 ln_hastings =
                         std::log(number_of_splittable_heights) +
                         ln_bell_num_minus_2;
@@ -2477,7 +2476,7 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
             }
             else if (! mapped_nodes_include_polytomy) {
                 // We have multiple bifurcating nodes mapped to height
-                double ln_stirling2 = std::log(this->get_stirling2(number_of_mapped_nodes));
+                double ln_stirling2 = this->get_ln_stirling2(number_of_mapped_nodes);
                 ln_hastings =
                         std::log(number_of_splittable_heights) +
                         std::log(2.0) +
@@ -2489,33 +2488,15 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
             else {
                 // We have multiple nodes mapped to height and some are
                 // polytomies
-                bool hit_overflow = false;
-                long double long_double_max = std::numeric_limits<long double>::max();
-                long double stirl2_term = this->get_stirling2(number_of_mapped_nodes);
-                // Check for multiplication overflow
-                if (2.0 > (long_double_max / stirl2_term)) {
-                    hit_overflow = true;
-                } else {
-                    stirl2_term *= 2.0;
-                }
-                // Check for addition overflow
-                if (stirl2_term > (long_double_max - 1.0)) {
-                    hit_overflow = true;
-                } else {
-                    stirl2_term += 1.0;
-                }
-                double ln_stirling2_term;
-                if (hit_overflow) {
-                    // If we hit overflow, we will ignore the tiny plus 1 to 
-                    // (2 * Stirling)
-                    ln_stirling2_term = std::log(2.0) + std::log(this->get_stirling2(number_of_mapped_nodes));
-                } else {
-                    ln_stirling2_term = std::log(stirl2_term);
-                }
+                // ln((2 * Stirling) + 1)
+                double ln_stirling2_term = this->get_ln_plus_constant(
+                        std::log(2.0) + this->get_ln_stirling2(number_of_mapped_nodes),
+                        1.0);
 
                 double ln_bell_num_minus_1_sum = 0.0;
                 for (auto polytomy_size : moving_polytomy_sizes) {
-                    ln_bell_num_minus_1_sum += std::log(this->get_bell_number(polytomy_size) - 1.0);
+                    ln_bell_num_minus_1_sum += this->get_ln_plus_constant(
+                            this->get_ln_bell_number(polytomy_size), -1.0);
                 }
                 double ln_bell_term = ln_bell_num_minus_1_sum;
 
@@ -2525,25 +2506,8 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
                     // we need to account for the case we reject where none of
                     // the polytomies get broken up (i.e., all node simply
                     // slide down and no parameter is added to model).
-                    hit_overflow = false;
-                    long double bell_num_minus_1_prod = 1.0;
-                    for (auto polytomy_size : moving_polytomy_sizes) {
-                        // Check for multiplication overflow
-                        long double bell_minus_1 = this->get_bell_number(polytomy_size) - 1.0;
-                        if (bell_minus_1 > (long_double_max / bell_num_minus_1_prod)) {
-                            hit_overflow = true;
-                            break;
-                        }
-                        bell_num_minus_1_prod *= bell_minus_1;
-                    }
-                    // If we overflowed, we will use ln_bell_num_minus_1_sum,
-                    // because the minus 1 from the product will be tiny
-                    // TODO: We could probably be less conservative and use
-                    // ln_bell_num_minus_1_sum when the bell_num_minus_1_prod
-                    // gets to a threshold much smaller than the numeric limit.
-                    if (! hit_overflow) {
-                        ln_bell_term = std::log(bell_num_minus_1_prod - 1.0);
-                    }
+                    ln_bell_term = this->get_ln_plus_constant(
+                            ln_bell_num_minus_1_sum, -1.0);
                 }
                 ln_hastings =
                         std::log(number_of_splittable_heights) +
@@ -2696,11 +2660,12 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
                         ln_density_of_rev_height;
                 ln_hastings -=
                         (std::log(post_num_splittable_heights) +
-                        std::log(this->get_bell_number(num_polytomy_children) - 2.0));
+                        this->get_ln_plus_constant(
+                            this->get_ln_bell_number(num_polytomy_children), -2.0));
             }
             else if (post_num_mapped_poly_nodes < 1) {
                 // Only shared bifurcating nodes
-                double ln_stirling2_num = std::log(this->get_stirling2(post_num_mapped_nodes));
+                double ln_stirling2_num = this->get_ln_stirling2(post_num_mapped_nodes);
                 ln_hastings =
                         std::log(num_heights - 1) +
                         ln_prob_of_drawing_old_node_states +
@@ -2712,34 +2677,15 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
             }
             // We have shared nodes that include at least on polytomy
             else {
-                bool hit_overflow = false;
-                long double long_double_max = std::numeric_limits<long double>::max();
-                long double stirl2_term = this->get_stirling2(post_num_mapped_nodes);
-                // Check for multiplication overflow
-                if (2.0 > (long_double_max / stirl2_term)) {
-                    hit_overflow = true;
-                } else {
-                    stirl2_term *= 2.0;
-                }
-                // Check for addition overflow
-                if (stirl2_term > (long_double_max - 1.0)) {
-                    hit_overflow = true;
-                } else {
-                    stirl2_term += 1.0;
-                }
-                double ln_stirling2_term;
-                if (hit_overflow) {
-                    // If we hit overflow, we will ignore the tiny plus 1 to 
-                    // (2 * Stirling)
-                    ln_stirling2_term = std::log(2.0) + std::log(this->get_stirling2(post_num_mapped_nodes));
-                } else {
-                    ln_stirling2_term = std::log(stirl2_term);
-                }
+                // ln((2 * Stirling) + 1)
+                double ln_stirling2_term = this->get_ln_plus_constant(
+                        std::log(2.0) + this->get_ln_stirling2(post_num_mapped_nodes),
+                        1.0);
 
                 double ln_bell_num_minus_1_sum = 0.0;
                 for (auto poly_size : sizes_of_mapped_polytomies_after_merge) {
-                    ln_bell_num_minus_1_sum += std::log(
-                            this->get_bell_number(poly_size) - 1.0);
+                    ln_bell_num_minus_1_sum += this->get_ln_plus_constant(
+                            this->get_ln_bell_number(poly_size), -1.0);
                 }
                 double ln_bell_term = ln_bell_num_minus_1_sum;
 
@@ -2750,25 +2696,8 @@ class SplitLumpNodesRevJumpSampler : public GeneralTreeOperatorInterface<TreeTyp
                     // case we reject where none of the polytomies get broken
                     // up (i.e., all node simply slide down and no parameter is
                     // added to model).
-                    hit_overflow = false;
-                    long double bell_num_minus_1_prod = 1.0;
-                    for (auto poly_size : sizes_of_mapped_polytomies_after_merge) {
-                        // Check for multiplication overflow
-                        long double bell_minus_1 = this->get_bell_number(poly_size) - 1.0;
-                        if (bell_minus_1 > (long_double_max / bell_num_minus_1_prod)) {
-                            hit_overflow = true;
-                            break;
-                        }
-                        bell_num_minus_1_prod *= bell_minus_1;
-                    }
-                    // If we overflowed, we will use ln_bell_num_minus_1_sum,
-                    // because the minus 1 from the product will be tiny
-                    // TODO: We could probably be less conservative and use
-                    // ln_bell_num_minus_1_sum when the bell_num_minus_1_prod
-                    // gets to a threshold much smaller than the numeric limit.
-                    if (! hit_overflow) {
-                        ln_bell_term = std::log(bell_num_minus_1_prod - 1.0);
-                    }
+                    ln_bell_term = this->get_ln_plus_constant(
+                            ln_bell_num_minus_1_sum, -1.0);
                 }
                 ln_hastings =
                         std::log(num_heights - 1) +
@@ -25,6 +25,12 @@
 #include <map>
 #include <algorithm>
 #include <numeric>
+#include <limits>
+#include <unordered_map>
+
+#ifdef BUILD_WITH_THREADS
+#include <mutex>
+#endif
 
 #include "assert.hpp"
 #include "error.hpp"
@@ -557,6 +563,137 @@ inline long double bell_float(int n) {
     return bell_number_base<long double>(n);
 }
 
+/**
+ * A shared table of the logs of Stirling numbers of the second kind and Bell
+ * numbers.
+ *
+ * Rows are computed once, in log space, with
+ * S(n, k) = S(n - 1, k - 1) + k S(n - 1, k), and the table grows as larger
+ * numbers of elements are requested, so lookups are O(1) and do not overflow
+ * for any number of elements. The table also keeps the most recent normalizing
+ * constant of the split-weighted uniform model prior for each number of
+ * elements, so the prior is O(1) while the split weight is unchanged.
+ *
+ * There is a single instance, which is guarded by a mutex when built with
+ * threads.
+ */
+class LogStirlingTable {
+    private:
+        // ln_stirling2_[n][k] = ln S(n, k) for 0 <= k <= n
+        std::vector< std::vector<double> > ln_stirling2_;
+        std::vector<double> ln_bell_;
+        // Most recent split weight and log normalizing constant for each
+        // number of elements
+        std::unordered_map<unsigned int, std::pair<double, double> > ln_normalizing_constants_;
+#ifdef BUILD_WITH_THREADS
+        std::mutex mutex_;
+#endif
+
+        LogStirlingTable() {
+            this->ln_stirling2_.push_back({0.0});
+            this->ln_bell_.push_back(0.0);
+        }
+
+        void extend(unsigned int number_of_elements) {
+            const double ninf = -std::numeric_limits<double>::infinity();
+            for (unsigned int n = this->ln_stirling2_.size(); n <= number_of_elements; ++n) {
+                const std::vector<double> & previous = this->ln_stirling2_.back();
+                std::vector<double> row(n + 1, ninf);
+                for (unsigned int k = 1; k <= n; ++k) {
+                    const double a = previous.at(k - 1);
+                    const double b = (k < n) ?
+                            previous.at(k) + std::log((double)k) : ninf;
+                    const double mx = std::max(a, b);
+                    row.at(k) = mx + std::log(std::exp(a - mx) + std::exp(b - mx));
+                }
+                double mx = ninf;
+                for (auto v : row) {
+                    mx = std::max(mx, v);
+                }
+                double sum = 0.0;
+                for (auto v : row) {
+                    sum += std::exp(v - mx);
+                }
+                this->ln_bell_.push_back(mx + std::log(sum));
+                this->ln_stirling2_.push_back(row);
+            }
+        }
+
+    public:
+        LogStirlingTable(const LogStirlingTable &) = delete;
+        LogStirlingTable & operator=(const LogStirlingTable &) = delete;
+
+        static LogStirlingTable & get_instance() {
+            static LogStirlingTable table;
+            return table;
+        }
+
+        /**
+         * ln S(n, k); negative infinity if k > n or k = 0 < n.
+         */
+        double get_ln_stirling2(unsigned int n, unsigned int k) {
+#ifdef BUILD_WITH_THREADS
+            std::lock_guard<std::mutex> lock(this->mutex_);
+#endif
+            if (k > n) {
+                return -std::numeric_limits<double>::infinity();
+            }
+            this->extend(n);
+            return this->ln_stirling2_[n][k];
+        }
+
+        double get_ln_bell_number(unsigned int n) {
+#ifdef BUILD_WITH_THREADS
+            std::lock_guard<std::mutex> lock(this->mutex_);
+#endif
+            this->extend(n);
+            return this->ln_bell_[n];
+        }
+
+        /**
+         * ln sum_k S(n, k) split_weight^(k - 1), the log of the normalizing
+         * constant of the split-weighted uniform prior over the set
+         * partitions of n elements.
+         */
+        double get_ln_uniform_normalizing_constant(
+                unsigned int number_of_elements,
+                double split_weight) {
+            ECOEVOLITY_ASSERT(split_weight > 0.0);
+            ECOEVOLITY_ASSERT(number_of_elements > 0);
+#ifdef BUILD_WITH_THREADS
+            std::lock_guard<std::mutex> lock(this->mutex_);
+#endif
+            auto cached = this->ln_normalizing_constants_.find(number_of_elements);
+            if ((cached != this->ln_normalizing_constants_.end()) &&
+                    (cached->second.first == split_weight)) {
+                return cached->second.second;
+            }
+            this->extend(number_of_elements);
+            const std::vector<double> & row = this->ln_stirling2_[number_of_elements];
+            const double ln_w = std::log(split_weight);
+            double mx = -std::numeric_limits<double>::infinity();
+            for (unsigned int k = 1; k <= number_of_elements; ++k) {
+                mx = std::max(mx, row[k] + ((k - 1) * ln_w));
+            }
+            double sum = 0.0;
+            for (unsigned int k = 1; k <= number_of_elements; ++k) {
+                sum += std::exp(row[k] + ((k - 1) * ln_w) - mx);
+            }
+            const double ln_z = mx + std::log(sum);
+            this->ln_normalizing_constants_[number_of_elements] =
+                    std::make_pair(split_weight, ln_z);
+            return ln_z;
+        }
+};
+
+inline double ln_stirling2(unsigned int n, unsigned int k) {
+    return LogStirlingTable::get_instance().get_ln_stirling2(n, k);
+}
+
+inline double ln_bell_number(unsigned int n) {
+    return LogStirlingTable::get_instance().get_ln_bell_number(n);
+}
+
 template <typename T>
 inline double get_uniform_model_log_prior_probability(
         const unsigned int number_of_elements,
@@ -590,10 +727,13 @@ inline double get_uniform_model_log_prior_probability(
         const unsigned int number_of_elements,
         const unsigned int number_of_categories,
         const double split_weight) {
-    return get_uniform_model_log_prior_probability<long double>(
-            number_of_elements,
-            number_of_categories,
-            split_weight);
+    ECOEVOLITY_ASSERT(split_weight > 0.0);
+    ECOEVOLITY_ASSERT(number_of_elements > 0);
+    ECOEVOLITY_ASSERT(number_of_categories > 0);
+    ECOEVOLITY_ASSERT(number_of_categories <= number_of_elements);
+    return ((number_of_categories - 1) * std::log(split_weight)) -
+            LogStirlingTable::get_instance().get_ln_uniform_normalizing_constant(
+                    number_of_elements, split_weight);
 }
 
 /**
@@ -650,26 +790,14 @@ inline void get_number_of_subset_probs(std::vector<long double> & number_of_subs
     ECOEVOLITY_ASSERT(split_weight > 0.0);
     ECOEVOLITY_ASSERT(number_of_subset_probs.size() > 0);
     unsigned int number_of_elements = number_of_subset_probs.size();
-    long double sum_of_k_weights = 0.0;
-    long double k_weight = 0.0;
-    for (unsigned int i = 0; i < number_of_elements; ++i) {
-        unsigned int k = i + 1;
-        long double number_of_partitions_with_k_subsets = stirling2_base<long double>(number_of_elements, k);
-        long double weight_of_each_partition = std::pow(split_weight, (k - 1));
-        // Check for multiplication overflow
-        if (weight_of_each_partition > (std::numeric_limits<long double>::max() / number_of_partitions_with_k_subsets)) {
-            throw EcoevolityNumericLimitError("Overflow during multiplication in get_number_of_subset_probs");
-        }
-        k_weight = number_of_partitions_with_k_subsets * weight_of_each_partition;
-        number_of_subset_probs.at(i) = k_weight;
-        // Check for addition overflow
-        if (sum_of_k_weights > (std::numeric_limits<long double>::max() - k_weight)) {
-            throw EcoevolityNumericLimitError("Overflow during addition in get_number_of_subset_probs");
-        }
-        sum_of_k_weights += k_weight;
-    }
+    LogStirlingTable & table = LogStirlingTable::get_instance();
+    const double ln_z = table.get_ln_uniform_normalizing_constant(
+            number_of_elements, split_weight);
+    const double ln_w = std::log(split_weight);
     for (unsigned int i = 0; i < number_of_elements; ++i) {
-        number_of_subset_probs.at(i) = number_of_subset_probs.at(i) / sum_of_k_weights;
+        number_of_subset_probs.at(i) = std::exp(
+                table.get_ln_stirling2(number_of_elements, i + 1) +
+                (i * ln_w) - ln_z);
     }
 }
 
@@ -0,0 +1,579 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_MODEL_PRIOR_PROBABILITY_HPP
+#define ECOEVOLITY_MODEL_PRIOR_PROBABILITY_HPP
+
+#include <vector>
+#include <map>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <sstream>
+
+#include "error.hpp"
+#include "assert.hpp"
+#include "options.hpp"
+#include "probability.hpp"
+#include "math_util.hpp"
+
+
+namespace model_prior_probability {
+
+/**
+ * Log of the sum of the exponentials of the values, without overflow.
+ */
+inline double log_sum_exp(const std::vector<double> & ln_values) {
+    double mx = -std::numeric_limits<double>::infinity();
+    for (auto v : ln_values) {
+        if (v > mx) {
+            mx = v;
+        }
+    }
+    if (std::isinf(mx)) {
+        return mx;
+    }
+    double sum = 0.0;
+    for (auto v : ln_values) {
+        sum += std::exp(v - mx);
+    }
+    return mx + std::log(sum);
+}
+
+/**
+ * Nodes and weights of the 16-point Gauss-Legendre rule on [-1, 1].
+ *
+ * The nodes are the roots of the Legendre polynomial, found by Newton
+ * iteration from the usual starting values.
+ */
+inline const std::vector< std::pair<double, double> > & get_gauss_legendre_rule() {
+    static const std::vector< std::pair<double, double> > rule = [] () {
+        const unsigned int n = 16;
+        const double pi = 3.14159265358979323846;
+        std::vector< std::pair<double, double> > r;
+        r.reserve(n);
+        for (unsigned int i = 1; i <= n; ++i) {
+            double x = std::cos(pi * (i - 0.25) / (n + 0.5));
+            double dp = 1.0;
+            for (unsigned int iter = 0; iter < 100; ++iter) {
+                double p0 = 1.0;
+                double p1 = x;
+                for (unsigned int j = 2; j <= n; ++j) {
+                    double p2 = (((2.0 * j - 1.0) * x * p1) - ((j - 1.0) * p0)) / j;
+                    p0 = p1;
+                    p1 = p2;
+                }
+                dp = n * ((x * p1) - p0) / ((x * x) - 1.0);
+                double dx = p1 / dp;
+                x -= dx;
+                if (std::abs(dx) < 1e-15) {
+                    break;
+                }
+            }
+            r.push_back(std::make_pair(x, 2.0 / ((1.0 - (x * x)) * dp * dp)));
+        }
+        return r;
+    }();
+    return rule;
+}
+
+} // namespace model_prior_probability
+
+
+/**
+ * A quadrature rule over the prior distribution of a hyperparameter of the
+ * event model prior (i.e., the concentration or discount of the
+ * Dirichlet/Pitman-Yor process or the split weight of the uniform prior).
+ *
+ * The expectation of a function f of the hyperparameter under its prior is
+ * approximated as sum_i w_i f(x_i). The nodes are placed with composite
+ * Gauss-Legendre rules on a transformed scale where the prior density is
+ * smooth and has no boundaries: the log of gamma-distributed values (less
+ * any offset) and the logit of beta-distributed values. Panels cover the
+ * bulk of the density and extend far enough into both tails that the
+ * missing mass is negligible. The weights are normalized to sum to one.
+ *
+ * Gamma (including exponential), beta, and uniform priors are supported.
+ * A fixed value is represented by a single node.
+ */
+class HyperpriorQuadrature {
+    private:
+        std::vector<double> values_;
+        std::vector<double> ln_weights_;
+
+    public:
+        explicit HyperpriorQuadrature(double fixed_value) {
+            this->values_.push_back(fixed_value);
+            this->ln_weights_.push_back(0.0);
+        }
+
+        HyperpriorQuadrature(const ContinuousProbabilityDistribution & prior) {
+            const OffsetGammaDistribution * gamma =
+                    dynamic_cast<const OffsetGammaDistribution *>(&prior);
+            const BetaDistribution * beta =
+                    dynamic_cast<const BetaDistribution *>(&prior);
+            const UniformDistribution * uniform =
+                    dynamic_cast<const UniformDistribution *>(&prior);
+            if (gamma) {
+                this->init_gamma(gamma->get_shape(), gamma->get_scale(),
+                        gamma->get_offset());
+            }
+            else if (beta) {
+                this->init_beta(beta->get_alpha(), beta->get_beta(),
+                        beta->get_min(), beta->get_max());
+            }
+            else if (uniform) {
+                this->init_uniform(uniform->get_min(), uniform->get_max());
+            }
+            else {
+                throw EcoevolityError(
+                        "HyperpriorQuadrature: Cannot integrate over a " +
+                        prior.get_name() + " prior");
+            }
+            this->normalize();
+        }
+
+        static bool can_integrate(const ContinuousProbabilityDistribution & prior) {
+            return ((dynamic_cast<const OffsetGammaDistribution *>(&prior)) ||
+                    (dynamic_cast<const BetaDistribution *>(&prior)) ||
+                    (dynamic_cast<const UniformDistribution *>(&prior)));
+        }
+
+        unsigned int size() const {
+            return this->values_.size();
+        }
+        double get_value(unsigned int i) const {
+            return this->values_.at(i);
+        }
+        double get_ln_weight(unsigned int i) const {
+            return this->ln_weights_.at(i);
+        }
+        double get_weight(unsigned int i) const {
+            return std::exp(this->ln_weights_.at(i));
+        }
+
+    private:
+        /**
+         * Add 'number_of_panels' Gauss-Legendre panels between 'lower' and
+         * 'upper' on the transformed scale. 'transform' returns the log of
+         * the density on the transformed scale (including the Jacobian) at t,
+         * and sets the value of the hyperparameter at t.
+         */
+        template <class F>
+        void add_panels(double lower, double upper, unsigned int number_of_panels,
+                const F & transform) {
+            const std::vector< std::pair<double, double> > & rule =
+                    model_prior_probability::get_gauss_legendre_rule();
+            const double width = (upper - lower) / number_of_panels;
+            for (unsigned int p = 0; p < number_of_panels; ++p) {
+                const double mid = lower + ((p + 0.5) * width);
+                for (auto const & node_weight : rule) {
+                    const double t = mid + (0.5 * width * node_weight.first);
+                    double x;
+                    const double ln_density = transform(t, x);
+                    const double ln_w = std::log(0.5 * width * node_weight.second) + ln_density;
+                    if (std::isfinite(ln_w)) {
+                        this->values_.push_back(x);
+                        this->ln_weights_.push_back(ln_w);
+                    }
+                }
+            }
+        }
+
+        static unsigned int get_number_of_panels(double length, double max_width) {
+            return std::max(1u, (unsigned int)std::ceil(length / max_width));
+        }
+
+        void init_gamma(double shape, double scale, double offset) {
+            // t = ln(x - offset)
+            const double ln_norm = std::lgamma(shape) + (shape * std::log(scale));
+            auto transform = [&](double t, double & x) {
+                const double y = std::exp(t);
+                x = offset + y;
+                return (shape * t) - (y / scale) - ln_norm;
+            };
+            const double sd = 1.0 / std::sqrt(shape);
+            const double core_lower = std::log(shape * scale) - (10.0 * sd);
+            const double core_upper = std::log(
+                    scale * (shape + (12.0 * std::sqrt(shape)) + 45.0));
+            const double tail = 40.0 / shape;
+            this->add_panels(core_lower - tail, core_lower,
+                    get_number_of_panels(tail, 4.0 / shape),
+                    transform);
+            this->add_panels(core_lower, core_upper, 32, transform);
+        }
+
+        void init_beta(double a, double b, double min, double max) {
+            // t = logit((x - min) / (max - min))
+            const double ln_norm = std::lgamma(a) + std::lgamma(b) -
+                    std::lgamma(a + b);
+            auto transform = [&](double t, double & x) {
+                // log(u) and log(1 - u) without cancellation
+                const double ln_u = (t >= 0.0) ?
+                        -std::log1p(std::exp(-t)) :
+                        t - std::log1p(std::exp(t));
+                const double ln_1mu = ln_u - t;
+                double u = std::exp(ln_u);
+                if (u >= 1.0) {
+                    u = std::nextafter(1.0, 0.0);
+                }
+                x = min + ((max - min) * u);
+                if (x >= max) {
+                    x = std::nextafter(max, min);
+                }
+                return (a * ln_u) + (b * ln_1mu) - ln_norm;
+            };
+            const double sd = std::sqrt((a + b) / (a * b));
+            const double mode = std::log(a / b);
+            const double core_lower = mode - (10.0 * sd);
+            const double core_upper = mode + (10.0 * sd);
+            const double left_tail = 40.0 / a;
+            const double right_tail = 40.0 / b;
+            this->add_panels(core_lower - left_tail, core_lower,
+                    get_number_of_panels(left_tail, 4.0 / a),
+                    transform);
+            this->add_panels(core_lower, core_upper, 32, transform);
+            this->add_panels(core_upper, core_upper + right_tail,
+                    get_number_of_panels(right_tail, 4.0 / b),
+                    transform);
+        }
+
+        void init_uniform(double min, double max) {
+            const double ln_density = -std::log(max - min);
+            auto transform = [&](double t, double & x) {
+                x = t;
+                return ln_density;
+            };
+            this->add_panels(min, max, 8, transform);
+        }
+
+        void normalize() {
+            if (this->ln_weights_.empty()) {
+                throw EcoevolityError(
+                        "HyperpriorQuadrature: Prior has no mass at any node");
+            }
+            const double ln_sum = model_prior_probability::log_sum_exp(this->ln_weights_);
+            for (auto & ln_w : this->ln_weights_) {
+                ln_w -= ln_sum;
+            }
+        }
+};
+
+
+/**
+ * Exact prior probabilities of event models (set partitions of comparisons)
+ * under the Dirichlet process, Pitman-Yor process, or split-weighted uniform
+ * model priors, integrated over the priors on their hyperparameters.
+ *
+ * Under the Pitman-Yor process (Dirichlet process when the discount d is
+ * zero) with concentration a, the probability of a partition of n elements
+ * into k subsets of sizes n_1, ..., n_k factors into
+ *
+ *     prod_{j=1}^{k-1} (a + jd) / prod_{i=1}^{n-1} (a + i)
+ *         * prod_b Gamma(n_b - d) / Gamma(1 - d),
+ *
+ * where the first term depends only on k. So, for each discount node, the
+ * first term is integrated over the concentration nodes once for each k, and
+ * the probability of any model only needs the product over its subsets. The
+ * probability of k subsets uses the generalized Stirling numbers
+ * C(n, k) = sum over partitions into k subsets of prod_b (1 - d)_{n_b - 1},
+ * computed in log space with C(m + 1, k) = C(m, k - 1) + (m - kd) C(m, k).
+ *
+ * Under the uniform prior with split weight w, each partition into k subsets
+ * has probability w^{k-1} / Z_n(w), where Z_n(w) = sum_k S(n, k) w^{k-1}
+ * and S are Stirling numbers of the second kind (from the shared
+ * LogStirlingTable).
+ *
+ * For the uniform prior, the concentration quadrature is over the split
+ * weight.
+ */
+class ModelPriorProbabilities {
+    private:
+        unsigned int number_of_elements_;
+        EcoevolityOptions::ModelPrior model_prior_;
+        HyperpriorQuadrature concentration_;
+        HyperpriorQuadrature discount_;
+        // P(k subsets), at index k - 1
+        std::vector<double> number_of_categories_probs_;
+        // ln_k_terms_[j][k - 1] is the log of the weight of discount node j
+        // plus the log of the first term above integrated over the
+        // concentration (for the uniform prior there is one row with the log
+        // of w^{k-1} / Z_n(w) integrated over the split weight)
+        std::vector< std::vector<double> > ln_k_terms_;
+        // ln_size_terms_[j][m - 1] = ln(Gamma(m - d_j) / Gamma(1 - d_j))
+        std::vector< std::vector<double> > ln_size_terms_;
+
+    public:
+        ModelPriorProbabilities(
+                unsigned int number_of_elements,
+                EcoevolityOptions::ModelPrior model_prior,
+                const HyperpriorQuadrature & concentration,
+                const HyperpriorQuadrature & discount = HyperpriorQuadrature(0.0))
+            : number_of_elements_(number_of_elements),
+              model_prior_(model_prior),
+              concentration_(concentration),
+              discount_(discount) {
+            if (number_of_elements < 1) {
+                throw EcoevolityError(
+                        "ModelPriorProbabilities: Need at least one element");
+            }
+            if ((model_prior == EcoevolityOptions::ModelPrior::dpp) ||
+                    (model_prior == EcoevolityOptions::ModelPrior::pyp)) {
+                this->init_pitman_yor();
+            }
+            else if (model_prior == EcoevolityOptions::ModelPrior::uniform) {
+                this->init_uniform();
+            }
+            else {
+                throw EcoevolityError(
+                        "ModelPriorProbabilities: Unsupported model prior");
+            }
+        }
+
+        unsigned int get_number_of_elements() const {
+            return this->number_of_elements_;
+        }
+
+        /**
+         * Prior probability of the elements being partitioned into
+         * 'number_of_categories' subsets.
+         */
+        double get_number_of_categories_probability(
+                unsigned int number_of_categories) const {
+            if ((number_of_categories < 1) ||
+                    (number_of_categories > this->number_of_elements_)) {
+                return 0.0;
+            }
+            return this->number_of_categories_probs_.at(number_of_categories - 1);
+        }
+
+        double get_expected_number_of_categories() const {
+            double e = 0.0;
+            for (unsigned int i = 0; i < this->number_of_categories_probs_.size(); ++i) {
+                e += (i + 1.0) * this->number_of_categories_probs_.at(i);
+            }
+            return e;
+        }
+
+        /**
+         * Log prior probability of a model, given as a vector of subset
+         * labels for the elements.
+         */
+        double get_ln_model_probability(const std::vector<unsigned int> & model) const {
+            if (model.size() != this->number_of_elements_) {
+                throw EcoevolityError(
+                        "ModelPriorProbabilities: Model has wrong number of "
+                        "elements");
+            }
+            std::map<unsigned int, unsigned int> subset_sizes;
+            for (auto s : model) {
+                ++subset_sizes[s];
+            }
+            const unsigned int k = subset_sizes.size();
+            std::vector<double> ln_terms;
+            ln_terms.reserve(this->ln_k_terms_.size());
+            for (unsigned int j = 0; j < this->ln_k_terms_.size(); ++j) {
+                double ln_p = this->ln_k_terms_.at(j).at(k - 1);
+                if (! this->ln_size_terms_.empty()) {
+                    for (auto const & kv : subset_sizes) {
+                        ln_p += this->ln_size_terms_.at(j).at(kv.second - 1);
+                    }
+                }
+                ln_terms.push_back(ln_p);
+            }
+            return model_prior_probability::log_sum_exp(ln_terms);
+        }
+
+        double get_model_probability(const std::vector<unsigned int> & model) const {
+            return std::exp(this->get_ln_model_probability(model));
+        }
+
+        /**
+         * Prior probability that a given set of 'number_of_shared_elements'
+         * elements are all in the same subset. The elements are
+         * exchangeable, so which elements does not matter.
+         */
+        double get_shared_probability(unsigned int number_of_shared_elements) const {
+            if ((number_of_shared_elements < 1) ||
+                    (number_of_shared_elements > this->number_of_elements_)) {
+                throw EcoevolityError(
+                        "ModelPriorProbabilities: Invalid number of shared "
+                        "elements");
+            }
+            const unsigned int m = number_of_shared_elements;
+            std::vector<double> ln_terms;
+            if (this->model_prior_ == EcoevolityOptions::ModelPrior::uniform) {
+                // Merging the shared elements leaves n - m + 1 elements, so
+                // the probability is Z_{n-m+1}(w) / Z_n(w)
+                LogStirlingTable & table = LogStirlingTable::get_instance();
+                for (unsigned int i = 0; i < this->concentration_.size(); ++i) {
+                    const double w = this->concentration_.get_value(i);
+                    ln_terms.push_back(this->concentration_.get_ln_weight(i) +
+                            table.get_ln_uniform_normalizing_constant(
+                                this->number_of_elements_ - m + 1, w) -
+                            table.get_ln_uniform_normalizing_constant(
+                                this->number_of_elements_, w));
+                }
+            }
+            else {
+                // Each of the elements after the first joins the subset of
+                // the first with probability (i - d) / (a + i)
+                for (unsigned int j = 0; j < this->discount_.size(); ++j) {
+                    const double d = this->discount_.get_value(j);
+                    for (unsigned int i = 0; i < this->concentration_.size(); ++i) {
+                        const double a = this->concentration_.get_value(i);
+                        double ln_p = this->discount_.get_ln_weight(j) +
+                                this->concentration_.get_ln_weight(i);
+                        for (unsigned int e = 1; e < m; ++e) {
+                            ln_p += std::log(e - d) - std::log(a + e);
+                        }
+                        ln_terms.push_back(ln_p);
+                    }
+                }
+            }
+            return std::exp(model_prior_probability::log_sum_exp(ln_terms));
+        }
+
+    private:
+        void init_pitman_yor() {
+            const unsigned int n = this->number_of_elements_;
+            const unsigned int nd = this->discount_.size();
+            const unsigned int na = this->concentration_.size();
+            for (unsigned int j = 0; j < nd; ++j) {
+                const double d = this->discount_.get_value(j);
+                if ((d < 0.0) || (d >= 1.0)) {
+                    throw EcoevolityError(
+                            "ModelPriorProbabilities: Discount must be "
+                            "0 <= discount < 1");
+                }
+            }
+            for (unsigned int i = 0; i < na; ++i) {
+                if (this->concentration_.get_value(i) <= 0.0) {
+                    throw EcoevolityError(
+                            "ModelPriorProbabilities: Concentration must be "
+                            "positive");
+                }
+            }
+
+            // ln prod_{i=1}^{n-1} (a + i) for each concentration node
+            std::vector<double> ln_denoms(na, 0.0);
+            for (unsigned int i = 0; i < na; ++i) {
+                const double a = this->concentration_.get_value(i);
+                for (unsigned int e = 1; e < n; ++e) {
+                    ln_denoms.at(i) += std::log(a + e);
+                }
+            }
+
+            this->ln_k_terms_.assign(nd, std::vector<double>(n, 0.0));
+            this->ln_size_terms_.assign(nd, std::vector<double>(n, 0.0));
+            std::vector< std::vector<double> > ln_k_probs(n);
+            std::vector<double> ln_terms(na);
+            std::vector<double> ln_numerators(na);
+            std::vector<double> ln_c(n + 1);
+            std::vector<double> ln_c_next(n + 1);
+            for (unsigned int j = 0; j < nd; ++j) {
+                const double d = this->discount_.get_value(j);
+                for (unsigned int i = 0; i < na; ++i) {
+                    ln_numerators.at(i) = 0.0;
+                }
+                for (unsigned int k = 1; k <= n; ++k) {
+                    if (k > 1) {
+                        for (unsigned int i = 0; i < na; ++i) {
+                            ln_numerators.at(i) += std::log(
+                                    this->concentration_.get_value(i) + ((k - 1) * d));
+                        }
+                    }
+                    for (unsigned int i = 0; i < na; ++i) {
+                        ln_terms.at(i) = this->concentration_.get_ln_weight(i) +
+                                ln_numerators.at(i) - ln_denoms.at(i);
+                    }
+                    this->ln_k_terms_.at(j).at(k - 1) =
+                            this->discount_.get_ln_weight(j) +
+                            model_prior_probability::log_sum_exp(ln_terms);
+                }
+
+                const double ln_gamma_1md = std::lgamma(1.0 - d);
+                for (unsigned int m = 1; m <= n; ++m) {
+                    this->ln_size_terms_.at(j).at(m - 1) =
+                            std::lgamma(m - d) - ln_gamma_1md;
+                }
+
+                // ln C(m, k) for m = 1, ..., n
+                const double ninf = -std::numeric_limits<double>::infinity();
+                std::fill(ln_c.begin(), ln_c.end(), ninf);
+                ln_c.at(1) = 0.0;
+                for (unsigned int m = 1; m < n; ++m) {
+                    std::fill(ln_c_next.begin(), ln_c_next.end(), ninf);
+                    for (unsigned int k = 1; k <= (m + 1); ++k) {
+                        const double new_subset = ln_c.at(k - 1);
+                        const double existing_subset = (k <= m) ?
+                                ln_c.at(k) + std::log(m - (k * d)) : ninf;
+                        ln_c_next.at(k) = model_prior_probability::log_sum_exp(
+                                {new_subset, existing_subset});
+                    }
+                    ln_c.swap(ln_c_next);
+                }
+                for (unsigned int k = 1; k <= n; ++k) {
+                    ln_k_probs.at(k - 1).push_back(
+                            this->ln_k_terms_.at(j).at(k - 1) + ln_c.at(k));
+                }
+            }
+            this->number_of_categories_probs_.assign(n, 0.0);
+            for (unsigned int k = 1; k <= n; ++k) {
+                this->number_of_categories_probs_.at(k - 1) = std::exp(
+                        model_prior_probability::log_sum_exp(ln_k_probs.at(k - 1)));
+            }
+        }
+
+        void init_uniform() {
+            const unsigned int n = this->number_of_elements_;
+            const unsigned int nw = this->concentration_.size();
+            for (unsigned int i = 0; i < nw; ++i) {
+                if (this->concentration_.get_value(i) <= 0.0) {
+                    throw EcoevolityError(
+                            "ModelPriorProbabilities: Split weight must be "
+                            "positive");
+                }
+            }
+
+            LogStirlingTable & table = LogStirlingTable::get_instance();
+            this->ln_k_terms_.assign(1, std::vector<double>(n, 0.0));
+            std::vector<double> ln_terms(nw);
+            std::vector<double> ln_z(nw);
+            for (unsigned int i = 0; i < nw; ++i) {
+                ln_z.at(i) = table.get_ln_uniform_normalizing_constant(n,
+                        this->concentration_.get_value(i));
+            }
+            this->number_of_categories_probs_.assign(n, 0.0);
+            for (unsigned int k = 1; k <= n; ++k) {
+                for (unsigned int i = 0; i < nw; ++i) {
+                    ln_terms.at(i) = this->concentration_.get_ln_weight(i) +
+                            ((k - 1) * std::log(this->concentration_.get_value(i))) -
+                            ln_z.at(i);
+                }
+                this->ln_k_terms_.at(0).at(k - 1) =
+                        model_prior_probability::log_sum_exp(ln_terms);
+                this->number_of_categories_probs_.at(k - 1) = std::exp(
+                        this->ln_k_terms_.at(0).at(k - 1) +
+                        table.get_ln_stirling2(n, k));
+            }
+        }
+};
+
+#endif
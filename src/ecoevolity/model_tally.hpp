@@ -0,0 +1,181 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_MODEL_TALLY_HPP
+#define ECOEVOLITY_MODEL_TALLY_HPP
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "error.hpp"
+
+
+/**
+ * Counts of event models (vectors of subset indices of a fixed length).
+ *
+ * Models are kept back to back in one flat vector and looked up through an
+ * open-addressing hash table, so tallying a model does not allocate unless
+ * the model has not been seen before.
+ */
+class ModelTally {
+
+    protected:
+
+        unsigned int model_size_;
+        std::vector<unsigned int> models_;
+        std::vector<unsigned int> counts_;
+        std::vector<std::uint64_t> hashes_;
+        // 0 if the slot is empty, otherwise 1 + the index of the model
+        std::vector<std::size_t> slots_;
+        unsigned long total_ = 0;
+
+        std::uint64_t hash(const unsigned int * model) const {
+            std::uint64_t h = 14695981039346656037ULL;
+            for (unsigned int i = 0; i < this->model_size_; ++i) {
+                h = (h ^ model[i]) * 1099511628211ULL;
+            }
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        std::size_t find_slot(const unsigned int * model,
+                std::uint64_t h) const {
+            const std::size_t mask = this->slots_.size() - 1;
+            std::size_t i = h & mask;
+            while (this->slots_[i] != 0) {
+                const std::size_t m = this->slots_[i] - 1;
+                if ((this->hashes_[m] == h) && std::equal(model,
+                            model + this->model_size_,
+                            this->models_.begin() + (m * this->model_size_))) {
+                    return i;
+                }
+                i = (i + 1) & mask;
+            }
+            return i;
+        }
+
+        void grow() {
+            std::vector<std::size_t> slots(this->slots_.size() * 2, 0);
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t m = 0; m < this->counts_.size(); ++m) {
+                std::size_t i = this->hashes_[m] & mask;
+                while (slots[i] != 0) {
+                    i = (i + 1) & mask;
+                }
+                slots[i] = m + 1;
+            }
+            this->slots_.swap(slots);
+        }
+
+        void check_model_size(std::size_t model_size) const {
+            if (model_size != this->model_size_) {
+                throw EcoevolityError(
+                        "ModelTally: model has the wrong number of elements");
+            }
+        }
+
+    public:
+
+        explicit ModelTally(unsigned int model_size) :
+            model_size_(model_size),
+            slots_(64, 0) { }
+
+        /** Add count to the tally of the model starting at model. */
+        void add(const unsigned int * model, unsigned int count = 1) {
+            // Keep the table at most 3/4 full
+            if (((this->counts_.size() + 1) * 4) > (this->slots_.size() * 3)) {
+                this->grow();
+            }
+            const std::uint64_t h = this->hash(model);
+            const std::size_t i = this->find_slot(model, h);
+            if (this->slots_[i] != 0) {
+                this->counts_[this->slots_[i] - 1] += count;
+            }
+            else {
+                this->models_.insert(this->models_.end(), model,
+                        model + this->model_size_);
+                this->counts_.push_back(count);
+                this->hashes_.push_back(h);
+                this->slots_[i] = this->counts_.size();
+            }
+            this->total_ += count;
+        }
+
+        void add(const std::vector<unsigned int>& model,
+                unsigned int count = 1) {
+            this->check_model_size(model.size());
+            this->add(model.data(), count);
+        }
+
+        /** Add the counts of another tally of models of the same size. */
+        void merge(const ModelTally& other) {
+            this->check_model_size(other.model_size_);
+            for (std::size_t m = 0; m < other.counts_.size(); ++m) {
+                this->add(other.models_.data() + (m * other.model_size_),
+                        other.counts_[m]);
+            }
+        }
+
+        unsigned int get_count(const std::vector<unsigned int>& model) const {
+            this->check_model_size(model.size());
+            const std::size_t i = this->find_slot(model.data(),
+                    this->hash(model.data()));
+            if (this->slots_[i] == 0) {
+                return 0;
+            }
+            return this->counts_[this->slots_[i] - 1];
+        }
+
+        unsigned int get_model_size() const {
+            return this->model_size_;
+        }
+
+        /** Number of distinct models. */
+        std::size_t size() const {
+            return this->counts_.size();
+        }
+
+        /** Sum of the counts of all models. */
+        unsigned long get_total() const {
+            return this->total_;
+        }
+
+        /**
+         * The models and their counts, sorted by model so the order does not
+         * depend on the hash table.
+         */
+        std::vector< std::pair<std::vector<unsigned int>, unsigned int> >
+        get_model_count_pairs() const {
+            std::vector< std::pair<std::vector<unsigned int>, unsigned int> > pairs;
+            pairs.reserve(this->counts_.size());
+            for (std::size_t m = 0; m < this->counts_.size(); ++m) {
+                auto model = this->models_.begin() + (m * this->model_size_);
+                pairs.push_back(std::make_pair(
+                        std::vector<unsigned int>(model, model + this->model_size_),
+                        this->counts_[m]));
+            }
+            std::sort(pairs.begin(), pairs.end());
+            return pairs;
+        }
+};
+
+#endif
@@ -35,6 +35,76 @@
 
 void write_nex2yml_splash(std::ostream& out);
 
+inline void write_nex2yml_data(const BiallelicData & d) {
+    std::string yml_out_path = d.get_path() + ".yml";
+    std::ofstream yml_out_stream;
+
+    std::cout << "    Writing \'" << yml_out_path << "\'" << std::endl;
+    try {
+        yml_out_stream.open(yml_out_path);
+    }
+    catch (...) {
+        std::cerr << "An error occurred when trying to open \'"
+                  << yml_out_path
+                  << "\'\n";
+        throw;
+    }
+    try {
+        d.write_yaml(yml_out_stream);
+    }
+    catch (...) {
+        yml_out_stream.close();
+        std::cerr << "An error occurred when trying to write to \'"
+                  << yml_out_path
+                  << "\'\n";
+        throw;
+    }
+    yml_out_stream.close();
+}
+
+/**
+ * Convert one alignment by streaming its NEXUS matrix, rather than reading
+ * it with NCL, and write the YAML file of its allele count patterns.
+ */
+inline void stream_nex2yml_data(
+        const std::string & path,
+        char population_name_delimiter,
+        bool population_name_is_prefix,
+        bool genotypes_are_diploid,
+        bool markers_are_dominant,
+        bool constant_sites_removed,
+        bool strict_on_constant_sites,
+        bool strict_on_missing_sites,
+        bool strict_on_triallelic_sites,
+        double ploidy,
+        bool constrain_state_frequencies,
+        unsigned int max_number_of_populations) {
+    BasePopulationTree tree;
+    tree.init_data_from_nexus_stream(
+            path,
+            population_name_delimiter,
+            population_name_is_prefix,
+            genotypes_are_diploid,
+            markers_are_dominant,
+            constant_sites_removed,
+            true, // validate
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            ploidy);
+    if (tree.get_data().get_number_of_populations() > max_number_of_populations) {
+        std::ostringstream message;
+        message << "Streamed alignments of comparisons cannot have more than "
+                << max_number_of_populations << " populations";
+        throw EcoevolityComparisonSettingError(message.str(), path);
+    }
+    if (constrain_state_frequencies) {
+        tree.constrain_state_frequencies();
+        tree.fold_patterns();
+    }
+    write_nex2yml_data(tree.get_data());
+}
+
 
 template <class SettingsType, class CollectionType, class TreeType>
 int nex2yml_main(int argc, char * argv[]) {
@@ -91,6 +161,28 @@ int nex2yml_main(int argc, char * argv[]) {
                   "affected by this option, not alignments of standard "
                   "characters (i.e., 0, 1, 2)."
                 );
+    parser.add_option("--stream")
+            .action("store_true")
+            .dest("stream")
+            .help("Convert each alignment by streaming its NEXUS matrix in "
+                  "blocks of sites, rather than reading the whole matrix "
+                  "into memory. Use this for very large alignments; memory "
+                  "use is then proportional to the number of site patterns. "
+                  "Only a TAXA block and a single DATA or CHARACTERS block "
+                  "(standard or nucleotide data, possibly interleaved) are "
+                  "supported; EQUATE, TRANSPOSE, TOKENS and NOLABELS are not. "
+                  "The model is not configured, so no summary of the "
+                  "settings is reported."
+                );
+#ifdef BUILD_WITH_THREADS
+    parser.add_option("--nthreads")
+            .action("store")
+            .type("unsigned int")
+            .dest("nthreads")
+            .set_default("1")
+            .help("Number of threads to use for loading the alignments. "
+                  "Default: 1 (no multithreading).");
+#endif
 
     optparse::Values& options = parser.parse_args(argc, argv);
     std::vector<std::string> args = parser.args();
@@ -100,6 +192,13 @@ int nex2yml_main(int argc, char * argv[]) {
     const bool strict_on_constant_sites = (! options.get("relax_constant_sites"));
     const bool strict_on_missing_sites = (! options.get("relax_missing_sites"));
     const bool strict_on_triallelic_sites = (! options.get("relax_triallelic_sites"));
+    const bool streaming = options.get("stream");
+
+#ifdef BUILD_WITH_THREADS
+    unsigned int nthreads = options.get("nthreads");
+#else
+    unsigned int nthreads = 1;
+#endif
 
     if (args.size() < 1) {
         throw EcoevolityError("Path to YAML-formatted config file is required");
@@ -137,48 +236,61 @@ int nex2yml_main(int argc, char * argv[]) {
         }
     }
 
-    if (! using_phyco_settings) {
+    if (streaming) {
+        std::cout << "Writing YAML files of allele count patterns..." << std::endl;
+        if (! using_phyco_settings) {
+            for (auto const & comparison : settings.get_comparison_settings()) {
+                stream_nex2yml_data(
+                        comparison.get_path(),
+                        comparison.get_population_name_delimiter(),
+                        comparison.population_name_is_prefix(),
+                        comparison.genotypes_are_diploid(),
+                        comparison.markers_are_dominant(),
+                        comparison.constant_sites_removed(),
+                        strict_on_constant_sites,
+                        strict_on_missing_sites,
+                        strict_on_triallelic_sites,
+                        comparison.get_ploidy(),
+                        comparison.constrain_state_frequencies(),
+                        2);
+            }
+        }
+        else {
+            stream_nex2yml_data(
+                    phyco_settings.data_settings.get_path(),
+                    phyco_settings.data_settings.get_population_name_delimiter(),
+                    phyco_settings.data_settings.population_name_is_prefix(),
+                    phyco_settings.data_settings.genotypes_are_diploid(),
+                    phyco_settings.data_settings.markers_are_dominant(),
+                    phyco_settings.data_settings.constant_sites_removed(),
+                    strict_on_constant_sites,
+                    strict_on_missing_sites,
+                    strict_on_triallelic_sites,
+                    phyco_settings.data_settings.get_ploidy(),
+                    false,
+                    std::numeric_limits<unsigned int>::max());
+        }
+    }
+    else if (! using_phyco_settings) {
         std::cout << "Configuring comparisons..." << std::endl;
         CollectionType comparisons = CollectionType(
                 settings,
                 rng,
                 strict_on_constant_sites,
                 strict_on_missing_sites,
-                strict_on_triallelic_sites);
+                strict_on_triallelic_sites,
+                false, // store_seq_loci_info
+                nthreads);
 
         std::cout << "\n" << string_util::banner('-') << "\n";
         comparisons.write_summary(std::cout);
         std::cout << string_util::banner('-') << "\n\n";
 
         std::cout << "Writing YAML files of allele count patterns..." << std::endl;
-        std::ofstream yml_out_stream;
         for (unsigned int i = 0;
                 i < comparisons.get_number_of_trees();
                 ++i) {
-            const BiallelicData & d = comparisons.get_tree(i)->get_data();
-            std::string yml_out_path = d.get_path() + ".yml";
-
-            std::cout << "    Writing \'" << yml_out_path << "\'" << std::endl;
-            try {
-                yml_out_stream.open(yml_out_path);
-            }
-            catch (...) {
-                std::cerr << "An error occurred when trying to open \'"
-                          << yml_out_path
-                          << "\'\n";
-                throw;
-            }
-            try {
-                d.write_yaml(yml_out_stream);
-            }
-            catch (...) {
-                yml_out_stream.close();
-                std::cerr << "An error occurred when trying to write to \'"
-                          << yml_out_path
-                          << "\'\n";
-                throw;
-            }
-            yml_out_stream.close();
+            write_nex2yml_data(comparisons.get_tree(i)->get_data());
         }
     }
     else {
@@ -190,7 +302,8 @@ int nex2yml_main(int argc, char * argv[]) {
                 strict_on_constant_sites,
                 strict_on_missing_sites,
                 strict_on_triallelic_sites,
-                false // store_seq_loci_info
+                false, // store_seq_loci_info
+                nthreads
                 );
 
         GeneralTreeOperatorSchedule<BasePopulationTree> operator_schedule(
@@ -201,31 +314,7 @@ int nex2yml_main(int argc, char * argv[]) {
         std::cout << string_util::banner('-') << "\n\n";
 
         std::cout << "Writing YAML files of allele count patterns..." << std::endl;
-        std::ofstream yml_out_stream;
-        const BiallelicData & d = tree.get_data();
-        std::string yml_out_path = d.get_path() + ".yml";
-
-        std::cout << "    Writing \'" << yml_out_path << "\'" << std::endl;
-        try {
-            yml_out_stream.open(yml_out_path);
-        }
-        catch (...) {
-            std::cerr << "An error occurred when trying to open \'"
-                      << yml_out_path
-                      << "\'\n";
-            throw;
-        }
-        try {
-            d.write_yaml(yml_out_stream);
-        }
-        catch (...) {
-            yml_out_stream.close();
-            std::cerr << "An error occurred when trying to write to \'"
-                      << yml_out_path
-                      << "\'\n";
-            throw;
-        }
-        yml_out_stream.close();
+        write_nex2yml_data(tree.get_data());
     }
     return 0;
 }
@@ -0,0 +1,1439 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_NEXUS_STREAM_HPP
+#define ECOEVOLITY_NEXUS_STREAM_HPP
+
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <istream>
+
+#include <ncl/nxsmultiformat.h>
+
+#include "assert.hpp"
+#include "error.hpp"
+
+
+/**
+ * Base class for streaming NEXUS readers.
+ *
+ * Provides character-level reading of a NEXUS stream, tokens with NEXUS
+ * quoting and comment rules, skipping of commands and blocks, and parsing of
+ * a TAXA block, without reading the whole file into memory.
+ */
+class NexusStreamReader {
+
+    public:
+        const std::string & get_path() const {
+            return this->path_;
+        }
+        unsigned int get_number_of_taxa() const {
+            return this->taxon_labels_.size();
+        }
+        const std::vector<std::string> & get_taxon_labels() const {
+            return this->taxon_labels_;
+        }
+
+    protected:
+        NexusStreamReader(const std::string & path) : path_(path) { }
+
+        std::string path_;
+        std::streambuf * buffer_ = nullptr;
+        std::streamoff position_ = 0;
+        unsigned int line_number_ = 1;
+
+        std::vector<std::string> taxon_labels_;
+        std::map<std::string, unsigned int> taxon_label_indices_;
+        bool found_taxa_block_ = false;
+
+        // Reading characters
+
+        int peek_char() {
+            return this->buffer_->sgetc();
+        }
+        int next_char() {
+            int c = this->buffer_->sbumpc();
+            if (c != std::char_traits<char>::eof()) {
+                ++this->position_;
+                if (c == '\n') {
+                    ++this->line_number_;
+                }
+            }
+            return c;
+        }
+        void seek(std::streamoff position) {
+            this->buffer_->pubseekpos(position, std::ios::in);
+            this->position_ = position;
+        }
+
+        static bool is_whitespace(int c) {
+            return ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') ||
+                    (c == '\f') || (c == '\v'));
+        }
+        static bool is_newline(int c) {
+            return ((c == '\n') || (c == '\r'));
+        }
+        static bool is_punctuation(int c) {
+            static const std::string punctuation = "()[]{}/\\,;:=*'\"`+-<>";
+            return (punctuation.find((char)c) != std::string::npos);
+        }
+
+        void throw_parsing_error(const std::string & message) const {
+            throw EcoevolityParsingError(message, this->path_, this->line_number_);
+        }
+        void throw_unsupported_error(const std::string & feature) const {
+            throw EcoevolityParsingError(
+                    feature + " is not supported when streaming NEXUS data",
+                    this->path_, this->line_number_);
+        }
+
+        void skip_comment() {
+            // The opening '[' has been consumed; comments can be nested
+            unsigned int depth = 1;
+            while (depth > 0) {
+                int c = this->next_char();
+                if (c == std::char_traits<char>::eof()) {
+                    this->throw_parsing_error("Unterminated comment");
+                }
+                if (c == '[') {
+                    ++depth;
+                }
+                else if (c == ']') {
+                    --depth;
+                }
+            }
+        }
+
+        // Skip whitespace and comments. Returns true if a newline was
+        // skipped.
+        bool skip_whitespace() {
+            bool skipped_newline = false;
+            while (true) {
+                int c = this->peek_char();
+                if (is_whitespace(c)) {
+                    if (is_newline(c)) {
+                        skipped_newline = true;
+                    }
+                    this->next_char();
+                }
+                else if (c == '[') {
+                    this->next_char();
+                    this->skip_comment();
+                }
+                else {
+                    return skipped_newline;
+                }
+            }
+        }
+
+        // Returns the next token; punctuation characters are tokens by
+        // themselves, and quotes are removed from quoted tokens. An empty
+        // string is returned at the end of the file.
+        std::string next_token(bool & was_quoted) {
+            was_quoted = false;
+            this->skip_whitespace();
+            int c = this->next_char();
+            if (c == std::char_traits<char>::eof()) {
+                return "";
+            }
+            std::string token;
+            if (c == '\'') {
+                was_quoted = true;
+                while (true) {
+                    c = this->next_char();
+                    if (c == std::char_traits<char>::eof()) {
+                        this->throw_parsing_error("Unterminated quoted token");
+                    }
+                    if (c == '\'') {
+                        if (this->peek_char() == '\'') {
+                            this->next_char();
+                        }
+                        else {
+                            return token;
+                        }
+                    }
+                    token += (char)c;
+                }
+            }
+            token += (char)c;
+            if (is_punctuation(c)) {
+                return token;
+            }
+            while (true) {
+                c = this->peek_char();
+                if ((c == std::char_traits<char>::eof()) || is_whitespace(c) ||
+                        is_punctuation(c)) {
+                    return token;
+                }
+                token += (char)this->next_char();
+            }
+        }
+        // Returns the next token as a label; as in NCL (and the NEXUS
+        // standard), underscores in unquoted labels are read as spaces
+        std::string next_label(bool & was_quoted) {
+            std::string label = this->next_token(was_quoted);
+            if (! was_quoted) {
+                std::replace(label.begin(), label.end(), '_', ' ');
+            }
+            return label;
+        }
+        std::string next_token() {
+            bool was_quoted;
+            return this->next_token(was_quoted);
+        }
+        std::string next_keyword() {
+            return upper(this->next_token());
+        }
+
+        static std::string upper(const std::string & s) {
+            std::string u = s;
+            std::transform(u.begin(), u.end(), u.begin(), ::toupper);
+            return u;
+        }
+
+        void expect_token(const std::string & expected) {
+            std::string token = this->next_token();
+            if (upper(token) != expected) {
+                this->throw_parsing_error("Expecting \'" + expected +
+                        "\', but found \'" + token + "\'");
+            }
+        }
+
+        unsigned int parse_dimension_value() {
+            this->expect_token("=");
+            std::string token = this->next_token();
+            unsigned int value = 0;
+            if (token.empty() ||
+                    (token.find_first_not_of("0123456789") != std::string::npos)) {
+                this->throw_parsing_error("Expecting an integer, but found \'" +
+                        token + "\'");
+            }
+            std::stringstream converter(token);
+            converter >> value;
+            return value;
+        }
+
+        // Skip to the semicolon that ends a command
+        void skip_command() {
+            while (true) {
+                std::string token = this->next_token();
+                if (token.empty()) {
+                    this->throw_parsing_error("Unexpected end of file");
+                }
+                if (token == ";") {
+                    return;
+                }
+            }
+        }
+
+        void skip_block() {
+            while (true) {
+                std::string token = this->next_keyword();
+                if (token.empty()) {
+                    this->throw_parsing_error("Unexpected end of file");
+                }
+                if ((token == "END") || (token == "ENDBLOCK")) {
+                    this->expect_token(";");
+                    return;
+                }
+                if (token != ";") {
+                    this->skip_command();
+                }
+            }
+        }
+
+        void parse_taxa_block() {
+            if (this->found_taxa_block_) {
+                throw EcoevolityParsingError("More than one taxa block found", this->path_, 0);
+            }
+            this->found_taxa_block_ = true;
+            unsigned int number_of_taxa = 0;
+            while (true) {
+                std::string command = this->next_keyword();
+                if ((command == "END") || (command == "ENDBLOCK")) {
+                    this->expect_token(";");
+                    break;
+                }
+                if (command == "DIMENSIONS") {
+                    std::string subcommand = this->next_keyword();
+                    while (subcommand != ";") {
+                        if (subcommand == "NTAX") {
+                            number_of_taxa = this->parse_dimension_value();
+                        }
+                        subcommand = this->next_keyword();
+                    }
+                }
+                else if (command == "TAXLABELS") {
+                    bool was_quoted;
+                    std::string label = this->next_label(was_quoted);
+                    while (was_quoted || (label != ";")) {
+                        if (label.empty()) {
+                            this->throw_parsing_error("Unexpected end of file");
+                        }
+                        this->add_taxon(label);
+                        label = this->next_label(was_quoted);
+                    }
+                }
+                else if (command.empty()) {
+                    this->throw_parsing_error("Unexpected end of file");
+                }
+                else if (command != ";") {
+                    this->skip_command();
+                }
+            }
+            if (this->taxon_labels_.size() != number_of_taxa) {
+                std::ostringstream message;
+                message << "Expecting " << number_of_taxa
+                        << " taxon labels, but found "
+                        << this->taxon_labels_.size();
+                this->throw_parsing_error(message.str());
+            }
+        }
+
+        void add_taxon(const std::string & label) {
+            std::string key = upper(label);
+            if (this->taxon_label_indices_.count(key) > 0) {
+                this->throw_parsing_error("Duplicate taxon label \'" + label + "\'");
+            }
+            this->taxon_label_indices_[key] = this->taxon_labels_.size();
+            this->taxon_labels_.push_back(label);
+        }
+};
+
+
+/**
+ * Class for reading the matrix of a NEXUS file in blocks of sites.
+ *
+ * NCL reads the entire character matrix into memory (as one integer per
+ * cell), which is prohibitive for chromosome-scale alignments. This class
+ * makes one pass through the file to parse the TAXA and DATA/CHARACTERS
+ * blocks and to record where the sequence of each taxon starts (for
+ * interleaved matrices, where each of its pieces starts). The cells can then
+ * be read in blocks of sites by seeking to each taxon's position, so the
+ * memory needed is proportional to the number of taxa times the size of the
+ * block, rather than the size of the alignment.
+ *
+ * The state codes of the cells follow NCL's conventions (states of DNA are
+ * A=0, C=1, G=2, T=3; standard states are the indices of the symbols;
+ * missing and gap are NXS_MISSING_CODE and NXS_GAP_STATE_CODE), and the
+ * states of every code are available from 'get_code_states', so cells can be
+ * tallied the same way as those from an NxsCharactersBlock.
+ *
+ * Only the common subset of NEXUS is supported: a TAXA block (optional with
+ * a DATA block) and a single DATA or CHARACTERS block of standard, DNA, RNA
+ * or nucleotide data, possibly interleaved, with MISSING, GAP, MATCHCHAR and
+ * SYMBOLS formats. Other blocks are skipped. EQUATE, TRANSPOSE, TOKENS and
+ * NOLABELS are not supported and result in an EcoevolityParsingError.
+ */
+class NexusMatrixStream : public NexusStreamReader {
+
+    public:
+        NexusMatrixStream(const std::string & path) : NexusStreamReader(path) {
+            this->stream_.open(path, std::ios::in | std::ios::binary);
+            if (! this->stream_.is_open()) {
+                throw EcoevolityParsingError(
+                        "Could not open NEXUS file",
+                        path);
+            }
+            this->buffer_ = this->stream_.rdbuf();
+            this->parse();
+            this->reset();
+        }
+
+
+        unsigned int get_number_of_sites() const {
+            return this->number_of_sites_;
+        }
+        NxsCharactersBlock::DataTypesEnum get_data_type() const {
+            return this->data_type_;
+        }
+        NxsDiscreteStateCell get_highest_state_code() const {
+            return this->code_states_.size() - 1;
+        }
+        const std::vector< std::vector<NxsDiscreteStateCell> > & get_code_states() const {
+            return this->code_states_;
+        }
+        unsigned int get_number_of_sites_read() const {
+            return this->number_of_sites_read_;
+        }
+
+        /**
+         * Go back to the first site of the matrix.
+         */
+        void reset() {
+            this->number_of_sites_read_ = 0;
+            this->cursors_.assign(this->taxon_labels_.size(), Cursor());
+        }
+
+        /**
+         * Read the cells of the next 'number_of_sites' sites (or as many as
+         * remain).
+         *
+         * The cells are stored by site, so the cell of site i (relative to
+         * the first site read) and taxon j is at 'cells[(i * ntax) + j]'.
+         * Returns the number of sites read, which is zero once all the sites
+         * have been read.
+         */
+        unsigned int read_sites(
+                unsigned int number_of_sites,
+                std::vector<NxsDiscreteStateCell> & cells) {
+            const unsigned int sites_to_read = std::min(number_of_sites,
+                    this->number_of_sites_ - this->number_of_sites_read_);
+            const unsigned int num_taxa = this->taxon_labels_.size();
+            cells.resize(sites_to_read * num_taxa);
+            if (sites_to_read < 1) {
+                return 0;
+            }
+            // Taxa are read in the order of the rows of the matrix, so that
+            // cells matching the first row can be resolved
+            for (auto taxon_idx : this->row_order_) {
+                Cursor & cursor = this->cursors_.at(taxon_idx);
+                const std::vector<Segment> & segments = this->segments_.at(taxon_idx);
+                for (unsigned int i = 0; i < sites_to_read; ++i) {
+                    if (cursor.sites_left_in_segment < 1) {
+                        ECOEVOLITY_ASSERT(cursor.segment_index < segments.size());
+                        const Segment & s = segments.at(cursor.segment_index);
+                        cursor.position = s.position;
+                        cursor.sites_left_in_segment = s.number_of_sites;
+                        ++cursor.segment_index;
+                    }
+                    if (cursor.position != this->position_) {
+                        this->seek(cursor.position);
+                    }
+                    NxsDiscreteStateCell code = this->read_cell(
+                            this->skip_to_cell(), taxon_idx,
+                            this->number_of_sites_read_ + i);
+                    if (code == match_code) {
+                        code = cells[(i * num_taxa) + this->row_order_.front()];
+                    }
+                    cells[(i * num_taxa) + taxon_idx] = code;
+                    cursor.position = this->position_;
+                    --cursor.sites_left_in_segment;
+                }
+            }
+            this->number_of_sites_read_ += sites_to_read;
+            return sites_to_read;
+        }
+
+    private:
+        enum {
+            // Stand-in code for the match character until it is resolved
+            match_code = -3,
+            // Code of characters that are not valid cells by themselves
+            invalid_code = -4
+        };
+
+        struct Segment {
+            std::streamoff position;
+            unsigned int number_of_sites;
+        };
+        struct Cursor {
+            unsigned int segment_index = 0;
+            unsigned int sites_left_in_segment = 0;
+            std::streamoff position = 0;
+        };
+
+        std::ifstream stream_;
+
+        bool found_character_block_ = false;
+        unsigned int number_of_sites_ = 0;
+        NxsCharactersBlock::DataTypesEnum data_type_ = NxsCharactersBlock::standard;
+        bool respecting_case_ = false;
+        bool interleaved_ = false;
+        char missing_char_ = '?';
+        char gap_char_ = '\0';
+        char match_char_ = '\0';
+
+        // The states of each code, and the code of each character (indexed
+        // by its unsigned value) and set of states
+        std::vector< std::vector<NxsDiscreteStateCell> > code_states_;
+        std::vector<NxsDiscreteStateCell> symbol_codes_;
+        std::map<std::vector<NxsDiscreteStateCell>, NxsDiscreteStateCell> state_set_codes_;
+
+        std::vector< std::vector<Segment> > segments_;
+        std::vector<unsigned int> row_order_;
+        std::vector<Cursor> cursors_;
+        unsigned int number_of_sites_read_ = 0;
+
+        char parse_format_char() {
+            this->expect_token("=");
+            std::string token = this->next_token();
+            if (token.size() != 1) {
+                this->throw_parsing_error("Expecting a single character, but found \'" +
+                        token + "\'");
+            }
+            return token.at(0);
+        }
+
+
+        // Parsing blocks
+
+        void parse() {
+            if (this->next_keyword() != "#NEXUS") {
+                this->throw_parsing_error("Expecting \'#NEXUS\' at the start of the file");
+            }
+            while (true) {
+                std::string token = this->next_keyword();
+                if (token.empty()) {
+                    break;
+                }
+                if (token != "BEGIN") {
+                    this->throw_parsing_error("Expecting \'BEGIN\', but found \'" +
+                            token + "\'");
+                }
+                std::string block_name = this->next_keyword();
+                this->expect_token(";");
+                if (block_name == "TAXA") {
+                    this->parse_taxa_block();
+                }
+                else if ((block_name == "DATA") || (block_name == "CHARACTERS")) {
+                    this->parse_character_block(block_name == "DATA");
+                }
+                else {
+                    this->skip_block();
+                }
+            }
+            if (! this->found_character_block_) {
+                if (! this->found_taxa_block_) {
+                    throw EcoevolityParsingError("No taxa block found", this->path_, 0);
+                }
+                throw EcoevolityParsingError("No character block found", this->path_, 0);
+            }
+        }
+
+
+        void parse_character_block(bool is_data_block) {
+            if (this->found_character_block_) {
+                throw EcoevolityParsingError("More than one character block found", this->path_, 0);
+            }
+            this->found_character_block_ = true;
+            unsigned int number_of_taxa = 0;
+            bool found_matrix = false;
+            bool found_symbols = false;
+            std::string symbols;
+            while (true) {
+                std::string command = this->next_keyword();
+                if ((command == "END") || (command == "ENDBLOCK")) {
+                    this->expect_token(";");
+                    break;
+                }
+                if (command == "DIMENSIONS") {
+                    std::string subcommand = this->next_keyword();
+                    while (subcommand != ";") {
+                        if (subcommand == "NTAX") {
+                            number_of_taxa = this->parse_dimension_value();
+                        }
+                        else if (subcommand == "NCHAR") {
+                            this->number_of_sites_ = this->parse_dimension_value();
+                        }
+                        else if (subcommand == "NEWTAXA") {
+                            is_data_block = true;
+                        }
+                        subcommand = this->next_keyword();
+                    }
+                }
+                else if (command == "FORMAT") {
+                    this->parse_format(found_symbols, symbols);
+                }
+                else if (command == "ELIMINATE") {
+                    this->throw_unsupported_error("ELIMINATE");
+                }
+                else if (command == "MATRIX") {
+                    if (is_data_block && (! this->found_taxa_block_)) {
+                        if (number_of_taxa < 1) {
+                            this->throw_parsing_error("Expecting NTAX in DIMENSIONS of DATA block");
+                        }
+                    }
+                    else if (! this->found_taxa_block_) {
+                        throw EcoevolityParsingError("No taxa block found", this->path_, 0);
+                    }
+                    else if ((number_of_taxa > 0) &&
+                            (number_of_taxa != this->taxon_labels_.size())) {
+                        this->throw_unsupported_error("A different NTAX than the TAXA block");
+                    }
+                    else {
+                        number_of_taxa = this->taxon_labels_.size();
+                    }
+                    this->init_codes(found_symbols, symbols);
+                    this->parse_matrix(number_of_taxa);
+                    found_matrix = true;
+                }
+                else if (command.empty()) {
+                    this->throw_parsing_error("Unexpected end of file");
+                }
+                else if (command != ";") {
+                    this->skip_command();
+                }
+            }
+            if (! found_matrix) {
+                this->throw_parsing_error("No MATRIX found in character block");
+            }
+        }
+
+        void parse_format(bool & found_symbols, std::string & symbols) {
+            while (true) {
+                std::string subcommand = this->next_keyword();
+                if (subcommand == ";") {
+                    return;
+                }
+                if (subcommand.empty()) {
+                    this->throw_parsing_error("Unexpected end of file");
+                }
+                if (subcommand == "DATATYPE") {
+                    this->expect_token("=");
+                    std::string data_type = this->next_keyword();
+                    if (data_type == "STANDARD") {
+                        this->data_type_ = NxsCharactersBlock::standard;
+                    }
+                    else if (data_type == "DNA") {
+                        this->data_type_ = NxsCharactersBlock::dna;
+                    }
+                    else if (data_type == "RNA") {
+                        this->data_type_ = NxsCharactersBlock::rna;
+                    }
+                    else if (data_type == "NUCLEOTIDE") {
+                        this->data_type_ = NxsCharactersBlock::nucleotide;
+                    }
+                    else {
+                        throw EcoevolityBiallelicDataError("Data type not supported", this->path_);
+                    }
+                }
+                else if (subcommand == "MISSING") {
+                    this->missing_char_ = this->parse_format_char();
+                }
+                else if (subcommand == "GAP") {
+                    this->gap_char_ = this->parse_format_char();
+                }
+                else if (subcommand == "MATCHCHAR") {
+                    this->match_char_ = this->parse_format_char();
+                }
+                else if (subcommand == "SYMBOLS") {
+                    this->expect_token("=");
+                    this->skip_whitespace();
+                    found_symbols = true;
+                    symbols.clear();
+                    if (this->peek_char() == '"') {
+                        this->next_char();
+                        while (true) {
+                            int c = this->next_char();
+                            if (c == std::char_traits<char>::eof()) {
+                                this->throw_parsing_error("Unterminated SYMBOLS");
+                            }
+                            if (c == '"') {
+                                break;
+                            }
+                            if (! is_whitespace(c)) {
+                                symbols += (char)c;
+                            }
+                        }
+                    }
+                    else {
+                        symbols = this->next_token();
+                    }
+                }
+                else if (subcommand == "INTERLEAVE") {
+                    this->interleaved_ = true;
+                    this->skip_whitespace();
+                    if (this->peek_char() == '=') {
+                        this->next_char();
+                        std::string value = this->next_keyword();
+                        this->interleaved_ = ((value == "YES") || (value == "TRUE"));
+                    }
+                }
+                else if (subcommand == "RESPECTCASE") {
+                    this->respecting_case_ = true;
+                }
+                else if (subcommand == "EQUATE") {
+                    this->throw_unsupported_error("EQUATE");
+                }
+                else if (subcommand == "TRANSPOSE") {
+                    this->throw_unsupported_error("TRANSPOSE");
+                }
+                else if (subcommand == "TOKENS") {
+                    this->throw_unsupported_error("TOKENS");
+                }
+                else if (subcommand == "NOLABELS") {
+                    this->throw_unsupported_error("NOLABELS");
+                }
+                else if ((subcommand == "ITEMS") || (subcommand == "STATESFORMAT")) {
+                    this->throw_unsupported_error(subcommand);
+                }
+            }
+        }
+
+        // State codes
+
+        NxsDiscreteStateCell get_state_set_code(
+                const std::vector<NxsDiscreteStateCell> & states) {
+            if ((states.size() == 1) && (states.front() < 0)) {
+                return states.front();
+            }
+            auto found = this->state_set_codes_.find(states);
+            if (found != this->state_set_codes_.end()) {
+                return found->second;
+            }
+            NxsDiscreteStateCell code = this->code_states_.size();
+            this->code_states_.push_back(states);
+            this->state_set_codes_[states] = code;
+            return code;
+        }
+
+        void add_symbol(char symbol, const std::vector<NxsDiscreteStateCell> & states) {
+            NxsDiscreteStateCell code = this->get_state_set_code(states);
+            this->set_symbol_code(symbol, code);
+        }
+
+        void set_symbol_code(char symbol, NxsDiscreteStateCell code) {
+            this->symbol_codes_.at((unsigned char)symbol) = code;
+            if (! this->respecting_case_) {
+                this->symbol_codes_.at((unsigned char)std::tolower(symbol)) = code;
+                this->symbol_codes_.at((unsigned char)std::toupper(symbol)) = code;
+            }
+        }
+
+        // The missing, gap and match characters take precedence over the
+        // symbols
+        void set_special_symbol_codes() {
+            if (this->gap_char_ != '\0') {
+                this->symbol_codes_.at((unsigned char)this->gap_char_) = NXS_GAP_STATE_CODE;
+            }
+            this->symbol_codes_.at((unsigned char)this->missing_char_) = NXS_MISSING_CODE;
+            if (this->match_char_ != '\0') {
+                this->symbol_codes_.at((unsigned char)this->match_char_) = match_code;
+            }
+        }
+
+        void init_codes(bool found_symbols, const std::string & symbols) {
+            this->code_states_.clear();
+            this->symbol_codes_.assign(256, invalid_code);
+            this->state_set_codes_.clear();
+            if (this->data_type_ == NxsCharactersBlock::standard) {
+                std::string standard_symbols = "01";
+                if (found_symbols) {
+                    standard_symbols = symbols;
+                }
+                for (unsigned int i = 0; i < standard_symbols.size(); ++i) {
+                    this->add_symbol(standard_symbols.at(i),
+                            std::vector<NxsDiscreteStateCell>(1, i));
+                }
+                this->set_special_symbol_codes();
+                return;
+            }
+            if (found_symbols) {
+                this->throw_unsupported_error("SYMBOLS for nucleotide data");
+            }
+            // The default equates of NCL
+            std::string t = "T";
+            if (this->data_type_ == NxsCharactersBlock::rna) {
+                t = "U";
+            }
+            std::map<char, std::string> iupac = {
+                {'A', "A"}, {'C', "C"}, {'G', "G"}, {t.at(0), "T"},
+                {'R', "AG"}, {'M', "AC"}, {'S', "CG"}, {'V', "ACG"},
+                {'Y', "CT"}, {'K', "GT"}, {'W', "AT"}, {'H', "ACT"},
+                {'B', "CGT"}, {'D', "AGT"}, {'N', "ACGT"}, {'X', "ACGT"}
+            };
+            if (this->data_type_ == NxsCharactersBlock::nucleotide) {
+                iupac['U'] = "T";
+            }
+            const std::string nucleotides = "ACGT";
+            // Add the single states first, so they get codes 0-3
+            for (auto n : nucleotides) {
+                char symbol = n;
+                if (n == 'T') {
+                    symbol = t.at(0);
+                }
+                this->add_symbol(symbol, std::vector<NxsDiscreteStateCell>(1,
+                        nucleotides.find(n)));
+            }
+            for (auto const & kv : iupac) {
+                std::vector<NxsDiscreteStateCell> states;
+                for (auto n : kv.second) {
+                    states.push_back(nucleotides.find(n));
+                }
+                this->add_symbol(kv.first, states);
+            }
+            this->set_special_symbol_codes();
+        }
+
+        void throw_invalid_character(int c,
+                unsigned int taxon_index,
+                unsigned int site_index) const {
+            std::string character = "end of file";
+            if (c != std::char_traits<char>::eof()) {
+                character = "\'" + std::string(1, (char)c) + "\'";
+            }
+            throw EcoevolityInvalidCharacterError(
+                    "Invalid character " + character,
+                    this->path_,
+                    this->taxon_labels_.at(taxon_index),
+                    site_index);
+        }
+
+        // Cells
+
+        // Skip to the first character of the next cell, and return it
+        int skip_to_cell() {
+            this->skip_whitespace();
+            return this->next_char();
+        }
+
+        // Parse the cell that begins with character 'c'
+        NxsDiscreteStateCell read_cell(int c,
+                unsigned int taxon_index,
+                unsigned int site_index) {
+            NxsDiscreteStateCell code = invalid_code;
+            if (c != std::char_traits<char>::eof()) {
+                code = this->symbol_codes_[(unsigned char)c];
+            }
+            // A state, set of states, missing or gap
+            if (code >= NXS_GAP_STATE_CODE) {
+                return code;
+            }
+            if (code == match_code) {
+                if (taxon_index == this->row_order_.front()) {
+                    this->throw_invalid_character(c, taxon_index, site_index);
+                }
+                return match_code;
+            }
+            if ((c != '{') && (c != '(')) {
+                this->throw_invalid_character(c, taxon_index, site_index);
+            }
+            const int closing = (c == '{') ? '}' : ')';
+            std::set<NxsDiscreteStateCell> state_set;
+            while (true) {
+                this->skip_whitespace();
+                int s = this->next_char();
+                if (s == closing) {
+                    break;
+                }
+                NxsDiscreteStateCell s_code = invalid_code;
+                if (s != std::char_traits<char>::eof()) {
+                    s_code = this->symbol_codes_[(unsigned char)s];
+                }
+                if (s_code == NXS_GAP_STATE_CODE) {
+                    state_set.insert(s_code);
+                    continue;
+                }
+                if (s_code < 0) {
+                    this->throw_invalid_character(s, taxon_index, site_index);
+                }
+                const std::vector<NxsDiscreteStateCell> & states = this->code_states_[s_code];
+                state_set.insert(states.begin(), states.end());
+            }
+            if (state_set.empty()) {
+                this->throw_invalid_character(closing, taxon_index, site_index);
+            }
+            return this->get_state_set_code(
+                    std::vector<NxsDiscreteStateCell>(state_set.begin(), state_set.end()));
+        }
+
+        // Matrix
+
+        void parse_matrix(unsigned int number_of_taxa) {
+            const bool adding_taxa = (! this->found_taxa_block_);
+            this->segments_.assign(number_of_taxa, std::vector<Segment>());
+            std::vector<unsigned int> number_of_sites_found(number_of_taxa, 0);
+            std::vector<bool> found_row(number_of_taxa, false);
+            this->row_order_.clear();
+            while (true) {
+                this->skip_whitespace();
+                if (this->peek_char() == ';') {
+                    this->next_char();
+                    break;
+                }
+                bool was_quoted;
+                std::string label = this->next_label(was_quoted);
+                if (label.empty()) {
+                    this->throw_parsing_error("Unexpected end of file in MATRIX");
+                }
+                if ((! was_quoted) && is_punctuation(label.at(0))) {
+                    this->throw_parsing_error("Expecting a taxon label, but found \'" +
+                            label + "\'");
+                }
+                auto found = this->taxon_label_indices_.find(upper(label));
+                if (found == this->taxon_label_indices_.end()) {
+                    if ((! adding_taxa) || (this->taxon_labels_.size() >= number_of_taxa)) {
+                        this->throw_parsing_error("Unknown taxon label \'" + label +
+                                "\' in MATRIX");
+                    }
+                    this->add_taxon(label);
+                    found = this->taxon_label_indices_.find(upper(label));
+                }
+                const unsigned int taxon_idx = found->second;
+                if (! found_row.at(taxon_idx)) {
+                    found_row.at(taxon_idx) = true;
+                    this->row_order_.push_back(taxon_idx);
+                }
+                else if (! this->interleaved_) {
+                    this->throw_parsing_error("Found taxon \'" + label +
+                            "\' more than once in MATRIX");
+                }
+                unsigned int & sites_found = number_of_sites_found.at(taxon_idx);
+                Segment segment;
+                segment.number_of_sites = 0;
+                // The position of the first cell is recorded after skipping
+                // the whitespace between it and the label
+                bool skipped_newline = this->skip_whitespace();
+                segment.position = this->position_;
+                while (sites_found < this->number_of_sites_) {
+                    if (this->interleaved_ && skipped_newline) {
+                        break;
+                    }
+                    if (this->peek_char() == ';') {
+                        break;
+                    }
+                    this->read_cell(this->next_char(), taxon_idx, sites_found);
+                    ++segment.number_of_sites;
+                    ++sites_found;
+                    if (this->interleaved_) {
+                        skipped_newline = this->skip_whitespace();
+                    }
+                    else {
+                        this->skip_whitespace();
+                    }
+                }
+                if (segment.number_of_sites > 0) {
+                    this->segments_.at(taxon_idx).push_back(segment);
+                }
+            }
+            if (this->taxon_labels_.size() != number_of_taxa) {
+                std::ostringstream message;
+                message << "Expecting " << number_of_taxa
+                        << " taxa in MATRIX, but found "
+                        << this->taxon_labels_.size();
+                this->throw_parsing_error(message.str());
+            }
+            for (unsigned int taxon_idx = 0; taxon_idx < number_of_taxa; ++taxon_idx) {
+                if (number_of_sites_found.at(taxon_idx) != this->number_of_sites_) {
+                    std::ostringstream message;
+                    message << "Expecting " << this->number_of_sites_
+                            << " characters for taxon \'"
+                            << this->taxon_labels_.at(taxon_idx)
+                            << "\', but found "
+                            << number_of_sites_found.at(taxon_idx);
+                    this->throw_parsing_error(message.str());
+                }
+            }
+        }
+};
+
+
+/**
+ * A rooted tree as written in a newick string.
+ *
+ * Nodes are stored in the order they appear in the string, so the root is
+ * node 0, every parent precedes its children, and the children of a node are
+ * in the order they were written. Node objects are kept when the tree is
+ * cleared, so parsing many trees into the same object does not allocate once
+ * the largest tree has been parsed.
+ */
+class NewickTree {
+
+    public:
+        struct Node {
+            int parent = -1;
+            std::vector<unsigned int> children;
+            // The taxon label of leaves, or the label of internal nodes
+            std::string label;
+            double edge_length = 0.0;
+            // The text of the comments attached to the node
+            std::vector<std::string> comments;
+        };
+
+        const std::string & get_name() const {
+            return this->name_;
+        }
+        unsigned int get_number_of_nodes() const {
+            return this->number_of_nodes_;
+        }
+        unsigned int get_number_of_leaves() const {
+            unsigned int n = 0;
+            for (unsigned int i = 0; i < this->number_of_nodes_; ++i) {
+                if (this->nodes_.at(i).children.empty()) {
+                    ++n;
+                }
+            }
+            return n;
+        }
+        const Node & get_node(unsigned int node_index) const {
+            ECOEVOLITY_ASSERT(node_index < this->number_of_nodes_);
+            return this->nodes_.at(node_index);
+        }
+        const Node & get_root() const {
+            return this->get_node(0);
+        }
+
+        void clear() {
+            this->name_.clear();
+            this->number_of_nodes_ = 0;
+        }
+
+        void set_name(const std::string & name) {
+            this->name_ = name;
+        }
+
+        /**
+         * Add a child to the node with index 'parent' (or the root if
+         * 'parent' is -1) and return the index of the new node.
+         */
+        unsigned int add_node(int parent) {
+            ECOEVOLITY_ASSERT((parent < 0) == (this->number_of_nodes_ == 0));
+            if (this->number_of_nodes_ >= this->nodes_.size()) {
+                this->nodes_.push_back(Node());
+            }
+            unsigned int node_index = this->number_of_nodes_++;
+            Node & node = this->nodes_.at(node_index);
+            node.parent = parent;
+            node.children.clear();
+            node.label.clear();
+            node.edge_length = 0.0;
+            node.comments.clear();
+            if (parent >= 0) {
+                this->nodes_.at(parent).children.push_back(node_index);
+            }
+            return node_index;
+        }
+        Node & get_mutable_node(unsigned int node_index) {
+            ECOEVOLITY_ASSERT(node_index < this->number_of_nodes_);
+            return this->nodes_.at(node_index);
+        }
+
+        /**
+         * Check whether the edge lengths of the tree are ultrametric.
+         *
+         * As in BaseTree, for every pair of leaves the path lengths from
+         * each leaf to their most recent common ancestor can differ by no
+         * more than 'proportional_tolerance' times half of the longest path
+         * between two leaves.
+         */
+        bool is_ultrametric(double proportional_tolerance = 1e-6) const {
+            // The shortest and longest paths from each node to its leaves
+            std::vector<double> min_depths(this->number_of_nodes_, 0.0);
+            std::vector<double> max_depths(this->number_of_nodes_, 0.0);
+            double max_pairwise_dist = -1.0;
+            double max_height_diff = 0.0;
+            // Parents precede their children, so visiting nodes in reverse
+            // visits children before their parent
+            for (int i = this->number_of_nodes_ - 1; i >= 0; --i) {
+                const Node & node = this->nodes_.at(i);
+                bool first_child = true;
+                for (auto child_idx : node.children) {
+                    const double len = this->nodes_.at(child_idx).edge_length;
+                    const double lo = min_depths.at(child_idx) + len;
+                    const double hi = max_depths.at(child_idx) + len;
+                    if (first_child) {
+                        min_depths.at(i) = lo;
+                        max_depths.at(i) = hi;
+                        first_child = false;
+                        continue;
+                    }
+                    // Compare the paths through this child to the paths
+                    // through the previous children
+                    max_pairwise_dist = std::max(max_pairwise_dist,
+                            max_depths.at(i) + hi);
+                    max_height_diff = std::max(max_height_diff,
+                            std::max(hi - min_depths.at(i),
+                                     max_depths.at(i) - lo));
+                    min_depths.at(i) = std::min(min_depths.at(i), lo);
+                    max_depths.at(i) = std::max(max_depths.at(i), hi);
+                }
+            }
+            double abs_tol = (max_pairwise_dist / 2.0) * proportional_tolerance;
+            return (max_height_diff <= abs_tol);
+        }
+
+    protected:
+        std::string name_;
+        std::vector<Node> nodes_;
+        unsigned int number_of_nodes_ = 0;
+};
+
+
+/**
+ * Class for reading the trees of a NEXUS file one at a time.
+ *
+ * NCL reads every tree description of a file into memory before any of them
+ * can be used, which is prohibitive for large MCMC samples of trees. This
+ * class reads the TAXA block and then parses each TREE command of the TREES
+ * block only when it is requested (or skips over it without parsing the
+ * tree), so the memory needed is that of a single tree.
+ *
+ * Trees can use the labels of the TAXA block, the keys of a TRANSLATE
+ * command, or the numbers of taxa. If there is no TAXA block, taxa are added
+ * as they are found in TRANSLATE commands and trees. Comments in trees are
+ * attached to the node they follow (or, if they precede a node, to that
+ * node), and rooting comments before a tree are ignored. A file must have a
+ * single TREES block; the END of the block can be missing (e.g., in the log of
+ * a chain that is still running).
+ */
+class NexusTreeStream : public NexusStreamReader {
+
+    public:
+        NexusTreeStream(std::istream & stream,
+                const std::string & path = "") : NexusStreamReader(path) {
+            this->buffer_ = stream.rdbuf();
+            this->parse();
+        }
+
+        unsigned int get_number_of_trees_read() const {
+            return this->number_of_trees_read_;
+        }
+
+        /**
+         * Parse the next tree into 'tree'. Returns false (and leaves 'tree'
+         * untouched) if there are no more trees.
+         */
+        bool next_tree(NewickTree & tree) {
+            std::string name;
+            if (! this->next_tree_command(name)) {
+                return false;
+            }
+            tree.clear();
+            tree.set_name(name);
+            this->parse_newick(tree);
+            ++this->number_of_trees_read_;
+            return true;
+        }
+
+        /**
+         * Skip the next tree without parsing it. Returns false if there are
+         * no more trees.
+         */
+        bool skip_tree() {
+            std::string name;
+            if (! this->next_tree_command(name)) {
+                return false;
+            }
+            this->skip_command();
+            ++this->number_of_trees_read_;
+            return true;
+        }
+
+    private:
+        bool in_trees_block_ = false;
+        bool found_trees_block_ = false;
+        unsigned int number_of_trees_read_ = 0;
+        std::map<std::string, unsigned int> translations_;
+        // The number of the last tree in which each taxon was found
+        std::vector<unsigned int> taxon_tree_numbers_;
+
+        static bool is_tree_punctuation(int c) {
+            return ((c == '(') || (c == ')') || (c == '[') || (c == ']') ||
+                    (c == ',') || (c == ';') || (c == ':') || (c == '\''));
+        }
+
+        void parse() {
+            if (this->next_keyword() != "#NEXUS") {
+                this->throw_parsing_error("Expecting \'#NEXUS\' at the start of the file");
+            }
+            this->parse_blocks();
+            if (! this->found_trees_block_) {
+                throw EcoevolityParsingError("No trees block found", this->path_, 0);
+            }
+        }
+
+        // Parse blocks until the start of a TREES block or the end of the
+        // file
+        void parse_blocks() {
+            while (true) {
+                std::string token = this->next_keyword();
+                if (token.empty()) {
+                    return;
+                }
+                if (token != "BEGIN") {
+                    this->throw_parsing_error("Expecting \'BEGIN\', but found \'" +
+                            token + "\'");
+                }
+                std::string block_name = this->next_keyword();
+                this->expect_token(";");
+                if (block_name == "TAXA") {
+                    this->parse_taxa_block();
+                }
+                else if (block_name == "TREES") {
+                    if (this->found_trees_block_) {
+                        throw EcoevolityParsingError("More than one trees block found",
+                                this->path_, 0);
+                    }
+                    this->found_trees_block_ = true;
+                    this->in_trees_block_ = true;
+                    return;
+                }
+                else {
+                    this->skip_block();
+                }
+            }
+        }
+
+        // Advance to the next TREE command and parse its name and '='.
+        // Returns false if there are no more trees.
+        bool next_tree_command(std::string & name) {
+            while (this->in_trees_block_) {
+                std::string command = this->next_keyword();
+                if (command.empty()) {
+                    this->in_trees_block_ = false;
+                }
+                else if ((command == "END") || (command == "ENDBLOCK")) {
+                    this->expect_token(";");
+                    this->in_trees_block_ = false;
+                    this->parse_blocks();
+                }
+                else if ((command == "TREE") || (command == "UTREE")) {
+                    bool was_quoted;
+                    name = this->next_label(was_quoted);
+                    if ((! was_quoted) && (name == "*")) {
+                        name = this->next_label(was_quoted);
+                    }
+                    this->expect_token("=");
+                    return true;
+                }
+                else if (command == "TRANSLATE") {
+                    this->parse_translate();
+                }
+                else if (command != ";") {
+                    this->skip_command();
+                }
+            }
+            return false;
+        }
+
+        void parse_translate() {
+            bool was_quoted;
+            while (true) {
+                std::string key = this->next_label(was_quoted);
+                if (key.empty() && (! was_quoted)) {
+                    this->throw_parsing_error("Unexpected end of file");
+                }
+                std::string label = this->next_label(was_quoted);
+                unsigned int taxon_index = this->get_taxon_index(label, false);
+                this->translations_[upper(key)] = taxon_index;
+                std::string token = this->next_token();
+                if (token == ";") {
+                    return;
+                }
+                if (token != ",") {
+                    this->throw_parsing_error("Expecting \',\' or \';\', but found \'" +
+                            token + "\'");
+                }
+            }
+        }
+
+        unsigned int get_taxon_index(const std::string & label,
+                bool use_translations) {
+            const std::string key = upper(label);
+            if (use_translations && (! this->translations_.empty())) {
+                auto t = this->translations_.find(key);
+                if (t != this->translations_.end()) {
+                    return t->second;
+                }
+            }
+            auto found = this->taxon_label_indices_.find(key);
+            if (found != this->taxon_label_indices_.end()) {
+                return found->second;
+            }
+            if ((! label.empty()) &&
+                    (label.find_first_not_of("0123456789") == std::string::npos)) {
+                std::stringstream converter(label);
+                unsigned int number = 0;
+                converter >> number;
+                if ((number > 0) && (number <= this->taxon_labels_.size())) {
+                    return number - 1;
+                }
+            }
+            if (this->found_taxa_block_) {
+                this->throw_parsing_error("Unknown taxon \'" + label + "\'");
+            }
+            this->add_taxon(label);
+            return this->taxon_labels_.size() - 1;
+        }
+
+        void read_comment(std::string & text) {
+            // The opening '[' has been consumed; comments can be nested
+            text.clear();
+            unsigned int depth = 1;
+            while (true) {
+                int c = this->next_char();
+                if (c == std::char_traits<char>::eof()) {
+                    this->throw_parsing_error("Unterminated comment");
+                }
+                if (c == '[') {
+                    ++depth;
+                }
+                else if ((c == ']') && (--depth == 0)) {
+                    return;
+                }
+                text += (char)c;
+            }
+        }
+
+        void read_tree_label(std::string & label) {
+            label.clear();
+            if (this->peek_char() == '\'') {
+                bool was_quoted;
+                label = this->next_token(was_quoted);
+                return;
+            }
+            while (true) {
+                int c = this->peek_char();
+                if ((c == std::char_traits<char>::eof()) || is_whitespace(c) ||
+                        is_tree_punctuation(c)) {
+                    break;
+                }
+                label += (char)(c == '_' ? ' ' : c);
+                this->next_char();
+            }
+        }
+
+        double read_edge_length() {
+            while (is_whitespace(this->peek_char())) {
+                this->next_char();
+            }
+            std::string token;
+            while (true) {
+                int c = this->peek_char();
+                if ((c == std::char_traits<char>::eof()) || is_whitespace(c) ||
+                        is_tree_punctuation(c)) {
+                    break;
+                }
+                token += (char)this->next_char();
+            }
+            char * end = nullptr;
+            double length = std::strtod(token.c_str(), &end);
+            if (token.empty() || (*end != '\0')) {
+                this->throw_parsing_error("Invalid edge length \'" + token + "\'");
+            }
+            return length;
+        }
+
+        // Parse the newick string of a tree up to and including its ';'
+        void parse_newick(NewickTree & tree) {
+            // Skip rooting (and other) comments before the tree
+            this->skip_whitespace();
+            if (this->taxon_tree_numbers_.size() < this->taxon_labels_.size()) {
+                this->taxon_tree_numbers_.resize(this->taxon_labels_.size(), 0);
+            }
+            const unsigned int tree_number = this->number_of_trees_read_ + 1;
+            // The node being built (whose children are being parsed), and
+            // the last node completed (to which labels, lengths and
+            // comments that follow it belong)
+            int parent = -1;
+            int current = -1;
+            std::vector<std::string> pending_comments;
+            std::string text;
+            while (true) {
+                int c = this->peek_char();
+                if (c == std::char_traits<char>::eof()) {
+                    this->throw_parsing_error("Unexpected end of file in tree");
+                }
+                if (is_whitespace(c)) {
+                    this->next_char();
+                }
+                else if (c == '[') {
+                    this->next_char();
+                    this->read_comment(text);
+                    if (current >= 0) {
+                        tree.get_mutable_node(current).comments.push_back(text);
+                    }
+                    else {
+                        pending_comments.push_back(text);
+                    }
+                }
+                else if (c == '(') {
+                    this->next_char();
+                    if ((current >= 0) || ((parent < 0) && (tree.get_number_of_nodes() > 0))) {
+                        this->throw_parsing_error("Unexpected \'(\' in tree");
+                    }
+                    parent = tree.add_node(parent);
+                    tree.get_mutable_node(parent).comments.swap(pending_comments);
+                }
+                else if (c == ',') {
+                    this->next_char();
+                    if ((current < 0) || (parent < 0)) {
+                        this->throw_parsing_error("Unexpected \',\' in tree");
+                    }
+                    current = -1;
+                }
+                else if (c == ')') {
+                    this->next_char();
+                    if ((current < 0) || (parent < 0)) {
+                        this->throw_parsing_error("Unexpected \')\' in tree");
+                    }
+                    current = parent;
+                    parent = tree.get_node(parent).parent;
+                }
+                else if (c == ':') {
+                    this->next_char();
+                    if (current < 0) {
+                        this->throw_parsing_error("Unexpected \':\' in tree");
+                    }
+                    tree.get_mutable_node(current).edge_length = this->read_edge_length();
+                }
+                else if (c == ';') {
+                    this->next_char();
+                    if ((parent >= 0) || (current < 0)) {
+                        this->throw_parsing_error("Unbalanced parentheses in tree");
+                    }
+                    return;
+                }
+                else if (c == ']') {
+                    this->throw_parsing_error("Unexpected \']\' in tree");
+                }
+                else {
+                    this->read_tree_label(text);
+                    if (current >= 0) {
+                        // Label of an internal node
+                        NewickTree::Node & node = tree.get_mutable_node(current);
+                        if (node.children.empty() || (! node.label.empty())) {
+                            this->throw_parsing_error("Unexpected label \'" +
+                                    text + "\' in tree");
+                        }
+                        node.label = text;
+                        continue;
+                    }
+                    if ((parent < 0) && (tree.get_number_of_nodes() > 0)) {
+                        this->throw_parsing_error("Unexpected label \'" +
+                                text + "\' in tree");
+                    }
+                    unsigned int taxon_index = this->get_taxon_index(text, true);
+                    if (this->taxon_tree_numbers_.size() <= taxon_index) {
+                        this->taxon_tree_numbers_.resize(taxon_index + 1, 0);
+                    }
+                    if (this->taxon_tree_numbers_.at(taxon_index) == tree_number) {
+                        this->throw_parsing_error("Taxon \'" +
+                                this->taxon_labels_.at(taxon_index) +
+                                "\' appears more than once in tree");
+                    }
+                    this->taxon_tree_numbers_.at(taxon_index) = tree_number;
+                    current = tree.add_node(parent);
+                    NewickTree::Node & node = tree.get_mutable_node(current);
+                    node.label = this->taxon_labels_.at(taxon_index);
+                    node.comments.swap(pending_comments);
+                }
+            }
+        }
+};
+
+#endif
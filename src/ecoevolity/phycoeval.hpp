@@ -87,7 +87,8 @@ int phycoeval_main(int argc, char * argv[]) {
             .type("unsigned int")
             .dest("nthreads")
             .set_default("1")
-            .help("Number of threads to use for likelihood calculations. "
+            .help("Number of threads to use for parsing the alignment and "
+                  "for likelihood calculations. "
                   "Default: 1 (no multithreading). If you are using "
                   "the \'--ignore-data\' option, no likelihood calculations "
                   "will be performed, and so no multithreading is used.");
@@ -198,8 +199,8 @@ int phycoeval_main(int argc, char * argv[]) {
             strict_on_constant_sites,
             strict_on_missing_sites,
             strict_on_triallelic_sites,
-            false // store_seq_loci_info
-            );
+            false, // store_seq_loci_info
+            nthreads);
 
     GeneralTreeOperatorSchedule<BasePopulationTree> operator_schedule(
             settings.operator_settings, tree.get_leaf_node_count());
@@ -417,8 +417,7 @@ class RandomNumberGenerator {
                 return;
             }
             else if (
-                    (stirling2_base<long double>(N-1, k-1) /
-                     stirling2_base<long double>(N, k)) >
+                    std::exp(ln_stirling2(N-1, k-1) - ln_stirling2(N, k)) >
                     this->uniform_real()) {
                 subsets.push_back({N-1});
                 std::vector< std::vector<unsigned int> > remaining_subsets;
@@ -509,19 +508,16 @@ class RandomNumberGenerator {
             if (possible_numbers_of_subsets.size() == 1) {
                 return possible_numbers_of_subsets.at(0);
             }
-            std::vector<long double> ncat_probs;
+            // Weights are in log space until normalized
+            std::vector<double> ncat_probs;
             ncat_probs.reserve(possible_numbers_of_subsets.size());
-            long double denom = 0.0;
-            long double p = 0.0;
+            const double ln_split_weight = std::log(split_weight);
             for (auto k : possible_numbers_of_subsets) {
                 ECOEVOLITY_ASSERT((k > 0) && (k <= number_of_elements));
-                p = stirling2_base<long double>(number_of_elements, k) * std::pow(split_weight, (k - 1));
-                ncat_probs.push_back(p);
-                denom += p;
-            }
-            for (unsigned int i = 0; i < ncat_probs.size(); ++i) {
-                ncat_probs.at(i) = ncat_probs.at(i) / denom;
+                ncat_probs.push_back(ln_stirling2(number_of_elements, k) +
+                        ((k - 1) * ln_split_weight));
             }
+            normalize_log_likelihoods(ncat_probs);
             unsigned int ncats_idx = this->weighted_index(ncat_probs);
             return possible_numbers_of_subsets.at(ncats_idx);
         }
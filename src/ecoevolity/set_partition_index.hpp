@@ -0,0 +1,166 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_SET_PARTITION_INDEX_HPP
+#define ECOEVOLITY_SET_PARTITION_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+
+#include "error.hpp"
+
+
+/**
+ * Maps the set partitions (event models) of a fixed number of elements to
+ * and from compact integer keys.
+ *
+ * Models are given as restricted growth strings, which is how ecoevolity
+ * standardizes event models: the first element is in subset 0, and each
+ * element is either in a subset used by an earlier element or in the next
+ * new subset. The key of a model is its lexicographic rank among all such
+ * strings, so keys run from 0 to Bell(n) - 1 without collisions. The rank
+ * is built from a table of the number of ways each prefix can be completed.
+ *
+ * Bell(n) only fits in 64 bits for n <= 25, so is_indexable() should be
+ * checked before using the keys.
+ */
+class SetPartitionIndex {
+    private:
+        typedef std::uint64_t key_type;
+
+        unsigned int number_of_elements_ = 0;
+        bool is_indexable_ = false;
+        // completions_[i][k] is the number of ways to finish a string with
+        // elements i to n-1, when k subsets have been used by elements 0 to
+        // i-1
+        std::vector< std::vector<key_type> > completions_;
+
+    public:
+        SetPartitionIndex() { }
+        SetPartitionIndex(unsigned int number_of_elements) {
+            this->init(number_of_elements);
+        }
+
+        void init(unsigned int number_of_elements) {
+            if (number_of_elements < 1) {
+                throw EcoevolityError(
+                        "SetPartitionIndex::init(): Need at least one element");
+            }
+            const unsigned int n = number_of_elements;
+            const key_type max_key = std::numeric_limits<key_type>::max();
+            this->number_of_elements_ = n;
+            this->is_indexable_ = true;
+            this->completions_.assign(n + 1, std::vector<key_type>(n + 2, 0));
+            for (unsigned int k = 0; k <= (n + 1); ++k) {
+                this->completions_[n][k] = 1;
+            }
+            for (int i = (n - 1); i >= 0; --i) {
+                for (unsigned int k = 0; k <= (unsigned int)i; ++k) {
+                    key_type existing = this->completions_[i + 1][k];
+                    key_type fresh = this->completions_[i + 1][k + 1];
+                    if (((k > 0) && (existing > (max_key / k))) ||
+                            ((k * existing) > (max_key - fresh))) {
+                        this->is_indexable_ = false;
+                        return;
+                    }
+                    this->completions_[i][k] = (k * existing) + fresh;
+                }
+            }
+        }
+
+        unsigned int get_number_of_elements() const {
+            return this->number_of_elements_;
+        }
+
+        bool is_indexable() const {
+            return this->is_indexable_;
+        }
+
+        /**
+         * The number of set partitions, Bell(n).
+         */
+        key_type get_number_of_partitions() const {
+            this->check_indexable();
+            return this->completions_[0][0];
+        }
+
+        key_type get_key(const std::vector<unsigned int> & model) const {
+            this->check_indexable();
+            if (model.size() != this->number_of_elements_) {
+                throw EcoevolityError(
+                        "SetPartitionIndex::get_key(): Model has wrong number "
+                        "of elements");
+            }
+            key_type key = 0;
+            unsigned int nsubsets = 0;
+            for (unsigned int i = 0; i < model.size(); ++i) {
+                if (model[i] > nsubsets) {
+                    std::ostringstream message;
+                    message << "SetPartitionIndex::get_key(): Model is not a "
+                            << "restricted growth string; element " << i
+                            << " is in subset " << model[i]
+                            << " after only " << nsubsets
+                            << " subsets were used";
+                    throw EcoevolityError(message.str());
+                }
+                key += model[i] * this->completions_[i + 1][nsubsets];
+                if (model[i] == nsubsets) {
+                    ++nsubsets;
+                }
+            }
+            return key;
+        }
+
+        std::vector<unsigned int> get_model(key_type key) const {
+            this->check_indexable();
+            if (key >= this->get_number_of_partitions()) {
+                throw EcoevolityError(
+                        "SetPartitionIndex::get_model(): Key is out of range");
+            }
+            std::vector<unsigned int> model(this->number_of_elements_, 0);
+            unsigned int nsubsets = 0;
+            for (unsigned int i = 0; i < model.size(); ++i) {
+                key_type block = this->completions_[i + 1][nsubsets];
+                key_type quotient = key / block;
+                unsigned int subset = (quotient > nsubsets) ?
+                        nsubsets : (unsigned int)quotient;
+                key -= subset * block;
+                model[i] = subset;
+                if (subset == nsubsets) {
+                    ++nsubsets;
+                }
+            }
+            return model;
+        }
+
+    private:
+        void check_indexable() const {
+            if (! this->is_indexable_) {
+                std::ostringstream message;
+                message << "SetPartitionIndex: The set partitions of "
+                        << this->number_of_elements_
+                        << " elements cannot be indexed with 64-bit keys";
+                throw EcoevolityError(message.str());
+            }
+        }
+};
+
+#endif
@@ -35,6 +35,7 @@
 #include "assert.hpp"
 #include "string_util.hpp"
 #include "path.hpp"
+#include "sim_archive.hpp"
 #include "math_util.hpp"
 #include "probability.hpp"
 #include "data.hpp"
@@ -3088,6 +3089,22 @@ class BaseCollectionSettings {
         }
 
         void set_output_paths_to_config_directory() {
+            std::string archive_path;
+            unsigned int replicate_index;
+            std::string member_name;
+            if (sim_archive::parse_member_path(this->path_,
+                        archive_path,
+                        replicate_index,
+                        member_name)) {
+                // The config is in a simulation archive, so write the logs
+                // next to the archive
+                std::string prefix = path::splitext(archive_path).first + "-" +
+                        std::to_string(replicate_index) + "-" +
+                        path::splitext(member_name).first;
+                this->state_log_path_ = prefix + "-state-run-1.log";
+                this->operator_log_path_ = prefix + "-operator-run-1.log";
+                return;
+            }
             std::pair<std::string, std::string> prefix_ext = path::splitext(this->path_);
             this->state_log_path_ = prefix_ext.first + "-state-run-1.log";
             this->operator_log_path_ = prefix_ext.first + "-operator-run-1.log";
@@ -3100,6 +3117,11 @@ class BaseCollectionSettings {
             ECOEVOLITY_ASSERT(this->operator_schedule_settings_.using_population_size_multipliers() == this->comparisons_.at(0).using_population_size_multipliers());
         }
         void init_from_config_file(const std::string& path) {
+            if (sim_archive::is_member_path(path)) {
+                std::istringstream member_stream(sim_archive::read_member(path));
+                this->init_from_config_stream(member_stream, path);
+                return;
+            }
             std::ifstream in_stream;
             in_stream.open(path);
             if (! in_stream.is_open()) {
@@ -0,0 +1,325 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_SIM_ARCHIVE_HPP
+#define ECOEVOLITY_SIM_ARCHIVE_HPP
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstdio>
+
+#include "error.hpp"
+#include "path.hpp"
+
+
+/**
+ * A single file that holds all the files (members) simulated for each
+ * replicate of a run of simcoevolity.
+ *
+ * The archive starts with a magic line, followed by one block per replicate.
+ * Each block is a small table of the sizes and names of its members, followed
+ * by the contents of the members. After the last block is an index with a
+ * fixed-width record of the offset of each block, and the archive ends with a
+ * fixed-width trailer giving the offset of the index and the number of
+ * replicates. So, any member of any replicate can be read with a few seeks,
+ * without scanning the archive.
+ *
+ * A member is referred to with a path of the form
+ * 'ARCHIVE-PATH#REPLICATE-INDEX/MEMBER-NAME'. Because the members of a
+ * replicate look like files in the same directory, the paths to alignments in
+ * an archived config are simply the names of the alignment members.
+ */
+namespace sim_archive {
+
+static const std::string MAGIC = "ECOEVOLITY-SIMULATION-ARCHIVE 1\n";
+// Fixed-width index records and trailer
+static const unsigned int INDEX_RECORD_LENGTH = 21;
+static const unsigned int TRAILER_LENGTH = 48;
+
+/**
+ * Split a path of the form 'ARCHIVE-PATH#REPLICATE-INDEX/MEMBER-NAME'.
+ *
+ * Returns false if the path is not of this form or if the archive file does
+ * not exist.
+ */
+inline bool parse_member_path(
+        const std::string & member_path,
+        std::string & archive_path,
+        unsigned int & replicate_index,
+        std::string & member_name) {
+    std::size_t hash_pos = member_path.rfind('#');
+    if (hash_pos == std::string::npos) {
+        return false;
+    }
+    std::size_t slash_pos = member_path.find('/', hash_pos);
+    if ((slash_pos == std::string::npos) ||
+            (slash_pos == hash_pos + 1) ||
+            (slash_pos + 1 >= member_path.size())) {
+        return false;
+    }
+    std::string rep_str = member_path.substr(hash_pos + 1, slash_pos - hash_pos - 1);
+    for (auto c : rep_str) {
+        if ((c < '0') || (c > '9')) {
+            return false;
+        }
+    }
+    archive_path = member_path.substr(0, hash_pos);
+    if (! path::isfile(archive_path)) {
+        return false;
+    }
+    replicate_index = std::stoul(rep_str);
+    member_name = member_path.substr(slash_pos + 1);
+    return true;
+}
+
+inline bool is_member_path(const std::string & p) {
+    if (path::exists(p)) {
+        return false;
+    }
+    std::string archive_path;
+    unsigned int replicate_index;
+    std::string member_name;
+    return parse_member_path(p, archive_path, replicate_index, member_name);
+}
+
+inline std::string get_member_path(
+        const std::string & archive_path,
+        unsigned int replicate_index,
+        const std::string & member_name) {
+    return archive_path + "#" + std::to_string(replicate_index) + "/" + member_name;
+}
+
+} // namespace sim_archive
+
+
+class SimulationArchiveWriter {
+    private:
+        std::string path_;
+        std::ofstream out_;
+        std::vector<char> stream_buffer_;
+        std::vector<unsigned long long> block_offsets_;
+        unsigned long long position_ = 0;
+
+    public:
+        SimulationArchiveWriter(const std::string & path) : path_(path) {
+            // Members are appended with large writes, so give the stream a
+            // large buffer
+            this->stream_buffer_.resize(1 << 20);
+            this->out_.rdbuf()->pubsetbuf(this->stream_buffer_.data(),
+                    this->stream_buffer_.size());
+            this->out_.open(path, std::ios::out | std::ios::binary);
+            if (! this->out_.is_open()) {
+                throw EcoevolitySimulationArchiveError(
+                        "Could not open archive for writing", path);
+            }
+            this->write(sim_archive::MAGIC);
+        }
+        ~SimulationArchiveWriter() {
+            if (this->out_.is_open()) {
+                try {
+                    this->close();
+                }
+                catch (...) { }
+            }
+        }
+
+        /**
+         * Append the next replicate, given as pairs of member names and
+         * contents.
+         */
+        void add_replicate(
+                const std::vector< std::pair<std::string, std::string> > & members) {
+            this->block_offsets_.push_back(this->position_);
+            std::ostringstream table;
+            table << members.size() << "\n";
+            for (auto const & name_contents : members) {
+                if (name_contents.first.find('\n') != std::string::npos) {
+                    throw EcoevolitySimulationArchiveError(
+                            "Archive member names cannot contain new lines",
+                            this->path_);
+                }
+                table << name_contents.second.size() << "\t"
+                      << name_contents.first << "\n";
+            }
+            this->write(table.str());
+            for (auto const & name_contents : members) {
+                this->write(name_contents.second);
+            }
+        }
+
+        unsigned int get_number_of_replicates() const {
+            return this->block_offsets_.size();
+        }
+
+        void close() {
+            const unsigned long long index_offset = this->position_;
+            char record[sim_archive::TRAILER_LENGTH + 1];
+            for (auto offset : this->block_offsets_) {
+                std::snprintf(record, sizeof(record), "%020llu\n", offset);
+                this->write(std::string(record, sim_archive::INDEX_RECORD_LENGTH));
+            }
+            std::snprintf(record, sizeof(record), "INDEX %020llu %020llu\n",
+                    index_offset,
+                    (unsigned long long)this->block_offsets_.size());
+            this->write(std::string(record, sim_archive::TRAILER_LENGTH));
+            this->out_.close();
+            if (this->out_.fail()) {
+                throw EcoevolitySimulationArchiveError(
+                        "Problem writing archive", this->path_);
+            }
+        }
+
+    private:
+        void write(const std::string & s) {
+            this->out_.write(s.data(), s.size());
+            this->position_ += s.size();
+        }
+};
+
+
+class SimulationArchiveReader {
+    private:
+        std::string path_;
+        std::ifstream in_;
+        unsigned long long index_offset_ = 0;
+        unsigned int number_of_replicates_ = 0;
+
+    public:
+        SimulationArchiveReader(const std::string & path) : path_(path) {
+            this->in_.open(path, std::ios::in | std::ios::binary);
+            if (! this->in_.is_open()) {
+                throw EcoevolitySimulationArchiveError(
+                        "Could not open archive", path);
+            }
+            std::string magic(sim_archive::MAGIC.size(), '\0');
+            this->in_.read(&magic[0], magic.size());
+            if ((! this->in_) || (magic != sim_archive::MAGIC)) {
+                throw EcoevolitySimulationArchiveError(
+                        "Not a simulation archive", path);
+            }
+            this->in_.seekg(-((long long)sim_archive::TRAILER_LENGTH), std::ios::end);
+            std::string trailer(sim_archive::TRAILER_LENGTH, '\0');
+            this->in_.read(&trailer[0], trailer.size());
+            std::istringstream trailer_stream(trailer);
+            std::string label;
+            unsigned long long nreps;
+            if ((! this->in_) ||
+                    (! (trailer_stream >> label >> this->index_offset_ >> nreps)) ||
+                    (label != "INDEX")) {
+                throw EcoevolitySimulationArchiveError(
+                        "Archive is truncated or its index is corrupt", path);
+            }
+            this->number_of_replicates_ = nreps;
+        }
+
+        unsigned int get_number_of_replicates() const {
+            return this->number_of_replicates_;
+        }
+
+        /**
+         * Return the names and sizes of the members of a replicate, and leave
+         * the stream at the start of the contents of the first member.
+         */
+        std::vector< std::pair<std::string, unsigned long long> > get_members(
+                unsigned int replicate_index) {
+            if (replicate_index >= this->number_of_replicates_) {
+                std::ostringstream message;
+                message << "Archive has no replicate " << replicate_index;
+                throw EcoevolitySimulationArchiveError(message.str(), this->path_);
+            }
+            this->in_.clear();
+            this->in_.seekg(this->index_offset_ +
+                    ((unsigned long long)replicate_index * sim_archive::INDEX_RECORD_LENGTH));
+            unsigned long long block_offset;
+            if (! (this->in_ >> block_offset)) {
+                throw EcoevolitySimulationArchiveError(
+                        "Archive index is corrupt", this->path_);
+            }
+            this->in_.seekg(block_offset);
+            std::string line;
+            std::getline(this->in_, line);
+            unsigned int nmembers = std::stoul(line);
+            std::vector< std::pair<std::string, unsigned long long> > members;
+            members.reserve(nmembers);
+            for (unsigned int i = 0; i < nmembers; ++i) {
+                std::getline(this->in_, line);
+                std::size_t tab_pos = line.find('\t');
+                if ((! this->in_) || (tab_pos == std::string::npos)) {
+                    throw EcoevolitySimulationArchiveError(
+                            "Archive member table is corrupt", this->path_);
+                }
+                members.push_back(std::make_pair(
+                        line.substr(tab_pos + 1),
+                        std::stoull(line.substr(0, tab_pos))));
+            }
+            return members;
+        }
+
+        std::string read_member(
+                unsigned int replicate_index,
+                const std::string & member_name) {
+            std::vector< std::pair<std::string, unsigned long long> > members =
+                    this->get_members(replicate_index);
+            unsigned long long offset = this->in_.tellg();
+            for (auto const & name_size : members) {
+                if (name_size.first == member_name) {
+                    std::string contents(name_size.second, '\0');
+                    this->in_.seekg(offset);
+                    this->in_.read(&contents[0], contents.size());
+                    if (! this->in_) {
+                        throw EcoevolitySimulationArchiveError(
+                                "Archive is truncated", this->path_);
+                    }
+                    return contents;
+                }
+                offset += name_size.second;
+            }
+            throw EcoevolitySimulationArchiveError(
+                    "Replicate " + std::to_string(replicate_index) +
+                    " has no member \'" + member_name + "\'",
+                    this->path_);
+        }
+};
+
+
+namespace sim_archive {
+
+/**
+ * Read the member at a path of the form
+ * 'ARCHIVE-PATH#REPLICATE-INDEX/MEMBER-NAME'.
+ */
+inline std::string read_member(const std::string & member_path) {
+    std::string archive_path;
+    unsigned int replicate_index;
+    std::string member_name;
+    if (! parse_member_path(member_path, archive_path, replicate_index, member_name)) {
+        throw EcoevolitySimulationArchiveError(
+                "Not a path to a member of a simulation archive",
+                member_path);
+    }
+    SimulationArchiveReader reader(archive_path);
+    return reader.read_member(replicate_index, member_name);
+}
+
+} // namespace sim_archive
+
+#endif
@@ -23,6 +23,11 @@
 #include <limits>
 #include <time.h>
 
+#ifdef BUILD_WITH_THREADS
+#include <mutex>
+#include <future>
+#endif
+
 #include "cpp-optparse/OptionParser.h"
 
 #include "version.hpp"
@@ -31,6 +36,9 @@
 #include "path.hpp"
 #include "settings.hpp"
 #include "collection.hpp"
+#include "spreadsheet.hpp"
+#include "stats_util.hpp"
+#include "sim_archive.hpp"
 
 
 void write_sim_splash(std::ostream& out);
@@ -145,6 +153,28 @@ int simcoevolity_main(int argc, char * argv[]) {
                   "settings for the '-o/--output-directory', '-l/--locus-size' "
                   "and '-p/--prior' options will be ignored."
                 );
+    parser.add_option("--calibrate")
+            .action("store_true")
+            .dest("calibrate")
+            .help("Run a simulation-based calibration of the analysis model. "
+                  "For each replicate, parameter values are drawn from the "
+                  "prior, data sets are simulated in memory and analyzed with "
+                  "the priors and MCMC settings of the prior config (see "
+                  "\'-p/--prior\'), and the rank of each true parameter value "
+                  "among the posterior samples is recorded, along with "
+                  "whether the true value is within the 95% credible "
+                  "intervals. No alignments or configs are written; only a "
+                  "table of ranks and a table summarizing the coverage of "
+                  "the credible intervals are written to the output "
+                  "directory.");
+    parser.add_option("--calibration-burnin")
+            .action("store")
+            .type("unsigned int")
+            .dest("calibration_burnin")
+            .set_default("0")
+            .help("Number of MCMC samples from the beginning of the analysis "
+                  "of each simulated data set to ignore as burn in when "
+                  "using the \'--calibrate\' option. Default: 0.");
     parser.add_option("--prefix")
             .action("store")
             .dest("prefix")
@@ -178,12 +208,38 @@ int simcoevolity_main(int argc, char * argv[]) {
                   "retained, but all simulated sites will have at most two "
                   "character states."
                 );
+#ifdef BUILD_WITH_THREADS
+    parser.add_option("--nthreads")
+            .action("store")
+            .type("unsigned int")
+            .dest("nthreads")
+            .set_default("1")
+            .help("Number of threads to use for loading the alignments and "
+                  "simulating the data sets (or drawing the parameters when "
+                  "using \'--parameters-only\'). Every replicate (or block "
+                  "of parameter draws) is simulated with its own random "
+                  "number stream seeded from the main seed, so the output "
+                  "does not depend on the number of threads. Default: 1 (no "
+                  "multithreading).");
+#endif
     parser.add_option("--nexus")
             .action("store_true")
             .dest("output_nexus")
             .help("Output simulated data in nexus format, rather than the "
                   "default YAML format."
                 );
+    parser.add_option("--archive")
+            .action("store_true")
+            .dest("archive")
+            .help("Rather than writing separate files for every replicate, "
+                  "pack the config, true values, and (YAML-formatted) "
+                  "alignments of all the replicates into a single indexed "
+                  "archive file. Ecoevolity can analyze a replicate straight "
+                  "from the archive by giving it the path to the config of the "
+                  "replicate in the archive as "
+                  "\'ARCHIVE-PATH#REPLICATE-INDEX/config.yml\' (e.g., "
+                  "\'simcoevolity-sims.simarchive#0/config.yml\' for the "
+                  "first replicate).");
 
     optparse::Values& options = parser.parse_args(argc, argv);
     std::vector<std::string> args = parser.args();
@@ -232,6 +288,30 @@ int simcoevolity_main(int argc, char * argv[]) {
     const bool strict_on_triallelic_sites = (! options.get("relax_triallelic_sites"));
     const bool simulate_sequences = (! options.get("parameters_only"));
     const bool output_nexus = options.get("output_nexus");
+    const bool write_archive = options.get("archive");
+    if (write_archive && output_nexus) {
+        throw EcoevolityError(
+                "The \'--archive\' and \'--nexus\' options cannot be used "
+                "together; archived alignments are always YAML formatted");
+    }
+    const bool calibrate = options.get("calibrate");
+    const unsigned int calibration_burnin = options.get("calibration_burnin");
+    if (calibrate && (! simulate_sequences)) {
+        throw EcoevolityError(
+                "The \'--calibrate\' and \'--parameters-only\' options "
+                "cannot be used together");
+    }
+    if (write_archive && ((! simulate_sequences) || calibrate)) {
+        throw EcoevolityError(
+                "The \'--archive\' option cannot be used with the "
+                "\'--calibrate\' or \'--parameters-only\' options");
+    }
+
+#ifdef BUILD_WITH_THREADS 
+    unsigned int nthreads = options.get("nthreads");
+#else
+    unsigned int nthreads = 1;
+#endif
 
     if (args.size() < 1) {
         throw EcoevolityError("Path to YAML-formatted config file is required");
@@ -306,7 +386,7 @@ int simcoevolity_main(int argc, char * argv[]) {
         }
     }
 
-    if (simulate_sequences) {
+    if (simulate_sequences && (! calibrate)) {
         std::string sim_settings_path = path::join(
                 output_dir,
                 output_prefix + "model-used-for-sims.yml");
@@ -327,7 +407,8 @@ int simcoevolity_main(int argc, char * argv[]) {
             strict_on_constant_sites,
             strict_on_missing_sites,
             strict_on_triallelic_sites,
-            use_charsets);
+            use_charsets,
+            nthreads);
 
     if (using_prior_config) {
         // Not used but creating instance to vet settings
@@ -338,7 +419,8 @@ int simcoevolity_main(int argc, char * argv[]) {
                 strict_on_constant_sites,
                 strict_on_missing_sites,
                 strict_on_triallelic_sites,
-                use_charsets);
+                use_charsets,
+                nthreads);
     }
 
     if (use_charsets) {
@@ -358,78 +440,532 @@ int simcoevolity_main(int argc, char * argv[]) {
     time_t finish;
     time(&start);
 
+    // Simulates a data set of the requested type from a tree
+    auto simulate_alignment = [&](const BasePopulationTree & tree,
+            RandomNumberGenerator & sim_rng) -> BiallelicData {
+        if (use_charsets) {
+            return tree.simulate_linked_biallelic_data_set(sim_rng,
+                    singleton_sample_probability,
+                    max_one_variable_site_per_locus,
+                    true);
+        }
+        if (locus_size < 2) {
+            return tree.simulate_biallelic_data_set(sim_rng,
+                    singleton_sample_probability,
+                    true);
+        }
+        if (max_one_variable_site_per_locus) {
+            return tree.simulate_data_set_max_one_variable_site_per_locus(sim_rng,
+                    locus_size,
+                    singleton_sample_probability,
+                    true).first;
+        }
+        return tree.simulate_complete_biallelic_data_set(sim_rng,
+                locus_size,
+                singleton_sample_probability,
+                true).first;
+    };
+
     std::cerr << "Starting simulations..." << std::endl;
-    if (simulate_sequences) {
-        unsigned int pad_width = std::to_string(nreps).size();
-        std::string sim_prefix = path::join(output_dir,
-                output_prefix + "sim-");
-        std::map<std::string, BiallelicData> sim_alignments;
-        for (unsigned int i = 0; i < nreps; ++i) {
-            std::cerr << "Simulating data set " << (i + 1) << " of " << nreps << "\n";
-            std::string rep_str = string_util::pad_int(i, pad_width);
-            std::string analysis_config_path = sim_prefix + rep_str + "-config.yml";
-            check_output_path(analysis_config_path);
-            std::string true_state_path = sim_prefix + rep_str + "-true-values.txt";
-            check_output_path(true_state_path);
-
-            comparisons.draw_from_prior(rng);
-            if (use_charsets) {
-                sim_alignments = comparisons.simulate_linked_biallelic_data_sets(rng,
-                        singleton_sample_probability,
-                        max_one_variable_site_per_locus,
-                        true);
+    if (calibrate) {
+        std::string ranks_path = path::join(output_dir,
+                output_prefix + "calibration-ranks.txt");
+        check_output_path(ranks_path);
+        std::string coverage_path = path::join(output_dir,
+                output_prefix + "calibration-coverage.txt");
+        check_output_path(coverage_path);
+
+        unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+        number_of_workers = std::max(1u, std::min(nthreads, nreps));
+#endif
+        const unsigned int analysis_nthreads = std::max(1u,
+                nthreads / number_of_workers);
+        const unsigned int chain_length = prior_settings.get_chain_length();
+        const unsigned int sample_frequency = prior_settings.get_sample_frequency();
+
+        // Each worker simulates from its own copy of the trees and analyzes
+        // the simulated data with its own model, which is only configured
+        // (and the alignments parsed) once
+        std::cerr << "Configuring models for analyses of simulated data sets..." << std::endl;
+        std::vector< std::vector<BasePopulationTree> > worker_trees(number_of_workers);
+        std::vector< std::shared_ptr<CollectionType> > worker_analyses;
+        worker_analyses.reserve(number_of_workers);
+        for (unsigned int w = 0; w < number_of_workers; ++w) {
+            worker_trees.at(w).reserve(comparisons.get_number_of_trees());
+            for (unsigned int t = 0; t < comparisons.get_number_of_trees(); ++t) {
+                worker_trees.at(w).push_back(BasePopulationTree(*comparisons.get_tree(t)));
             }
-            else if (locus_size < 2) {
-                sim_alignments = comparisons.simulate_biallelic_data_sets(rng,
-                        singleton_sample_probability,
-                        true);
+            worker_analyses.push_back(std::make_shared<CollectionType>(
+                    prior_settings,
+                    rng,
+                    strict_on_constant_sites,
+                    strict_on_missing_sites,
+                    strict_on_triallelic_sites,
+                    false, // store_seq_loci_info
+                    analysis_nthreads));
+            worker_analyses.back()->set_logging_delimiter("\t");
+        }
+
+        // The trees of the analysis model can be in a different order than
+        // those used for simulating
+        std::vector<unsigned int> sim_tree_indices;
+        for (unsigned int t = 0; t < worker_analyses.at(0)->get_number_of_trees(); ++t) {
+            const std::string & p = worker_analyses.at(0)->get_tree(t)->get_data().get_path();
+            for (unsigned int sim_t = 0; sim_t < comparisons.get_number_of_trees(); ++sim_t) {
+                if (comparisons.get_tree(sim_t)->get_data().get_path() == p) {
+                    sim_tree_indices.push_back(sim_t);
+                    break;
+                }
             }
-            else {
-                sim_alignments = comparisons.simulate_complete_biallelic_data_sets(rng,
-                        locus_size,
-                        singleton_sample_probability,
-                        max_one_variable_site_per_locus,
-                        true);
+        }
+        ECOEVOLITY_ASSERT(sim_tree_indices.size() == comparisons.get_number_of_trees());
+
+        // Calibrate every parameter that is logged by both models (other
+        // than the generation, likelihoods, priors, and the arbitrary
+        // indices of the event times)
+        comparisons.set_logging_delimiter("\t");
+        std::vector<std::string> true_header;
+        std::vector<std::string> analysis_header;
+        {
+            std::stringstream header_stream;
+            comparisons.write_state_log_header(header_stream);
+            spreadsheet::parse_header(header_stream, true_header);
+        }
+        {
+            std::stringstream header_stream;
+            worker_analyses.at(0)->write_state_log_header(header_stream);
+            spreadsheet::parse_header(header_stream, analysis_header);
+        }
+        std::vector<std::string> parameter_names;
+        std::vector<unsigned int> true_columns;
+        for (auto const & h : analysis_header) {
+            if ((h == "generation") ||
+                    string_util::startswith(h, "ln_likelihood") ||
+                    string_util::startswith(h, "ln_prior") ||
+                    string_util::startswith(h, "root_height_index")) {
+                continue;
+            }
+            for (unsigned int i = 0; i < true_header.size(); ++i) {
+                if (true_header.at(i) == h) {
+                    parameter_names.push_back(h);
+                    true_columns.push_back(i);
+                    break;
+                }
             }
+        }
+        if (parameter_names.empty()) {
+            throw EcoevolityError(
+                    "None of the parameters of the analysis model are in the "
+                    "model used for simulations");
+        }
+        const unsigned int nparameters = parameter_names.size();
 
-            std::ofstream true_state_stream;
-            true_state_stream.open(true_state_path);
-            true_state_stream.precision(comparisons.get_logging_precision());
-            comparisons.write_state_log_header(true_state_stream);
-            comparisons.log_state(true_state_stream, 0);
-            true_state_stream.close();
+        std::ofstream ranks_stream;
+        ranks_stream.open(ranks_path);
+        ranks_stream << "replicate\tnumber_of_samples";
+        for (auto const & p : parameter_names) {
+            ranks_stream << "\t" << p;
+        }
+        ranks_stream << std::endl;
 
+        // Rows of the rank table are written in replicate order as soon as
+        // every earlier replicate has finished, and the coverage counts are
+        // accumulated as the rows are written
+        std::vector< std::vector<unsigned long> > rep_ranks(nreps);
+        std::vector<unsigned int> rep_number_of_samples(nreps, 0);
+        std::vector< std::vector<bool> > rep_in_hpd(nreps);
+        std::vector< std::vector<bool> > rep_in_eti(nreps);
+        std::vector<bool> rep_is_done(nreps, false);
+        unsigned int next_rep_to_write = 0;
+        std::vector<double> sum_of_normalized_ranks(nparameters, 0.0);
+        std::vector<unsigned int> number_in_hpd(nparameters, 0);
+        std::vector<unsigned int> number_in_eti(nparameters, 0);
 
-            std::ofstream sim_alignment_stream;
-            for (auto const & k_v: sim_alignments) {
-                std::string sim_alignment_path = sim_prefix + rep_str + "-" + path::basename(k_v.first);
-                check_output_path(sim_alignment_path);
+        // Parameters are drawn, and the seed of each replicate's random
+        // number stream is drawn, from the main stream one replicate at a
+        // time in replicate order, so the true values and simulated data do
+        // not depend on the number of workers. However, the tuning of each
+        // worker's MCMC operators carries over from one replicate to the next
+        // one it analyzes.
+        unsigned int next_rep = 0;
+        bool failed = false;
+        std::vector<std::exception_ptr> errors(nreps);
+#ifdef BUILD_WITH_THREADS
+        std::mutex draw_mutex;
+#endif
+        auto work = [&](unsigned int worker_idx) {
+            std::vector<BasePopulationTree> & trees = worker_trees.at(worker_idx);
+            CollectionType & analysis = *worker_analyses.at(worker_idx);
+            std::vector<BiallelicData> sim_alignments(trees.size());
+            std::vector<double> true_values(nparameters);
+            std::ostream null_stream(nullptr);
+            unsigned int i;
+            long rep_seed;
+            while (true) {
+                {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    if (failed || (next_rep >= nreps)) {
+                        return;
+                    }
+                    i = next_rep++;
+                    try {
+                        std::cerr << "Simulating and analyzing data set " << (i + 1) << " of " << nreps << "\n";
+                        comparisons.draw_from_prior(rng);
+                        rep_seed = rng.uniform_int(1, std::numeric_limits<int>::max() - 1);
 
-                char delim = prior_settings.get_population_name_delimiter(k_v.first);
-                prior_settings.replace_comparison_path(k_v.first, path::basename(sim_alignment_path));
+                        std::ostringstream true_state_stream;
+                        true_state_stream.precision(comparisons.get_logging_precision());
+                        comparisons.log_state(true_state_stream, 0);
+                        std::vector<std::string> true_state = string_util::split(
+                                string_util::strip(true_state_stream.str()), '\t');
+                        for (unsigned int p = 0; p < nparameters; ++p) {
+                            true_values.at(p) = std::stod(true_state.at(true_columns.at(p)));
+                        }
 
-                sim_alignment_stream.open(sim_alignment_path);
-                if (output_nexus) {
-                    k_v.second.write_nexus(sim_alignment_stream, delim);
+                        for (unsigned int t = 0; t < trees.size(); ++t) {
+                            trees.at(t).copy_state_for_simulation(*comparisons.get_tree(t));
+                        }
+                    }
+                    catch (...) {
+                        errors.at(i) = std::current_exception();
+                        failed = true;
+                        return;
+                    }
                 }
-                else {
-                    k_v.second.write_yaml(sim_alignment_stream);
+                try {
+                    RandomNumberGenerator rep_rng(rep_seed);
+                    for (unsigned int t = 0; t < trees.size(); ++t) {
+                        sim_alignments.at(t) = simulate_alignment(trees.at(t), rep_rng);
+                    }
+                    for (unsigned int t = 0; t < analysis.get_number_of_trees(); ++t) {
+                        std::shared_ptr<PopulationTree> tree = analysis.get_tree(t);
+                        tree->set_simulated_data(
+                                sim_alignments.at(sim_tree_indices.at(t)),
+                                (max_one_variable_site_per_locus ||
+                                 tree->constant_sites_removed()));
+                    }
+
+                    analysis.draw_from_prior(rep_rng);
+                    std::stringstream state_log_stream;
+                    analysis.mcmc(rep_rng,
+                            chain_length,
+                            sample_frequency,
+                            state_log_stream,
+                            null_stream,
+                            null_stream);
+
+                    spreadsheet::ColumnarSpreadsheet posterior_sample;
+                    for (auto const & parameter_name : parameter_names) {
+                        posterior_sample.add_column<double>(parameter_name);
+                    }
+                    posterior_sample.update(state_log_stream, calibration_burnin);
+                    std::vector<unsigned long> ranks(nparameters);
+                    std::vector<bool> in_hpd(nparameters);
+                    std::vector<bool> in_eti(nparameters);
+                    unsigned int number_of_samples = 0;
+                    for (unsigned int p = 0; p < nparameters; ++p) {
+                        std::vector<double> samples = posterior_sample.get<double>(
+                                parameter_names.at(p));
+                        if (samples.empty()) {
+                            throw EcoevolityError(
+                                    "No MCMC samples remain after the calibration burn in");
+                        }
+                        number_of_samples = samples.size();
+                        const double v = true_values.at(p);
+                        unsigned long number_below = 0;
+                        unsigned long number_equal = 0;
+                        for (auto x : samples) {
+                            if (x < v) {
+                                ++number_below;
+                            }
+                            else if (x == v) {
+                                ++number_equal;
+                            }
+                        }
+                        // Ties (e.g., for discrete or fixed parameters) are
+                        // broken at random
+                        ranks.at(p) = number_below;
+                        if (number_equal > 0) {
+                            ranks.at(p) += rep_rng.uniform_positive_int(number_equal);
+                        }
+                        std::pair<double, double> hpd = get_hpd_interval(samples, 0.95);
+                        std::pair<double, double> eti = quantiles_95(samples);
+                        in_hpd.at(p) = ((v >= hpd.first) && (v <= hpd.second));
+                        in_eti.at(p) = ((v >= eti.first) && (v <= eti.second));
+                    }
+
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    rep_ranks.at(i) = ranks;
+                    rep_number_of_samples.at(i) = number_of_samples;
+                    rep_in_hpd.at(i) = in_hpd;
+                    rep_in_eti.at(i) = in_eti;
+                    rep_is_done.at(i) = true;
+                    while ((next_rep_to_write < nreps) && rep_is_done.at(next_rep_to_write)) {
+                        unsigned int r = next_rep_to_write;
+                        ranks_stream << r << "\t" << rep_number_of_samples.at(r);
+                        for (unsigned int p = 0; p < nparameters; ++p) {
+                            ranks_stream << "\t" << rep_ranks.at(r).at(p);
+                            sum_of_normalized_ranks.at(p) +=
+                                    (rep_ranks.at(r).at(p) + 0.5) /
+                                    (rep_number_of_samples.at(r) + 1.0);
+                            if (rep_in_hpd.at(r).at(p)) {
+                                ++number_in_hpd.at(p);
+                            }
+                            if (rep_in_eti.at(r).at(p)) {
+                                ++number_in_eti.at(p);
+                            }
+                        }
+                        ranks_stream << std::endl;
+                        ++next_rep_to_write;
+                    }
+                }
+                catch (...) {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    errors.at(i) = std::current_exception();
+                    failed = true;
+                    return;
                 }
-                sim_alignment_stream.close();
             }
-            prior_settings.blanket_set_population_name_is_prefix(true);
-            prior_settings.blanket_set_genotypes_are_diploid(false);
-            if (max_one_variable_site_per_locus) {
-                prior_settings.blanket_set_constant_sites_removed(true);
+        };
+#ifdef BUILD_WITH_THREADS
+        std::vector< std::future<void> > workers;
+        workers.reserve(number_of_workers - 1);
+        for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+            workers.push_back(std::async(std::launch::async, work, w));
+        }
+        // Use the main thread as the last worker
+        work(number_of_workers - 1);
+        for (auto & w : workers) {
+            w.get();
+        }
+#else
+        work(0);
+#endif
+        ranks_stream.close();
+        for (auto & e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
             }
-            std::ofstream analysis_settings_stream;
-            analysis_settings_stream.open(analysis_config_path);
-            prior_settings.write_settings(analysis_settings_stream);
-            analysis_settings_stream.close();
-            for (auto const & k_v: sim_alignments) {
-                std::string sim_alignment_path = sim_prefix + rep_str + "-" + path::basename(k_v.first);
-                prior_settings.replace_comparison_path(path::basename(sim_alignment_path), k_v.first);
+        }
+
+        std::ofstream coverage_stream;
+        coverage_stream.open(coverage_path);
+        coverage_stream << "parameter\tnumber_of_replicates\tmean_normalized_rank\thpd_95_coverage\teti_95_coverage\n";
+        for (unsigned int p = 0; p < nparameters; ++p) {
+            coverage_stream << parameter_names.at(p) << "\t"
+                            << nreps << "\t"
+                            << sum_of_normalized_ranks.at(p) / nreps << "\t"
+                            << number_in_hpd.at(p) / (double)nreps << "\t"
+                            << number_in_eti.at(p) / (double)nreps << "\n";
+        }
+        coverage_stream.close();
+        std::cerr << "Ranks of true values written to: " << ranks_path << "\n";
+        std::cerr << "Coverage of credible intervals written to: " << coverage_path << std::endl;
+    }
+    else if (simulate_sequences) {
+        unsigned int pad_width = std::to_string(nreps).size();
+        std::string sim_prefix = path::join(output_dir,
+                output_prefix + "sim-");
+        prior_settings.blanket_set_population_name_is_prefix(true);
+        prior_settings.blanket_set_genotypes_are_diploid(false);
+        if (max_one_variable_site_per_locus) {
+            prior_settings.blanket_set_constant_sites_removed(true);
+        }
+
+        unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+        number_of_workers = std::max(1u, std::min(nthreads, nreps));
+#endif
+        // Each worker simulates from its own copy of the trees and writes
+        // configs from its own copy of the prior settings
+        std::vector< std::vector<BasePopulationTree> > worker_trees(number_of_workers);
+        for (auto & trees : worker_trees) {
+            trees.reserve(comparisons.get_number_of_trees());
+            for (unsigned int t = 0; t < comparisons.get_number_of_trees(); ++t) {
+                trees.push_back(BasePopulationTree(*comparisons.get_tree(t)));
+            }
+        }
+        std::vector<SettingsType> worker_settings(number_of_workers, prior_settings);
+
+        // When archiving, the files of each replicate are appended to the
+        // archive in replicate order as soon as every earlier replicate has
+        // been simulated
+        std::string archive_path = path::join(output_dir,
+                output_prefix + "sims.simarchive");
+        std::shared_ptr<SimulationArchiveWriter> archive;
+        if (write_archive) {
+            check_output_path(archive_path);
+            archive = std::make_shared<SimulationArchiveWriter>(archive_path);
+        }
+        std::map<unsigned int, std::vector< std::pair<std::string, std::string> > > archive_queue;
+        unsigned int next_rep_to_archive = 0;
+
+        // Parameters are drawn, and the seed of each replicate's random
+        // number stream is drawn, from the main stream one replicate at a
+        // time in replicate order, so the output does not depend on the
+        // number of workers.
+        unsigned int next_rep = 0;
+        bool failed = false;
+        std::vector<std::exception_ptr> errors(nreps);
+#ifdef BUILD_WITH_THREADS
+        std::mutex draw_mutex;
+#endif
+        auto work = [&](unsigned int worker_idx) {
+            std::vector<BasePopulationTree> & trees = worker_trees.at(worker_idx);
+            SettingsType & rep_settings = worker_settings.at(worker_idx);
+            std::map<std::string, BiallelicData> sim_alignments;
+            // The name and contents of each file of a replicate; every file
+            // is formatted in memory and written with a single write (or
+            // appended to the archive)
+            std::vector< std::pair<std::string, std::string> > rep_files;
+            std::string true_state;
+            unsigned int i;
+            long rep_seed;
+            while (true) {
+                {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    if (failed || (next_rep >= nreps)) {
+                        return;
+                    }
+                    i = next_rep++;
+                    try {
+                        std::cerr << "Simulating data set " << (i + 1) << " of " << nreps << "\n";
+                        if (! write_archive) {
+                            std::string rep_str = string_util::pad_int(i, pad_width);
+                            check_output_path(sim_prefix + rep_str + "-config.yml");
+                            check_output_path(sim_prefix + rep_str + "-true-values.txt");
+                        }
+
+                        comparisons.draw_from_prior(rng);
+                        rep_seed = rng.uniform_int(1, std::numeric_limits<int>::max() - 1);
+
+                        std::ostringstream true_state_stream;
+                        true_state_stream.precision(comparisons.get_logging_precision());
+                        comparisons.write_state_log_header(true_state_stream);
+                        comparisons.log_state(true_state_stream, 0);
+                        true_state = true_state_stream.str();
+
+                        for (unsigned int t = 0; t < trees.size(); ++t) {
+                            trees.at(t).copy_state_for_simulation(*comparisons.get_tree(t));
+                        }
+                    }
+                    catch (...) {
+                        errors.at(i) = std::current_exception();
+                        failed = true;
+                        return;
+                    }
+                }
+                try {
+                    RandomNumberGenerator rep_rng(rep_seed);
+                    // Files of a replicate are named relative to the other
+                    // files of the replicate in the archive
+                    std::string rep_file_prefix = "";
+                    if (! write_archive) {
+                        rep_file_prefix = output_prefix + "sim-" +
+                                string_util::pad_int(i, pad_width) + "-";
+                    }
+                    sim_alignments.clear();
+                    for (auto const & tree : trees) {
+                        sim_alignments[tree.get_data().get_path()] =
+                                simulate_alignment(tree, rep_rng);
+                    }
+
+                    rep_files.clear();
+                    rep_files.push_back(std::make_pair(
+                            rep_file_prefix + "config.yml", std::string()));
+                    rep_files.push_back(std::make_pair(
+                            rep_file_prefix + "true-values.txt", true_state));
+                    for (auto const & k_v: sim_alignments) {
+                        std::string sim_alignment_name = rep_file_prefix + path::basename(k_v.first);
+                        if (! write_archive) {
+                            check_output_path(path::join(output_dir, sim_alignment_name));
+                        }
+
+                        char delim = rep_settings.get_population_name_delimiter(k_v.first);
+                        rep_settings.replace_comparison_path(k_v.first, sim_alignment_name);
+
+                        std::ostringstream sim_alignment_stream;
+                        if (output_nexus) {
+                            k_v.second.write_nexus(sim_alignment_stream, delim);
+                        }
+                        else {
+                            k_v.second.write_yaml(sim_alignment_stream);
+                        }
+                        rep_files.push_back(std::make_pair(
+                                sim_alignment_name, sim_alignment_stream.str()));
+                    }
+                    std::ostringstream analysis_settings_stream;
+                    rep_settings.write_settings(analysis_settings_stream);
+                    rep_files.at(0).second = analysis_settings_stream.str();
+                    for (auto const & k_v: sim_alignments) {
+                        std::string sim_alignment_name = rep_file_prefix + path::basename(k_v.first);
+                        rep_settings.replace_comparison_path(sim_alignment_name, k_v.first);
+                    }
+
+                    if (write_archive) {
+#ifdef BUILD_WITH_THREADS
+                        std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                        archive_queue[i] = std::move(rep_files);
+                        rep_files.clear();
+                        while ((! archive_queue.empty()) &&
+                                (archive_queue.begin()->first == next_rep_to_archive)) {
+                            archive->add_replicate(archive_queue.begin()->second);
+                            archive_queue.erase(archive_queue.begin());
+                            ++next_rep_to_archive;
+                        }
+                    }
+                    else {
+                        std::ofstream out_stream;
+                        for (auto const & name_contents : rep_files) {
+                            out_stream.open(path::join(output_dir, name_contents.first));
+                            out_stream.write(name_contents.second.data(),
+                                    name_contents.second.size());
+                            out_stream.close();
+                        }
+                    }
+                }
+                catch (...) {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    errors.at(i) = std::current_exception();
+                    failed = true;
+                    return;
+                }
             }
+        };
+#ifdef BUILD_WITH_THREADS
+        std::vector< std::future<void> > workers;
+        workers.reserve(number_of_workers - 1);
+        for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+            workers.push_back(std::async(std::launch::async, work, w));
+        }
+        // Use the main thread as the last worker
+        work(number_of_workers - 1);
+        for (auto & w : workers) {
+            w.get();
+        }
+#else
+        work(0);
+#endif
+        for (auto & e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        }
+        if (archive) {
+            archive->close();
+            std::cerr << "Simulated data sets archived in: " << archive_path << std::endl;
         }
     }
     else {
@@ -437,10 +973,112 @@ int simcoevolity_main(int argc, char * argv[]) {
         state_stream.precision(comparisons.get_logging_precision());
         comparisons.write_state_log_header(state_stream);
         std::cerr << "Only drawing samples of parameters and writing to stdout." << std::endl;
-        for (unsigned int i = 0; i < nreps; ++i) {
-            comparisons.draw_from_prior(rng);
-            comparisons.log_state(state_stream, i + 1);
+
+        // Samples are drawn in blocks, each from its own random number
+        // stream seeded from the main stream in block order, so the samples
+        // do not depend on the number of workers. Blocks are written to
+        // stdout in order as soon as every earlier block has been drawn.
+        const unsigned int prior_block_size = 1000;
+        const unsigned int nblocks = (nreps + prior_block_size - 1) / prior_block_size;
+        std::vector<long> block_seeds(nblocks);
+        for (auto & seed : block_seeds) {
+            seed = rng.uniform_int(1, std::numeric_limits<int>::max() - 1);
+        }
+
+        unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+        number_of_workers = std::max(1u, std::min(nthreads, nblocks));
+#endif
+        // The main thread draws with the model configured above, and every
+        // other worker draws with its own copy
+        std::vector< std::shared_ptr<CollectionType> > worker_comparisons;
+        worker_comparisons.reserve(number_of_workers);
+        for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+            worker_comparisons.push_back(std::make_shared<CollectionType>(
+                    settings,
+                    rng,
+                    strict_on_constant_sites,
+                    strict_on_missing_sites,
+                    strict_on_triallelic_sites,
+                    use_charsets,
+                    1));
+        }
+
+        std::map<unsigned int, std::string> block_queue;
+        unsigned int next_block = 0;
+        unsigned int next_block_to_write = 0;
+        bool failed = false;
+        std::vector<std::exception_ptr> errors(nblocks);
+#ifdef BUILD_WITH_THREADS
+        std::mutex block_mutex;
+#endif
+        auto work = [&](unsigned int worker_idx) {
+            CollectionType & model = (worker_idx < worker_comparisons.size()) ?
+                    *worker_comparisons.at(worker_idx) : comparisons;
+            unsigned int b;
+            while (true) {
+                {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> block_lock(block_mutex);
+#endif
+                    if (failed || (next_block >= nblocks)) {
+                        return;
+                    }
+                    b = next_block++;
+                }
+                try {
+                    const unsigned int first_rep = b * prior_block_size;
+                    const unsigned int block_size = std::min(prior_block_size,
+                            nreps - first_rep);
+                    RandomNumberGenerator block_rng(block_seeds.at(b));
+                    std::ostringstream block_stream;
+                    block_stream.precision(state_stream.precision());
+                    model.log_prior_samples(block_rng,
+                            block_size,
+                            block_stream,
+                            first_rep + 1);
+
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> block_lock(block_mutex);
+#endif
+                    block_queue[b] = block_stream.str();
+                    while ((! block_queue.empty()) &&
+                            (block_queue.begin()->first == next_block_to_write)) {
+                        state_stream << block_queue.begin()->second;
+                        block_queue.erase(block_queue.begin());
+                        ++next_block_to_write;
+                    }
+                }
+                catch (...) {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> block_lock(block_mutex);
+#endif
+                    errors.at(b) = std::current_exception();
+                    failed = true;
+                    return;
+                }
+            }
+        };
+#ifdef BUILD_WITH_THREADS
+        std::vector< std::future<void> > workers;
+        workers.reserve(number_of_workers - 1);
+        for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+            workers.push_back(std::async(std::launch::async, work, w));
+        }
+        // Use the main thread as the last worker
+        work(number_of_workers - 1);
+        for (auto & w : workers) {
+            w.get();
+        }
+#else
+        work(0);
+#endif
+        for (auto & e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
         }
+        state_stream.flush();
     }
 
     time(&finish);
@@ -23,6 +23,11 @@
 #include <limits>
 #include <time.h>
 
+#ifdef BUILD_WITH_THREADS
+#include <mutex>
+#include <future>
+#endif
+
 #include "cpp-optparse/OptionParser.h"
 
 #include "version.hpp"
@@ -201,6 +206,18 @@ int simphycoeval_main(int argc, char * argv[]) {
                   "With this option, simphycoeval will automatically ignore such "
                   "sites and only issue a warning."
                 );
+#ifdef BUILD_WITH_THREADS
+    parser.add_option("--nthreads")
+            .action("store")
+            .type("unsigned int")
+            .dest("nthreads")
+            .set_default("1")
+            .help("Number of threads to use for loading the alignment and "
+                  "simulating the data sets. Every replicate is simulated "
+                  "with its own random number stream seeded from the "
+                  "main seed, so the output does not depend on the number "
+                  "of threads. Default: 1 (no multithreading).");
+#endif
     parser.add_option("--relax-triallelic-sites")
             .action("store_true")
             .dest("relax_triallelic_sites")
@@ -274,6 +291,12 @@ int simphycoeval_main(int argc, char * argv[]) {
     const bool simulate_sequences = (! options.get("parameters_only"));
     const bool fix_model = options.get("fix_model");
 
+#ifdef BUILD_WITH_THREADS 
+    unsigned int nthreads = options.get("nthreads");
+#else
+    unsigned int nthreads = 1;
+#endif
+
     if (args.size() < 1) {
         throw EcoevolityError("Path to YAML-formatted config file is required");
     }
@@ -385,7 +408,8 @@ int simphycoeval_main(int argc, char * argv[]) {
             strict_on_constant_sites,
             strict_on_missing_sites,
             strict_on_triallelic_sites,
-            use_charsets // store_seq_loci_info
+            use_charsets, // store_seq_loci_info
+            nthreads
             );
     tree.ignore_data();
     tree.compute_log_likelihood_and_prior(1);
@@ -517,7 +541,6 @@ int simphycoeval_main(int argc, char * argv[]) {
     std::string sim_prefix = path::join(output_dir,
             output_prefix + "sim-");
     std::string sim_data_suffix = path::basename(tree.get_data().get_path());
-    BiallelicData sim_alignment;
 
     time_t start;
     time_t finish;
@@ -525,7 +548,9 @@ int simphycoeval_main(int argc, char * argv[]) {
 
     std::cerr << "Starting simulations..." << std::endl;
     unsigned int rejected_tree_count = 0;
-    for (unsigned int i = 0; i < nreps; ++i) {
+    // Sample the topology and draw the parameters of the next replicate from
+    // the main random number stream
+    auto draw_replicate = [&](unsigned int i) {
         bool reject_tree = true;
         while (reject_tree) {
             reject_tree = false;
@@ -561,90 +586,171 @@ int simphycoeval_main(int argc, char * argv[]) {
                 }
             }
         }
+    };
 
-        if (simulate_sequences) {
-            std::string rep_str = string_util::pad_int(i, pad_width);
-            std::string true_state_path = sim_prefix + rep_str + "-true-parameters.txt";
-            std::string true_tree_path = sim_prefix + rep_str + "-true-tree.phy";
-            std::string sim_alignment_path = sim_prefix + rep_str + "-" + sim_data_suffix;
-            check_simphy_output_path(true_state_path);
-            check_simphy_output_path(true_tree_path);
-            check_simphy_output_path(sim_alignment_path);
-
-            if (use_charsets) {
-                sim_alignment = tree.simulate_linked_biallelic_data_set(
-                        rng,
-                        singleton_sample_probability,
-                        max_one_variable_site_per_locus,
-                        true);
-            }
-            else if (locus_size < 2) {
-                sim_alignment = tree.simulate_biallelic_data_set(
-                        rng,
-                        singleton_sample_probability,
-                        true);
-            }
-            else if (max_one_variable_site_per_locus) {
-                std::pair<BiallelicData, unsigned int> data_nloci =
-                    tree.simulate_data_set_max_one_variable_site_per_locus(
-                            rng,
-                            locus_size,
-                            singleton_sample_probability,
-                            true);
-                sim_alignment = data_nloci.first;
-            }
-            else {
-                std::pair<BiallelicData, unsigned int> data_nloci =
-                    tree.simulate_complete_biallelic_data_set(
-                            rng,
-                            locus_size,
-                            singleton_sample_probability,
-                            true);
-                sim_alignment = data_nloci.first;
-            }
+    if (simulate_sequences) {
+        unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+        number_of_workers = std::max(1u, std::min(nthreads, nreps));
+#endif
+        // Each worker simulates from its own copy of the tree
+        std::vector<BasePopulationTree> worker_trees(number_of_workers,
+                BasePopulationTree(tree));
+
+        // Parameters are drawn, and the seed of each replicate's random
+        // number stream is drawn, from the main stream one replicate at a
+        // time in replicate order, so the output does not depend on the
+        // number of workers.
+        unsigned int next_rep = 0;
+        bool failed = false;
+        std::vector<std::exception_ptr> errors(nreps);
+#ifdef BUILD_WITH_THREADS
+        std::mutex draw_mutex;
+#endif
+        auto work = [&](unsigned int worker_idx) {
+            BasePopulationTree & sim_tree = worker_trees.at(worker_idx);
+            BiallelicData sim_alignment;
+            unsigned int i;
+            long rep_seed;
+            while (true) {
+                {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    if (failed || (next_rep >= nreps)) {
+                        return;
+                    }
+                    i = next_rep++;
+                    try {
+                        draw_replicate(i);
+                        rep_seed = rng.uniform_int(1, std::numeric_limits<int>::max() - 1);
+
+                        std::string rep_str = string_util::pad_int(i, pad_width);
+                        std::string true_state_path = sim_prefix + rep_str + "-true-parameters.txt";
+                        std::string true_tree_path = sim_prefix + rep_str + "-true-tree.phy";
+                        check_simphy_output_path(true_state_path);
+                        check_simphy_output_path(true_tree_path);
+
+                        std::ofstream true_state_stream;
+                        true_state_stream.open(true_state_path);
+                        true_state_stream.precision(logging_precision);
+                        tree.write_state_log_header(true_state_stream, logging_delimiter);
+                        tree.log_state(true_state_stream, 0, logging_delimiter);
+                        true_state_stream.close();
+
+                        std::ofstream true_tree_stream;
+                        true_tree_stream.open(true_tree_path);
+                        true_tree_stream.precision(logging_precision);
+                        true_tree_stream << "[&R]"
+                                         << tree.to_parentheses(true, logging_precision)
+                                         << ";";
+                        true_tree_stream.close();
+
+                        sim_tree.copy_state_for_simulation(tree);
+                    }
+                    catch (...) {
+                        errors.at(i) = std::current_exception();
+                        failed = true;
+                        return;
+                    }
+                }
+                try {
+                    RandomNumberGenerator rep_rng(rep_seed);
+                    std::string rep_str = string_util::pad_int(i, pad_width);
+                    std::string sim_alignment_path = sim_prefix + rep_str + "-" + sim_data_suffix;
+                    check_simphy_output_path(sim_alignment_path);
+
+                    if (use_charsets) {
+                        sim_alignment = sim_tree.simulate_linked_biallelic_data_set(
+                                rep_rng,
+                                singleton_sample_probability,
+                                max_one_variable_site_per_locus,
+                                true);
+                    }
+                    else if (locus_size < 2) {
+                        sim_alignment = sim_tree.simulate_biallelic_data_set(
+                                rep_rng,
+                                singleton_sample_probability,
+                                true);
+                    }
+                    else if (max_one_variable_site_per_locus) {
+                        std::pair<BiallelicData, unsigned int> data_nloci =
+                            sim_tree.simulate_data_set_max_one_variable_site_per_locus(
+                                    rep_rng,
+                                    locus_size,
+                                    singleton_sample_probability,
+                                    true);
+                        sim_alignment = data_nloci.first;
+                    }
+                    else {
+                        std::pair<BiallelicData, unsigned int> data_nloci =
+                            sim_tree.simulate_complete_biallelic_data_set(
+                                    rep_rng,
+                                    locus_size,
+                                    singleton_sample_probability,
+                                    true);
+                        sim_alignment = data_nloci.first;
+                    }
 
-            std::ofstream true_state_stream;
-            true_state_stream.open(true_state_path);
-            true_state_stream.precision(logging_precision);
-            tree.write_state_log_header(true_state_stream, logging_delimiter);
-            tree.log_state(true_state_stream, 0, logging_delimiter);
-            true_state_stream.close();
-
-            std::ofstream true_tree_stream;
-            true_tree_stream.open(true_tree_path);
-            true_tree_stream.precision(logging_precision);
-            true_tree_stream << "[&R]"
-                             << tree.to_parentheses(true, logging_precision)
-                             << ";";
-            true_tree_stream.close();
-
-            std::ofstream sim_alignment_stream;
-            sim_alignment_stream.open(sim_alignment_path);
-            sim_alignment.write_yaml(sim_alignment_stream);
-            sim_alignment_stream.close();
-
-            for (unsigned int prior_i = 0; prior_i < num_prior_configs; ++prior_i) {
-                PopulationTreeSettings prior_settings = prior_settings_vector.at(prior_i);
-
-                prior_settings.data_settings.set_path(path::basename(sim_alignment_path));
-
-                std::string analysis_config_path = (
-                        sim_prefix +
-                        rep_str +
-                        "-" +
-                        prior_config_prefixes.at(prior_i) +
-                        "-config.yml");
-                check_simphy_output_path(analysis_config_path);
-
-                std::ofstream analysis_settings_stream;
-                analysis_settings_stream.open(analysis_config_path);
-                write_settings(analysis_settings_stream,
-                        prior_settings,
-                        prior_operator_schedules.at(prior_i));
-                analysis_settings_stream.close();
+                    std::ofstream sim_alignment_stream;
+                    sim_alignment_stream.open(sim_alignment_path);
+                    sim_alignment.write_yaml(sim_alignment_stream);
+                    sim_alignment_stream.close();
+
+                    for (unsigned int prior_i = 0; prior_i < num_prior_configs; ++prior_i) {
+                        PopulationTreeSettings prior_settings = prior_settings_vector.at(prior_i);
+
+                        prior_settings.data_settings.set_path(path::basename(sim_alignment_path));
+
+                        std::string analysis_config_path = (
+                                sim_prefix +
+                                rep_str +
+                                "-" +
+                                prior_config_prefixes.at(prior_i) +
+                                "-config.yml");
+                        check_simphy_output_path(analysis_config_path);
+
+                        std::ofstream analysis_settings_stream;
+                        analysis_settings_stream.open(analysis_config_path);
+                        write_settings(analysis_settings_stream,
+                                prior_settings,
+                                prior_operator_schedules.at(prior_i));
+                        analysis_settings_stream.close();
+                    }
+                }
+                catch (...) {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> draw_lock(draw_mutex);
+#endif
+                    errors.at(i) = std::current_exception();
+                    failed = true;
+                    return;
+                }
+            }
+        };
+#ifdef BUILD_WITH_THREADS
+        std::vector< std::future<void> > workers;
+        workers.reserve(number_of_workers - 1);
+        for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+            workers.push_back(std::async(std::launch::async, work, w));
+        }
+        // Use the main thread as the last worker
+        work(number_of_workers - 1);
+        for (auto & w : workers) {
+            w.get();
+        }
+#else
+        work(0);
+#endif
+        for (auto & e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
             }
         }
-        else {
+    }
+    else {
+        for (unsigned int i = 0; i < nreps; ++i) {
+            draw_replicate(i);
             tree.log_state(true_params_stream, i + 1, logging_delimiter);
             true_trees_stream << "[&R]"
                               << tree.to_parentheses(true, logging_precision)
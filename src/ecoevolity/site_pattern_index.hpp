@@ -0,0 +1,332 @@
+/******************************************************************************
+ * Copyright (C) 2015-2016 Jamie R. Oaks.
+ *
+ * This file is part of Ecoevolity.
+ *
+ * Ecoevolity is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option)
+ * any later version.
+ *
+ * Ecoevolity is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Ecoevolity.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#ifndef ECOEVOLITY_SITE_PATTERN_INDEX_HPP
+#define ECOEVOLITY_SITE_PATTERN_INDEX_HPP
+
+#include <vector>
+#include <iterator>
+#include <cstdint>
+#include <stdexcept>
+
+#include "assert.hpp"
+
+
+/**
+ * Bit-packed map from site index to pattern index.
+ *
+ * When the loci of a linked dataset are stored, every site of the alignment
+ * needs to remember which allele-count pattern it belongs to. Storing one
+ * 32-bit integer per site wastes most of the bits, because the number of
+ * patterns is usually small relative to the number of sites. Here each site
+ * uses only as many bits as are needed for the largest pattern index stored.
+ * The width grows as larger indices are added and is recomputed (so it can
+ * shrink) whenever the indices are remapped.
+ *
+ * Random access is O(1). The const_iterator walks the sites sequentially
+ * without recomputing word offsets from scratch, and is what the alignment
+ * writers use.
+ */
+class SitePatternIndex {
+    private:
+        typedef std::uint64_t word_type;
+        enum { bits_per_word = 64 };
+
+        std::vector<word_type> words_;
+        unsigned int number_of_sites_ = 0;
+        unsigned int bits_per_index_ = 1;
+        word_type mask_ = 1;
+
+        static unsigned int get_bits_needed(unsigned int value) {
+            unsigned int nbits = 1;
+            while ((nbits < 32) && ((value >> nbits) != 0)) {
+                ++nbits;
+            }
+            return nbits;
+        }
+
+        static std::size_t get_number_of_words(
+                std::size_t number_of_sites,
+                unsigned int bits_per_index) {
+            return ((number_of_sites * bits_per_index) + bits_per_word - 1) / bits_per_word;
+        }
+
+        unsigned int get_value(std::size_t site_index) const {
+            std::size_t bit = site_index * this->bits_per_index_;
+            std::size_t word_index = bit / bits_per_word;
+            unsigned int offset = bit % bits_per_word;
+            word_type v = this->words_[word_index] >> offset;
+            if ((offset + this->bits_per_index_) > bits_per_word) {
+                v |= this->words_[word_index + 1] << (bits_per_word - offset);
+            }
+            return static_cast<unsigned int>(v & this->mask_);
+        }
+
+        void set_value(std::size_t site_index, unsigned int value) {
+            std::size_t bit = site_index * this->bits_per_index_;
+            std::size_t word_index = bit / bits_per_word;
+            unsigned int offset = bit % bits_per_word;
+            word_type v = static_cast<word_type>(value);
+            this->words_[word_index] &= ~(this->mask_ << offset);
+            this->words_[word_index] |= (v << offset);
+            if ((offset + this->bits_per_index_) > bits_per_word) {
+                unsigned int shift = bits_per_word - offset;
+                this->words_[word_index + 1] &= ~(this->mask_ >> shift);
+                this->words_[word_index + 1] |= (v >> shift);
+            }
+        }
+
+        void set_bits_per_index(unsigned int bits_per_index) {
+            this->bits_per_index_ = bits_per_index;
+            this->mask_ = (bits_per_index >= bits_per_word) ?
+                    ~static_cast<word_type>(0) :
+                    ((static_cast<word_type>(1) << bits_per_index) - 1);
+        }
+
+        void repack(unsigned int bits_per_index) {
+            if (bits_per_index == this->bits_per_index_) {
+                return;
+            }
+            SitePatternIndex repacked;
+            repacked.set_bits_per_index(bits_per_index);
+            // Keep any capacity that was reserved for sites to come
+            std::size_t site_capacity = (this->words_.capacity() * bits_per_word) / this->bits_per_index_;
+            repacked.words_.reserve(get_number_of_words(site_capacity, bits_per_index));
+            repacked.words_.assign(
+                    get_number_of_words(this->number_of_sites_, bits_per_index),
+                    0);
+            repacked.number_of_sites_ = this->number_of_sites_;
+            for (std::size_t i = 0; i < this->number_of_sites_; ++i) {
+                repacked.set_value(i, this->get_value(i));
+            }
+            this->words_.swap(repacked.words_);
+            this->set_bits_per_index(bits_per_index);
+        }
+
+    public:
+        class const_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef unsigned int value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const unsigned int * pointer;
+                typedef unsigned int reference;
+
+                const_iterator() { }
+                const_iterator(const SitePatternIndex * index,
+                        std::size_t site_index)
+                    : index_(index),
+                      site_index_(site_index) {
+                    if (index) {
+                        std::size_t bit = site_index * index->bits_per_index_;
+                        this->word_index_ = bit / bits_per_word;
+                        this->offset_ = bit % bits_per_word;
+                    }
+                }
+
+                unsigned int operator*() const {
+                    word_type v = this->index_->words_[this->word_index_] >> this->offset_;
+                    if ((this->offset_ + this->index_->bits_per_index_) > bits_per_word) {
+                        v |= this->index_->words_[this->word_index_ + 1] << (bits_per_word - this->offset_);
+                    }
+                    return static_cast<unsigned int>(v & this->index_->mask_);
+                }
+                const_iterator& operator++() {
+                    ++this->site_index_;
+                    this->offset_ += this->index_->bits_per_index_;
+                    if (this->offset_ >= bits_per_word) {
+                        this->offset_ -= bits_per_word;
+                        ++this->word_index_;
+                    }
+                    return * this;
+                }
+                const_iterator operator++(int) {
+                    const_iterator tmp(* this);
+                    ++(* this);
+                    return tmp;
+                }
+                bool operator==(const const_iterator& other) const {
+                    return this->site_index_ == other.site_index_;
+                }
+                bool operator!=(const const_iterator& other) const {
+                    return this->site_index_ != other.site_index_;
+                }
+
+            private:
+                const SitePatternIndex * index_ = nullptr;
+                std::size_t site_index_ = 0;
+                std::size_t word_index_ = 0;
+                unsigned int offset_ = 0;
+        };
+
+        SitePatternIndex() { }
+        SitePatternIndex(unsigned int number_of_sites,
+                unsigned int pattern_index = 0) {
+            this->assign(number_of_sites, pattern_index);
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+        const_iterator end() const {
+            return const_iterator(this, this->number_of_sites_);
+        }
+
+        unsigned int size() const {
+            return this->number_of_sites_;
+        }
+        bool empty() const {
+            return this->number_of_sites_ == 0;
+        }
+        unsigned int get_bits_per_index() const {
+            return this->bits_per_index_;
+        }
+        std::size_t get_number_of_bytes() const {
+            return this->words_.size() * sizeof(word_type);
+        }
+
+        void clear() {
+            this->words_.clear();
+            this->number_of_sites_ = 0;
+            this->set_bits_per_index(1);
+        }
+
+        void reserve(unsigned int number_of_sites) {
+            this->words_.reserve(get_number_of_words(number_of_sites,
+                    this->bits_per_index_));
+        }
+
+        void assign(unsigned int number_of_sites, unsigned int pattern_index) {
+            this->clear();
+            this->set_bits_per_index(get_bits_needed(pattern_index));
+            this->words_.assign(get_number_of_words(number_of_sites,
+                    this->bits_per_index_), 0);
+            this->number_of_sites_ = number_of_sites;
+            if (pattern_index != 0) {
+                for (std::size_t i = 0; i < number_of_sites; ++i) {
+                    this->set_value(i, pattern_index);
+                }
+            }
+        }
+
+        unsigned int at(unsigned int site_index) const {
+            if (site_index >= this->number_of_sites_) {
+                throw std::out_of_range("SitePatternIndex: site index out of range");
+            }
+            return this->get_value(site_index);
+        }
+        unsigned int operator[](unsigned int site_index) const {
+            return this->get_value(site_index);
+        }
+
+        void set(unsigned int site_index, unsigned int pattern_index) {
+            if (site_index >= this->number_of_sites_) {
+                throw std::out_of_range("SitePatternIndex: site index out of range");
+            }
+            if ((pattern_index & this->mask_) != pattern_index) {
+                this->repack(get_bits_needed(pattern_index));
+            }
+            this->set_value(site_index, pattern_index);
+        }
+
+        void push_back(unsigned int pattern_index) {
+            if ((pattern_index & this->mask_) != pattern_index) {
+                this->repack(get_bits_needed(pattern_index));
+            }
+            ++this->number_of_sites_;
+            std::size_t nwords = get_number_of_words(this->number_of_sites_,
+                    this->bits_per_index_);
+            if (nwords > this->words_.size()) {
+                this->words_.resize(nwords, 0);
+            }
+            this->set_value(this->number_of_sites_ - 1, pattern_index);
+        }
+
+        /**
+         * Replace every stored pattern index i with new_indices.at(i).
+         *
+         * The width is recomputed from the largest new index, so remapping
+         * after patterns are removed or merged also narrows the storage.
+         */
+        void remap(const std::vector<unsigned int> & new_indices) {
+            unsigned int max_index = 0;
+            for (auto idx : new_indices) {
+                if (idx > max_index) {
+                    max_index = idx;
+                }
+            }
+            SitePatternIndex remapped;
+            remapped.set_bits_per_index(get_bits_needed(max_index));
+            remapped.words_.assign(get_number_of_words(this->number_of_sites_,
+                    remapped.bits_per_index_), 0);
+            remapped.number_of_sites_ = this->number_of_sites_;
+            std::size_t site_idx = 0;
+            for (const_iterator it = this->begin(); it != this->end(); ++it) {
+                remapped.set_value(site_idx, new_indices.at(*it));
+                ++site_idx;
+            }
+            this->words_.swap(remapped.words_);
+            this->set_bits_per_index(remapped.bits_per_index_);
+        }
+
+        std::vector<unsigned int> to_vector() const {
+            std::vector<unsigned int> v;
+            v.reserve(this->number_of_sites_);
+            for (const_iterator it = this->begin(); it != this->end(); ++it) {
+                v.push_back(*it);
+            }
+            return v;
+        }
+
+        bool operator==(const SitePatternIndex & other) const {
+            if (this->number_of_sites_ != other.number_of_sites_) {
+                return false;
+            }
+            const_iterator other_it = other.begin();
+            for (const_iterator it = this->begin(); it != this->end(); ++it) {
+                if (*it != *other_it) {
+                    return false;
+                }
+                ++other_it;
+            }
+            return true;
+        }
+        bool operator!=(const SitePatternIndex & other) const {
+            return ! (*this == other);
+        }
+
+        bool operator==(const std::vector<unsigned int> & other) const {
+            if (this->number_of_sites_ != other.size()) {
+                return false;
+            }
+            std::size_t site_idx = 0;
+            for (const_iterator it = this->begin(); it != this->end(); ++it) {
+                if (*it != other[site_idx]) {
+                    return false;
+                }
+                ++site_idx;
+            }
+            return true;
+        }
+        bool operator!=(const std::vector<unsigned int> & other) const {
+            return ! (*this == other);
+        }
+};
+
+#endif
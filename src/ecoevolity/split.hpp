@@ -26,10 +26,64 @@
 #include <map>
 #include <climits>
 #include <cassert>
+#include <cstdint>
+#include <cstddef>
 
 #include "error.hpp"
 
 
+/**
+ * 128-bit hash of a split, a set of splits (e.g., the splits of a node), or a
+ * set of sets of splits (e.g., a topology).
+ *
+ * The hash of a set is an order-independent sum of the mixed hashes of its
+ * elements, so equal sets always have equal hashes. Equal hashes do not
+ * guarantee equal keys, so containers keyed on these hashes need to compare
+ * the canonical (set) form of the keys as well.
+ */
+struct SplitHash {
+    std::uint64_t h1 = 0;
+    std::uint64_t h2 = 0;
+
+    bool operator==(const SplitHash & other) const {
+        return ((this->h1 == other.h1) && (this->h2 == other.h2));
+    }
+    bool operator!=(const SplitHash & other) const {
+        return (! (*this == other));
+    }
+
+    static std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // Hash of a set from the hashes of its elements
+    template<class Iterator>
+    static SplitHash combine(Iterator first, Iterator last) {
+        SplitHash h;
+        std::uint64_t n = 0;
+        for (; first != last; ++first) {
+            SplitHash e = first->get_hash();
+            h.h1 += mix(e.h1 ^ 0x9e3779b97f4a7c15ULL);
+            h.h2 += mix(e.h2 + 0xc2b2ae3d27d4eb4fULL);
+            ++n;
+        }
+        h.h1 = mix(h.h1 ^ n);
+        h.h2 = mix(h.h2 + (n * 0x165667b19e3779f9ULL));
+        return h;
+    }
+
+    struct Hasher {
+        std::size_t operator()(const SplitHash & h) const {
+            return (std::size_t)h.h1;
+        }
+    };
+};
+
 /**
  * Object for storing set of taxa that descend from a node.
  *
@@ -94,6 +148,8 @@ class Split {
                 const char set_char = '1') const;
         split_metrics_t get_split_metrics() const;
 
+        SplitHash get_hash() const;
+
     private:
         split_unit_t  mask_;
         split_t       bits_;
@@ -123,6 +179,29 @@ class Split {
             return parent_split;
         }
 
+        static SplitHash get_hash(const Split & split) {
+            return split.get_hash();
+        }
+
+        static SplitHash get_hash(const std::set<Split> & split_set) {
+            return SplitHash::combine(split_set.begin(), split_set.end());
+        }
+
+        static SplitHash get_hash(
+                const std::set< std::set<Split> > & split_sets) {
+            SplitHash h;
+            std::uint64_t n = 0;
+            for (auto & split_set : split_sets) {
+                SplitHash e = Split::get_hash(split_set);
+                h.h1 += SplitHash::mix(e.h1 + 0x2545f4914f6cdd1dULL);
+                h.h2 += SplitHash::mix(e.h2 ^ 0x27d4eb2f165667c5ULL);
+                ++n;
+            }
+            h.h1 = SplitHash::mix(h.h1 + n);
+            h.h2 = SplitHash::mix(h.h2 ^ (n * 0x9e3779b97f4a7c15ULL));
+            return h;
+        }
+
         static bool can_be_siblings(std::set<Split> splits) {
             assert(splits.size() > 1);
             Split parent_split;
@@ -419,6 +498,17 @@ inline bool Split::overlaps_with(const Split & other) const {
     return false;
 }
 
+inline SplitHash Split::get_hash() const {
+    SplitHash h;
+    h.h1 = SplitHash::mix(this->number_of_leaves_ ^ 0x6a09e667f3bcc908ULL);
+    h.h2 = SplitHash::mix(this->number_of_leaves_ + 0xbb67ae8584caa73bULL);
+    for (auto & split_u : this->bits_) {
+        h.h1 = SplitHash::mix(h.h1 ^ (std::uint64_t)split_u);
+        h.h2 = SplitHash::mix((h.h2 + (std::uint64_t)split_u) * 0x9e3779b97f4a7c15ULL);
+    }
+    return h;
+}
+
 inline bool Split::is_parent_of(
         const std::set<Split> & split_set
         ) const {
@@ -24,6 +24,26 @@
 #include <sstream>
 #include <fstream>
 #include <map>
+#include <algorithm>
+#include <iterator>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <exception>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef BUILD_WITH_THREADS
+#include <mutex>
+#include <future>
+#endif
 
 #include "assert.hpp"
 #include "error.hpp"
@@ -42,6 +62,21 @@ inline void parse_header(
             header_line, delimiter);
 }
 
+inline void parse_header(
+        const std::string& path,
+        std::vector<std::string>& header,
+        char delimiter = '\t') {
+    std::ifstream in_stream;
+    in_stream.open(path);
+    if (! in_stream.is_open()) {
+        throw EcoevolityParsingError(
+                "Could not open spreadsheet file",
+                path);
+    }
+    parse_header(in_stream, header, delimiter);
+    in_stream.close();
+}
+
 inline void parse(
         std::istream& in_stream,
         std::map<std::string, std::vector<std::string> >& column_data,
@@ -221,6 +256,786 @@ class Spreadsheet {
 
 };
 
+/**
+ * Read-only memory map of a file.
+ *
+ * Empty files are not mapped; they simply yield an empty range.
+ */
+class MappedFile {
+
+    protected:
+
+        const char * data_ = nullptr;
+        std::size_t size_ = 0;
+        std::size_t released_ = 0;
+
+    public:
+
+        explicit MappedFile(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw EcoevolityParsingError(
+                        "Could not open spreadsheet file",
+                        path);
+            }
+            struct stat file_stats;
+            if (::fstat(fd, &file_stats) != 0) {
+                ::close(fd);
+                throw EcoevolityParsingError(
+                        "Could not stat spreadsheet file",
+                        path);
+            }
+            this->size_ = file_stats.st_size;
+            if (this->size_ > 0) {
+                void * map = ::mmap(nullptr, this->size_, PROT_READ,
+                        MAP_PRIVATE, fd, 0);
+                if (map == MAP_FAILED) {
+                    ::close(fd);
+                    throw EcoevolityParsingError(
+                            "Could not map spreadsheet file",
+                            path);
+                }
+                ::madvise(map, this->size_, MADV_SEQUENTIAL);
+                this->data_ = static_cast<const char *>(map);
+            }
+            ::close(fd);
+        }
+        ~MappedFile() {
+            if (this->data_) {
+                ::munmap(const_cast<char *>(this->data_), this->size_);
+            }
+        }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char * begin() const {
+            return this->data_;
+        }
+        const char * end() const {
+            return this->data_ + this->size_;
+        }
+        std::size_t size() const {
+            return this->size_;
+        }
+
+        /**
+         * Drop the pages before position from memory; they are read back
+         * from the file if they are touched again. Releasing behind a
+         * sequential pass keeps the resident size of the map bounded.
+         */
+        void release(const char * position) {
+            const std::size_t page_size = ::sysconf(_SC_PAGESIZE);
+            const std::size_t length = ((position - this->data_) / page_size) * page_size;
+            if (length > this->released_) {
+                ::madvise(const_cast<char *>(this->data_) + this->released_,
+                        length - this->released_, MADV_DONTNEED);
+                this->released_ = length;
+            }
+        }
+};
+
+/**
+ * Parse the whole of [begin, end) as a base-10 integer.
+ *
+ * Returns false if the cell is empty, contains anything other than an
+ * optional sign followed by digits, or overflows a long long.
+ */
+inline bool parse_integer(const char * begin, const char * end,
+        long long& value) {
+    const char * p = begin;
+    bool negative = false;
+    if ((p < end) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p >= end) {
+        return false;
+    }
+    const unsigned long long limit = negative ?
+            (unsigned long long)std::numeric_limits<long long>::max() + 1 :
+            (unsigned long long)std::numeric_limits<long long>::max();
+    unsigned long long v = 0;
+    for (; p < end; ++p) {
+        unsigned int d = (unsigned int)(*p - '0');
+        if (d > 9) {
+            return false;
+        }
+        if (v > ((limit - d) / 10)) {
+            return false;
+        }
+        v = (v * 10) + d;
+    }
+    if (negative) {
+        value = (v == limit) ? std::numeric_limits<long long>::min() :
+                -(long long)v;
+    }
+    else {
+        value = (long long)v;
+    }
+    return true;
+}
+
+/**
+ * Parse the whole of [begin, end) as a floating-point number.
+ *
+ * Plain decimals with at most 19 significant digits and a power of ten
+ * within +/-22 are converted directly, which is exact when the digits fit
+ * in the 53-bit mantissa of a double. Everything else (long mantissas,
+ * large exponents, "nan", "inf") falls back to strtod.
+ */
+inline bool parse_real(const char * begin, const char * end,
+        double& value) {
+    static const double powers_of_ten[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char * p = begin;
+    bool negative = false;
+    if ((p < end) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    std::uint64_t mantissa = 0;
+    int number_of_digits = 0;
+    int exponent = 0;
+    bool has_digits = false;
+    bool use_fallback = false;
+    for (; (p < end) && ((unsigned int)(*p - '0') <= 9); ++p) {
+        has_digits = true;
+        mantissa = (mantissa * 10) + (*p - '0');
+        if ((number_of_digits > 0) || (*p != '0')) {
+            ++number_of_digits;
+        }
+    }
+    if ((p < end) && (*p == '.')) {
+        ++p;
+        for (; (p < end) && ((unsigned int)(*p - '0') <= 9); ++p) {
+            has_digits = true;
+            mantissa = (mantissa * 10) + (*p - '0');
+            --exponent;
+            if ((number_of_digits > 0) || (*p != '0')) {
+                ++number_of_digits;
+            }
+        }
+    }
+    if (has_digits && (p < end) && ((*p == 'e') || (*p == 'E'))) {
+        ++p;
+        bool negative_exponent = false;
+        if ((p < end) && ((*p == '-') || (*p == '+'))) {
+            negative_exponent = (*p == '-');
+            ++p;
+        }
+        if (p >= end) {
+            return false;
+        }
+        int e = 0;
+        for (; p < end; ++p) {
+            unsigned int d = (unsigned int)(*p - '0');
+            if (d > 9) {
+                return false;
+            }
+            if (e < 100000) {
+                e = (e * 10) + d;
+            }
+        }
+        exponent += negative_exponent ? -e : e;
+    }
+    if (! has_digits) {
+        use_fallback = true;
+    }
+    else if (p != end) {
+        return false;
+    }
+    else if ((number_of_digits > 19) ||
+            (mantissa > (std::uint64_t(1) << 53)) ||
+            (exponent < -22) || (exponent > 22)) {
+        use_fallback = true;
+    }
+    if (! use_fallback) {
+        double v = (double)mantissa;
+        if (exponent < 0) {
+            v /= powers_of_ten[-exponent];
+        }
+        else {
+            v *= powers_of_ten[exponent];
+        }
+        value = negative ? -v : v;
+        return true;
+    }
+    if ((begin >= end) || std::isspace((unsigned char)*begin)) {
+        return false;
+    }
+    std::string cell(begin, end);
+    char * cell_end = nullptr;
+    value = std::strtod(cell.c_str(), &cell_end);
+    return (cell_end == (cell.c_str() + cell.size()));
+}
+
+inline const char * find_line_end(const char * begin, const char * end) {
+    const char * eol = static_cast<const char *>(
+            std::memchr(begin, '\n', end - begin));
+    return eol ? eol : end;
+}
+
+inline std::vector<std::string> read_header(
+        const char * begin,
+        const char * end,
+        char delimiter = '\t') {
+    std::vector<std::string> header;
+    if (begin >= end) {
+        return header;
+    }
+    const char * line_end = find_line_end(begin, end);
+    if ((line_end > begin) && (*(line_end - 1) == '\r')) {
+        --line_end;
+    }
+    std::string header_line(begin, line_end);
+    string_util::split(header_line, delimiter, header);
+    return header;
+}
+
+inline void throw_parsing_error(
+        const std::string& message,
+        const std::string& path,
+        unsigned int line_number) {
+    if (path.empty()) {
+        throw EcoevolityParsingError(message, line_number);
+    }
+    throw EcoevolityParsingError(message, path, line_number);
+}
+
+/**
+ * Map each column of the header to the requested column it feeds: 0 if the
+ * column is skipped, i + 1 for integer column i, and -(i + 1) for real
+ * column i.
+ */
+inline std::vector<int> get_column_map(
+        const std::vector<std::string>& header,
+        const std::vector<std::string>& integer_labels,
+        const std::vector<std::string>& real_labels) {
+    std::vector<int> column_map(header.size(), 0);
+    for (unsigned int pass = 0; pass < 2; ++pass) {
+        const std::vector<std::string>& labels = (pass == 0) ?
+                integer_labels : real_labels;
+        for (unsigned int i = 0; i < labels.size(); ++i) {
+            auto column = std::find(header.begin(), header.end(), labels.at(i));
+            if (column == header.end()) {
+                throw EcoevolitySpreadsheetError("column \'" + labels.at(i) +
+                        "\' not found in spreadsheet");
+            }
+            column_map.at(column - header.begin()) = (pass == 0) ?
+                    (int)(i + 1) : -(int)(i + 1);
+        }
+    }
+    return column_map;
+}
+
+/**
+ * Tokenize the rows of a spreadsheet buffer in place.
+ *
+ * The first line must match header. After skipping offset rows, the
+ * requested cells of each row (see get_column_map) are converted into
+ * integers and reals, and handler(integers, reals) is called. If the buffer
+ * is a mapped file, pages are released behind the parser as it goes.
+ * Returns the number of rows passed to the handler.
+ */
+template <typename RowHandler>
+inline std::size_t parse_rows(
+        const char * begin,
+        const char * end,
+        const std::vector<std::string>& header,
+        const std::vector<int>& column_map,
+        unsigned int offset,
+        char delimiter,
+        RowHandler& handler,
+        const std::string& path = "",
+        MappedFile * mapped_file = nullptr) {
+    const std::size_t release_interval = 1 << 26;
+    unsigned int line_number = 1;
+    if (read_header(begin, end, delimiter) != header) {
+        throw_parsing_error("Headers does not match", path, line_number);
+    }
+    const unsigned int number_of_columns = header.size();
+    std::vector<long long> integers;
+    std::vector<double> reals;
+    for (auto slot : column_map) {
+        if (slot > 0) {
+            integers.resize(std::max((std::size_t)slot, integers.size()));
+        }
+        else if (slot < 0) {
+            reals.resize(std::max((std::size_t)(-slot), reals.size()));
+        }
+    }
+
+    const char * p = find_line_end(begin, end);
+    if (p < end) {
+        ++p;
+    }
+    const char * next_release = p + release_interval;
+    unsigned int row_index = 0;
+    std::size_t number_of_rows = 0;
+    while (p < end) {
+        ++line_number;
+        const char * eol = find_line_end(p, end);
+        const char * line_end = eol;
+        if ((line_end > p) && (*(line_end - 1) == '\r')) {
+            --line_end;
+        }
+        if (row_index < offset) {
+            ++row_index;
+            p = (eol < end) ? eol + 1 : end;
+            continue;
+        }
+        unsigned int column_index = 0;
+        const char * cell = p;
+        while (true) {
+            const char * cell_end = static_cast<const char *>(
+                    std::memchr(cell, delimiter, line_end - cell));
+            if (! cell_end) {
+                cell_end = line_end;
+            }
+            if (column_index < number_of_columns) {
+                int slot = column_map[column_index];
+                bool converted = true;
+                if (slot > 0) {
+                    converted = parse_integer(cell, cell_end,
+                            integers[slot - 1]);
+                }
+                else if (slot < 0) {
+                    converted = parse_real(cell, cell_end,
+                            reals[-slot - 1]);
+                }
+                if (! converted) {
+                    throw_parsing_error("could not convert \'" +
+                            std::string(cell, cell_end) + "\' in column \'" +
+                            header.at(column_index) + "\'",
+                            path, line_number);
+                }
+            }
+            ++column_index;
+            if (cell_end >= line_end) {
+                break;
+            }
+            cell = cell_end + 1;
+        }
+        if (column_index != number_of_columns) {
+            std::ostringstream message;
+            message << "Incorrect number of columns: Expecting "
+                    << number_of_columns << ", but found "
+                    << column_index;
+            throw_parsing_error(message.str(), path, line_number);
+        }
+        handler(integers, reals);
+        ++row_index;
+        ++number_of_rows;
+        p = (eol < end) ? eol + 1 : end;
+        if (mapped_file && (p >= next_release)) {
+            mapped_file->release(p);
+            next_release = p + release_interval;
+        }
+    }
+    return number_of_rows;
+}
+
+/**
+ * Stream the rows of spreadsheet files without storing them.
+ *
+ * The integer and real columns to convert are given up front, and each
+ * row of each file is passed once to a handler. Files are memory mapped
+ * and released behind the parser, so memory use does not grow with the
+ * size of the files.
+ */
+class ColumnarReader {
+
+    protected:
+
+        std::vector<std::string> integer_labels_;
+        std::vector<std::string> real_labels_;
+        char delimiter_;
+
+    public:
+
+        ColumnarReader(
+                const std::vector<std::string>& integer_labels,
+                const std::vector<std::string>& real_labels,
+                char delimiter = '\t') :
+            integer_labels_(integer_labels),
+            real_labels_(real_labels),
+            delimiter_(delimiter) { }
+
+        /**
+         * Pass each row of path after the first offset to
+         * handler(integers, reals), where the integers and reals are in the
+         * order of the labels given to the constructor. Returns the number
+         * of rows passed to the handler.
+         */
+        template <typename RowHandler>
+        std::size_t read(
+                const std::string& path,
+                RowHandler& handler,
+                unsigned int offset = 0) const {
+            MappedFile file(path);
+            std::vector<std::string> header = read_header(file.begin(),
+                    file.end(), this->delimiter_);
+            if (header.empty()) {
+                throw_parsing_error("Could not parse header", path, 1);
+            }
+            return parse_rows(file.begin(), file.end(), header,
+                    get_column_map(header, this->integer_labels_,
+                            this->real_labels_),
+                    offset, this->delimiter_, handler, path, &file);
+        }
+
+        template <typename RowHandler>
+        std::size_t read(
+                std::istream& in_stream,
+                RowHandler& handler,
+                unsigned int offset = 0) const {
+            std::string buffer(
+                    (std::istreambuf_iterator<char>(in_stream)),
+                    std::istreambuf_iterator<char>());
+            const char * begin = buffer.data();
+            const char * end = begin + buffer.size();
+            std::vector<std::string> header = read_header(begin, end,
+                    this->delimiter_);
+            if (header.empty()) {
+                throw_parsing_error("Could not parse header", "", 1);
+            }
+            return parse_rows(begin, end, header,
+                    get_column_map(header, this->integer_labels_,
+                            this->real_labels_),
+                    offset, this->delimiter_, handler);
+        }
+};
+
+/**
+ * A spreadsheet that only keeps the columns it is asked for, stored as
+ * typed contiguous vectors.
+ *
+ * Columns are requested (as integer or real) before parsing. Files are
+ * memory mapped and tokenized in place, so no strings are allocated for
+ * cells, and cells of columns that were not requested are only counted.
+ * When built with threads, multiple files can be parsed concurrently; the
+ * rows are always appended in the order of the paths.
+ */
+class ColumnarSpreadsheet {
+
+    protected:
+
+        std::vector<std::string> header_;
+        std::vector<std::string> integer_labels_;
+        std::vector<std::string> real_labels_;
+        std::map<std::string, std::vector<long long> > integer_columns_;
+        std::map<std::string, std::vector<double> > real_columns_;
+        std::size_t number_of_rows_ = 0;
+        bool parsed_ = false;
+
+        struct Chunk {
+            std::vector< std::vector<long long> > integers;
+            std::vector< std::vector<double> > reals;
+            std::size_t number_of_rows = 0;
+
+            void operator()(
+                    const std::vector<long long>& row_integers,
+                    const std::vector<double>& row_reals) {
+                for (unsigned int i = 0; i < row_integers.size(); ++i) {
+                    this->integers[i].push_back(row_integers[i]);
+                }
+                for (unsigned int i = 0; i < row_reals.size(); ++i) {
+                    this->reals[i].push_back(row_reals[i]);
+                }
+            }
+        };
+
+        void parse_buffer(
+                const char * begin,
+                const char * end,
+                const std::vector<int>& column_map,
+                unsigned int offset,
+                char delimiter,
+                Chunk& chunk,
+                const std::string& path,
+                MappedFile * mapped_file = nullptr) const {
+            chunk.integers.assign(this->integer_labels_.size(),
+                    std::vector<long long>());
+            chunk.reals.assign(this->real_labels_.size(),
+                    std::vector<double>());
+            chunk.number_of_rows = parse_rows(begin, end, this->header_,
+                    column_map, offset, delimiter, chunk, path,
+                    mapped_file);
+        }
+
+        void set_header(
+                const std::vector<std::string>& header,
+                const std::string& path) {
+            if (this->header_.empty()) {
+                if (header.empty()) {
+                    throw_parsing_error("Could not parse header", path, 1);
+                }
+                this->header_ = header;
+            }
+            else if (header != this->header_) {
+                throw_parsing_error("Headers does not match", path, 1);
+            }
+        }
+
+        void append(Chunk& chunk) {
+            for (unsigned int i = 0; i < this->integer_labels_.size(); ++i) {
+                std::vector<long long>& column = this->integer_columns_[this->integer_labels_.at(i)];
+                if (column.empty()) {
+                    column.swap(chunk.integers.at(i));
+                }
+                else {
+                    column.insert(column.end(),
+                            chunk.integers.at(i).begin(),
+                            chunk.integers.at(i).end());
+                }
+            }
+            for (unsigned int i = 0; i < this->real_labels_.size(); ++i) {
+                std::vector<double>& column = this->real_columns_[this->real_labels_.at(i)];
+                if (column.empty()) {
+                    column.swap(chunk.reals.at(i));
+                }
+                else {
+                    column.insert(column.end(),
+                            chunk.reals.at(i).begin(),
+                            chunk.reals.at(i).end());
+                }
+            }
+            this->number_of_rows_ += chunk.number_of_rows;
+        }
+
+        template <typename T>
+        static bool integer_fits(long long v, std::true_type) {
+            if (v < 0) {
+                return (std::is_signed<T>::value &&
+                        (v >= (long long)std::numeric_limits<T>::min()));
+            }
+            return ((unsigned long long)v <=
+                    (unsigned long long)std::numeric_limits<T>::max());
+        }
+        template <typename T>
+        static bool integer_fits(long long, std::false_type) {
+            return true;
+        }
+
+        void check_requests() {
+            if (this->parsed_) {
+                throw EcoevolitySpreadsheetError(
+                        "columns must be requested before parsing");
+            }
+        }
+
+    public:
+
+        /**
+         * Request that a column be parsed; integral types are stored as
+         * long long, and all other types as double.
+         */
+        template <typename T>
+        void add_column(const std::string& label) {
+            this->check_requests();
+            if ((this->integer_columns_.count(label) > 0) ||
+                    (this->real_columns_.count(label) > 0)) {
+                return;
+            }
+            if (std::is_integral<T>::value) {
+                this->integer_labels_.push_back(label);
+                this->integer_columns_[label];
+            }
+            else {
+                this->real_labels_.push_back(label);
+                this->real_columns_[label];
+            }
+        }
+
+        void update(
+                std::istream& in_stream,
+                unsigned int offset = 0,
+                char delimiter = '\t')
+        {
+            std::string buffer(
+                    (std::istreambuf_iterator<char>(in_stream)),
+                    std::istreambuf_iterator<char>());
+            const char * begin = buffer.data();
+            const char * end = begin + buffer.size();
+            this->set_header(read_header(begin, end, delimiter), "");
+            this->parsed_ = true;
+            Chunk chunk;
+            this->parse_buffer(begin, end, get_column_map(this->header_,
+                        this->integer_labels_, this->real_labels_),
+                    offset, delimiter, chunk, "");
+            this->append(chunk);
+        }
+
+        void update(
+                const std::string& path,
+                unsigned int offset = 0,
+                char delimiter = '\t')
+        {
+            std::vector<std::string> paths = {path};
+            this->update(paths, offset, delimiter);
+        }
+
+        void update(
+                const std::vector<std::string>& paths,
+                unsigned int offset = 0,
+                char delimiter = '\t',
+                unsigned int nthreads = 1)
+        {
+            if (paths.empty()) {
+                return;
+            }
+            {
+                MappedFile first_file(paths.at(0));
+                this->set_header(read_header(first_file.begin(),
+                        first_file.end(), delimiter), paths.at(0));
+            }
+            this->parsed_ = true;
+            const std::vector<int> column_map = get_column_map(this->header_,
+                    this->integer_labels_, this->real_labels_);
+
+            std::vector<Chunk> chunks(paths.size());
+            std::vector<std::exception_ptr> errors(paths.size());
+            unsigned int next_path = 0;
+#ifdef BUILD_WITH_THREADS
+            std::mutex path_mutex;
+#endif
+            auto work = [&]() {
+                unsigned int i;
+                while (true) {
+                    {
+#ifdef BUILD_WITH_THREADS
+                        std::lock_guard<std::mutex> path_lock(path_mutex);
+#endif
+                        if (next_path >= paths.size()) {
+                            return;
+                        }
+                        i = next_path++;
+                    }
+                    try {
+                        MappedFile file(paths.at(i));
+                        this->parse_buffer(file.begin(), file.end(),
+                                column_map, offset, delimiter,
+                                chunks.at(i), paths.at(i), &file);
+                    }
+                    catch (...) {
+                        errors.at(i) = std::current_exception();
+                    }
+                }
+            };
+            unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+            number_of_workers = std::max(1u,
+                    std::min(nthreads, (unsigned int)paths.size()));
+            std::vector< std::future<void> > workers;
+            workers.reserve(number_of_workers - 1);
+            for (unsigned int w = 1; w < number_of_workers; ++w) {
+                workers.push_back(std::async(std::launch::async, work));
+            }
+#endif
+            work();
+#ifdef BUILD_WITH_THREADS
+            for (auto & w : workers) {
+                w.get();
+            }
+#endif
+            for (unsigned int i = 0; i < paths.size(); ++i) {
+                if (errors.at(i)) {
+                    std::cerr << "ERROR: Problem parsing spreadsheet \'"
+                              << paths.at(i) << "\'\n";
+                    std::rethrow_exception(errors.at(i));
+                }
+            }
+            for (auto & chunk : chunks) {
+                this->append(chunk);
+            }
+        }
+
+        const std::vector<std::string>& get_keys() const {
+            return this->header_;
+        }
+
+        bool has_key(const std::string& k) const {
+            for (auto const & h : this->header_) {
+                if (h == k) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool has_column(const std::string& k) const {
+            return ((this->integer_columns_.count(k) > 0) ||
+                    (this->real_columns_.count(k) > 0));
+        }
+
+        std::size_t get_number_of_rows() const {
+            return this->number_of_rows_;
+        }
+
+        const std::vector<long long>& get_integer_column(
+                const std::string& column_label) const {
+            auto column = this->integer_columns_.find(column_label);
+            if (column == this->integer_columns_.end()) {
+                throw EcoevolitySpreadsheetError("integer column \'" +
+                        column_label + "\' was not parsed");
+            }
+            return column->second;
+        }
+
+        const std::vector<double>& get_real_column(
+                const std::string& column_label) const {
+            auto column = this->real_columns_.find(column_label);
+            if (column == this->real_columns_.end()) {
+                throw EcoevolitySpreadsheetError("real column \'" +
+                        column_label + "\' was not parsed");
+            }
+            return column->second;
+        }
+
+        template <typename T>
+        void get(
+                const std::string& column_label,
+                std::vector<T>& target) const
+        {
+            if (this->real_columns_.count(column_label) > 0) {
+                if (std::is_integral<T>::value) {
+                    throw EcoevolitySpreadsheetError("column \'" +
+                            column_label + "\' was parsed as real numbers");
+                }
+                const std::vector<double>& column = this->real_columns_.at(column_label);
+                target.insert(target.end(), column.begin(), column.end());
+                return;
+            }
+            for (auto v : this->get_integer_column(column_label)) {
+                if (! integer_fits<T>(v, std::is_integral<T>())) {
+                    throw EcoevolitySpreadsheetError("could not convert \'" +
+                            std::to_string(v) + "\'");
+                }
+                target.push_back(static_cast<T>(v));
+            }
+        }
+
+        template <typename T>
+        std::vector<T> get(
+                const std::string& column_label) const
+        {
+            std::vector<T> r;
+            r.reserve(this->number_of_rows_);
+            this->get<T>(column_label, r);
+            return r;
+        }
+
+        template <typename T>
+        SampleSummarizer<T> summarize(const std::string& column_label) const {
+            SampleSummarizer<T> summarizer;
+            for (auto v : this->get<T>(column_label)) {
+                summarizer.add_sample(v);
+            }
+            return summarizer;
+        }
+};
+
 } // namespace spreadsheet 
 
 #endif
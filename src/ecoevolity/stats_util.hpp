@@ -234,25 +234,14 @@ inline double effective_sample_size(
  */
 template <typename T>
 inline double potential_scale_reduction_factor(
-        const std::vector< std::vector<T> > & chains) {
-    unsigned int nchains = chains.size();
+        const std::vector< SampleSummarizer<T> > & sample_summaries) {
+    unsigned int nchains = sample_summaries.size();
     ECOEVOLITY_ASSERT(nchains > 1);
-    unsigned int nsamples = chains.at(0).size();
-    std::vector<SampleSummarizer<T>> sample_summaries(nchains);
-    for (unsigned int chain_idx = 0; chain_idx < chains.size(); ++chain_idx) {
-        for (unsigned int sample_idx = 0;
-                sample_idx < chains.at(chain_idx).size();
-                ++sample_idx) {
-            sample_summaries.at(chain_idx).add_sample(
-                    chains.at(chain_idx).at(sample_idx));
-        }
-        ECOEVOLITY_ASSERT(sample_summaries.at(chain_idx).sample_size() == nsamples);
-    }
-    ECOEVOLITY_ASSERT(sample_summaries.size() == nchains);
-
+    unsigned int nsamples = sample_summaries.at(0).sample_size();
     SampleSummarizer<double> summary_of_variances;
     SampleSummarizer<double> summary_of_means;
     for (auto ss : sample_summaries) {
+        ECOEVOLITY_ASSERT(ss.sample_size() == nsamples);
         summary_of_variances.add_sample(ss.variance());
         summary_of_means.add_sample(ss.mean());
     }
@@ -266,6 +255,22 @@ inline double potential_scale_reduction_factor(
     }
     return std::sqrt(pooled_posterior_var / within_chain_var);
 }
+template <typename T>
+inline double potential_scale_reduction_factor(
+        const std::vector< std::vector<T> > & chains) {
+    unsigned int nchains = chains.size();
+    ECOEVOLITY_ASSERT(nchains > 1);
+    std::vector<SampleSummarizer<T>> sample_summaries(nchains);
+    for (unsigned int chain_idx = 0; chain_idx < chains.size(); ++chain_idx) {
+        for (unsigned int sample_idx = 0;
+                sample_idx < chains.at(chain_idx).size();
+                ++sample_idx) {
+            sample_summaries.at(chain_idx).add_sample(
+                    chains.at(chain_idx).at(sample_idx));
+        }
+    }
+    return potential_scale_reduction_factor<T>(sample_summaries);
+}
 
 
 /**
@@ -21,7 +21,14 @@
 #define SUMCOEVOLITY_HPP
 
 #include <limits>
+#include <algorithm>
 #include <time.h>
+#include <unordered_map>
+
+#ifdef BUILD_WITH_THREADS
+#include <mutex>
+#include <future>
+#endif
 
 #include "cpp-optparse/OptionParser.h"
 
@@ -34,6 +41,9 @@
 #include "string_util.hpp"
 #include "settings.hpp"
 #include "spreadsheet.hpp"
+#include "set_partition_index.hpp"
+#include "model_prior_probability.hpp"
+#include "model_tally.hpp"
 
 
 void write_sumcoevolity_splash(std::ostream& out);
@@ -83,15 +93,24 @@ int sumcoevolity_main(int argc, char * argv[]) {
             .set_default("")
             .help("Path to the YAML config file used to generate the provided "
                   "log files. If provided, prior probabilities and Bayes "
-                  "factors will be approximated via simulation.");
+                  "factors will be calculated.");
     parser.add_option("-n", "--number-of-samples")
             .action("store")
             .type("unsigned int")
             .dest("number_of_samples")
             .set_default("100000")
             .help("Number of simulation samples. "
-                  "Only used if YAML config file is provided. "
+                  "Only used if prior probabilities are simulated. "
                   "Default: 100000.");
+    parser.add_option("--simulate")
+            .action("store_true")
+            .dest("simulate")
+            .help("Approximate prior probabilities via simulation. By "
+                  "default, prior probabilities are calculated exactly, "
+                  "integrating over the priors on the concentration (or "
+                  "split weight) and discount parameters numerically. "
+                  "Simulations are always used if these priors are not "
+                  "gamma, beta, or uniform distributions.");
     parser.add_option("--comparisons")
             .action("store")
             .dest("comparisons")
@@ -106,8 +125,22 @@ int sumcoevolity_main(int argc, char * argv[]) {
             .type("long")
             .dest("seed")
             .help("Seed for random number generator. "
-                  "Only used if YAML config file is provided. "
+                  "Only used if prior probabilities are simulated. "
                   "Default: Set from clock.");
+#ifdef BUILD_WITH_THREADS
+    parser.add_option("--nthreads")
+            .action("store")
+            .type("unsigned int")
+            .dest("nthreads")
+            .set_default("1")
+            .help("Number of threads to use for parsing the log files and, "
+                  "if prior probabilities are simulated, for the "
+                  "simulations. The simulations are done in blocks, each "
+                  "with its own random number stream seeded from the main "
+                  "seed, so the results do not depend on the number of "
+                  "threads. "
+                  "Default: 1 (no multithreading).");
+#endif
     parser.add_option("-f", "--force")
             .action("store_true")
             .dest("force")
@@ -151,6 +184,12 @@ int sumcoevolity_main(int argc, char * argv[]) {
                 "Number of samples must be 1 or greater");
     }
 
+#ifdef BUILD_WITH_THREADS 
+    unsigned int nthreads = options.get("nthreads");
+#else
+    unsigned int nthreads = 1;
+#endif
+
     unsigned int burnin = options.get("burnin");
     // Using unsigned int for burnin, so no need to check if negative
     // if (burnin < 0) {
@@ -159,9 +198,10 @@ int sumcoevolity_main(int argc, char * argv[]) {
     // }
 
     std::string config_path = options.get("config").get_str();
-    bool running_sims = false;
+    bool reporting_priors = false;
+    bool simulating_priors = options.get("simulate");
     if (options.is_set_by_user("config")) {
-        running_sims = true;
+        reporting_priors = true;
         if (! path::exists(config_path)) {
             throw EcoevolityError("Config path \'" + config_path +
                     "\' does not exist");
@@ -212,29 +252,14 @@ int sumcoevolity_main(int argc, char * argv[]) {
     time(&start);
 
     std::cerr << "Parsing log files...\n";
-    spreadsheet::Spreadsheet posterior_sample;
-    posterior_sample.update(log_paths, burnin);
-    std::vector<int> nevents = posterior_sample.get<int>("number_of_events");
-
-    unsigned int number_of_posterior_samples = nevents.size();
-    if (number_of_posterior_samples < 1) {
-        throw EcoevolityError(
-                "No samples were parsed from the log files. "
-                "Perhaps you specified a burn in value larger than the number "
-                "of samples in each log file?"
-                );
-    }
-
-    std::cerr << "Parsed " << number_of_posterior_samples
-              << " total samples from "
-              << log_paths.size() << " log files.\n";
-
-    std::vector<std::string> keys = posterior_sample.get_keys();
+    std::vector<std::string> keys;
+    spreadsheet::parse_header(log_paths.at(0), keys);
 
     // Vet user specified comparison labels
     if (user_specified_comparisons) {
         for (unsigned int i = 0; i < comparison_labels.size(); ++i) {
-            if (! posterior_sample.has_key("root_height_index_" + comparison_labels.at(i))) {
+            if (std::find(keys.begin(), keys.end(),
+                        "root_height_index_" + comparison_labels.at(i)) == keys.end()) {
                 std::ostringstream message;
                 message << "ERROR: comparison label \'"
                         << comparison_labels.at(i)
@@ -244,12 +269,12 @@ int sumcoevolity_main(int argc, char * argv[]) {
         }
     }
 
-    std::vector<std::vector<unsigned int> > indices;
+    std::vector<std::string> integer_labels = {"number_of_events"};
     std::vector<unsigned int> comparison_indices;
     unsigned int comparison_index = 0;
     for (auto const & k: keys) { 
         if (string_util::startswith(k, "root_height_index_")) {
-            indices.push_back(posterior_sample.get<unsigned int>(k));
+            integer_labels.push_back(k);
             if (user_specified_comparisons) {
                 for (auto const & l: comparison_labels) {
                     if (k == ("root_height_index_" + l)) {
@@ -260,8 +285,113 @@ int sumcoevolity_main(int argc, char * argv[]) {
             ++comparison_index;
         }
     }
-    unsigned int number_of_comparisons = indices.size();
+    unsigned int number_of_comparisons = comparison_index;
+    if (number_of_comparisons < 1) {
+        throw EcoevolityError(
+                "No root_height_index columns were found in the log files");
+    }
+
+    // The rows of the log files are tallied as they are parsed, so memory
+    // use depends on the number of distinct models sampled, not on the
+    // number of samples. Files are split among workers, each with its own
+    // tally, and the tallies are merged at the end.
+    struct PosteriorTally {
+        std::vector<unsigned int> nevents_counts;
+        unsigned int comparisons_shared_count = 0;
+        ModelTally model_counts;
 
+        explicit PosteriorTally(unsigned int number_of_comparisons) :
+            nevents_counts(number_of_comparisons + 1, 0),
+            model_counts(number_of_comparisons) { }
+    };
+    const spreadsheet::ColumnarReader log_reader(integer_labels,
+            std::vector<std::string>());
+    unsigned int number_of_log_workers = 1;
+#ifdef BUILD_WITH_THREADS
+    number_of_log_workers = std::max(1u,
+            std::min(nthreads, (unsigned int)log_paths.size()));
+#endif
+    std::vector<PosteriorTally> posterior_tallies(number_of_log_workers,
+            PosteriorTally(number_of_comparisons));
+    std::vector<std::exception_ptr> log_errors(log_paths.size());
+    unsigned int next_log = 0;
+#ifdef BUILD_WITH_THREADS
+    std::mutex log_mutex;
+#endif
+    auto tally_logs = [&](unsigned int worker_idx) {
+        PosteriorTally & worker_tally = posterior_tallies.at(worker_idx);
+        std::vector<unsigned int> model(number_of_comparisons, 0);
+        auto tally_row = [&](const std::vector<long long>& integers,
+                const std::vector<double>&) {
+            const long long nevents = integers[0];
+            if ((nevents < 1) || (nevents > number_of_comparisons)) {
+                throw EcoevolityError("Invalid number of events: " +
+                        std::to_string(nevents));
+            }
+            for (unsigned int j = 0; j < number_of_comparisons; ++j) {
+                if ((integers[j + 1] < 0) ||
+                        (integers[j + 1] >= number_of_comparisons)) {
+                    throw EcoevolityError("Invalid root height index: " +
+                            std::to_string(integers[j + 1]));
+                }
+                model[j] = integers[j + 1];
+            }
+            ++worker_tally.nevents_counts[nevents];
+            worker_tally.model_counts.add(model.data());
+            if (user_specified_comparisons) {
+                unsigned int ref_index = model.at(comparison_indices.at(0));
+                bool comps_shared = true;
+                for (unsigned int comp_idx = 1; comp_idx < comparison_indices.size(); ++comp_idx) {
+                    if (model.at(comparison_indices.at(comp_idx)) != ref_index) {
+                        comps_shared = false;
+                        break;
+                    }
+                }
+                if (comps_shared) {
+                    ++worker_tally.comparisons_shared_count;
+                }
+            }
+        };
+        unsigned int i;
+        while (true) {
+            {
+#ifdef BUILD_WITH_THREADS
+                std::lock_guard<std::mutex> log_lock(log_mutex);
+#endif
+                if (next_log >= log_paths.size()) {
+                    return;
+                }
+                i = next_log++;
+            }
+            try {
+                log_reader.read(log_paths.at(i), tally_row, burnin);
+            }
+            catch (...) {
+                log_errors.at(i) = std::current_exception();
+            }
+        }
+    };
+#ifdef BUILD_WITH_THREADS
+    std::vector< std::future<void> > log_workers;
+    log_workers.reserve(number_of_log_workers - 1);
+    for (unsigned int w = 0; w < (number_of_log_workers - 1); ++w) {
+        log_workers.push_back(std::async(std::launch::async, tally_logs, w));
+    }
+    // Use the main thread as the last worker
+    tally_logs(number_of_log_workers - 1);
+    for (auto & w : log_workers) {
+        w.get();
+    }
+#else
+    tally_logs(0);
+#endif
+    for (unsigned int i = 0; i < log_paths.size(); ++i) {
+        if (log_errors.at(i)) {
+            std::cerr << "ERROR: Problem parsing log file \'"
+                      << log_paths.at(i) << "\'\n";
+            std::rethrow_exception(log_errors.at(i));
+        }
+    }
 
     std::map<unsigned int, unsigned int> nevents_counts;
     std::map<unsigned int, unsigned int> prior_nevents_counts;
@@ -272,47 +402,44 @@ int sumcoevolity_main(int argc, char * argv[]) {
     unsigned int comparisons_shared_count = 0;
     unsigned int prior_comparisons_shared_count = 0;
 
-    std::map<std::vector<unsigned int>, unsigned int> model_counts;
-    std::map<std::vector<unsigned int>, unsigned int> prior_model_counts;
-
-    for (unsigned int i = 0; i < nevents.size(); ++i) {
-        std::vector<unsigned int> model;
-        model.reserve(number_of_comparisons);
-        for (unsigned int j = 0; j < number_of_comparisons; ++j) {
-            model.push_back(indices.at(j).at(i));
+    ModelTally & model_counts = posterior_tallies.at(0).model_counts;
+    for (unsigned int w = 0; w < posterior_tallies.size(); ++w) {
+        const PosteriorTally & worker_tally = posterior_tallies.at(w);
+        for (unsigned int k = 1; k <= number_of_comparisons; ++k) {
+            nevents_counts[k] += worker_tally.nevents_counts.at(k);
         }
-        if (model_counts.count(model) < 1) {
-            model_counts[model] = 1;
-            prior_model_counts[model] = 0;
-        }
-        else {
-            ++model_counts[model];
-        }
-        ++nevents_counts[nevents.at(i)];
-        if (user_specified_comparisons) {
-            unsigned int ref_index = model.at(comparison_indices.at(0));
-            bool comps_shared = true;
-            for (unsigned int comp_idx = 1; comp_idx < comparison_indices.size(); ++comp_idx) {
-                if (model.at(comparison_indices.at(comp_idx)) != ref_index) {
-                    comps_shared = false;
-                    break;
-                }
-            }
-            if (comps_shared) {
-                ++comparisons_shared_count;
-            }
+        comparisons_shared_count += worker_tally.comparisons_shared_count;
+        if (w > 0) {
+            model_counts.merge(worker_tally.model_counts);
         }
     }
+
+    unsigned int number_of_posterior_samples = model_counts.get_total();
+    if (number_of_posterior_samples < 1) {
+        throw EcoevolityError(
+                "No samples were parsed from the log files. "
+                "Perhaps you specified a burn in value larger than the number "
+                "of samples in each log file?"
+                );
+    }
+
+    std::cerr << "Parsed " << number_of_posterior_samples
+              << " total samples from "
+              << log_paths.size() << " log files.\n";
+
+    // Sorted by model
+    std::vector< std::pair<std::vector<unsigned int>, unsigned int> > model_count_pairs =
+            model_counts.get_model_count_pairs();
+    std::map<std::vector<unsigned int>, unsigned int> prior_model_counts;
+    for (auto const & kv: model_count_pairs) {
+        prior_model_counts[kv.first] = 0;
+    }
+
     unsigned int tally = 0;
     for (auto const & kv: nevents_counts) {
         tally += kv.second;
     }
     ECOEVOLITY_ASSERT(tally == number_of_posterior_samples);
-    tally = 0;
-    for (auto const & kv: model_counts) {
-        tally += kv.second;
-    }
-    ECOEVOLITY_ASSERT(tally == number_of_posterior_samples);
 
     // Sort descending by counts
     std::vector< std::pair<unsigned int, unsigned int> > nevents_count_pairs;
@@ -320,14 +447,16 @@ int sumcoevolity_main(int argc, char * argv[]) {
         nevents_count_pairs.push_back(kv);
     }
     sort_pairs(nevents_count_pairs, false, true);
-    std::vector< std::pair<std::vector<unsigned int>, unsigned int> > model_count_pairs;
-    for (auto const & kv: model_counts) {
-        model_count_pairs.push_back(kv);
-    }
     sort_pairs(model_count_pairs, false, true);
 
-    // Run simulations
-    if (running_sims) {
+    std::map<unsigned int, double> prior_nevents_probs;
+    std::map<std::vector<unsigned int>, double> prior_model_probs;
+    double prior_comparisons_shared_prob = 0.0;
+    double min_prior_prob = 1.0 / (double)nreps;
+    double max_prior_prob = (nreps - 1) / (double)nreps;
+
+    // Calculate or simulate prior probabilities
+    if (reporting_priors) {
         SettingsType settings = SettingsType(config_path);
         if (settings.get_number_of_comparisons() != number_of_comparisons) {
             throw EcoevolityError("Number of comparisons found in log files "
@@ -348,7 +477,6 @@ int sumcoevolity_main(int argc, char * argv[]) {
                     "model was fixed in the analysis).");
         }
 
-        std::cerr << "Approximating prior probabilities via simulations...\n";
         const PositiveRealParameterSettings & concentration_settings = settings.get_concentration_settings();
         std::shared_ptr<ContinuousProbabilityDistribution> concentration_prior = concentration_settings.get_prior_settings().get_instance();
         bool concentration_is_fixed = concentration_settings.is_fixed();
@@ -358,8 +486,7 @@ int sumcoevolity_main(int argc, char * argv[]) {
         double discount = 0.0;
         bool discount_is_fixed = true;
 
-        std::cerr << "Simulations settings:\n";
-        std::cerr << "\tseed = " << seed << "\n";
+        std::cerr << "Prior settings:\n";
         double concentration = 1.0;
         EcoevolityOptions::ModelPrior model_prior = settings.get_model_prior();
         if ((model_prior == EcoevolityOptions::ModelPrior::dpp) ||
@@ -406,65 +533,242 @@ int sumcoevolity_main(int argc, char * argv[]) {
                     "probabilities.");
         }
 
-        for (unsigned int i = 0; i < nreps; ++i) {
-            if (! concentration_is_fixed) {
-                concentration = concentration_prior->draw(rng);
+        if ((model_prior != EcoevolityOptions::ModelPrior::dpp) &&
+                (model_prior != EcoevolityOptions::ModelPrior::pyp) &&
+                (model_prior != EcoevolityOptions::ModelPrior::uniform)) {
+            std::ostringstream message;
+            message << "ERROR: simulations not supported for model prior \'"
+                    << (int)settings.get_model_prior()
+                    << "\'\n";
+            throw EcoevolityError(message.str());
+        }
+
+        if ((! simulating_priors) && (
+                    ((! concentration_is_fixed) &&
+                     (! HyperpriorQuadrature::can_integrate(*concentration_prior))) ||
+                    ((! discount_is_fixed) &&
+                     (! HyperpriorQuadrature::can_integrate(*discount_prior))))) {
+            std::cerr << "The priors on the model hyperparameters cannot be "
+                      << "integrated numerically, so prior probabilities will "
+                      << "be simulated\n";
+            simulating_priors = true;
+        }
+
+        if (! simulating_priors) {
+            std::cerr << "Calculating prior probabilities...\n";
+            ModelPriorProbabilities prior_probs(number_of_comparisons,
+                    model_prior,
+                    concentration_is_fixed ?
+                        HyperpriorQuadrature(concentration) :
+                        HyperpriorQuadrature(*concentration_prior),
+                    discount_is_fixed ?
+                        HyperpriorQuadrature(discount) :
+                        HyperpriorQuadrature(*discount_prior));
+            for (unsigned int k = 1; k <= number_of_comparisons; ++k) {
+                prior_nevents_probs[k] =
+                        prior_probs.get_number_of_categories_probability(k);
             }
-            if (! discount_is_fixed) {
-                discount = discount_prior->draw(rng);
+            for (auto const & kv: prior_model_counts) {
+                prior_model_probs[kv.first] =
+                        prior_probs.get_model_probability(kv.first);
             }
-            std::vector<unsigned int> model(number_of_comparisons, 0);
-            unsigned int number_of_categories;
-            if ((settings.get_model_prior() == EcoevolityOptions::ModelPrior::dpp) ||
-                    (settings.get_model_prior() == EcoevolityOptions::ModelPrior::pyp)) {
-                number_of_categories = rng.pitman_yor_process(model, concentration, discount);
+            if (user_specified_comparisons) {
+                prior_comparisons_shared_prob = prior_probs.get_shared_probability(
+                        comparison_indices.size());
             }
-            else if (settings.get_model_prior() == EcoevolityOptions::ModelPrior::uniform) {
-                number_of_categories = rng.random_set_partition(model, concentration);
+            // Only probabilities that underflow or are certain are flagged
+            min_prior_prob = std::numeric_limits<double>::min();
+            max_prior_prob = 1.0 - std::numeric_limits<double>::epsilon();
+        }
+        else {
+            std::cerr << "Approximating prior probabilities via simulations...\n";
+            std::cerr << "\tseed = " << seed << "\n";
+            std::cerr << "\tnumber of samples = " << nreps << "\n";
+
+            // Models are tallied by their rank among all possible models when
+            // every model has a 64-bit key (up to 25 comparisons). Otherwise,
+            // they are tallied by the models themselves.
+            const SetPartitionIndex model_index(number_of_comparisons);
+            const bool tallying_model_keys = model_index.is_indexable();
+
+            struct PriorTally {
+                std::vector<unsigned int> nevents_counts;
+                unsigned int comparisons_shared_count = 0;
+                std::unordered_map<std::uint64_t, unsigned int> model_key_counts;
+                std::map<std::vector<unsigned int>, unsigned int> model_counts;
+            };
+
+            // Models are drawn in blocks, each from its own random number stream
+            // seeded from the main stream in block order, so the prior
+            // probabilities do not depend on the number of workers. Each worker
+            // keeps its own tally, and the tallies are merged at the end.
+            const unsigned int prior_block_size = 10000;
+            const unsigned int nblocks = (nreps + prior_block_size - 1) / prior_block_size;
+            std::vector<long> block_seeds(nblocks);
+            for (auto & block_seed : block_seeds) {
+                block_seed = rng.uniform_int(1, std::numeric_limits<int>::max() - 1);
             }
-            else {
-                std::ostringstream message;
-                message << "ERROR: simulations not supported for model prior \'"
-                        << (int)settings.get_model_prior()
-                        << "\'\n";
-                throw EcoevolityError(message.str());
+
+            unsigned int number_of_workers = 1;
+#ifdef BUILD_WITH_THREADS
+            number_of_workers = std::max(1u, std::min(nthreads, nblocks));
+#endif
+            std::vector<PriorTally> tallies(number_of_workers);
+            unsigned int next_block = 0;
+            bool failed = false;
+            std::vector<std::exception_ptr> errors(nblocks);
+#ifdef BUILD_WITH_THREADS
+            std::mutex block_mutex;
+#endif
+            auto work = [&](unsigned int worker_idx) {
+                PriorTally & worker_tally = tallies.at(worker_idx);
+                worker_tally.nevents_counts.assign(number_of_comparisons + 1, 0);
+                std::vector<unsigned int> model(number_of_comparisons, 0);
+                double worker_concentration = concentration;
+                double worker_discount = discount;
+                unsigned int b;
+                while (true) {
+                    {
+#ifdef BUILD_WITH_THREADS
+                        std::lock_guard<std::mutex> block_lock(block_mutex);
+#endif
+                        if (failed || (next_block >= nblocks)) {
+                            return;
+                        }
+                        b = next_block++;
+                    }
+                    try {
+                        const unsigned int block_size = std::min(prior_block_size,
+                                nreps - (b * prior_block_size));
+                        RandomNumberGenerator block_rng(block_seeds.at(b));
+                        for (unsigned int i = 0; i < block_size; ++i) {
+                            if (! concentration_is_fixed) {
+                                worker_concentration = concentration_prior->draw(block_rng);
+                            }
+                            if (! discount_is_fixed) {
+                                worker_discount = discount_prior->draw(block_rng);
+                            }
+                            unsigned int number_of_categories;
+                            if (model_prior == EcoevolityOptions::ModelPrior::uniform) {
+                                number_of_categories = block_rng.random_set_partition(
+                                        model, worker_concentration);
+                            }
+                            else {
+                                number_of_categories = block_rng.pitman_yor_process(
+                                        model, worker_concentration, worker_discount);
+                            }
+                            ++worker_tally.nevents_counts.at(number_of_categories);
+                            if (tallying_model_keys) {
+                                ++worker_tally.model_key_counts[model_index.get_key(model)];
+                            }
+                            else {
+                                ++worker_tally.model_counts[model];
+                            }
+                            if (user_specified_comparisons) {
+                                unsigned int ref_index = model.at(comparison_indices.at(0));
+                                bool comps_shared = true;
+                                for (unsigned int comp_idx = 1; comp_idx < comparison_indices.size(); ++comp_idx) {
+                                    if (model.at(comparison_indices.at(comp_idx)) != ref_index) {
+                                        comps_shared = false;
+                                        break;
+                                    }
+                                }
+                                if (comps_shared) {
+                                    ++worker_tally.comparisons_shared_count;
+                                }
+                            }
+                        }
+                    }
+                    catch (...) {
+#ifdef BUILD_WITH_THREADS
+                        std::lock_guard<std::mutex> block_lock(block_mutex);
+#endif
+                        errors.at(b) = std::current_exception();
+                        failed = true;
+                        return;
+                    }
+                }
+            };
+#ifdef BUILD_WITH_THREADS
+            std::vector< std::future<void> > workers;
+            workers.reserve(number_of_workers - 1);
+            for (unsigned int w = 0; w < (number_of_workers - 1); ++w) {
+                workers.push_back(std::async(std::launch::async, work, w));
             }
-            ++prior_nevents_counts[number_of_categories];
-            if (prior_model_counts.count(model) < 1) {
-                prior_model_counts[model] = 1;
+            // Use the main thread as the last worker
+            work(number_of_workers - 1);
+            for (auto & w : workers) {
+                w.get();
             }
-            else {
-                ++prior_model_counts[model];
+#else
+            work(0);
+#endif
+            for (auto & e : errors) {
+                if (e) {
+                    std::rethrow_exception(e);
+                }
             }
-            if (user_specified_comparisons) {
-                unsigned int ref_index = model.at(comparison_indices.at(0));
-                bool comps_shared = true;
-                for (unsigned int comp_idx = 1; comp_idx < comparison_indices.size(); ++comp_idx) {
-                    if (model.at(comparison_indices.at(comp_idx)) != ref_index) {
-                        comps_shared = false;
-                        break;
+
+            // Merge the tallies. Only the prior probabilities of the models
+            // sampled from the posterior are reported, so only those are looked
+            // up.
+            std::unordered_map<std::uint64_t, unsigned int> & model_key_counts =
+                    tallies.at(0).model_key_counts;
+            std::map<std::vector<unsigned int>, unsigned int> & all_model_counts =
+                    tallies.at(0).model_counts;
+            for (unsigned int w = 0; w < tallies.size(); ++w) {
+                const PriorTally & worker_tally = tallies.at(w);
+                for (unsigned int k = 1; k <= number_of_comparisons; ++k) {
+                    prior_nevents_counts[k] += worker_tally.nevents_counts.at(k);
+                }
+                prior_comparisons_shared_count += worker_tally.comparisons_shared_count;
+                if (w < 1) {
+                    continue;
+                }
+                for (auto const & kv: worker_tally.model_key_counts) {
+                    model_key_counts[kv.first] += kv.second;
+                }
+                for (auto const & kv: worker_tally.model_counts) {
+                    all_model_counts[kv.first] += kv.second;
+                }
+            }
+            tally = 0;
+            for (auto const & kv: prior_nevents_counts) {
+                tally += kv.second;
+            }
+            ECOEVOLITY_ASSERT(tally == nreps);
+            tally = 0;
+            for (auto const & kv: model_key_counts) {
+                tally += kv.second;
+            }
+            for (auto const & kv: all_model_counts) {
+                tally += kv.second;
+            }
+            ECOEVOLITY_ASSERT(tally == nreps);
+            for (auto & kv: prior_model_counts) {
+                if (tallying_model_keys) {
+                    auto key_count = model_key_counts.find(model_index.get_key(kv.first));
+                    if (key_count != model_key_counts.end()) {
+                        kv.second = key_count->second;
                     }
                 }
-                if (comps_shared) {
-                    ++prior_comparisons_shared_count;
+                else {
+                    auto model_count = all_model_counts.find(kv.first);
+                    if (model_count != all_model_counts.end()) {
+                        kv.second = model_count->second;
+                    }
                 }
             }
+            for (auto const & kv: prior_nevents_counts) {
+                prior_nevents_probs[kv.first] = kv.second / (double)nreps;
+            }
+            for (auto const & kv: prior_model_counts) {
+                prior_model_probs[kv.first] = kv.second / (double)nreps;
+            }
+            prior_comparisons_shared_prob = prior_comparisons_shared_count / (double)nreps;
         }
-        tally = 0;
-        for (auto const & kv: prior_nevents_counts) {
-            tally += kv.second;
-        }
-        ECOEVOLITY_ASSERT(tally == nreps);
-        tally = 0;
-        for (auto const & kv: prior_model_counts) {
-            tally += kv.second;
-        }
-        ECOEVOLITY_ASSERT(tally == nreps);
     }
 
-    double min_prior_prob = 1.0 / (double)nreps;
-    double max_prior_prob = (nreps - 1) / (double)nreps;
-
     double min_post_prob = 1.0 / (double)number_of_posterior_samples;
     double max_post_prob = (number_of_posterior_samples - 1) / (double)number_of_posterior_samples;
 
@@ -494,15 +798,15 @@ int sumcoevolity_main(int argc, char * argv[]) {
         else {
             std::cerr << post_prob << "\n";
         }
-        if (running_sims) {
+        if (reporting_priors) {
             std::cerr << "\tprior probability: ";
-            double prior_prob = prior_comparisons_shared_count / (double)nreps;
-            if (prior_comparisons_shared_count < 1) {
+            double prior_prob = prior_comparisons_shared_prob;
+            if (prior_prob <= 0.0) {
                 prior_prob = min_prior_prob;
                 std::cerr << "<" << prior_prob << "\n";
                 min_prior = true;
             }
-            else if (prior_comparisons_shared_count == nreps) {
+            else if (prior_prob >= 1.0) {
                 prior_prob = max_prior_prob;
                 std::cerr << ">" << prior_prob << "\n";
                 max_prior = true;
@@ -574,14 +878,14 @@ int sumcoevolity_main(int argc, char * argv[]) {
                 nevents_stream << post_prob << "\t";
             }
             nevents_stream << cumulative_post_prob << "\t";
-            if (running_sims) {
-                double prior_prob = prior_nevents_counts[nc.first] / (double)nreps;
-                if (prior_nevents_counts[nc.first] < 1) {
+            if (reporting_priors) {
+                double prior_prob = prior_nevents_probs[nc.first];
+                if (prior_prob <= 0.0) {
                     prior_prob = min_prior_prob;
                     nevents_stream << "<" << prior_prob << "\t";
                     min_prior = true;
                 }
-                else if (prior_nevents_counts[nc.first] == nreps) {
+                else if (prior_prob >= 1.0) {
                     prior_prob = max_prior_prob;
                     nevents_stream << ">" << prior_prob << "\t";
                     max_prior = true;
@@ -667,14 +971,14 @@ int sumcoevolity_main(int argc, char * argv[]) {
                 model_stream << post_prob << "\t";
             }
             model_stream << cumulative_post_prob << "\t";
-            if (running_sims) {
-                double prior_prob = prior_model_counts[mc.first] / (double)nreps;
-                if (prior_model_counts[mc.first] < 1) {
+            if (reporting_priors) {
+                double prior_prob = prior_model_probs[mc.first];
+                if (prior_prob <= 0.0) {
                     prior_prob = min_prior_prob;
                     model_stream << "<" << prior_prob << "\t";
                     min_prior = true;
                 }
-                else if (prior_model_counts[mc.first] == nreps) {
+                else if (prior_prob >= 1.0) {
                     prior_prob = max_prior_prob;
                     model_stream << ">" << prior_prob << "\t";
                     max_prior = true;
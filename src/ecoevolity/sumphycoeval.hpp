@@ -137,6 +137,17 @@ int sumphycoeval_main(int argc, char * argv[]) {
             .dest("include_merged_target_heights")
             .help("Include a summary of merged heights from the target tree. "
                   "If a target tree is not provided, this option is ignored.");
+#ifdef BUILD_WITH_THREADS
+    parser.add_option("--nthreads")
+            .action("store")
+            .type("unsigned int")
+            .dest("nthreads")
+            .set_default("1")
+            .help("Number of threads to use for parsing and summarizing "
+                  "trees. Tree files are summarized in parallel and merged in "
+                  "the order of the files, so the results do not depend on "
+                  "the number of threads. Default: 1.");
+#endif
     parser.add_option("-f", "--force")
             .action("store_true")
             .dest("force")
@@ -162,6 +173,12 @@ int sumphycoeval_main(int argc, char * argv[]) {
         }
     }
 
+#ifdef BUILD_WITH_THREADS
+    unsigned int nthreads = options.get("nthreads");
+#else
+    unsigned int nthreads = 1;
+#endif
+
     const double precision = 18;
     const double ultrametricity_tolerance = 1e-6;
     time_t start;
@@ -178,86 +195,14 @@ int sumphycoeval_main(int argc, char * argv[]) {
         std::cerr << "Writing tab-delimited table of convergence statistics..."
                   << std::endl;
         time(&start);
-        burnin = 1;
-
-        SampleSummarizer<double> std_devs_of_split_freqs;
-        tree_sample = treesum::TreeSample<PopulationNode>(
+        // Each tree is parsed only once and the statistics for every
+        // burn-in are computed from the compact samples
+        treesum::ConvergenceTable<PopulationNode> convergence_table(
                 log_paths,
                 "nexus",
-                burnin,
-                ultrametricity_tolerance);
-
-        unsigned int min_sample_size = tree_sample.get_source_sample_size(0);
-        for (unsigned int source_idx = 1;
-                source_idx < tree_sample.get_number_of_sources();
-                ++source_idx) {
-            if (tree_sample.get_source_sample_size(source_idx) < min_sample_size) {
-                min_sample_size = tree_sample.get_source_sample_size(source_idx);
-            }
-        }
-
-        bool use_inter_chain_stats = ((tree_sample.get_number_of_sources() > 1)
-                && tree_sample.equal_source_sample_sizes());
-
-        std::cout << "burnin\tsample_size";
-        if (use_inter_chain_stats) {
-            std::cout << "\tasdsf\tpsrf_tree_length\tpsrf_root_height\tpsrf_root_pop_size";
-        }
-        std::cout << "\tess_tree_length\tess_root_height\tess_root_pop_size\n";
-
-        while (true) {
-            ECOEVOLITY_ASSERT(burnin == tree_sample.get_source_burnin(0));
-            std::cout << burnin
-                      << "\t" << tree_sample.get_sample_size();
-            if (use_inter_chain_stats) {
-                double asdsf = tree_sample.get_average_std_dev_of_split_freqs(min_split_freq);
-
-                std::vector< std::vector<double> > tree_lens = tree_sample.get_tree_lengths_by_source();
-                double psrf_tree_len = potential_scale_reduction_factor<double>(tree_lens);
-                double ess_tree_len = effective_sample_size<double>(tree_lens, true);
-
-                std::vector< std::vector<double> > root_sizes = tree_sample.get_root_parameter_values_by_source("pop_size");
-                double psrf_root_pop_size = potential_scale_reduction_factor<double>(root_sizes);
-                double ess_root_pop_size = effective_sample_size<double>(root_sizes, true);
-
-                std::vector< std::vector<double> > root_heights = tree_sample.get_root_parameter_values_by_source("height");
-                double psrf_root_height = potential_scale_reduction_factor<double>(root_heights);
-                double ess_root_height = effective_sample_size<double>(root_heights, true);
-
-                std::cout << "\t" << asdsf
-                          << "\t" << psrf_tree_len
-                          << "\t" << psrf_root_height
-                          << "\t" << psrf_root_pop_size
-                          << "\t" << ess_tree_len
-                          << "\t" << ess_root_height
-                          << "\t" << ess_root_pop_size
-                          << "\n";
-            }
-            else {
-                std::vector<double> tree_lens = tree_sample.get_tree_lengths();
-                double ess_tree_len = effective_sample_size<double>(tree_lens, true);
-
-                std::vector<double> root_sizes = tree_sample.get_root_parameter_values("pop_size");
-                double ess_root_pop_size = effective_sample_size<double>(root_sizes, true);
-
-                std::vector<double> root_heights = tree_sample.get_root_parameter_values("height");
-                double ess_root_height = effective_sample_size<double>(root_heights, true);
-
-                std::cout << "\t" << ess_tree_len
-                          << "\t" << ess_root_height
-                          << "\t" << ess_root_pop_size
-                          << "\n";
-            }
-            burnin += conv_sum_interval;
-            if ((burnin + 1) >= min_sample_size) {
-                break;
-            }
-            tree_sample = treesum::TreeSample<PopulationNode>(
-                    log_paths,
-                    "nexus",
-                    burnin,
-                    ultrametricity_tolerance);
-        }
+                ultrametricity_tolerance,
+                nthreads);
+        convergence_table.write(std::cout, conv_sum_interval, min_split_freq);
 
         time(&finish);
         double duration = difftime(finish, start);
@@ -384,7 +329,8 @@ int sumphycoeval_main(int argc, char * argv[]) {
                 "nexus",
                 burnin,
                 ultrametricity_tolerance,
-                multiplier);
+                multiplier,
+                nthreads);
     }
     else {
         tree_sample = treesum::TreeSample<PopulationNode>(
@@ -392,7 +338,8 @@ int sumphycoeval_main(int argc, char * argv[]) {
                 "nexus",
                 burnin,
                 ultrametricity_tolerance,
-                multiplier);
+                multiplier,
+                nthreads);
     }
 
     if (writing_target_to_nexus) {
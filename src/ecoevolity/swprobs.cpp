@@ -45,7 +45,7 @@ int swprobs_main(int argc, char * argv[]) {
     const std::string version = version_ss.str();
 
     const std::string description =
-        "swprobs: Simulating split-weight probabilites";
+        "swprobs: Calculating split-weight probabilites";
     // const std::string epilog =
     //     "Epilog goes here...";
 
@@ -59,16 +59,24 @@ int swprobs_main(int argc, char * argv[]) {
             .action("store")
             .type("long")
             .dest("seed")
-            .help("Seed for random number generator. Default: Set from clock.");
+            .help("Seed for random number generator. Only used with "
+                  "\'--simulate\'. Default: Set from clock.");
     parser.add_option("-n", "--number-of-samples")
             .action("store")
             .type("unsigned int")
             .dest("number_of_samples")
             .set_default("100000")
             .help("Number of simulation samples. Default: 100000. "
-                  "Simulations are only used if a prior distribution on the "
-                  "split weight is specified (i.e., using "
-                  "\'--shape\'/\'--scale\' options.");
+                  "Only used with \'--simulate\'.");
+    parser.add_option("--simulate")
+            .action("store_true")
+            .dest("simulate")
+            .help("If a prior distribution on the split weight is specified "
+                  "(i.e., using \'--shape\'/\'--scale\' options), "
+                  "approximate the probabilities by averaging over split "
+                  "weights drawn from the prior. By default, the probabilities "
+                  "are calculated exactly, integrating over the prior "
+                  "numerically.");
     parser.add_option("--shape")
             .action("store")
             .type("double")
@@ -79,12 +87,9 @@ int swprobs_main(int argc, char * argv[]) {
                   "event models. If provided, the program will calculate the "
                   "corresponding scale parameter for the gamma distribution "
                   "such that the mean of the gamma prior is equal to the "
-                  "specified value of the split-weight parameter. Also, "
-                  "simulations will be performed to approximate the prior "
-                  "probabilities for numbers of events. If not provided, the "
-                  "split-weight parameter is simply fixed to the specifed "
-                  "value, and the prior probabilities are calculated "
-                  "exactly.");
+                  "specified value of the split-weight parameter. If not "
+                  "provided, the split-weight parameter is simply fixed to the "
+                  "specifed value.");
     parser.add_option("--scale")
             .action("store")
             .type("double")
@@ -172,6 +177,7 @@ int swprobs_main(int argc, char * argv[]) {
     }
 
     GammaDistribution gamma_split_weight(shape, scale);
+    const bool simulating = options.get("simulate");
 
     std::cerr << "Prior = split-weighted uniform\n";
     std::cerr << "Number of elements = " << number_of_elements << std::endl;
@@ -181,8 +187,10 @@ int swprobs_main(int argc, char * argv[]) {
     else {
         std::cerr << "Split weight ~ "
                   << gamma_split_weight.to_string() << std::endl;
-        std::cerr << "Seed = " << seed << std::endl;
-        std::cerr << "Number of samples = " << nreps << std::endl;
+        if (simulating) {
+            std::cerr << "Seed = " << seed << std::endl;
+            std::cerr << "Number of samples = " << nreps << std::endl;
+        }
     }
     std::string number_of_elements_str = std::to_string(number_of_elements);
     unsigned int ncats_padding = number_of_elements_str.size();
@@ -203,6 +211,17 @@ int swprobs_main(int argc, char * argv[]) {
         std::cerr << "Mean number of categories = " << sample_mean_ncats << std::endl;
 
     }
+    else if (! simulating) {
+        ModelPriorProbabilities prior_probs(number_of_elements,
+                model_prior,
+                HyperpriorQuadrature(gamma_split_weight));
+        for (unsigned int j = 0; j < number_of_elements; ++j) {
+            number_of_cat_probs.at(j) =
+                    prior_probs.get_number_of_categories_probability(j + 1);
+        }
+        std::cerr << "Mean number of categories = "
+                  << prior_probs.get_expected_number_of_categories() << std::endl;
+    }
     // else {
     //     unsigned int total = 0;
     //     std::vector<unsigned int> number_of_categories_counts(number_of_elements, 0);
@@ -249,7 +268,7 @@ int swprobs_main(int argc, char * argv[]) {
     }
 
 
-    if (split_weight_is_fixed) {
+    if (split_weight_is_fixed || (! simulating)) {
         std::cerr << "\nProbabilities of the number of categories:\n";
     }
     else {
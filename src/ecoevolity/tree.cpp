@@ -30,7 +30,8 @@ BasePopulationTree::BasePopulationTree(
         bool strict_on_constant_sites,
         bool strict_on_missing_sites, 
         bool strict_on_triallelic_sites,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->init(settings.data_settings.get_path(),
                settings.data_settings.get_population_name_delimiter(),
                settings.data_settings.population_name_is_prefix(),
@@ -42,7 +43,8 @@ BasePopulationTree::BasePopulationTree(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                settings.data_settings.get_ploidy(),
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     this->establish_tree_and_node_heights(settings, rng);
     this->establish_branch_and_mu_parameters(settings, rng);
 }
@@ -357,7 +359,8 @@ void BasePopulationTree::init_data(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         double ploidy,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->set_ploidy(ploidy);
     try {
         // First, try to parse data as YAML formatted
@@ -386,8 +389,54 @@ void BasePopulationTree::init_data(
                 genotypes_are_diploid,
                 markers_are_dominant,
                 validate,
-                store_seq_loci_info);
+                store_seq_loci_info,
+                nthreads);
     }
+    this->finish_data_init(
+            constant_sites_removed,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites);
+}
+
+void BasePopulationTree::init_data_from_nexus_stream(
+        std::string path, 
+        char population_name_delimiter,
+        bool population_name_is_prefix,
+        bool genotypes_are_diploid,
+        bool markers_are_dominant,
+        bool constant_sites_removed,
+        bool validate,
+        bool strict_on_constant_sites,
+        bool strict_on_missing_sites,
+        bool strict_on_triallelic_sites,
+        double ploidy) {
+    this->set_ploidy(ploidy);
+    if (genotypes_are_diploid && (ploidy != 2.0)) {
+        throw EcoevolityBiallelicDataError(
+                "Genotypes cannot be diploid if ploidy is not 2",
+                path);
+    }
+    this->data_ = BiallelicData();
+    this->data_.init_from_streamed_nexus(
+            path,
+            population_name_delimiter,
+            population_name_is_prefix,
+            genotypes_are_diploid,
+            markers_are_dominant,
+            validate);
+    this->finish_data_init(
+            constant_sites_removed,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites);
+}
+
+void BasePopulationTree::finish_data_init(
+        bool constant_sites_removed,
+        bool strict_on_constant_sites,
+        bool strict_on_missing_sites,
+        bool strict_on_triallelic_sites) {
     this->constant_sites_removed_ = constant_sites_removed;
 
     this->process_and_vet_initialized_data(
@@ -415,7 +464,8 @@ void BasePopulationTree::init(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         double ploidy,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->init_data(
             path,
             population_name_delimiter,
@@ -428,7 +478,8 @@ void BasePopulationTree::init(
             strict_on_missing_sites,
             strict_on_triallelic_sites,
             ploidy,
-            store_seq_loci_info);
+            store_seq_loci_info,
+            nthreads);
     this->init_tree();
 }
 
@@ -464,7 +515,7 @@ void BasePopulationTree::process_and_vet_initialized_data(
                     << "these sites, please remove all sites with more than two nucleotide\n"
                     << "states from your DNA alignments and re-run the analysis.\n"
                     << "#######################################################################\n";
-            std::cerr << message.str() << std::endl;
+            this->write_warning(message.str());
         }
     }
     if (number_of_missing_patterns_removed > 0) {
@@ -488,7 +539,7 @@ void BasePopulationTree::process_and_vet_initialized_data(
                     << this->data_.get_path() << "\'\n"
                     << "due no data across all populations.\n"
                     << "#######################################################################\n";
-            std::cerr << message.str() << std::endl;
+            this->write_warning(message.str());
         }
     }
     if (this->constant_sites_removed_) {
@@ -526,7 +577,7 @@ void BasePopulationTree::process_and_vet_initialized_data(
                         << "\'constant_sites_removed\' to false for this alignment and re-run this\n"
                         << "analysis.\n"
                         << "#######################################################################\n";
-                std::cerr << message.str() << std::endl;
+                this->write_warning(message.str());
             }
         }
     }
@@ -784,6 +835,19 @@ void BasePopulationTree::set_data(const BiallelicData & data, bool constant_site
     this->likelihood_correction_was_calculated_ = false;
 }
 
+void BasePopulationTree::set_simulated_data(const BiallelicData & data,
+        bool constant_sites_removed) {
+    this->set_data(data, constant_sites_removed);
+    this->data_.remove_missing_patterns();
+    if (this->constant_sites_removed_) {
+        this->data_.remove_constant_patterns();
+    }
+    this->update_unique_allele_counts();
+    if (this->state_frequencies_are_constrained()) {
+        this->fold_patterns();
+    }
+}
+
 void BasePopulationTree::update_unique_allele_counts() {
     this->unique_allele_counts_.clear();
     this->unique_allele_count_weights_.clear();
@@ -844,9 +908,25 @@ double BasePopulationTree::calculate_log_binomial(
 //     return false;
 // }
 
+void BasePopulationTree::write_warning(const std::string& message) {
+    if (this->buffering_warnings_) {
+        this->buffered_warnings_ += message + "\n";
+        return;
+    }
+    std::cerr << message << std::endl;
+}
+
+void BasePopulationTree::flush_warnings(std::ostream& out) {
+    this->buffering_warnings_ = false;
+    if (! this->buffered_warnings_.empty()) {
+        out << this->buffered_warnings_ << std::flush;
+        this->buffered_warnings_.clear();
+    }
+}
+
 void BasePopulationTree::fold_patterns() {
     if (! this->state_frequencies_are_constrained()) {
-        std::cerr << "WARNING: Site patterns are being folded when u/v rates are not constrained." << std::endl;
+        this->write_warning("WARNING: Site patterns are being folded when u/v rates are not constrained.");
     }
     this->data_.fold_patterns();
     this->make_dirty();
@@ -1218,6 +1298,16 @@ void BasePopulationTree::simulate_gene_tree(
     }
 }
 
+void BasePopulationTree::copy_state_for_simulation(
+        const BasePopulationTree & other) {
+    ECOEVOLITY_ASSERT(this->get_leaf_node_count() == other.get_leaf_node_count());
+    this->set_root(other.root_->get_deep_copy());
+    this->freq_1_ = std::make_shared<PositiveRealParameter>(*other.freq_1_);
+    this->mutation_rate_ = std::make_shared<PositiveRealParameter>(*other.mutation_rate_);
+    this->ploidy_ = other.ploidy_;
+    this->constant_sites_removed_ = other.constant_sites_removed_;
+}
+
 std::shared_ptr<GeneTreeSimNode> BasePopulationTree::simulate_gene_tree(
         const unsigned int pattern_index,
         RandomNumberGenerator& rng,
@@ -1270,7 +1360,10 @@ double BasePopulationTree::coalesce_in_branch(
         for (int i = 0; i < 2; ++i) {
             int idx = rng.uniform_int(0, lineages.size() - 1);
             mrca->add_child(lineages.at(idx));
-            lineages.erase(lineages.begin() + idx);
+            // Order of lineages does not matter, so swap rather than shift
+            // the remaining lineages
+            lineages.at(idx) = lineages.back();
+            lineages.pop_back();
         }
         // std::cout << "coalescence!\n";
         lineages.push_back(mrca);
@@ -1280,6 +1373,111 @@ double BasePopulationTree::coalesce_in_branch(
     return current_height;
 }
 
+void BasePopulationTree::simulate_gene_tree(
+        FlatGeneTree & gene_tree,
+        const std::vector< std::shared_ptr<PopulationNode> > & pre_ordered_nodes,
+        const unsigned int pattern_index,
+        RandomNumberGenerator & rng,
+        const bool use_max_allele_counts) const {
+    gene_tree.clear(pre_ordered_nodes.size());
+    const bool markers_are_dominant = this->data_.markers_are_dominant();
+    // In reverse pre-order, every population is visited after all of its
+    // descendants
+    for (auto node_iter = pre_ordered_nodes.rbegin();
+            node_iter != pre_ordered_nodes.rend();
+            ++node_iter) {
+        const PopulationNode & node = **node_iter;
+        std::vector<unsigned int> & lineages = gene_tree.get_branch_lineages(
+                node.get_index());
+        if (node.has_children()) {
+            // Gather the uncoalesced lineages from the children
+            for (unsigned int i = 0; i < node.get_number_of_children(); ++i) {
+                std::vector<unsigned int> & child_lineages = gene_tree.get_branch_lineages(
+                        node.get_child(i)->get_index());
+                lineages.insert(lineages.end(),
+                        child_lineages.begin(),
+                        child_lineages.end());
+                child_lineages.clear();
+            }
+        }
+        else {
+            unsigned int allele_count;
+            if (use_max_allele_counts) {
+                allele_count = this->data_.get_max_allele_count(
+                        node.get_index());
+            }
+            else {
+                allele_count = this->data_.get_allele_count(
+                        pattern_index,
+                        node.get_index());
+            }
+            if (markers_are_dominant) {
+                allele_count *= 2;
+            }
+            for (unsigned int tip_idx = 0; tip_idx < allele_count; ++tip_idx) {
+                lineages.push_back(gene_tree.add_leaf(node.get_index(), 0.0));
+            }
+        }
+        double node_height = this->get_node_height_in_subs_per_site(node);
+        double top_of_branch_height = std::numeric_limits<double>::infinity();
+        if (node.get_number_of_parents() > 0) {
+            top_of_branch_height = node_height +
+                    this->get_node_length_in_subs_per_site(node);
+        }
+        else if (lineages.size() < 2) {
+            continue;
+        }
+        BasePopulationTree::coalesce_in_branch(
+                gene_tree,
+                lineages,
+                this->get_node_theta(node),
+                rng,
+                node_height,
+                top_of_branch_height,
+                node.get_index());
+    }
+    ECOEVOLITY_ASSERT(gene_tree.get_branch_lineages(this->root_->get_index()).size() == 1);
+    gene_tree.compute_binary_transition_probabilities(this->get_u(), this->get_v());
+}
+
+double BasePopulationTree::coalesce_in_branch(
+        FlatGeneTree & gene_tree,
+        std::vector<unsigned int> & lineages,
+        double population_size,
+        RandomNumberGenerator & rng,
+        double bottom_of_branch_height,
+        double top_of_branch_height,
+        unsigned int branch_index
+        ) {
+    if (lineages.size() < 1) {
+        return top_of_branch_height;
+    }
+    ECOEVOLITY_ASSERT(bottom_of_branch_height < top_of_branch_height);
+    double current_height = bottom_of_branch_height;
+    unsigned int k = lineages.size();
+    while (k > 1) {
+        double scale = population_size / (((double)k) * (k - 1.0));
+        double wait = rng.gamma(1.0, scale);
+        if ((current_height + wait) >= top_of_branch_height) {
+            break;
+        }
+        current_height += wait;
+        // Each picked lineage is replaced by the last one still in play
+        unsigned int idx = rng.uniform_int(0, k - 1);
+        unsigned int child1 = lineages[idx];
+        lineages[idx] = lineages[k - 1];
+        idx = rng.uniform_int(0, k - 2);
+        unsigned int child2 = lineages[idx];
+        lineages[idx] = lineages[k - 2];
+        lineages[k - 2] = gene_tree.add_parent(child1, child2,
+                current_height,
+                branch_index);
+        lineages.pop_back();
+        --k;
+    }
+    return current_height;
+}
+
 bool BasePopulationTree::sample_pattern(
         RandomNumberGenerator& rng,
         const float singleton_sample_probability,
@@ -1321,24 +1519,73 @@ BiallelicData BasePopulationTree::simulate_biallelic_data_set(
     )
     BiallelicData sim_data = this->data_.get_empty_copy();
     const bool filtering_constant_sites = this->constant_sites_removed_;
+
+    // Computing the probability of a pattern by pruning costs about as much
+    // as simulating a few dozen gene trees, so the exact pattern
+    // distribution is only used for sample configurations with many more
+    // sites than possible patterns
+    const unsigned long sites_per_pattern_for_exact_sampling = 32;
+    std::map< std::vector<unsigned int>, unsigned long > configuration_site_counts;
+    for (unsigned int pattern_idx = 0;
+            pattern_idx < this->data_.get_number_of_patterns();
+            ++pattern_idx) {
+        configuration_site_counts[this->data_.get_allele_counts(pattern_idx)] +=
+                this->data_.get_pattern_weight(pattern_idx);
+    }
+    std::map< std::vector<unsigned int>, AliasTable > pattern_tables;
+    for (auto const & config_count : configuration_site_counts) {
+        unsigned long number_of_patterns =
+                BasePopulationTree::get_number_of_red_allele_count_patterns(
+                        config_count.first);
+        if ((number_of_patterns > 0) &&
+                (number_of_patterns <= (config_count.second / sites_per_pattern_for_exact_sampling))) {
+            pattern_tables[config_count.first].build(
+                    this->compute_red_allele_count_pattern_probabilities(
+                        config_count.first));
+        }
+    }
+
+    std::vector< std::shared_ptr<PopulationNode> > pre_ordered_nodes;
+    this->root_->pre_order(pre_ordered_nodes);
+    FlatGeneTree gene_tree;
+    std::vector<unsigned int> red_allele_counts;
+    std::vector<unsigned int> allele_counts;
     // Looping over patterns to make sure simulated dataset has exact same
     // sample configuration (i.e., the same pattern of missing data) as the
     // member dataset.
     for (unsigned int pattern_idx = 0;
             pattern_idx < this->data_.get_number_of_patterns();
             ++pattern_idx) {
+        auto table_iter = pattern_tables.find(
+                this->data_.get_allele_counts(pattern_idx));
+        const AliasTable * pattern_table = nullptr;
+        if (table_iter != pattern_tables.end()) {
+            pattern_table = &table_iter->second;
+        }
         for (unsigned int i = 0;
                 i < this->data_.get_pattern_weight(pattern_idx);
                 ++i) {
             bool site_added = false;
             while (! site_added) {
-                auto pattern_tree = this->simulate_biallelic_site(
-                        pattern_idx,
-                        rng,
-                        false);
-                auto pattern = pattern_tree.first;
-                std::vector<unsigned int> red_allele_counts = pattern.first;
-                std::vector<unsigned int> allele_counts = pattern.second;
+                if (pattern_table) {
+                    allele_counts = this->data_.get_allele_counts(pattern_idx);
+                    BasePopulationTree::get_red_allele_count_pattern(
+                            pattern_table->draw(rng),
+                            allele_counts,
+                            red_allele_counts);
+                }
+                else {
+                    this->simulate_gene_tree(gene_tree,
+                            pre_ordered_nodes,
+                            pattern_idx,
+                            rng,
+                            false);
+                    this->simulate_biallelic_site(gene_tree,
+                            rng,
+                            red_allele_counts,
+                            allele_counts);
+                }
+                ECOEVOLITY_ASSERT(allele_counts == this->data_.get_allele_counts(pattern_idx));
                 if (singleton_sample_probability < 1.0) {
                     bool sample_pattern = this->sample_pattern(
                             rng,
@@ -1349,7 +1596,6 @@ BiallelicData BasePopulationTree::simulate_biallelic_data_set(
                         continue;
                     }
                 }
-                std::shared_ptr<GeneTreeSimNode> gtree = pattern_tree.second;
                 site_added = sim_data.add_site(red_allele_counts,
                         allele_counts,
                         filtering_constant_sites,
@@ -1367,6 +1613,79 @@ BiallelicData BasePopulationTree::simulate_biallelic_data_set(
     return sim_data;
 }
 
+unsigned long BasePopulationTree::get_number_of_red_allele_count_patterns(
+        const std::vector<unsigned int> & allele_counts) {
+    // Returns zero if the number of patterns overflows
+    unsigned long number_of_patterns = 1;
+    for (auto n : allele_counts) {
+        if (number_of_patterns > (std::numeric_limits<unsigned long>::max() / (n + 1))) {
+            return 0;
+        }
+        number_of_patterns *= (n + 1);
+    }
+    return number_of_patterns;
+}
+
+void BasePopulationTree::get_red_allele_count_pattern(
+        unsigned int pattern_index,
+        const std::vector<unsigned int> & allele_counts,
+        std::vector<unsigned int> & red_allele_counts) {
+    red_allele_counts.resize(allele_counts.size());
+    for (unsigned int pop_idx = 0; pop_idx < allele_counts.size(); ++pop_idx) {
+        const unsigned int radix = allele_counts[pop_idx] + 1;
+        red_allele_counts[pop_idx] = pattern_index % radix;
+        pattern_index /= radix;
+    }
+    ECOEVOLITY_ASSERT(pattern_index == 0);
+}
+
+std::vector<double>
+BasePopulationTree::compute_red_allele_count_pattern_probabilities(
+        const std::vector<unsigned int> & allele_counts) const {
+    ECOEVOLITY_ASSERT(allele_counts.size() == this->data_.get_number_of_populations());
+    const unsigned long number_of_patterns =
+            BasePopulationTree::get_number_of_red_allele_count_patterns(
+                    allele_counts);
+    if ((number_of_patterns < 1) ||
+            (number_of_patterns > std::numeric_limits<unsigned int>::max())) {
+        throw EcoevolityError(
+                "Too many red allele count patterns to compute their "
+                "probabilities");
+    }
+    // The pruning algorithm stores partials in the nodes, so work on a copy
+    // to leave the tree untouched
+    std::shared_ptr<PopulationNode> root = this->root_->get_deep_copy();
+    const bool markers_are_dominant = this->data_.markers_are_dominant();
+    const double u = this->get_u();
+    const double v = this->get_v();
+    const double mutation_rate = this->get_mutation_rate();
+    const double ploidy = this->get_ploidy();
+    std::vector<double> probabilities;
+    probabilities.reserve(number_of_patterns);
+    std::vector<unsigned int> red_allele_counts(allele_counts.size(), 0);
+    for (unsigned int pattern_idx = 0;
+            pattern_idx < number_of_patterns;
+            ++pattern_idx) {
+        probabilities.push_back(compute_pattern_likelihood(*root,
+                red_allele_counts,
+                allele_counts,
+                u,
+                v,
+                mutation_rate,
+                ploidy,
+                markers_are_dominant));
+        // Increment the mixed-radix red allele counts
+        for (unsigned int pop_idx = 0; pop_idx < allele_counts.size(); ++pop_idx) {
+            if (red_allele_counts[pop_idx] < allele_counts[pop_idx]) {
+                ++red_allele_counts[pop_idx];
+                break;
+            }
+            red_allele_counts[pop_idx] = 0;
+        }
+    }
+    return probabilities;
+}
+
 BiallelicData BasePopulationTree::simulate_linked_biallelic_data_set(
         RandomNumberGenerator& rng,
         float singleton_sample_probability,
@@ -1392,19 +1711,23 @@ BiallelicData BasePopulationTree::simulate_linked_biallelic_data_set(
         sim_data.stop_storing_seq_loci_info();
     }
     const std::vector<unsigned int> & locus_end_indices = this->data_.get_locus_end_indices();
+    std::vector< std::shared_ptr<PopulationNode> > pre_ordered_nodes;
+    this->root_->pre_order(pre_ordered_nodes);
+    FlatGeneTree gene_tree;
+    std::vector<unsigned int> red_allele_counts;
+    std::vector<unsigned int> allele_counts;
     unsigned int site_idx = 0;
     for (unsigned int locus_idx = 0; locus_idx < locus_end_indices.size(); ++locus_idx) {
-        std::shared_ptr<GeneTreeSimNode> gene_tree;
-        gene_tree = this->simulate_gene_tree(0, rng, true);
-        std::pair<std::vector<unsigned int>, std::vector<unsigned int> > pattern;
+        this->simulate_gene_tree(gene_tree, pre_ordered_nodes, 0, rng, true);
         while (site_idx <= locus_end_indices.at(locus_idx)) {
             bool site_added = false;
-            pattern = this->simulate_biallelic_site_sans_missing(
+            this->simulate_biallelic_site_sans_missing(
                     gene_tree,
                     this->data_.get_allele_counts(this->data_.get_pattern_index_for_site(site_idx)),
-                    rng);
-            std::vector<unsigned int> red_allele_counts = pattern.first;
-            std::vector<unsigned int> allele_counts = pattern.second;
+                    rng,
+                    red_allele_counts,
+                    allele_counts,
+                    locus_end_indices.at(locus_idx) - site_idx + 1);
             if (singleton_sample_probability < 1.0) {
                 bool sample_pattern = this->sample_pattern(
                         rng,
@@ -1478,31 +1801,30 @@ BasePopulationTree::simulate_complete_biallelic_data_set(
     if (locus_size < 2) {
         sim_data.stop_storing_seq_loci_info();
     }
-    std::shared_ptr<GeneTreeSimNode> current_gene_tree;
-    auto pattern_tree = this->simulate_biallelic_site(0, rng, true);
-    auto pattern = pattern_tree.first;
-    current_gene_tree = pattern_tree.second;
+    std::vector< std::shared_ptr<PopulationNode> > pre_ordered_nodes;
+    this->root_->pre_order(pre_ordered_nodes);
+    FlatGeneTree gene_tree;
+    std::vector<unsigned int> red_allele_counts;
+    std::vector<unsigned int> allele_counts;
+    this->simulate_gene_tree(gene_tree, pre_ordered_nodes, 0, rng, true);
+    const unsigned int number_of_sites = this->data_.get_number_of_sites();
     unsigned int number_of_loci = 1;
     unsigned int locus_site_count = 0;
     for (unsigned int site_idx = 0;
-            site_idx < this->data_.get_number_of_sites();
+            site_idx < number_of_sites;
             ++site_idx) {
         bool site_added = false;
         while (! site_added) {
-            if (locus_site_count < locus_size) {
-                pattern = this->simulate_biallelic_site(
-                        current_gene_tree,
-                        rng);
-            }
-            else {
-                pattern_tree = this->simulate_biallelic_site(0, rng, true);
-                pattern = pattern_tree.first;
-                current_gene_tree = pattern_tree.second;
+            if (locus_site_count >= locus_size) {
+                this->simulate_gene_tree(gene_tree, pre_ordered_nodes, 0, rng, true);
                 locus_site_count = 0;
                 ++number_of_loci;
             }
-            std::vector<unsigned int> red_allele_counts = pattern.first;
-            std::vector<unsigned int> allele_counts = pattern.second;
+            this->simulate_biallelic_site(gene_tree, rng,
+                    red_allele_counts,
+                    allele_counts,
+                    std::min(locus_size - locus_site_count,
+                            number_of_sites - site_idx));
             if (singleton_sample_probability < 1.0) {
                 bool sample_pattern = this->sample_pattern(
                         rng,
@@ -1516,7 +1838,7 @@ BasePopulationTree::simulate_complete_biallelic_data_set(
             bool end_of_locus = (
                     (
                         (locus_site_count == (locus_size - 1)) ||
-                        (site_idx == (this->data_.get_number_of_sites() - 1))
+                        (site_idx == (number_of_sites - 1))
                     ) &&
                     (locus_size > 1)
                     );
@@ -1554,30 +1876,29 @@ BasePopulationTree::simulate_data_set_max_one_variable_site_per_locus(
     }
     const bool filtering_constant_sites = true;
     sim_data.stop_storing_seq_loci_info();
-    std::shared_ptr<GeneTreeSimNode> current_gene_tree;
-    auto pattern_tree = this->simulate_biallelic_site(0, rng, true);
-    auto pattern = pattern_tree.first;
-    current_gene_tree = pattern_tree.second;
+    std::vector< std::shared_ptr<PopulationNode> > pre_ordered_nodes;
+    this->root_->pre_order(pre_ordered_nodes);
+    FlatGeneTree gene_tree;
+    std::vector<unsigned int> red_allele_counts;
+    std::vector<unsigned int> allele_counts;
+    this->simulate_gene_tree(gene_tree, pre_ordered_nodes, 0, rng, true);
+    const unsigned int number_of_sites = this->data_.get_number_of_sites();
     unsigned int number_of_loci = 1;
     unsigned int locus_site_count = 0;
     bool site_added = false;
     for (unsigned int site_idx = 0;
-            site_idx < this->data_.get_number_of_sites();
+            site_idx < number_of_sites;
             ++site_idx) {
-        if (locus_site_count < locus_size) {
-            pattern = this->simulate_biallelic_site(
-                    current_gene_tree,
-                    rng);
-        }
-        else {
-            pattern_tree = this->simulate_biallelic_site(0, rng, true);
-            pattern = pattern_tree.first;
-            current_gene_tree = pattern_tree.second;
+        if (locus_site_count >= locus_size) {
+            this->simulate_gene_tree(gene_tree, pre_ordered_nodes, 0, rng, true);
             locus_site_count = 0;
             ++number_of_loci;
         }
-        std::vector<unsigned int> red_allele_counts = pattern.first;
-        std::vector<unsigned int> allele_counts = pattern.second;
+        this->simulate_biallelic_site(gene_tree, rng,
+                red_allele_counts,
+                allele_counts,
+                std::min(locus_size - locus_site_count,
+                        number_of_sites - site_idx));
         if (singleton_sample_probability < 1.0) {
             bool sample_pattern = this->sample_pattern(
                     rng,
@@ -1720,6 +2041,72 @@ BasePopulationTree::simulate_biallelic_site_sans_missing(
     return sampled_pattern;
 }
 
+void BasePopulationTree::simulate_biallelic_site(
+        FlatGeneTree & gene_tree,
+        RandomNumberGenerator & rng,
+        std::vector<unsigned int> & red_allele_counts,
+        std::vector<unsigned int> & allele_counts,
+        const unsigned int number_of_linked_sites) const {
+    const unsigned int npops = this->data_.get_number_of_populations();
+    allele_counts.assign(npops, 0);
+    red_allele_counts.assign(npops, 0);
+    if ((number_of_linked_sites > 1) ||
+            (gene_tree.get_number_of_block_sites_remaining() > 0)) {
+        if (gene_tree.get_number_of_block_sites_remaining() < 1) {
+            gene_tree.simulate_binary_character_block(rng,
+                    std::min(number_of_linked_sites, 64u),
+                    this->data_.markers_are_dominant());
+        }
+        gene_tree.get_next_block_site_allele_counts(
+                allele_counts,
+                red_allele_counts);
+        return;
+    }
+    gene_tree.simulate_binary_character(rng);
+    if (this->data_.markers_are_dominant()) {
+        std::vector<int> last_allele(npops, -1);
+        gene_tree.get_allele_counts(
+                allele_counts,
+                red_allele_counts,
+                last_allele);
+    }
+    else {
+        gene_tree.get_allele_counts(
+                allele_counts,
+                red_allele_counts);
+    }
+}
+
+void BasePopulationTree::simulate_biallelic_site_sans_missing(
+        FlatGeneTree & gene_tree,
+        const std::vector<unsigned int> & site_allele_counts,
+        RandomNumberGenerator & rng,
+        std::vector<unsigned int> & red_allele_counts,
+        std::vector<unsigned int> & allele_counts,
+        const unsigned int number_of_linked_sites) const {
+    this->simulate_biallelic_site(gene_tree, rng,
+            red_allele_counts,
+            allele_counts,
+            number_of_linked_sites);
+    ECOEVOLITY_ASSERT(site_allele_counts.size() == allele_counts.size());
+    for (unsigned int pop_idx = 0; pop_idx < allele_counts.size(); ++pop_idx) {
+        if (allele_counts[pop_idx] == site_allele_counts[pop_idx]) {
+            // No gene copies to prune
+            continue;
+        }
+        double prob_pick_red = (double)red_allele_counts[pop_idx] / (double)allele_counts[pop_idx];
+        while (allele_counts[pop_idx] > site_allele_counts[pop_idx]) {
+            double u = rng.uniform_real();
+            if (u < prob_pick_red) {
+                --red_allele_counts[pop_idx];
+            }
+            --allele_counts[pop_idx];
+            prob_pick_red = (double)red_allele_counts[pop_idx] / (double)allele_counts[pop_idx];
+        }
+    }
+    ECOEVOLITY_ASSERT(site_allele_counts == allele_counts);
+}
+
 double BasePopulationTree::compute_log_likelihood(
         const unsigned int nthreads) {
     if (this->ignoring_data()) {
@@ -1933,7 +2320,8 @@ void ComparisonPopulationTree::comparison_init(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         double ploidy,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->init(path,
                population_name_delimiter,
                population_name_is_prefix,
@@ -1945,7 +2333,8 @@ void ComparisonPopulationTree::comparison_init(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                ploidy,
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     if (this->data_.get_number_of_populations() > 2) {
         throw EcoevolityComparisonSettingError(
                 "ComparisonPopulationTree() does not support more than 2 populations",
@@ -1960,6 +2349,21 @@ ComparisonPopulationTree::ComparisonPopulationTree(
         bool strict_on_missing_sites, 
         bool strict_on_triallelic_sites,
         bool store_seq_loci_info) {
+    this->init_comparison_data(settings,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            store_seq_loci_info);
+    this->init_comparison_parameters(settings, rng);
+}
+
+void ComparisonPopulationTree::init_comparison_data(
+        const ComparisonSettings& settings,
+        bool strict_on_constant_sites,
+        bool strict_on_missing_sites,
+        bool strict_on_triallelic_sites,
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->comparison_init(settings.get_path(),
                settings.get_population_name_delimiter(),
                settings.population_name_is_prefix(),
@@ -1971,11 +2375,17 @@ ComparisonPopulationTree::ComparisonPopulationTree(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                settings.get_ploidy(),
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     if (settings.constrain_state_frequencies()) {
         this->constrain_state_frequencies();
         this->fold_patterns();
     }
+}
+
+void ComparisonPopulationTree::init_comparison_parameters(
+        const ComparisonSettings& settings,
+        RandomNumberGenerator& rng) {
     this->set_population_size_prior(
             settings.get_population_size_settings().get_prior_settings().get_instance());
     if (settings.constrain_population_sizes()) {
@@ -2218,7 +2628,8 @@ void ComparisonDirichletPopulationTree::comparison_init(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         double ploidy,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->init(path,
                population_name_delimiter,
                population_name_is_prefix,
@@ -2230,7 +2641,8 @@ void ComparisonDirichletPopulationTree::comparison_init(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                ploidy,
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     if (this->data_.get_number_of_populations() > 2) {
         throw EcoevolityComparisonSettingError(
                 "ComparisonDirichletPopulationTree() does not support more than 2 populations",
@@ -2246,6 +2658,21 @@ ComparisonDirichletPopulationTree::ComparisonDirichletPopulationTree(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         bool store_seq_loci_info) {
+    this->init_comparison_data(settings,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            store_seq_loci_info);
+    this->init_comparison_parameters(settings, rng);
+}
+
+void ComparisonDirichletPopulationTree::init_comparison_data(
+        const DirichletComparisonSettings& settings,
+        bool strict_on_constant_sites,
+        bool strict_on_missing_sites,
+        bool strict_on_triallelic_sites,
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->comparison_init(settings.get_path(),
                settings.get_population_name_delimiter(),
                settings.population_name_is_prefix(),
@@ -2257,11 +2684,17 @@ ComparisonDirichletPopulationTree::ComparisonDirichletPopulationTree(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                settings.get_ploidy(),
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     if (settings.constrain_state_frequencies()) {
         this->constrain_state_frequencies();
         this->fold_patterns();
     }
+}
+
+void ComparisonDirichletPopulationTree::init_comparison_parameters(
+        const DirichletComparisonSettings& settings,
+        RandomNumberGenerator& rng) {
     this->set_population_size_prior(
             settings.get_population_size_settings().get_prior_settings().get_instance());
     PositiveRealParameter p = PositiveRealParameter(
@@ -2598,7 +3031,8 @@ void ComparisonRelativeRootPopulationTree::comparison_init(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         double ploidy,
-        bool store_seq_loci_info) {
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->init(path,
                population_name_delimiter,
                population_name_is_prefix,
@@ -2610,7 +3044,8 @@ void ComparisonRelativeRootPopulationTree::comparison_init(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                ploidy,
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     if (this->data_.get_number_of_populations() > 2) {
         throw EcoevolityComparisonSettingError(
                 "ComparisonRelativeRootPopulationTree() does not support more than 2 populations",
@@ -2626,6 +3061,21 @@ ComparisonRelativeRootPopulationTree::ComparisonRelativeRootPopulationTree(
         bool strict_on_missing_sites,
         bool strict_on_triallelic_sites,
         bool store_seq_loci_info) {
+    this->init_comparison_data(settings,
+            strict_on_constant_sites,
+            strict_on_missing_sites,
+            strict_on_triallelic_sites,
+            store_seq_loci_info);
+    this->init_comparison_parameters(settings, rng);
+}
+
+void ComparisonRelativeRootPopulationTree::init_comparison_data(
+        const RelativeRootComparisonSettings& settings,
+        bool strict_on_constant_sites,
+        bool strict_on_missing_sites,
+        bool strict_on_triallelic_sites,
+        bool store_seq_loci_info,
+        unsigned int nthreads) {
     this->comparison_init(settings.get_path(),
                settings.get_population_name_delimiter(),
                settings.population_name_is_prefix(),
@@ -2637,12 +3087,17 @@ ComparisonRelativeRootPopulationTree::ComparisonRelativeRootPopulationTree(
                strict_on_missing_sites,
                strict_on_triallelic_sites,
                settings.get_ploidy(),
-               store_seq_loci_info);
+               store_seq_loci_info,
+               nthreads);
     if (settings.constrain_state_frequencies()) {
         this->constrain_state_frequencies();
         this->fold_patterns();
     }
+}
 
+void ComparisonRelativeRootPopulationTree::init_comparison_parameters(
+        const RelativeRootComparisonSettings& settings,
+        RandomNumberGenerator& rng) {
     PositiveRealParameter p = PositiveRealParameter(
             settings.get_population_size_settings(),
             rng);
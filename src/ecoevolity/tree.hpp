@@ -22,6 +22,8 @@
 
 #include "basetree.hpp"
 #include "data.hpp"
+#include "flat_gene_tree.hpp"
+#include "alias_table.hpp"
 #include "node.hpp"
 #include "likelihood.hpp"
 #include "parameter.hpp"
@@ -61,7 +63,15 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
         std::vector< std::vector<unsigned int> > unique_allele_counts_;
         std::vector<unsigned int> unique_allele_count_weights_;
 
+        // When buffering, warnings about the data are held until
+        // 'flush_warnings' is called, so that warnings from comparisons
+        // loaded concurrently are reported in order.
+        bool buffering_warnings_ = false;
+        std::string buffered_warnings_;
+
         // methods
+        void write_warning(const std::string& message);
+
         void process_and_vet_initialized_data(
                 bool strict_on_constant_sites = false,
                 bool strict_on_missing_sites = false,
@@ -80,8 +90,14 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
                 bool strict_on_missing_sites = false,
                 bool strict_on_triallelic_sites = true,
                 double ploidy = 2.0,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
+        void finish_data_init(
+                bool constant_sites_removed,
+                bool strict_on_constant_sites,
+                bool strict_on_missing_sites,
+                bool strict_on_triallelic_sites);
 
         // bool constant_site_counts_were_provided();
         void calculate_likelihood_correction();
@@ -138,7 +154,8 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
                 bool strict_on_constant_sites = false,
                 bool strict_on_missing_sites = false,
                 bool strict_on_triallelic_sites = true,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
         BasePopulationTree(
@@ -176,7 +193,8 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
                 bool strict_on_missing_sites = false,
                 bool strict_on_triallelic_sites = true,
                 double ploidy = 2.0,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
         double get_ln_prob_of_drawing_node_state(
@@ -188,6 +206,30 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
 
         void fold_patterns();
 
+        /**
+         * Initialize only the data, by streaming the matrix of a NEXUS file
+         * in blocks of sites (see BiallelicData::init_from_streamed_nexus).
+         * The tree is not initialized; this is for converting and vetting
+         * alignments that are too large to read with NCL.
+         */
+        void init_data_from_nexus_stream(
+                std::string path, 
+                char population_name_delimiter = ' ',
+                bool population_name_is_prefix = true,
+                bool genotypes_are_diploid = true,
+                bool markers_are_dominant = false,
+                bool constant_sites_removed = true,
+                bool validate = true,
+                bool strict_on_constant_sites = false,
+                bool strict_on_missing_sites = false,
+                bool strict_on_triallelic_sites = true,
+                double ploidy = 2.0);
+
+        void buffer_warnings() {
+            this->buffering_warnings_ = true;
+        }
+        void flush_warnings(std::ostream& out = std::cerr);
+
         bool constant_sites_removed() const {
             return this->constant_sites_removed_;
         }
@@ -213,6 +255,19 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
 
         void set_data(const BiallelicData & data, bool constant_sites_removed);
 
+        /**
+         * Replace the data with a data set simulated from this (or an
+         * equivalent) tree.
+         *
+         * The simulated data are processed the same way as data parsed from
+         * an alignment file (missing and, if they are not used, constant
+         * patterns are removed, and patterns are folded if the state
+         * frequencies are constrained), so the tree ends up in the same state
+         * as if the simulated alignment had been written out and analyzed.
+         */
+        void set_simulated_data(const BiallelicData & data,
+                bool constant_sites_removed);
+
         void set_ploidy(double ploidy) {
             this->ploidy_ = ploidy;
         }
@@ -358,6 +413,15 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
             return this->state_frequencies_are_constrained_;
         }
 
+        /**
+         * Copy the tree, population sizes, state frequency and mutation rate
+         * of another tree with the same populations.
+         *
+         * The copied parameters are not shared with 'other', so data can be
+         * simulated from this tree while 'other' goes on to draw new values.
+         */
+        void copy_state_for_simulation(const BasePopulationTree & other);
+
         void simulate_gene_tree(
                 const std::shared_ptr<PopulationNode> node,
                 std::unordered_map<unsigned int, std::vector< std::shared_ptr<GeneTreeSimNode> > > & branch_lineages,
@@ -370,6 +434,22 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
                 RandomNumberGenerator& rng,
                 const bool use_max_allele_counts = false) const;
 
+        /**
+         * Simulate a gene tree into the flat arrays of 'gene_tree', which
+         * are reused rather than reallocated.
+         *
+         * 'pre_ordered_nodes' are the population nodes in pre-order; they
+         * are visited in reverse, so no recursion is needed. The transition
+         * probabilities of the binary character are computed for the new
+         * gene tree.
+         */
+        void simulate_gene_tree(
+                FlatGeneTree & gene_tree,
+                const std::vector< std::shared_ptr<PopulationNode> > & pre_ordered_nodes,
+                const unsigned int pattern_index,
+                RandomNumberGenerator & rng,
+                const bool use_max_allele_counts = false) const;
+
         static double coalesce_in_branch(
                 std::vector< std::shared_ptr<GeneTreeSimNode> >& lineages,
                 double population_size,
@@ -379,17 +459,59 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
                 unsigned int branch_index = 0
                 );
 
+        static double coalesce_in_branch(
+                FlatGeneTree & gene_tree,
+                std::vector<unsigned int> & lineages,
+                double population_size,
+                RandomNumberGenerator & rng,
+                double bottom_of_branch_height = 0.0,
+                double top_of_branch_height = std::numeric_limits<double>::infinity(),
+                unsigned int branch_index = 0
+                );
+
         bool sample_pattern(
                 RandomNumberGenerator& rng,
                 const float singleton_sample_probability,
                 const std::vector<unsigned int>& red_allele_counts,
                 const std::vector<unsigned int>& allele_counts) const;
 
+        /**
+         * Simulate unlinked sites with the same sample configurations
+         * (patterns of missing data) as the tree's data.
+         *
+         * For each sample configuration with many more sites than possible
+         * red allele count patterns, the exact probabilities of the patterns
+         * are computed once by pruning (see
+         * compute_red_allele_count_pattern_probabilities) and the sites are
+         * drawn from them with an alias table. The sites of the other
+         * configurations are simulated along a coalescent gene tree drawn
+         * for each site.
+         */
         BiallelicData simulate_biallelic_data_set(
                 RandomNumberGenerator& rng,
                 float singleton_sample_probability = 1.0,
                 bool validate = true) const;
 
+        /**
+         * Probability of every red allele count pattern for a sample
+         * configuration, under the current state of the tree.
+         *
+         * The patterns are indexed by treating the red allele counts as the
+         * digits of a mixed-radix number; the count of the first population
+         * is the least significant digit, and the radix of population 'i' is
+         * 'allele_counts[i] + 1' (see get_red_allele_count_pattern).
+         */
+        std::vector<double> compute_red_allele_count_pattern_probabilities(
+                const std::vector<unsigned int> & allele_counts) const;
+
+        static void get_red_allele_count_pattern(
+                unsigned int pattern_index,
+                const std::vector<unsigned int> & allele_counts,
+                std::vector<unsigned int> & red_allele_counts);
+
+        static unsigned long get_number_of_red_allele_count_patterns(
+                const std::vector<unsigned int> & allele_counts);
+
         BiallelicData simulate_linked_biallelic_data_set(
                 RandomNumberGenerator& rng,
                 float singleton_sample_probability,
@@ -429,6 +551,31 @@ class BasePopulationTree : public BaseTree<PopulationNode> {
                 const std::vector<unsigned int> & site_allele_counts,
                 RandomNumberGenerator& rng) const;
 
+        /**
+         * Simulate a site on 'gene_tree'.
+         *
+         * 'number_of_linked_sites' is the number of sites (including this
+         * one) that are still expected to be simulated on the same gene
+         * tree. When it is greater than one, the states of up to 64 of these
+         * sites are drawn together as a bit-parallel block, and the
+         * following calls take their sites from the block until it is used
+         * up or a new gene tree is simulated.
+         */
+        void simulate_biallelic_site(
+                FlatGeneTree & gene_tree,
+                RandomNumberGenerator & rng,
+                std::vector<unsigned int> & red_allele_counts,
+                std::vector<unsigned int> & allele_counts,
+                const unsigned int number_of_linked_sites = 1) const;
+
+        void simulate_biallelic_site_sans_missing(
+                FlatGeneTree & gene_tree,
+                const std::vector<unsigned int> & site_allele_counts,
+                RandomNumberGenerator & rng,
+                std::vector<unsigned int> & red_allele_counts,
+                std::vector<unsigned int> & allele_counts,
+                const unsigned int number_of_linked_sites = 1) const;
+
         void write_data_summary(
                 std::ostream& out,
                 unsigned int indent_level = 0) const {
@@ -811,9 +958,31 @@ class ComparisonPopulationTree: public PopulationTree {
                 bool strict_on_missing_sites = false,
                 bool strict_on_triallelic_sites = true,
                 double ploidy = 2.0,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
+        /**
+         * Parse and vet the data of the comparison.
+         *
+         * Together with 'init_comparison_parameters', this does the work of
+         * the constructor that takes settings. None of the parameters are
+         * drawn here (the RNG is not used), so the data of many comparisons
+         * can be loaded concurrently, and the parameters initialized in
+         * order afterward.
+         */
+        void init_comparison_data(
+                const ComparisonSettings& settings,
+                bool strict_on_constant_sites = false,
+                bool strict_on_missing_sites = false,
+                bool strict_on_triallelic_sites = true,
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
+                );
+        void init_comparison_parameters(
+                const ComparisonSettings& settings,
+                RandomNumberGenerator& rng);
+
         void set_child_population_size(unsigned int child_index, double size);
         double get_child_population_size(unsigned int child_index) const;
         std::shared_ptr<PositiveRealParameter> get_child_population_size_parameter(
@@ -879,9 +1048,22 @@ class ComparisonRelativeRootPopulationTree: public RelativeRootPopulationTree {
                 bool strict_on_missing_sites = false,
                 bool strict_on_triallelic_sites = true,
                 double ploidy = 2.0,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
+        void init_comparison_data(
+                const RelativeRootComparisonSettings& settings,
+                bool strict_on_constant_sites = false,
+                bool strict_on_missing_sites = false,
+                bool strict_on_triallelic_sites = true,
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
+                );
+        void init_comparison_parameters(
+                const RelativeRootComparisonSettings& settings,
+                RandomNumberGenerator& rng);
+
         void set_child_population_size(unsigned int child_index, double size);
         double get_child_population_size(unsigned int child_index) const;
         std::shared_ptr<PositiveRealParameter> get_child_population_size_parameter(
@@ -947,9 +1129,22 @@ class ComparisonDirichletPopulationTree: public ComparisonPopulationTree {
                 bool strict_on_missing_sites = false,
                 bool strict_on_triallelic_sites = true,
                 double ploidy = 2.0,
-                bool store_seq_loci_info = false
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
                 );
 
+        void init_comparison_data(
+                const DirichletComparisonSettings& settings,
+                bool strict_on_constant_sites = false,
+                bool strict_on_missing_sites = false,
+                bool strict_on_triallelic_sites = true,
+                bool store_seq_loci_info = false,
+                unsigned int nthreads = 1
+                );
+        void init_comparison_parameters(
+                const DirichletComparisonSettings& settings,
+                RandomNumberGenerator& rng);
+
         bool using_population_size_multipliers() const {
             return true;
         }
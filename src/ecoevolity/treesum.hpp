@@ -23,6 +23,15 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <limits>
+#include <exception>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef BUILD_WITH_THREADS
+#include <mutex>
+#include <future>
+#endif
 
 #include "assert.hpp"
 #include "stats_util.hpp"
@@ -47,6 +56,29 @@ class BaseSamples {
             ++this->n_;
         }
 
+        // Append the tallies of other, whose source indices are offset by
+        // source_index_offset
+        void merge_tallies_(
+                const BaseSamples & other,
+                unsigned int source_index_offset) {
+            this->tree_indices_.insert(this->tree_indices_.end(),
+                    other.tree_indices_.begin(),
+                    other.tree_indices_.end());
+            for (auto source_index : other.source_indices_) {
+                this->source_indices_.push_back(
+                        source_index + source_index_offset);
+            }
+            this->n_ += other.n_;
+        }
+
+        static void append_values_(
+                std::vector<double> & values,
+                const std::vector<double> & other_values) {
+            values.insert(values.end(),
+                    other_values.begin(),
+                    other_values.end());
+        }
+
     public:
         bool operator< (const BaseSamples & other) const {
             return this->n_ < other.n_;
@@ -96,6 +128,16 @@ class NumberOfHeightsSamples : public BaseSamples {
             this->tally_sample_(tree_index, source_index);
         }
 
+        void merge(
+                const NumberOfHeightsSamples & other,
+                unsigned int source_index_offset) {
+            if (this->n_ == 0) {
+                this->number_of_heights_ = other.number_of_heights_;
+            }
+            ECOEVOLITY_ASSERT(other.number_of_heights_ == this->number_of_heights_);
+            this->merge_tallies_(other, source_index_offset);
+        }
+
         unsigned int get_number_of_heights() const {
             return this->number_of_heights_;
         }
@@ -115,31 +157,60 @@ class TopologySamples : public BaseSamples {
                 const std::map< Split, std::set<Split> > & node_map,
                 unsigned int tree_index,
                 unsigned int source_index) { 
-            std::set< std::set<Split> > s_set;
-            for (auto splits_height : height_map) {
-                s_set.insert(splits_height.first);
-                this->heights_[splits_height.first].push_back(
-                        splits_height.second);
-            }
             if (this->n_ == 0) {
-                this->split_set_ = s_set;
+                for (auto & splits_height : height_map) {
+                    this->split_set_.insert(splits_height.first);
+                    this->heights_[splits_height.first].push_back(
+                            splits_height.second);
+                }
                 this->split_to_node_map_ = node_map;
-                for (auto split_node : node_map) {
+                for (auto & split_node : node_map) {
                     this->node_to_split_map_[split_node.second] = split_node.first;
                 }
-                for (auto splt_set : s_set) {
-                    for (auto splt : splt_set) {
+                for (auto & splt_set : this->split_set_) {
+                    for (auto & splt : splt_set) {
                         this->split_to_height_split_set_map_[splt] = splt_set;
                     }
                 }
             }
             else {
-                ECOEVOLITY_ASSERT(s_set == this->split_set_);
+                ECOEVOLITY_ASSERT(height_map.size() == this->heights_.size());
                 ECOEVOLITY_ASSERT(node_map == this->split_to_node_map_);
+                // Same topology, so height_map has the same (ordered) keys as
+                // heights_ and they can be walked together without lookups
+                auto h_iter = this->heights_.begin();
+                for (auto & splits_height : height_map) {
+                    ECOEVOLITY_ASSERT(h_iter->first == splits_height.first);
+                    h_iter->second.push_back(splits_height.second);
+                    ++h_iter;
+                }
             }
             this->tally_sample_(tree_index, source_index);
         }
 
+        void merge(
+                const TopologySamples & other,
+                unsigned int source_index_offset) {
+            if (this->n_ == 0) {
+                this->split_set_ = other.split_set_;
+                this->split_to_node_map_ = other.split_to_node_map_;
+                this->node_to_split_map_ = other.node_to_split_map_;
+                this->split_to_height_split_set_map_ = other.split_to_height_split_set_map_;
+                this->heights_ = other.heights_;
+            }
+            else {
+                ECOEVOLITY_ASSERT(other.split_set_ == this->split_set_);
+                auto h_iter = this->heights_.begin();
+                for (auto & splits_heights : other.heights_) {
+                    ECOEVOLITY_ASSERT(h_iter->first == splits_heights.first);
+                    BaseSamples::append_values_(h_iter->second,
+                            splits_heights.second);
+                    ++h_iter;
+                }
+            }
+            this->merge_tallies_(other, source_index_offset);
+        }
+
         const std::set< std::set<Split> > & get_split_set() const {
             return this->split_set_;
         }
@@ -206,6 +277,14 @@ class HeightSamples : public BaseSamples {
             this->tally_sample_(tree_index, source_index);
         }
 
+        void merge(
+                const HeightSamples & other,
+                unsigned int source_index_offset) {
+            this->set_split_set(other.split_set_);
+            BaseSamples::append_values_(this->heights_, other.heights_);
+            this->merge_tallies_(other, source_index_offset);
+        }
+
         const std::set<Split> & get_split_set() const {
             return this->split_set_;
         }
@@ -245,6 +324,14 @@ class NodeHeightSamples : public BaseSamples {
             this->tally_sample_(tree_index, source_index);
         }
 
+        void merge(
+                const NodeHeightSamples & other,
+                unsigned int source_index_offset) {
+            this->set_node_set(other.node_set_);
+            BaseSamples::append_values_(this->heights_, other.heights_);
+            this->merge_tallies_(other, source_index_offset);
+        }
+
         const std::set< std::set<Split> > & get_node_set() const {
             return this->node_set_;
         }
@@ -280,12 +367,29 @@ class SplitSamples : public BaseSamples {
             else {
                 ECOEVOLITY_ASSERT(s == this->split_);
             }
-            for (auto pname_value : p) {
+            for (auto & pname_value : p) {
                 this->parameters_[pname_value.first].push_back(pname_value.second);
             }
             this->tally_sample_(tree_index, source_index);
         }
 
+        void merge(
+                const SplitSamples & other,
+                unsigned int source_index_offset) {
+            if (this->n_ == 0) {
+                this->split_ = other.split_;
+            }
+            else {
+                ECOEVOLITY_ASSERT(other.split_ == this->split_);
+            }
+            for (auto & pname_values : other.parameters_) {
+                BaseSamples::append_values_(
+                        this->parameters_[pname_values.first],
+                        pname_values.second);
+            }
+            this->merge_tallies_(other, source_index_offset);
+        }
+
         const Split & get_split() const {
             return this->split_;
         }
@@ -319,12 +423,24 @@ class NodeSamples : public BaseSamples {
                 unsigned int source_index) {
             ECOEVOLITY_ASSERT(set_of_splits.size() > 0);
             this->set_split_set(set_of_splits);
-            for (auto pname_value : p) {
+            for (auto & pname_value : p) {
                 this->parameters_[pname_value.first].push_back(pname_value.second);
             }
             this->tally_sample_(tree_index, source_index);
         }
 
+        void merge(
+                const NodeSamples & other,
+                unsigned int source_index_offset) {
+            this->set_split_set(other.split_set_);
+            for (auto & pname_values : other.parameters_) {
+                BaseSamples::append_values_(
+                        this->parameters_[pname_values.first],
+                        pname_values.second);
+            }
+            this->merge_tallies_(other, source_index_offset);
+        }
+
         const std::set<Split> & get_split_set() const {
             return this->split_set_;
         }
@@ -363,6 +479,162 @@ class NodeSamples : public BaseSamples {
         }
 };
 
+/**
+ * Hash map from a split, set of splits, or set of sets of splits to the
+ * samples tallied for it.
+ *
+ * Keys are looked up by their 128-bit SplitHash, so a lookup does not walk
+ * the split bitsets of other keys. The canonical form of each key is stored
+ * with its samples and compared on every hit, so a hash collision is reported
+ * rather than silently merging the tallies of two different keys.
+ */
+template<class KeyType, class SamplesType>
+class SplitKeyedMap {
+    protected:
+        typedef std::pair< KeyType, std::shared_ptr<SamplesType> > entry_type;
+        std::unordered_map<SplitHash, entry_type, SplitHash::Hasher> map_;
+
+        const entry_type * find_entry_(const KeyType & key) const {
+            auto it = this->map_.find(Split::get_hash(key));
+            if (it == this->map_.end()) {
+                return nullptr;
+            }
+            if (it->second.first != key) {
+                throw EcoevolityError(
+                        "SplitKeyedMap: hash collision between different keys");
+            }
+            return &it->second;
+        }
+
+    public:
+        /** Samples of key, or null if key has not been added. */
+        std::shared_ptr<SamplesType> find(const KeyType & key) const {
+            const entry_type * entry = this->find_entry_(key);
+            if (! entry) {
+                return std::shared_ptr<SamplesType>();
+            }
+            return entry->second;
+        }
+
+        void insert(const KeyType & key,
+                std::shared_ptr<SamplesType> samples) {
+            ECOEVOLITY_ASSERT(! this->find_entry_(key));
+            this->map_.emplace(Split::get_hash(key),
+                    entry_type(key, samples));
+        }
+
+        unsigned int count(const KeyType & key) const {
+            return (this->find_entry_(key) ? 1 : 0);
+        }
+
+        const std::shared_ptr<SamplesType> & at(const KeyType & key) const {
+            const entry_type * entry = this->find_entry_(key);
+            if (! entry) {
+                throw std::out_of_range("SplitKeyedMap::at");
+            }
+            return entry->second;
+        }
+
+        std::size_t size() const {
+            return this->map_.size();
+        }
+};
+
+/**
+ * Read the trees of a NEXUS tree file (e.g., a phycoeval tree log) one batch
+ * at a time, without holding all of the tree descriptions in memory.
+ *
+ * The first 'skip' trees are skipped without being parsed. The trees of
+ * each batch are built in parallel (with 'nthreads' threads) and then passed
+ * in file order to 'handler' as 'handler(tree, tree_index)', where
+ * 'tree_index' counts the skipped trees. Returns the number of trees in the
+ * file.
+ */
+template<class TreeType, class TreeHandler>
+inline unsigned int read_nexus_trees(
+        std::istream & tree_stream,
+        const std::string & path,
+        TreeHandler & handler,
+        const unsigned int skip = 0,
+        const double ultrametricity_tolerance = 1e-6,
+        const double multiplier = -1.0,
+        const unsigned int nthreads = 1) {
+    NexusTreeStream nexus_stream(tree_stream, path);
+    unsigned int tree_index = 0;
+    while ((tree_index < skip) && nexus_stream.skip_tree()) {
+        ++tree_index;
+    }
+    const unsigned int batch_size = 64 * std::max(1u, nthreads);
+    std::vector<NewickTree> newick_trees(batch_size);
+    std::vector<TreeType> trees(batch_size);
+    std::vector<std::exception_ptr> errors(batch_size);
+    while (true) {
+        unsigned int ntrees = 0;
+        while ((ntrees < batch_size) &&
+                nexus_stream.next_tree(newick_trees.at(ntrees))) {
+            ++ntrees;
+        }
+        unsigned int next_tree = 0;
+#ifdef BUILD_WITH_THREADS
+        std::mutex tree_mutex;
+#endif
+        auto work = [&]() {
+            unsigned int i;
+            while (true) {
+                {
+#ifdef BUILD_WITH_THREADS
+                    std::lock_guard<std::mutex> tree_lock(tree_mutex);
+#endif
+                    if (next_tree >= ntrees) {
+                        return;
+                    }
+                    i = next_tree++;
+                }
+                try {
+                    trees.at(i) = TreeType(newick_trees.at(i),
+                            ultrametricity_tolerance,
+                            multiplier);
+                }
+                catch (...) {
+                    errors.at(i) = std::current_exception();
+                }
+            }
+        };
+#ifdef BUILD_WITH_THREADS
+        unsigned int number_of_workers = std::max(1u,
+                std::min(nthreads, ntrees));
+        std::vector< std::future<void> > workers;
+        workers.reserve(number_of_workers - 1);
+        for (unsigned int w = 1; w < number_of_workers; ++w) {
+            workers.push_back(std::async(std::launch::async, work));
+        }
+#endif
+        work();
+#ifdef BUILD_WITH_THREADS
+        for (auto & w : workers) {
+            w.get();
+        }
+#endif
+        for (unsigned int i = 0; i < ntrees; ++i) {
+            if (errors.at(i)) {
+                std::cerr << "ERROR: Problem with tree "
+                          << (tree_index + 1) << " ('"
+                          << newick_trees.at(i).get_name() << "')\n";
+                std::rethrow_exception(errors.at(i));
+            }
+            handler(trees.at(i), tree_index);
+            ++tree_index;
+        }
+        if (ntrees < batch_size) {
+            break;
+        }
+    }
+    if (nexus_stream.get_number_of_trees_read() < 1) {
+        throw EcoevolityParsingError("No trees found", path);
+    }
+    return nexus_stream.get_number_of_trees_read();
+}
+
 template<class NodeType>
 class TreeSample {
     public:
@@ -376,11 +648,11 @@ class TreeSample {
         std::vector< std::shared_ptr<NodeSamples> > nodes_;
         std::vector< std::shared_ptr<SplitSamples> > non_trivial_splits_;
         std::vector< std::shared_ptr<NumberOfHeightsSamples> > num_heights_;
-        std::map< std::set< std::set<Split> >, std::shared_ptr<TopologySamples> > topologies_map_;
-        std::map< std::set<Split>,             std::shared_ptr<HeightSamples>   > heights_map_;
-        std::map< std::set< std::set<Split> >, std::shared_ptr<NodeHeightSamples> > node_heights_map_;
-        std::map< Split,                       std::shared_ptr<SplitSamples>    > splits_map_;
-        std::map< std::set<Split>,             std::shared_ptr<NodeSamples>    > nodes_map_;
+        SplitKeyedMap< std::set< std::set<Split> >, TopologySamples > topologies_map_;
+        SplitKeyedMap< std::set<Split>,             HeightSamples     > heights_map_;
+        SplitKeyedMap< std::set< std::set<Split> >, NodeHeightSamples > node_heights_map_;
+        SplitKeyedMap< Split,                       SplitSamples      > splits_map_;
+        SplitKeyedMap< std::set<Split>,             NodeSamples       > nodes_map_;
         std::map< unsigned int,                std::shared_ptr<NumberOfHeightsSamples> > num_heights_map_;
         std::vector<double> tree_lengths_;
         std::vector<std::string> source_paths_;
@@ -687,97 +959,67 @@ class TreeSample {
                 this->num_heights_.push_back(nhs);
                 this->num_heights_map_[nheights] = nhs;
             }
-            if (this->topologies_map_.count(split_set) > 0) {
-                this->topologies_map_[split_set]->add_sample(
-                        heights,
-                        node_map,
-                        tree_index,
-                        source_index);
-            }
-            else {
-                std::shared_ptr<TopologySamples> ts = std::make_shared<TopologySamples>();
-                ts->add_sample(heights, node_map, tree_index, source_index);
+            std::shared_ptr<TopologySamples> ts = this->topologies_map_.find(split_set);
+            if (! ts) {
+                ts = std::make_shared<TopologySamples>();
                 this->topologies_.push_back(ts);
-                this->topologies_map_[split_set] = ts;
+                this->topologies_map_.insert(split_set, ts);
             }
-            for (auto splits_height : heights) {
-                if (this->heights_map_.count(splits_height.first) > 0) {
-                    this->heights_map_[splits_height.first]->add_sample(
-                            splits_height.first,
-                            splits_height.second,
-                            tree_index,
-                            source_index);
-                }
-                else {
-                    std::shared_ptr<HeightSamples> hs = std::make_shared<HeightSamples>();
-                    hs->add_sample(
-                            splits_height.first,
-                            splits_height.second,
-                            tree_index,
-                            source_index);
+            ts->add_sample(heights, node_map, tree_index, source_index);
+            for (auto & splits_height : heights) {
+                std::shared_ptr<HeightSamples> hs = this->heights_map_.find(splits_height.first);
+                if (! hs) {
+                    hs = std::make_shared<HeightSamples>();
                     this->heights_.push_back(hs);
-                    this->heights_map_[splits_height.first] = hs;
+                    this->heights_map_.insert(splits_height.first, hs);
                 }
+                hs->add_sample(
+                        splits_height.first,
+                        splits_height.second,
+                        tree_index,
+                        source_index);
             }
-            for (auto node_height : node_heights) {
-                if (this->node_heights_map_.count(node_height.first) > 0) {
-                    this->node_heights_map_[node_height.first]->add_sample(
-                            node_height.first,
-                            node_height.second,
-                            tree_index,
-                            source_index);
-                }
-                else {
-                    std::shared_ptr<NodeHeightSamples> nhs = std::make_shared<NodeHeightSamples>();
-                    nhs->add_sample(
-                            node_height.first,
-                            node_height.second,
-                            tree_index,
-                            source_index);
+            for (auto & node_height : node_heights) {
+                std::shared_ptr<NodeHeightSamples> nhs = this->node_heights_map_.find(node_height.first);
+                if (! nhs) {
+                    nhs = std::make_shared<NodeHeightSamples>();
                     this->node_heights_.push_back(nhs);
-                    this->node_heights_map_[node_height.first] = nhs;
+                    this->node_heights_map_.insert(node_height.first, nhs);
                 }
+                nhs->add_sample(
+                        node_height.first,
+                        node_height.second,
+                        tree_index,
+                        source_index);
             }
-            for (auto split_pmap : split_parameters) {
-                if (this->splits_map_.count(split_pmap.first) > 0) {
-                    this->splits_map_[split_pmap.first]->add_sample(
-                            split_pmap.first,
-                            split_pmap.second,
-                            tree_index,
-                            source_index);
-                }
-                else {
-                    std::shared_ptr<SplitSamples> ss = std::make_shared<SplitSamples>();
-                    ss->add_sample(
-                            split_pmap.first,
-                            split_pmap.second,
-                            tree_index,
-                            source_index);
+            for (auto & split_pmap : split_parameters) {
+                std::shared_ptr<SplitSamples> ss = this->splits_map_.find(split_pmap.first);
+                if (! ss) {
+                    ss = std::make_shared<SplitSamples>();
                     this->splits_.push_back(ss);
-                    this->splits_map_[split_pmap.first] = ss;
-                    if (this->trivial_splits_.count(ss->get_split()) < 1) {
+                    this->splits_map_.insert(split_pmap.first, ss);
+                    if (this->trivial_splits_.count(split_pmap.first) < 1) {
                         this->non_trivial_splits_.push_back(ss);
                     }
                 }
+                ss->add_sample(
+                        split_pmap.first,
+                        split_pmap.second,
+                        tree_index,
+                        source_index);
             }
-            for (auto split_set_pmap : node_parameters) {
-                if (this->nodes_map_.count(split_set_pmap.first) > 0) {
-                    this->nodes_map_[split_set_pmap.first]->add_sample(
-                            split_set_pmap.first,
-                            split_set_pmap.second,
-                            tree_index,
-                            source_index);
-                }
-                else {
-                    std::shared_ptr<NodeSamples> ns = std::make_shared<NodeSamples>();
-                    ns->add_sample(
-                            split_set_pmap.first,
-                            split_set_pmap.second,
-                            tree_index,
-                            source_index);
+            for (auto & split_set_pmap : node_parameters) {
+                std::shared_ptr<NodeSamples> ns = this->nodes_map_.find(split_set_pmap.first);
+                if (! ns) {
+                    ns = std::make_shared<NodeSamples>();
                     this->nodes_.push_back(ns);
-                    this->nodes_map_[split_set_pmap.first] = ns;
+                    this->nodes_map_.insert(split_set_pmap.first, ns);
                 }
+                ns->add_sample(
+                        split_set_pmap.first,
+                        split_set_pmap.second,
+                        tree_index,
+                        source_index);
             }
             if (this->target_tree_provided_) {
                 this->target_euclidean_distances_.push_back(
@@ -1053,12 +1295,12 @@ class TreeSample {
                 const std::string & ncl_file_format,
                 const unsigned int skip = 0,
                 const double ultrametricity_tolerance = 1e-6,
-                const double multiplier = -1.0) {
-            for (auto path : paths) {
-                this->add_trees(path, ncl_file_format, skip,
-                        ultrametricity_tolerance,
-                        multiplier);
-            }
+                const double multiplier = -1.0,
+                const unsigned int nthreads = 1) {
+            this->add_trees(paths, ncl_file_format, skip,
+                    ultrametricity_tolerance,
+                    multiplier,
+                    nthreads);
         }
         TreeSample(
                 const std::string & target_tree_path,
@@ -1067,12 +1309,46 @@ class TreeSample {
                 const std::string & ncl_file_format,
                 const unsigned int skip = 0,
                 const double ultrametricity_tolerance = 1e-6,
-                const double multiplier = -1.0) {
+                const double multiplier = -1.0,
+                const unsigned int nthreads = 1) {
             this->set_target_tree(target_tree_path, target_ncl_file_format);
-            for (auto path : paths) {
+            this->add_trees(paths, ncl_file_format, skip,
+                    ultrametricity_tolerance,
+                    multiplier,
+                    nthreads);
+        }
+
+        /**
+         * Add the trees of each file in 'paths' as a separate source.
+         *
+         * With more than one thread and more than one file, each file is
+         * tallied into its own TreeSample shard (with files spread across
+         * the threads), and the shards are then merged in the order of
+         * 'paths'. Each merge appends to the tallies just as adding the file
+         * serially would, so the result (and any summary written from it) is
+         * identical to calling add_trees for each path in turn.
+         */
+        void add_trees(
+                const std::vector<std::string> & paths,
+                const std::string & ncl_file_format,
+                const unsigned int skip = 0,
+                const double ultrametricity_tolerance = 1e-6,
+                const double multiplier = -1.0,
+                const unsigned int nthreads = 1) {
+#ifdef BUILD_WITH_THREADS
+            if ((nthreads > 1) && (paths.size() > 1)) {
+                this->add_tree_file_shards_(paths, ncl_file_format, skip,
+                        ultrametricity_tolerance,
+                        multiplier,
+                        nthreads);
+                return;
+            }
+#endif
+            for (auto & path : paths) {
                 this->add_trees(path, ncl_file_format, skip,
                         ultrametricity_tolerance,
-                        multiplier);
+                        multiplier,
+                        nthreads);
             }
         }
 
@@ -1081,21 +1357,16 @@ class TreeSample {
                 const std::string & ncl_file_format,
                 const unsigned int skip = 0,
                 const double ultrametricity_tolerance = 1e-6,
-                const double multiplier = -1.0) {
-            this->source_paths_.push_back(path);
-            std::ifstream in_stream;
-            in_stream.open(path);
-            if (! in_stream.is_open()) {
-                throw EcoevolityParsingError(
-                        "Could not open tree file",
-                        path);
-            }
+                const double multiplier = -1.0,
+                const unsigned int nthreads = 1) {
             try {
-                this->add_trees(in_stream,
+                this->tally_tree_file_(path,
                         ncl_file_format,
                         skip,
                         ultrametricity_tolerance,
-                        multiplier);
+                        multiplier,
+                        nthreads);
+                this->finish_source_();
             }
             catch(...) {
                 std::cerr << "ERROR: Problem parsing tree file path: "
@@ -1104,16 +1375,309 @@ class TreeSample {
             }
         }
 
+        /**
+         * Add the trees of a stream. NEXUS trees (ncl_file_format "nexus")
+         * are read one batch at a time by read_nexus_trees (building the
+         * trees of each batch with 'nthreads' threads); other formats are
+         * read by NCL.
+         */
         void add_trees(
                 std::istream & tree_stream,
                 const std::string & ncl_file_format,
                 const unsigned int skip = 0,
                 const double ultrametricity_tolerance = 1e-6,
-                const double multiplier = -1.0) {
+                const double multiplier = -1.0,
+                const unsigned int nthreads = 1) {
+            this->add_trees_(tree_stream,
+                    "",
+                    ncl_file_format,
+                    skip,
+                    ultrametricity_tolerance,
+                    multiplier,
+                    nthreads);
+        }
+
+    protected:
+        void add_trees_(
+                std::istream & tree_stream,
+                const std::string & path,
+                const std::string & ncl_file_format,
+                const unsigned int skip,
+                const double ultrametricity_tolerance,
+                const double multiplier,
+                const unsigned int nthreads) {
+            this->tally_trees_(tree_stream,
+                    path,
+                    ncl_file_format,
+                    skip,
+                    ultrametricity_tolerance,
+                    multiplier,
+                    nthreads);
+            this->finish_source_();
+        }
+
+        void tally_tree_file_(
+                const std::string & path,
+                const std::string & ncl_file_format,
+                const unsigned int skip,
+                const double ultrametricity_tolerance,
+                const double multiplier,
+                const unsigned int nthreads) {
+            this->source_paths_.push_back(path);
+            std::ifstream in_stream;
+            in_stream.open(path);
+            if (! in_stream.is_open()) {
+                throw EcoevolityParsingError(
+                        "Could not open tree file",
+                        path);
+            }
+            this->tally_trees_(in_stream,
+                    path,
+                    ncl_file_format,
+                    skip,
+                    ultrametricity_tolerance,
+                    multiplier,
+                    nthreads);
+        }
+
+        // Tally the trees of a stream as a new source, without the sorting
+        // done by finish_source_, so the samples stay in the order they were
+        // first seen (which merge_shard_ relies on)
+        void tally_trees_(
+                std::istream & tree_stream,
+                const std::string & path,
+                const std::string & ncl_file_format,
+                const unsigned int skip,
+                const double ultrametricity_tolerance,
+                const double multiplier,
+                const unsigned int nthreads) {
             this->source_num_skipped_.push_back(skip);
             unsigned int source_index = this->source_sample_sizes_.size();
             this->source_sample_sizes_.push_back(0);
 
+            if (ncl_file_format == "nexus") {
+                auto add_tree = [this, source_index](const tree_type & t,
+                        unsigned int tree_index) {
+                    this->_add_tree(t, tree_index, source_index);
+                };
+                read_nexus_trees<tree_type>(tree_stream,
+                        path,
+                        add_tree,
+                        skip,
+                        ultrametricity_tolerance,
+                        multiplier,
+                        nthreads);
+            }
+            else {
+                this->add_ncl_trees_(tree_stream,
+                        ncl_file_format,
+                        skip,
+                        ultrametricity_tolerance,
+                        multiplier,
+                        source_index);
+            }
+        }
+
+        void finish_source_() {
+            unsigned int source_total = 0;
+            for (unsigned int n : this->source_sample_sizes_) {
+                source_total += n;
+            }
+            ECOEVOLITY_ASSERT(source_total == this->sample_size_);
+            this->reverse_sort_samples_by_freq_();
+            this->update_constrained_node_parameters_();
+        }
+
+        // Start a shard that tallies trees for this sample: it shares the
+        // tip labels (if known) and target tree, but none of the samples
+        void init_shard_(const TreeSample & parent) {
+            this->leaf_labels_ = parent.leaf_labels_;
+            this->leaf_splits_ = parent.leaf_splits_;
+            this->trivial_splits_ = parent.trivial_splits_;
+            this->root_split_ = parent.root_split_;
+            this->target_tree_provided_ = parent.target_tree_provided_;
+            if (parent.target_tree_provided_) {
+                this->target_tree_ = parent.target_tree_;
+            }
+        }
+
+        template<class KeyType, class SamplesType>
+        static void merge_samples_(
+                const std::vector< std::shared_ptr<SamplesType> > & shard_samples,
+                const KeyType & (SamplesType::*get_key)() const,
+                SplitKeyedMap<KeyType, SamplesType> & samples_map,
+                std::vector< std::shared_ptr<SamplesType> > & samples,
+                const unsigned int source_index_offset,
+                std::vector< std::shared_ptr<SamplesType> > * new_samples = nullptr) {
+            for (auto & shard_sample : shard_samples) {
+                const KeyType & key = ((*shard_sample).*get_key)();
+                std::shared_ptr<SamplesType> sample = samples_map.find(key);
+                if (! sample) {
+                    sample = std::make_shared<SamplesType>();
+                    samples.push_back(sample);
+                    samples_map.insert(key, sample);
+                    if (new_samples) {
+                        new_samples->push_back(sample);
+                    }
+                }
+                sample->merge(*shard_sample, source_index_offset);
+            }
+        }
+
+        // Append the single source tallied by 'shard' (which has not been
+        // sorted by finish_source_). Samples new to this sample are added in
+        // the order the shard first saw them, which is the order tallying
+        // the source here would have added them.
+        void merge_shard_(const TreeSample & shard) {
+            ECOEVOLITY_ASSERT(shard.source_sample_sizes_.size() == 1);
+            if (shard.sample_size_ > 0) {
+                if (this->leaf_labels_.size() < 1) {
+                    this->leaf_labels_ = shard.leaf_labels_;
+                    this->leaf_splits_ = shard.leaf_splits_;
+                    this->trivial_splits_ = shard.trivial_splits_;
+                    this->root_split_ = shard.root_split_;
+                }
+                else if (shard.leaf_labels_ != this->leaf_labels_) {
+                    throw EcoevolityError("Tip labels in trees do not match");
+                }
+            }
+            const unsigned int source_index_offset = this->source_sample_sizes_.size();
+
+            for (auto & shard_nhs : shard.num_heights_) {
+                unsigned int nheights = shard_nhs->get_number_of_heights();
+                if (this->num_heights_map_.count(nheights) < 1) {
+                    std::shared_ptr<NumberOfHeightsSamples> nhs = std::make_shared<NumberOfHeightsSamples>();
+                    this->num_heights_.push_back(nhs);
+                    this->num_heights_map_[nheights] = nhs;
+                }
+                this->num_heights_map_[nheights]->merge(*shard_nhs,
+                        source_index_offset);
+            }
+            merge_samples_(shard.topologies_,
+                    &TopologySamples::get_split_set,
+                    this->topologies_map_,
+                    this->topologies_,
+                    source_index_offset);
+            merge_samples_(shard.heights_,
+                    &HeightSamples::get_split_set,
+                    this->heights_map_,
+                    this->heights_,
+                    source_index_offset);
+            merge_samples_(shard.node_heights_,
+                    &NodeHeightSamples::get_node_set,
+                    this->node_heights_map_,
+                    this->node_heights_,
+                    source_index_offset);
+            std::vector< std::shared_ptr<SplitSamples> > new_splits;
+            merge_samples_(shard.splits_,
+                    &SplitSamples::get_split,
+                    this->splits_map_,
+                    this->splits_,
+                    source_index_offset,
+                    &new_splits);
+            for (auto & ss : new_splits) {
+                if (this->trivial_splits_.count(ss->get_split()) < 1) {
+                    this->non_trivial_splits_.push_back(ss);
+                }
+            }
+            merge_samples_(shard.nodes_,
+                    &NodeSamples::get_split_set,
+                    this->nodes_map_,
+                    this->nodes_,
+                    source_index_offset);
+
+            this->tree_lengths_.insert(this->tree_lengths_.end(),
+                    shard.tree_lengths_.begin(),
+                    shard.tree_lengths_.end());
+            this->target_euclidean_distances_.insert(
+                    this->target_euclidean_distances_.end(),
+                    shard.target_euclidean_distances_.begin(),
+                    shard.target_euclidean_distances_.end());
+            this->source_paths_.insert(this->source_paths_.end(),
+                    shard.source_paths_.begin(),
+                    shard.source_paths_.end());
+            this->source_sample_sizes_.push_back(shard.source_sample_sizes_.at(0));
+            this->source_num_skipped_.push_back(shard.source_num_skipped_.at(0));
+            this->sample_size_ += shard.sample_size_;
+        }
+
+#ifdef BUILD_WITH_THREADS
+        void add_tree_file_shards_(
+                const std::vector<std::string> & paths,
+                const std::string & ncl_file_format,
+                const unsigned int skip,
+                const double ultrametricity_tolerance,
+                const double multiplier,
+                const unsigned int nthreads) {
+            const unsigned int nsources = paths.size();
+            const unsigned int number_of_workers = std::min(nthreads, nsources);
+            // Threads left over are used to build the trees of each file
+            const unsigned int nthreads_per_source = std::max(1u,
+                    nthreads / number_of_workers);
+            std::vector< std::unique_ptr<TreeSample> > shards(nsources);
+            std::vector<std::exception_ptr> errors(nsources);
+            unsigned int next_source = 0;
+            std::mutex source_mutex;
+            auto work = [&]() {
+                unsigned int i;
+                while (true) {
+                    {
+                        std::lock_guard<std::mutex> source_lock(source_mutex);
+                        if (next_source >= nsources) {
+                            return;
+                        }
+                        i = next_source++;
+                    }
+                    try {
+                        std::unique_ptr<TreeSample> shard(new TreeSample());
+                        shard->init_shard_(*this);
+                        shard->tally_tree_file_(paths.at(i),
+                                ncl_file_format,
+                                skip,
+                                ultrametricity_tolerance,
+                                multiplier,
+                                nthreads_per_source);
+                        shards.at(i) = std::move(shard);
+                    }
+                    catch (...) {
+                        errors.at(i) = std::current_exception();
+                    }
+                }
+            };
+            std::vector< std::future<void> > workers;
+            workers.reserve(number_of_workers - 1);
+            for (unsigned int w = 1; w < number_of_workers; ++w) {
+                workers.push_back(std::async(std::launch::async, work));
+            }
+            work();
+            for (auto & w : workers) {
+                w.get();
+            }
+            for (unsigned int i = 0; i < nsources; ++i) {
+                try {
+                    if (errors.at(i)) {
+                        std::rethrow_exception(errors.at(i));
+                    }
+                    this->merge_shard_(*shards.at(i));
+                    shards.at(i).reset();
+                    this->finish_source_();
+                }
+                catch(...) {
+                    std::cerr << "ERROR: Problem parsing tree file path: "
+                            << paths.at(i) << "\n";
+                    throw;
+                }
+            }
+        }
+#endif
+
+        void add_ncl_trees_(
+                std::istream & tree_stream,
+                const std::string & ncl_file_format,
+                const unsigned int skip,
+                const double ultrametricity_tolerance,
+                const double multiplier,
+                const unsigned int source_index) {
             MultiFormatReader nexus_reader(-1, NxsReader::WARNINGS_TO_STDERR);
             try {
                 nexus_reader.ReadStream(tree_stream, ncl_file_format.c_str());
@@ -1142,16 +1706,10 @@ class TreeSample {
                 this->_add_tree(t, i, source_index);
             }
             nexus_reader.DeleteBlocksFromFactories();
-
-            unsigned int source_total = 0;
-            for (unsigned int n : this->source_sample_sizes_) {
-                source_total += n;
-            }
-            ECOEVOLITY_ASSERT(source_total == this->sample_size_);
-            this->reverse_sort_samples_by_freq_();
-            this->update_constrained_node_parameters_();
         }
 
+    public:
+
         void set_target_tree(
                 std::istream & tree_stream,
                 const std::string & ncl_file_format) {
@@ -2375,6 +2933,394 @@ class TreeSample {
         }
 };
 
+/**
+ * Convergence statistics of a sample of trees across a range of burn-in
+ * values.
+ *
+ * Every tree is parsed once and reduced to its non-trivial splits (stored
+ * as indices into a table of the distinct splits), its length, and the
+ * height and population size of its root. The statistics for successive
+ * burn-in values are then computed from these compact samples, from the
+ * largest burn-in down, so split counts and per-chain moments are only
+ * ever added to as the window grows. The ESS is based on batch means whose
+ * batches shift with the burn-in, so it is recomputed from the stored
+ * values of each window.
+ */
+template<class NodeType>
+class ConvergenceTable {
+    public:
+        typedef BaseTree<NodeType> tree_type;
+
+        struct Row {
+            unsigned int burnin;
+            unsigned int sample_size;
+            double asdsf;
+            double psrf_tree_length;
+            double psrf_root_height;
+            double psrf_root_pop_size;
+            double ess_tree_length;
+            double ess_root_height;
+            double ess_root_pop_size;
+        };
+
+    protected:
+        struct Source {
+            std::vector<double> tree_lengths;
+            std::vector<double> root_heights;
+            std::vector<double> root_pop_sizes;
+            // The splits of tree i are split_indices[split_offsets[i]] to
+            // split_indices[split_offsets[i + 1] - 1]
+            std::vector<unsigned int> split_offsets {0};
+            std::vector<unsigned int> split_indices;
+
+            unsigned int size() const {
+                return this->tree_lengths.size();
+            }
+        };
+
+        std::vector<Source> sources_;
+        std::map<Split, unsigned int> split_index_map_;
+        std::vector<std::string> leaf_labels_;
+
+        void add_tree_(const tree_type & tree, Source & source) {
+            if (this->leaf_labels_.empty()) {
+                this->leaf_labels_ = tree.get_leaf_labels();
+                std::sort(std::begin(this->leaf_labels_),
+                        std::end(this->leaf_labels_));
+            }
+            else {
+                std::vector<std::string> l = tree.get_leaf_labels();
+                if ((l.size() != this->leaf_labels_.size()) ||
+                        (! std::is_permutation(std::begin(l), std::end(l),
+                                               std::begin(this->leaf_labels_)))) {
+                    throw EcoevolityError("Tip labels in trees do not match");
+                }
+            }
+            std::map<std::string, double> root_parameters;
+            tree.get_root_ptr()->get_parameter_map(root_parameters);
+            if ((root_parameters.count("height") < 1) ||
+                    (root_parameters.count("pop_size") < 1)) {
+                throw EcoevolityError(
+                        "Trees are missing the height or pop_size of the root");
+            }
+            std::map< int, std::set<Split> > split_map =
+                    tree.get_splits_by_height_index(false, false, false);
+            for (auto const & height_splits : split_map) {
+                for (auto const & split : height_splits.second) {
+                    auto s = this->split_index_map_.find(split);
+                    if (s == this->split_index_map_.end()) {
+                        s = this->split_index_map_.insert(std::make_pair(split,
+                                (unsigned int)this->split_index_map_.size())).first;
+                    }
+                    source.split_indices.push_back(s->second);
+                }
+            }
+            source.split_offsets.push_back(source.split_indices.size());
+            source.tree_lengths.push_back(tree.get_tree_length());
+            source.root_heights.push_back(root_parameters.at("height"));
+            source.root_pop_sizes.push_back(root_parameters.at("pop_size"));
+        }
+
+        static std::vector<double> get_window_(
+                const std::vector<Source> & sources,
+                std::vector<double> Source::* values,
+                unsigned int burnin) {
+            std::vector<double> window;
+            for (auto const & source : sources) {
+                window.insert(window.end(),
+                        (source.*values).begin() + burnin,
+                        (source.*values).end());
+            }
+            return window;
+        }
+
+    public:
+        ConvergenceTable() { }
+        ConvergenceTable(
+                const std::vector<std::string> & paths,
+                const std::string & ncl_file_format,
+                const double ultrametricity_tolerance = 1e-6,
+                const unsigned int nthreads = 1) {
+            for (auto path : paths) {
+                this->add_trees(path, ncl_file_format,
+                        ultrametricity_tolerance,
+                        nthreads);
+            }
+        }
+
+        void add_trees(
+                const std::string & path,
+                const std::string & ncl_file_format,
+                const double ultrametricity_tolerance = 1e-6,
+                const unsigned int nthreads = 1) {
+            std::ifstream in_stream;
+            in_stream.open(path);
+            if (! in_stream.is_open()) {
+                throw EcoevolityParsingError(
+                        "Could not open tree file",
+                        path);
+            }
+            try {
+                this->add_trees_(in_stream,
+                        path,
+                        ncl_file_format,
+                        ultrametricity_tolerance,
+                        nthreads);
+            }
+            catch(...) {
+                std::cerr << "ERROR: Problem parsing tree file path: "
+                        << path << "\n";
+                throw;
+            }
+        }
+
+        void add_trees(
+                std::istream & tree_stream,
+                const std::string & ncl_file_format,
+                const double ultrametricity_tolerance = 1e-6,
+                const unsigned int nthreads = 1) {
+            this->add_trees_(tree_stream,
+                    "",
+                    ncl_file_format,
+                    ultrametricity_tolerance,
+                    nthreads);
+        }
+
+    protected:
+        void add_trees_(
+                std::istream & tree_stream,
+                const std::string & path,
+                const std::string & ncl_file_format,
+                const double ultrametricity_tolerance,
+                const unsigned int nthreads) {
+            Source source;
+            if (ncl_file_format == "nexus") {
+                auto add_tree = [this, &source](const tree_type & t,
+                        unsigned int) {
+                    this->add_tree_(t, source);
+                };
+                read_nexus_trees<tree_type>(tree_stream,
+                        path,
+                        add_tree,
+                        0,
+                        ultrametricity_tolerance,
+                        -1.0,
+                        nthreads);
+                this->sources_.push_back(std::move(source));
+                return;
+            }
+
+            MultiFormatReader nexus_reader(-1, NxsReader::WARNINGS_TO_STDERR);
+            try {
+                nexus_reader.ReadStream(tree_stream, ncl_file_format.c_str());
+            }
+            catch(...) {
+                nexus_reader.DeleteBlocksFromFactories();
+                throw;
+            }
+            unsigned int num_taxa_blocks = nexus_reader.GetNumTaxaBlocks();
+            ECOEVOLITY_ASSERT(num_taxa_blocks == 1);
+            NxsTaxaBlock * taxa_block = nexus_reader.GetTaxaBlock(0);
+
+            unsigned int num_tree_blocks = nexus_reader.GetNumTreesBlocks(taxa_block);
+            ECOEVOLITY_ASSERT(num_tree_blocks == 1);
+
+            NxsTreesBlock * tree_block = nexus_reader.GetTreesBlock(taxa_block, 0);
+            unsigned int num_trees = tree_block->GetNumTrees();
+            ECOEVOLITY_ASSERT(num_trees > 0);
+
+            source.tree_lengths.reserve(num_trees);
+            source.root_heights.reserve(num_trees);
+            source.root_pop_sizes.reserve(num_trees);
+            source.split_offsets.reserve(num_trees + 1);
+            try {
+                for (unsigned int i = 0; i < num_trees; ++i) {
+                    const NxsFullTreeDescription & tree_description = tree_block->GetFullTreeDescription(i);
+                    tree_type t(tree_description,
+                            taxa_block,
+                            ultrametricity_tolerance);
+                    this->add_tree_(t, source);
+                }
+            }
+            catch(...) {
+                nexus_reader.DeleteBlocksFromFactories();
+                throw;
+            }
+            nexus_reader.DeleteBlocksFromFactories();
+            this->sources_.push_back(std::move(source));
+        }
+
+    public:
+
+        unsigned int get_number_of_sources() const {
+            return this->sources_.size();
+        }
+
+        unsigned int get_source_sample_size(unsigned int source_index) const {
+            return this->sources_.at(source_index).size();
+        }
+
+        unsigned int get_number_of_splits() const {
+            return this->split_index_map_.size();
+        }
+
+        /**
+         * Whether the inter-chain statistics (ASDSF and PSRF) are reported,
+         * which requires multiple sources with equal numbers of trees.
+         */
+        bool has_inter_chain_stats() const {
+            if (this->sources_.size() < 2) {
+                return false;
+            }
+            for (auto const & source : this->sources_) {
+                if (source.size() != this->sources_.at(0).size()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Statistics for burn-in values first_burnin, first_burnin +
+         * interval, ..., for as long as the burn-in is at least 2 trees
+         * short of the smallest number of trees remaining in any source
+         * after the first burn-in.
+         */
+        std::vector<Row> get_rows(
+                const unsigned int interval,
+                const double min_split_freq = 0.1,
+                const unsigned int first_burnin = 1) const {
+            if (interval < 1) {
+                throw EcoevolityError("Burn-in interval must be positive");
+            }
+            if (this->sources_.empty()) {
+                throw EcoevolityError("No trees to summarize");
+            }
+            unsigned int min_sample_size = std::numeric_limits<unsigned int>::max();
+            for (auto const & source : this->sources_) {
+                if (source.size() <= first_burnin) {
+                    throw EcoevolityError(
+                            "No trees remain in a source after the burn in");
+                }
+                min_sample_size = std::min(min_sample_size,
+                        source.size() - first_burnin);
+            }
+            std::vector<unsigned int> burnins = {first_burnin};
+            while ((burnins.back() + interval + 1) < min_sample_size) {
+                burnins.push_back(burnins.back() + interval);
+            }
+
+            const bool inter_chain = this->has_inter_chain_stats();
+            const unsigned int nsources = this->sources_.size();
+            const unsigned int nsplits = this->split_index_map_.size();
+            std::vector<unsigned int> split_counts(nsplits, 0);
+            std::vector<unsigned int> source_split_counts(nsplits * nsources, 0);
+            std::vector< SampleSummarizer<double> > tree_length_summaries(nsources);
+            std::vector< SampleSummarizer<double> > root_height_summaries(nsources);
+            std::vector< SampleSummarizer<double> > root_pop_size_summaries(nsources);
+            std::vector<unsigned int> next_tree(nsources);
+            for (unsigned int s = 0; s < nsources; ++s) {
+                next_tree.at(s) = this->sources_.at(s).size();
+            }
+
+            std::vector<Row> rows(burnins.size());
+            for (int row_idx = burnins.size() - 1; row_idx >= 0; --row_idx) {
+                const unsigned int burnin = burnins.at(row_idx);
+                unsigned int sample_size = 0;
+                for (unsigned int s = 0; s < nsources; ++s) {
+                    const Source & source = this->sources_.at(s);
+                    while (next_tree.at(s) > burnin) {
+                        const unsigned int t = --next_tree.at(s);
+                        for (unsigned int i = source.split_offsets.at(t);
+                                i < source.split_offsets.at(t + 1);
+                                ++i) {
+                            ++split_counts.at(source.split_indices.at(i));
+                            ++source_split_counts.at(
+                                    (source.split_indices.at(i) * nsources) + s);
+                        }
+                        tree_length_summaries.at(s).add_sample(source.tree_lengths.at(t));
+                        root_height_summaries.at(s).add_sample(source.root_heights.at(t));
+                        root_pop_size_summaries.at(s).add_sample(source.root_pop_sizes.at(t));
+                    }
+                    sample_size += source.size() - burnin;
+                }
+
+                Row & row = rows.at(row_idx);
+                row.burnin = burnin;
+                row.sample_size = sample_size;
+                row.asdsf = std::numeric_limits<double>::quiet_NaN();
+                row.psrf_tree_length = std::numeric_limits<double>::quiet_NaN();
+                row.psrf_root_height = std::numeric_limits<double>::quiet_NaN();
+                row.psrf_root_pop_size = std::numeric_limits<double>::quiet_NaN();
+                if (inter_chain) {
+                    SampleSummarizer<double> std_devs_of_split_freqs;
+                    for (unsigned int split_idx = 0; split_idx < nsplits; ++split_idx) {
+                        const unsigned int count = split_counts.at(split_idx);
+                        if ((count < 1) ||
+                                ((count / (double)sample_size) < min_split_freq)) {
+                            continue;
+                        }
+                        SampleSummarizer<double> split_freqs;
+                        for (unsigned int s = 0; s < nsources; ++s) {
+                            split_freqs.add_sample(
+                                    source_split_counts.at((split_idx * nsources) + s) /
+                                    (double)(this->sources_.at(s).size() - burnin));
+                        }
+                        std_devs_of_split_freqs.add_sample(split_freqs.std_dev());
+                    }
+                    row.asdsf = std_devs_of_split_freqs.mean();
+                    row.psrf_tree_length = potential_scale_reduction_factor(
+                            tree_length_summaries);
+                    row.psrf_root_height = potential_scale_reduction_factor(
+                            root_height_summaries);
+                    row.psrf_root_pop_size = potential_scale_reduction_factor(
+                            root_pop_size_summaries);
+                }
+                row.ess_tree_length = effective_sample_size<double>(
+                        get_window_(this->sources_, &Source::tree_lengths, burnin),
+                        true);
+                row.ess_root_height = effective_sample_size<double>(
+                        get_window_(this->sources_, &Source::root_heights, burnin),
+                        true);
+                row.ess_root_pop_size = effective_sample_size<double>(
+                        get_window_(this->sources_, &Source::root_pop_sizes, burnin),
+                        true);
+            }
+            return rows;
+        }
+
+        /**
+         * Write a tab-delimited table of the rows returned by get_rows.
+         */
+        void write(std::ostream & out,
+                const unsigned int interval,
+                const double min_split_freq = 0.1,
+                const unsigned int first_burnin = 1) const {
+            const bool inter_chain = this->has_inter_chain_stats();
+            std::vector<Row> rows = this->get_rows(interval, min_split_freq,
+                    first_burnin);
+            out << "burnin\tsample_size";
+            if (inter_chain) {
+                out << "\tasdsf\tpsrf_tree_length\tpsrf_root_height\tpsrf_root_pop_size";
+            }
+            out << "\tess_tree_length\tess_root_height\tess_root_pop_size\n";
+            for (auto const & row : rows) {
+                out << row.burnin
+                    << "\t" << row.sample_size;
+                if (inter_chain) {
+                    out << "\t" << row.asdsf
+                        << "\t" << row.psrf_tree_length
+                        << "\t" << row.psrf_root_height
+                        << "\t" << row.psrf_root_pop_size;
+                }
+                out << "\t" << row.ess_tree_length
+                    << "\t" << row.ess_root_height
+                    << "\t" << row.ess_root_pop_size
+                    << "\n";
+            }
+        }
+};
+
 } // treesum
 
 #endif
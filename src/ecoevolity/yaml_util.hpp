@@ -21,13 +21,17 @@
 #define ECOEVOLITY_YAML_UTIL_HPP
 
 #include "yaml-cpp/yaml.h"
+#include "yaml-cpp/eventhandler.h"
 
 class YamlCppUtils {
 
     public:
 
         static std::string get_node_type(const YAML::Node& node) {
-            switch(node.Type()) {
+            return get_node_type(node.Type());
+        }
+        static std::string get_node_type(YAML::NodeType::value type) {
+            switch(type) {
                 case YAML::NodeType::Null:
                     return "Null";
                 case YAML::NodeType::Scalar:
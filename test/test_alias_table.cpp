@@ -0,0 +1,55 @@
+#include "catch.hpp"
+#include "ecoevolity/alias_table.hpp"
+#include "ecoevolity/rng.hpp"
+
+
+TEST_CASE("Testing AliasTable errors", "[AliasTable]") {
+
+    SECTION("Testing bad weights") {
+        AliasTable table;
+        REQUIRE_THROWS_AS(table.build({}), EcoevolityError &);
+        REQUIRE_THROWS_AS(table.build({0.0, 0.0}), EcoevolityError &);
+        REQUIRE_THROWS_AS(table.build({1.0, -0.5, 1.0}), EcoevolityError &);
+    }
+}
+
+TEST_CASE("Testing AliasTable draws", "[AliasTable]") {
+
+    SECTION("Testing single category") {
+        RandomNumberGenerator rng = RandomNumberGenerator(123);
+        AliasTable table({3.0});
+        REQUIRE(table.size() == 1);
+        for (unsigned int i = 0; i < 100; ++i) {
+            REQUIRE(table.draw(rng) == 0);
+        }
+    }
+
+    SECTION("Testing zero weights are never drawn") {
+        RandomNumberGenerator rng = RandomNumberGenerator(234);
+        AliasTable table({0.0, 1.0, 0.0, 2.0, 0.0});
+        for (unsigned int i = 0; i < 10000; ++i) {
+            unsigned int k = table.draw(rng);
+            REQUIRE(((k == 1) || (k == 3)));
+        }
+    }
+
+    SECTION("Testing frequencies of unnormalized weights") {
+        RandomNumberGenerator rng = RandomNumberGenerator(345);
+        std::vector<double> weights = {5.0, 0.1, 2.0, 0.9, 12.0, 0.5, 3.5};
+        double sum = 0.0;
+        for (auto w : weights) {
+            sum += w;
+        }
+        AliasTable table(weights);
+        REQUIRE(table.size() == weights.size());
+        unsigned int nreps = 200000;
+        std::vector<unsigned int> counts(weights.size(), 0);
+        for (unsigned int i = 0; i < nreps; ++i) {
+            ++counts.at(table.draw(rng));
+        }
+        for (unsigned int i = 0; i < weights.size(); ++i) {
+            double freq = counts.at(i) / (double)nreps;
+            REQUIRE(std::abs(freq - (weights.at(i) / sum)) < 0.005);
+        }
+    }
+}
@@ -5912,3 +5912,109 @@ TEST_CASE("Testing draw_from_prior logging for PYP with variable conc and discou
         REQUIRE(lnl_summary.variance() == 0.0);
     }
 }
+
+TEST_CASE("Testing multithreaded loading of comparisons",
+        "[ComparisonPopulationTreeCollection]") {
+
+    std::string cfg_path = "data/dummy.yml";
+
+    std::stringstream cfg;
+    cfg << "event_time_prior:\n";
+    cfg << "    gamma_distribution:\n";
+    cfg << "        shape: 10.0\n";
+    cfg << "        scale: 0.01\n";
+    cfg << "event_model_prior:\n";
+    cfg << "    dirichlet_process:\n";
+    cfg << "        parameters:\n";
+    cfg << "            concentration:\n";
+    cfg << "                value: 1.0\n";
+    cfg << "                estimate: false\n";
+    cfg << "global_comparison_settings:\n";
+    cfg << "    genotypes_are_diploid: true\n";
+    cfg << "    markers_are_dominant: false\n";
+    cfg << "    population_name_delimiter: \" \"\n";
+    cfg << "    population_name_is_prefix: true\n";
+    cfg << "    constant_sites_removed: true\n";
+    cfg << "    equal_population_sizes: false\n";
+    cfg << "    parameters:\n";
+    cfg << "        population_size:\n";
+    cfg << "            estimate: true\n";
+    cfg << "            prior:\n";
+    cfg << "                gamma_distribution:\n";
+    cfg << "                    shape: 5.0\n";
+    cfg << "                    scale: 0.001\n";
+    cfg << "        mutation_rate:\n";
+    cfg << "            estimate: true\n";
+    cfg << "            prior:\n";
+    cfg << "                gamma_distribution:\n";
+    cfg << "                    shape: 10.0\n";
+    cfg << "                    scale: 0.1\n";
+    cfg << "        freq_1:\n";
+    cfg << "            estimate: true\n";
+    cfg << "            prior:\n";
+    cfg << "                beta_distribution:\n";
+    cfg << "                    alpha: 2.0\n";
+    cfg << "                    beta: 2.0\n";
+    cfg << "comparisons:\n";
+    cfg << "- comparison:\n";
+    cfg << "    path: hemi129.nex\n";
+    cfg << "- comparison:\n";
+    cfg << "    path: hemi129-altname1.nex\n";
+    cfg << "- comparison:\n";
+    cfg << "    path: hemi129-altname2.nex\n";
+    cfg << "- comparison:\n";
+    cfg << "    path: hemi129-altname3.nex\n";
+
+    SECTION("Testing that thread count does not change the collection") {
+        CollectionSettings settings = CollectionSettings(cfg, cfg_path);
+        RandomNumberGenerator rng1 = RandomNumberGenerator(3214);
+        ComparisonPopulationTreeCollection collection1 = ComparisonPopulationTreeCollection(
+                settings,
+                rng1,
+                true, true, true, false,
+                1);
+        RandomNumberGenerator rng3 = RandomNumberGenerator(3214);
+        ComparisonPopulationTreeCollection collection3 = ComparisonPopulationTreeCollection(
+                settings,
+                rng3,
+                true, true, true, false,
+                3);
+
+        REQUIRE(collection1.get_number_of_trees() == 4);
+        REQUIRE(collection3.get_number_of_trees() == 4);
+        for (unsigned int i = 0; i < 4; ++i) {
+            std::shared_ptr<PopulationTree> t1 = collection1.get_tree(i);
+            std::shared_ptr<PopulationTree> t3 = collection3.get_tree(i);
+            REQUIRE(t1->get_data().get_path() == t3->get_data().get_path());
+            REQUIRE(t1->get_data().get_number_of_patterns() ==
+                    t3->get_data().get_number_of_patterns());
+            REQUIRE(t1->get_data().get_pattern_weights() ==
+                    t3->get_data().get_pattern_weights());
+            REQUIRE(t1->get_population_labels() == t3->get_population_labels());
+            REQUIRE(t1->get_root_height() == t3->get_root_height());
+            REQUIRE(t1->get_root_population_size() == t3->get_root_population_size());
+            REQUIRE(t1->get_freq_1() == t3->get_freq_1());
+            REQUIRE(t1->get_mutation_rate() == t3->get_mutation_rate());
+        }
+        REQUIRE(rng1.uniform_real() == rng3.uniform_real());
+
+        collection1.compute_log_likelihood_and_prior(true);
+        collection3.compute_log_likelihood_and_prior(true);
+        REQUIRE(collection1.get_log_likelihood() == collection3.get_log_likelihood());
+    }
+
+    SECTION("Testing label conflicts are reported when loading in parallel") {
+        std::stringstream bad_cfg;
+        bad_cfg << cfg.str();
+        bad_cfg << "- comparison:\n";
+        bad_cfg << "    path: hemi129.nex\n";
+        CollectionSettings settings = CollectionSettings(bad_cfg, cfg_path);
+        RandomNumberGenerator rng = RandomNumberGenerator(3214);
+        REQUIRE_THROWS_AS(ComparisonPopulationTreeCollection(
+                settings,
+                rng,
+                true, true, true, false,
+                4),
+                EcoevolityCollectionSettingError &);
+    }
+}
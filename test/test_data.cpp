@@ -11350,6 +11350,81 @@ TEST_CASE("Testing yaml parsing with duplicated pattern", "[BiallelicData]") {
     }
 }
 
+TEST_CASE("Testing yaml parsing with keys out of order", "[BiallelicData]") {
+
+    SECTION("Testing patterns before labels and ignored keys") {
+        std::stringstream yml;
+        yml << "---\n";
+        yml << "comment:\n";
+        yml << "    notes: [ignored, {nested: [1, 2]}]\n";
+        yml << "pattern_weights:\n";
+        yml << "    - 3\n";
+        yml << "    - \"7\"\n";
+        yml << "allele_count_patterns:\n";
+        yml << "    - [[0,4], [1,2]]\n";
+        yml << "    - [[2,4], [0,2]]\n";
+        yml << "markers_are_dominant: false\n";
+        yml << "population_labels:\n";
+        yml << "    - pop1\n";
+        yml << "    - pop2\n";
+        BiallelicData bd;
+        bd.init_from_yaml_stream(yml, "dummy.yml");
+        REQUIRE(bd.get_number_of_populations() == 2);
+        REQUIRE(bd.get_number_of_patterns() == 2);
+        REQUIRE(bd.get_population_index("pop1") == 0);
+        REQUIRE(bd.get_population_index("pop2") == 1);
+        REQUIRE(bd.get_pattern_weights() == std::vector<unsigned int>({3, 7}));
+        REQUIRE(bd.get_red_allele_counts(0) == std::vector<unsigned int>({0, 1}));
+        REQUIRE(bd.get_allele_counts(0) == std::vector<unsigned int>({4, 2}));
+        REQUIRE(bd.get_red_allele_counts(1) == std::vector<unsigned int>({2, 0}));
+        REQUIRE(bd.get_allele_counts(1) == std::vector<unsigned int>({4, 2}));
+        REQUIRE(! bd.markers_are_dominant());
+        REQUIRE(bd.get_max_allele_counts() == std::vector<unsigned int>({4, 2}));
+    }
+
+    SECTION("Testing pattern with too few populations before labels") {
+        std::stringstream yml;
+        yml << "allele_count_patterns:\n";
+        yml << "    - [[0,4], [1,2]]\n";
+        yml << "    - [[2,4]]\n";
+        yml << "pattern_weights: [1, 1]\n";
+        yml << "population_labels: [pop1, pop2]\n";
+        BiallelicData bd;
+        REQUIRE_THROWS_AS(bd.init_from_yaml_stream(yml, "dummy.yml"),
+                EcoevolityYamlDataError &);
+    }
+
+    SECTION("Testing missing pattern weights") {
+        std::stringstream yml;
+        yml << "population_labels: [pop1, pop2]\n";
+        yml << "allele_count_patterns:\n";
+        yml << "    - [[0,4], [1,2]]\n";
+        BiallelicData bd;
+        REQUIRE_THROWS_AS(bd.init_from_yaml_stream(yml, "dummy.yml"),
+                EcoevolityYamlDataError &);
+    }
+
+    SECTION("Testing allele count with three values") {
+        std::stringstream yml;
+        yml << "population_labels: [pop1, pop2]\n";
+        yml << "allele_count_patterns:\n";
+        yml << "    - [[0,4,1], [1,2]]\n";
+        yml << "pattern_weights: [1]\n";
+        BiallelicData bd;
+        REQUIRE_THROWS_AS(bd.init_from_yaml_stream(yml, "dummy.yml"),
+                EcoevolityYamlDataError &);
+    }
+
+    SECTION("Testing top level sequence") {
+        std::stringstream yml;
+        yml << "- pop1\n";
+        yml << "- pop2\n";
+        BiallelicData bd;
+        REQUIRE_THROWS_AS(bd.init_from_yaml_stream(yml, "dummy.yml"),
+                EcoevolityYamlDataError &);
+    }
+}
+
 TEST_CASE("Testing yaml writing methods for diploid standard data set",
         "[BiallelicData]") {
 
@@ -11988,3 +12063,274 @@ TEST_CASE("Testing yaml writing methods for hemi data with folding and removing"
         }
     }
 }
+
+TEST_CASE("Testing multithreaded parsing of nexus data",
+        "[BiallelicData]") {
+
+    SECTION("Testing data/Cyrtodactylus-tutorial-data.nex with charsets") {
+        std::string nex_path = "data/Cyrtodactylus-tutorial-data.nex";
+        BiallelicData bd(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                true,  // store seq loci info (false)
+                1);    // nthreads (1)
+        BiallelicData threaded_bd(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                true,  // store seq loci info (false)
+                3);    // nthreads (1)
+
+        REQUIRE(bd.get_number_of_sites() == 4575);
+        REQUIRE(bd.has_seq_loci_info());
+        REQUIRE(threaded_bd.has_seq_loci_info());
+        REQUIRE(bd.get_population_labels() == threaded_bd.get_population_labels());
+        REQUIRE(bd.get_number_of_patterns() == threaded_bd.get_number_of_patterns());
+        REQUIRE(bd.get_red_allele_count_matrix() == threaded_bd.get_red_allele_count_matrix());
+        REQUIRE(bd.get_allele_count_matrix() == threaded_bd.get_allele_count_matrix());
+        REQUIRE(bd.get_pattern_weights() == threaded_bd.get_pattern_weights());
+        REQUIRE(bd.get_contiguous_pattern_indices() == threaded_bd.get_contiguous_pattern_indices());
+        REQUIRE(bd.get_locus_end_indices() == threaded_bd.get_locus_end_indices());
+        REQUIRE(bd.get_number_of_triallelic_sites_recoded() == threaded_bd.get_number_of_triallelic_sites_recoded());
+        REQUIRE(bd.get_contiguous_pattern_indices().size() == 4575);
+        for (unsigned int site_idx = 0; site_idx < 4575; ++site_idx) {
+            unsigned int pattern_idx = bd.get_pattern_index_for_site(site_idx);
+            REQUIRE(pattern_idx < bd.get_number_of_patterns());
+        }
+    }
+
+    SECTION("Testing data/aflp_25.nex") {
+        std::string nex_path = "data/aflp_25.nex";
+        BiallelicData bd(
+                nex_path,
+                ' ',
+                true,  // pop name is prefix (true)
+                false, // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                false, // store seq loci info (false)
+                1);    // nthreads (1)
+        BiallelicData threaded_bd(
+                nex_path,
+                ' ',
+                true,  // pop name is prefix (true)
+                false, // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                false, // store seq loci info (false)
+                4);    // nthreads (1)
+
+        REQUIRE(bd.get_number_of_sites() == 1217);
+        REQUIRE(bd.get_number_of_patterns() == threaded_bd.get_number_of_patterns());
+        REQUIRE(bd.get_red_allele_count_matrix() == threaded_bd.get_red_allele_count_matrix());
+        REQUIRE(bd.get_allele_count_matrix() == threaded_bd.get_allele_count_matrix());
+        REQUIRE(bd.get_pattern_weights() == threaded_bd.get_pattern_weights());
+    }
+}
+
+TEST_CASE("Testing streamed parsing of nexus data",
+        "[BiallelicData]") {
+
+    SECTION("Testing interleaved data/Cyrtodactylus-tutorial-data.nex") {
+        std::string nex_path = "data/Cyrtodactylus-tutorial-data.nex";
+        BiallelicData bd(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true); // validate (true)
+        BiallelicData streamed_bd;
+        streamed_bd.init_from_streamed_nexus(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true); // validate (true)
+
+        REQUIRE(streamed_bd.get_number_of_sites() == 4575);
+        REQUIRE(! streamed_bd.has_seq_loci_info());
+        REQUIRE(bd.get_population_labels() == streamed_bd.get_population_labels());
+        REQUIRE(bd.get_sequence_labels(0) == streamed_bd.get_sequence_labels(0));
+        REQUIRE(bd.get_number_of_patterns() == streamed_bd.get_number_of_patterns());
+        REQUIRE(bd.get_red_allele_count_matrix() == streamed_bd.get_red_allele_count_matrix());
+        REQUIRE(bd.get_allele_count_matrix() == streamed_bd.get_allele_count_matrix());
+        REQUIRE(bd.get_pattern_weights() == streamed_bd.get_pattern_weights());
+        REQUIRE(bd.get_number_of_triallelic_sites_recoded() == streamed_bd.get_number_of_triallelic_sites_recoded());
+    }
+
+    SECTION("Testing data/aflp_25.nex") {
+        std::string nex_path = "data/aflp_25.nex";
+        BiallelicData bd(
+                nex_path,
+                ' ',
+                true,  // pop name is prefix (true)
+                false, // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true); // validate (true)
+        BiallelicData streamed_bd;
+        streamed_bd.init_from_streamed_nexus(
+                nex_path,
+                ' ',
+                true,  // pop name is prefix (true)
+                false, // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true); // validate (true)
+
+        REQUIRE(streamed_bd.get_number_of_sites() == 1217);
+        REQUIRE(bd.get_number_of_patterns() == streamed_bd.get_number_of_patterns());
+        REQUIRE(bd.get_red_allele_count_matrix() == streamed_bd.get_red_allele_count_matrix());
+        REQUIRE(bd.get_allele_count_matrix() == streamed_bd.get_allele_count_matrix());
+        REQUIRE(bd.get_pattern_weights() == streamed_bd.get_pattern_weights());
+    }
+
+    SECTION("Testing ambiguity codes, match characters and comments") {
+        std::string tag = _ECOEVOLITY_DATA_RNG.random_string(10);
+        std::string test_path = "data/tmp-data-" + tag + "-streamed.nex";
+        std::ofstream os;
+        os.open(test_path);
+        os << "#NEXUS\n"
+           << "[comment [nested]]\n"
+           << "Begin taxa;\n"
+           << "    Dimensions ntax=4;\n"
+           << "    Taxlabels pop1_a 'pop1 b' pop2_c 'pop2 ''d''';\n"
+           << "End;\n"
+           << "Begin characters;\n"
+           << "    Dimensions nchar=8;\n"
+           << "    Format datatype=dna missing=? gap=- matchchar=. interleave;\n"
+           << "    Matrix\n"
+           << "        pop1_a ACGT\n"
+           << "        'pop1 b' .c.{AG}\n"
+           << "        pop2_c a-?R\n"
+           << "        'pop2 ''d''' AA[x]AA\n"
+           << "\n"
+           << "        pop1_a acgt\n"
+           << "        'pop1 b' ..(CT).\n"
+           << "        pop2_c RRYY\n"
+           << "        'pop2 ''d''' GG KK\n"
+           << "    ;\n"
+           << "End;\n";
+        os.close();
+
+        BiallelicData bd(
+                test_path,
+                ' ',
+                true,  // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                false); // validate (true)
+        BiallelicData streamed_bd;
+        streamed_bd.init_from_streamed_nexus(
+                test_path,
+                ' ',
+                true,  // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                false); // validate (true)
+
+        REQUIRE(streamed_bd.get_number_of_sites() == 8);
+        REQUIRE(streamed_bd.get_population_labels() == std::vector<std::string>({"pop1", "pop2"}));
+        REQUIRE(bd.get_sequence_labels(1) == streamed_bd.get_sequence_labels(1));
+        REQUIRE(bd.get_number_of_patterns() == streamed_bd.get_number_of_patterns());
+        REQUIRE(bd.get_red_allele_count_matrix() == streamed_bd.get_red_allele_count_matrix());
+        REQUIRE(bd.get_allele_count_matrix() == streamed_bd.get_allele_count_matrix());
+        REQUIRE(bd.get_pattern_weights() == streamed_bd.get_pattern_weights());
+    }
+
+    SECTION("Testing unsupported equate") {
+        std::string tag = _ECOEVOLITY_DATA_RNG.random_string(10);
+        std::string test_path = "data/tmp-data-" + tag + "-streamed-equate.nex";
+        std::ofstream os;
+        os.open(test_path);
+        os << "#NEXUS\n"
+           << "Begin data;\n"
+           << "    Dimensions ntax=2 nchar=2;\n"
+           << "    Format datatype=standard equate=\"2=(01)\";\n"
+           << "    Matrix\n"
+           << "        pop1_a 01\n"
+           << "        pop2_b 10\n"
+           << "    ;\n"
+           << "End;\n";
+        os.close();
+
+        BiallelicData streamed_bd;
+        REQUIRE_THROWS_AS(streamed_bd.init_from_streamed_nexus(test_path, ' ',
+                    true, false, false, true),
+                EcoevolityParsingError &);
+    }
+}
+
+TEST_CASE("Testing writing alignments with stored loci info",
+        "[BiallelicData]") {
+
+    SECTION("Testing data/Cyrtodactylus-tutorial-data.nex with charsets") {
+        std::string nex_path = "data/Cyrtodactylus-tutorial-data.nex";
+        BiallelicData bd(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                true); // store seq loci info (false)
+
+        REQUIRE(bd.get_contiguous_pattern_indices().size() == 4575);
+        REQUIRE(bd.get_contiguous_pattern_indices().get_bits_per_index() < 32);
+
+        std::vector< std::vector<std::string> > alignment = bd.get_alignment();
+        std::stringstream expected;
+        for (unsigned int pop_idx = 0; pop_idx < alignment.size(); ++pop_idx) {
+            for (unsigned int row_idx = 0; row_idx < alignment.at(pop_idx).size(); ++row_idx) {
+                expected << "\'" << bd.get_population_label(pop_idx) << "-"
+                         << string_util::pad_int(row_idx, 4) << "\'  "
+                         << alignment.at(pop_idx).at(row_idx) << "\n";
+                REQUIRE(alignment.at(pop_idx).at(row_idx).size() == 4575);
+            }
+        }
+        std::stringstream written;
+        bd.write_alignment(written, '-');
+        REQUIRE(written.str() == expected.str());
+    }
+
+    SECTION("Testing removing constant patterns with charsets") {
+        std::string nex_path = "data/Cyrtodactylus-tutorial-data.nex";
+        BiallelicData bd(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                true); // store seq loci info (false)
+        BiallelicData bd_sans_loci(
+                nex_path,
+                '_',
+                false, // pop name is prefix (true)
+                true,  // genotypes are diploid (true)
+                false, // markers are dominant (false)
+                true,  // validate (true)
+                false); // store seq loci info (false)
+
+        bd.remove_constant_patterns();
+        bd_sans_loci.remove_constant_patterns();
+
+        REQUIRE(bd.get_number_of_patterns() == bd_sans_loci.get_number_of_patterns());
+        REQUIRE(bd.get_number_of_sites() == bd_sans_loci.get_number_of_sites());
+        REQUIRE(bd.get_contiguous_pattern_indices().size() == bd.get_number_of_sites());
+        REQUIRE(bd.get_contiguous_pattern_indices().size() == (bd.get_locus_end_indices().back() + 1));
+        for (unsigned int locus_idx = 1; locus_idx < bd.get_locus_end_indices().size(); ++locus_idx) {
+            REQUIRE(bd.get_locus_end_indices().at(locus_idx) > bd.get_locus_end_indices().at(locus_idx - 1));
+        }
+        for (auto pattern_idx : bd.get_contiguous_pattern_indices()) {
+            REQUIRE(pattern_idx < bd.get_number_of_patterns());
+        }
+    }
+}
@@ -0,0 +1,316 @@
+#include "catch.hpp"
+#include "ecoevolity/flat_gene_tree.hpp"
+#include "ecoevolity/tree.hpp"
+#include "ecoevolity/rng.hpp"
+#include "ecoevolity/stats_util.hpp"
+
+
+TEST_CASE("Testing building FlatGeneTree", "[FlatGeneTree]") {
+
+    SECTION("Testing leaves and parents") {
+        FlatGeneTree gene_tree;
+        gene_tree.clear(3);
+        unsigned int l0 = gene_tree.add_leaf(0);
+        unsigned int l1 = gene_tree.add_leaf(0);
+        unsigned int l2 = gene_tree.add_leaf(1);
+        unsigned int p0 = gene_tree.add_parent(l0, l2, 0.1, 2);
+        unsigned int root = gene_tree.add_parent(p0, l1, 0.3, 2);
+
+        REQUIRE(gene_tree.get_node_count() == 5);
+        REQUIRE(gene_tree.get_leaf_node_count() == 3);
+        REQUIRE(gene_tree.get_root_index() == root);
+        REQUIRE(gene_tree.get_parent(l0) == (int)p0);
+        REQUIRE(gene_tree.get_parent(l1) == (int)root);
+        REQUIRE(gene_tree.get_parent(l2) == (int)p0);
+        REQUIRE(gene_tree.get_parent(p0) == (int)root);
+        REQUIRE(gene_tree.get_parent(root) == -1);
+        REQUIRE(gene_tree.get_height(p0) == 0.1);
+        REQUIRE(gene_tree.get_population_index(l2) == 1);
+        std::vector<unsigned int> expected_leaves = {l0, l1, l2};
+        REQUIRE(gene_tree.get_leaves() == expected_leaves);
+
+        gene_tree.get_branch_lineages(2).push_back(root);
+        gene_tree.clear(3);
+        REQUIRE(gene_tree.get_node_count() == 0);
+        REQUIRE(gene_tree.get_leaf_node_count() == 0);
+        REQUIRE(gene_tree.get_branch_lineages(2).empty());
+    }
+}
+
+TEST_CASE("Testing FlatGeneTree binary character", "[FlatGeneTree]") {
+
+    SECTION("Testing zero-length branches share the root state") {
+        RandomNumberGenerator rng = RandomNumberGenerator(1234);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(1);
+        unsigned int l0 = gene_tree.add_leaf(0);
+        unsigned int l1 = gene_tree.add_leaf(0);
+        unsigned int l2 = gene_tree.add_leaf(1);
+        unsigned int p0 = gene_tree.add_parent(l0, l1, 0.0, 0);
+        gene_tree.add_parent(p0, l2, 0.0, 0);
+        double freq_1 = 0.3;
+        double u = 1.0 / (2.0 * freq_1);
+        double v = 1.0 / (2.0 * (1.0 - freq_1));
+        gene_tree.compute_binary_transition_probabilities(u, v);
+
+        unsigned int nreps = 10000;
+        unsigned int nred = 0;
+        for (unsigned int i = 0; i < nreps; ++i) {
+            gene_tree.simulate_binary_character(rng);
+            std::vector<unsigned int> allele_counts(2, 0);
+            std::vector<unsigned int> red_allele_counts(2, 0);
+            gene_tree.get_allele_counts(allele_counts, red_allele_counts);
+            REQUIRE(allele_counts.at(0) == 2);
+            REQUIRE(allele_counts.at(1) == 1);
+            REQUIRE(((red_allele_counts.at(0) == 0) || (red_allele_counts.at(0) == 2)));
+            REQUIRE(red_allele_counts.at(0) == (2 * red_allele_counts.at(1)));
+            nred += red_allele_counts.at(1);
+        }
+        REQUIRE((double)nred / nreps == Approx(freq_1).epsilon(0.02));
+    }
+
+    SECTION("Testing long branches are at stationarity") {
+        RandomNumberGenerator rng = RandomNumberGenerator(2345);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(1);
+        unsigned int l0 = gene_tree.add_leaf(0);
+        unsigned int l1 = gene_tree.add_leaf(0);
+        gene_tree.add_parent(l0, l1, 1000.0, 0);
+        double freq_1 = 0.8;
+        double u = 1.0 / (2.0 * freq_1);
+        double v = 1.0 / (2.0 * (1.0 - freq_1));
+        gene_tree.compute_binary_transition_probabilities(u, v);
+
+        unsigned int nreps = 20000;
+        unsigned int nshared = 0;
+        unsigned int nred = 0;
+        for (unsigned int i = 0; i < nreps; ++i) {
+            gene_tree.simulate_binary_character(rng);
+            nred += gene_tree.get_character_state(l0);
+            if (gene_tree.get_character_state(l0) == gene_tree.get_character_state(l1)) {
+                ++nshared;
+            }
+        }
+        REQUIRE((double)nred / nreps == Approx(freq_1).epsilon(0.02));
+        double expected_shared = (freq_1 * freq_1) + ((1.0 - freq_1) * (1.0 - freq_1));
+        REQUIRE((double)nshared / nreps == Approx(expected_shared).epsilon(0.02));
+    }
+}
+
+TEST_CASE("Testing FlatGeneTree dominant allele counts", "[FlatGeneTree]") {
+
+    SECTION("Testing consecutive leaves are paired") {
+        RandomNumberGenerator rng = RandomNumberGenerator(3456);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(1);
+        // Two individuals in population 0, one in population 1; the two
+        // gene copies of each individual coalesce immediately, so they share
+        // a state
+        unsigned int a0 = gene_tree.add_leaf(0);
+        unsigned int a1 = gene_tree.add_leaf(0);
+        unsigned int b0 = gene_tree.add_leaf(0);
+        unsigned int b1 = gene_tree.add_leaf(0);
+        unsigned int c0 = gene_tree.add_leaf(1);
+        unsigned int c1 = gene_tree.add_leaf(1);
+        unsigned int a = gene_tree.add_parent(a0, a1, 0.0, 0);
+        unsigned int b = gene_tree.add_parent(b0, b1, 0.0, 0);
+        unsigned int c = gene_tree.add_parent(c0, c1, 0.0, 1);
+        unsigned int ab = gene_tree.add_parent(a, b, 10.0, 2);
+        gene_tree.add_parent(ab, c, 20.0, 2);
+        gene_tree.compute_binary_transition_probabilities(1.0, 1.0);
+
+        for (unsigned int i = 0; i < 1000; ++i) {
+            gene_tree.simulate_binary_character(rng);
+            std::vector<unsigned int> allele_counts(2, 0);
+            std::vector<unsigned int> red_allele_counts(2, 0);
+            std::vector<int> last_allele(2, -1);
+            gene_tree.get_allele_counts(allele_counts, red_allele_counts, last_allele);
+            REQUIRE(allele_counts.at(0) == 2);
+            REQUIRE(allele_counts.at(1) == 1);
+            unsigned int expected_red = gene_tree.get_character_state(a) +
+                    gene_tree.get_character_state(b);
+            REQUIRE(red_allele_counts.at(0) == expected_red);
+            REQUIRE(red_allele_counts.at(1) == (unsigned int)gene_tree.get_character_state(c));
+        }
+    }
+}
+
+TEST_CASE("Testing coalesce_in_branch with FlatGeneTree", "[FlatGeneTree]") {
+
+    SECTION("Testing waiting times and lineage bookkeeping") {
+        RandomNumberGenerator rng = RandomNumberGenerator(4567);
+        double theta = 0.2;
+        unsigned int nlineages = 5;
+        FlatGeneTree gene_tree;
+        SampleSummarizer<double> first_coalescence;
+        SampleSummarizer<double> tmrca;
+        unsigned int nreps = 20000;
+        for (unsigned int i = 0; i < nreps; ++i) {
+            gene_tree.clear(1);
+            std::vector<unsigned int> & lineages = gene_tree.get_branch_lineages(0);
+            for (unsigned int j = 0; j < nlineages; ++j) {
+                lineages.push_back(gene_tree.add_leaf(0));
+            }
+            double h = BasePopulationTree::coalesce_in_branch(
+                    gene_tree,
+                    lineages,
+                    theta,
+                    rng);
+            REQUIRE(lineages.size() == 1);
+            REQUIRE(lineages.at(0) == gene_tree.get_root_index());
+            REQUIRE(gene_tree.get_node_count() == ((2 * nlineages) - 1));
+            REQUIRE(gene_tree.get_height(gene_tree.get_root_index()) == h);
+            for (unsigned int n = 0; n < gene_tree.get_root_index(); ++n) {
+                REQUIRE(gene_tree.get_parent(n) > (int)n);
+                REQUIRE(gene_tree.get_height(gene_tree.get_parent(n)) >= gene_tree.get_height(n));
+            }
+            first_coalescence.add_sample(gene_tree.get_height(nlineages));
+            tmrca.add_sample(h);
+        }
+        // Expected waiting time with k lineages is theta / (k * (k - 1))
+        double k = nlineages;
+        REQUIRE(first_coalescence.mean() == Approx(theta / (k * (k - 1.0))).epsilon(0.03));
+        double expected_tmrca = theta * (1.0 - (1.0 / k));
+        REQUIRE(tmrca.mean() == Approx(expected_tmrca).epsilon(0.03));
+    }
+
+    SECTION("Testing branch with a top") {
+        RandomNumberGenerator rng = RandomNumberGenerator(5678);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(1);
+        std::vector<unsigned int> & lineages = gene_tree.get_branch_lineages(0);
+        for (unsigned int j = 0; j < 10; ++j) {
+            lineages.push_back(gene_tree.add_leaf(0));
+        }
+        double h = BasePopulationTree::coalesce_in_branch(
+                gene_tree,
+                lineages,
+                1.0,
+                rng,
+                0.0,
+                1e-6);
+        REQUIRE(h < 1e-6);
+        REQUIRE(lineages.size() == (20 - gene_tree.get_node_count()));
+    }
+}
+
+TEST_CASE("Testing FlatGeneTree binary character blocks", "[FlatGeneTree]") {
+
+    SECTION("Testing block counts match node states") {
+        RandomNumberGenerator rng = RandomNumberGenerator(6789);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(3);
+        std::vector<unsigned int> & lineages0 = gene_tree.get_branch_lineages(0);
+        std::vector<unsigned int> & lineages1 = gene_tree.get_branch_lineages(1);
+        for (unsigned int j = 0; j < 7; ++j) {
+            lineages0.push_back(gene_tree.add_leaf(0));
+        }
+        for (unsigned int j = 0; j < 4; ++j) {
+            lineages1.push_back(gene_tree.add_leaf(1));
+        }
+        BasePopulationTree::coalesce_in_branch(gene_tree, lineages0, 0.2, rng);
+        BasePopulationTree::coalesce_in_branch(gene_tree, lineages1, 0.2, rng);
+        unsigned int root = gene_tree.add_parent(lineages0.at(0),
+                lineages1.at(0), 0.5, 2);
+        gene_tree.compute_binary_transition_probabilities(1.0 / (2.0 * 0.4),
+                1.0 / (2.0 * 0.6));
+        REQUIRE(gene_tree.get_root_index() == root);
+
+        for (unsigned int nsites : {1, 5, 63, 64, 100}) {
+            gene_tree.simulate_binary_character_block(rng, nsites);
+            unsigned int block_size = (nsites > 64) ? 64 : nsites;
+            REQUIRE(gene_tree.get_number_of_block_sites_remaining() == block_size);
+            for (unsigned int site = 0; site < block_size; ++site) {
+                std::vector<unsigned int> expected_reds(2, 0);
+                for (auto leaf : gene_tree.get_leaves()) {
+                    expected_reds.at(gene_tree.get_population_index(leaf)) +=
+                            gene_tree.get_block_character_state(leaf, site);
+                }
+                std::vector<unsigned int> allele_counts(2, 0);
+                std::vector<unsigned int> red_allele_counts(2, 0);
+                gene_tree.get_next_block_site_allele_counts(allele_counts,
+                        red_allele_counts);
+                REQUIRE(allele_counts.at(0) == 7);
+                REQUIRE(allele_counts.at(1) == 4);
+                REQUIRE(red_allele_counts == expected_reds);
+            }
+            REQUIRE(gene_tree.get_number_of_block_sites_remaining() == 0);
+        }
+
+        gene_tree.simulate_binary_character_block(rng, 10);
+        gene_tree.compute_binary_transition_probabilities(1.0, 1.0);
+        REQUIRE(gene_tree.get_number_of_block_sites_remaining() == 0);
+    }
+
+    SECTION("Testing dominant block counts") {
+        RandomNumberGenerator rng = RandomNumberGenerator(7890);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(1);
+        unsigned int a0 = gene_tree.add_leaf(0);
+        unsigned int a1 = gene_tree.add_leaf(0);
+        unsigned int b0 = gene_tree.add_leaf(0);
+        unsigned int b1 = gene_tree.add_leaf(0);
+        unsigned int p0 = gene_tree.add_parent(a0, b0, 0.3, 0);
+        unsigned int p1 = gene_tree.add_parent(a1, b1, 0.4, 0);
+        gene_tree.add_parent(p0, p1, 0.9, 0);
+        gene_tree.compute_binary_transition_probabilities(1.0, 1.0);
+
+        gene_tree.simulate_binary_character_block(rng, 64, true);
+        for (unsigned int site = 0; site < 64; ++site) {
+            unsigned int expected_reds =
+                (gene_tree.get_block_character_state(a0, site) |
+                 gene_tree.get_block_character_state(a1, site)) +
+                (gene_tree.get_block_character_state(b0, site) |
+                 gene_tree.get_block_character_state(b1, site));
+            std::vector<unsigned int> allele_counts(1, 0);
+            std::vector<unsigned int> red_allele_counts(1, 0);
+            gene_tree.get_next_block_site_allele_counts(allele_counts,
+                    red_allele_counts);
+            REQUIRE(allele_counts.at(0) == 2);
+            REQUIRE(red_allele_counts.at(0) == expected_reds);
+        }
+    }
+
+    SECTION("Testing block and single-site states have the same distribution") {
+        RandomNumberGenerator rng = RandomNumberGenerator(8901);
+        FlatGeneTree gene_tree;
+        gene_tree.clear(1);
+        unsigned int l0 = gene_tree.add_leaf(0);
+        unsigned int l1 = gene_tree.add_leaf(0);
+        unsigned int l2 = gene_tree.add_leaf(0);
+        unsigned int p0 = gene_tree.add_parent(l0, l1, 0.05, 0);
+        unsigned int root = gene_tree.add_parent(p0, l2, 0.8, 0);
+        double freq_1 = 0.35;
+        gene_tree.compute_binary_transition_probabilities(
+                1.0 / (2.0 * freq_1),
+                1.0 / (2.0 * (1.0 - freq_1)));
+
+        // Frequencies of the 8 possible leaf patterns
+        unsigned int nreps = 64 * 4000;
+        std::vector<double> single_freqs(8, 0.0);
+        std::vector<double> block_freqs(8, 0.0);
+        std::vector<double> root_freqs(2, 0.0);
+        for (unsigned int i = 0; i < nreps; ++i) {
+            gene_tree.simulate_binary_character(rng);
+            unsigned int pattern = gene_tree.get_character_state(l0) +
+                    (2 * gene_tree.get_character_state(l1)) +
+                    (4 * gene_tree.get_character_state(l2));
+            single_freqs.at(pattern) += 1.0 / nreps;
+        }
+        for (unsigned int i = 0; i < (nreps / 64); ++i) {
+            gene_tree.simulate_binary_character_block(rng, 64);
+            for (unsigned int site = 0; site < 64; ++site) {
+                unsigned int pattern =
+                        gene_tree.get_block_character_state(l0, site) +
+                        (2 * gene_tree.get_block_character_state(l1, site)) +
+                        (4 * gene_tree.get_block_character_state(l2, site));
+                block_freqs.at(pattern) += 1.0 / nreps;
+                root_freqs.at(gene_tree.get_block_character_state(root, site)) += 1.0 / nreps;
+            }
+        }
+        REQUIRE(root_freqs.at(1) == Approx(freq_1).epsilon(0.02));
+        for (unsigned int pattern = 0; pattern < 8; ++pattern) {
+            REQUIRE(std::abs(block_freqs.at(pattern) - single_freqs.at(pattern)) < 0.005);
+        }
+    }
+}
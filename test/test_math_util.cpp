@@ -3,6 +3,10 @@
 #include "ecoevolity/math_util.hpp"
 #include "ecoevolity/stats_util.hpp"
 
+#ifdef BUILD_WITH_THREADS
+#include <future>
+#endif
+
 TEST_CASE("Testing n_choose_k_base overflow", "[math_util]") {
     SECTION("Testing overflow error") {
         // std::cout << "max int: " << std::numeric_limits<int>::max() << "\n";
@@ -1208,6 +1212,76 @@ TEST_CASE("Testing bell number functions", "[math_util]") {
     }
 }
 
+TEST_CASE("Testing LogStirlingTable", "[math_util]") {
+    SECTION("Testing against exact numbers") {
+        for (unsigned int n = 1; n <= 30; ++n) {
+            REQUIRE(ln_bell_number(n) == Approx(std::log(bell_float(n))).epsilon(1e-12));
+            for (unsigned int k = 1; k <= n; ++k) {
+                REQUIRE(ln_stirling2(n, k) ==
+                        Approx(std::log(stirling2_float(n, k))).epsilon(1e-12));
+            }
+        }
+        REQUIRE(ln_stirling2(0, 0) == 0.0);
+        REQUIRE(std::isinf(ln_stirling2(3, 0)));
+        REQUIRE(std::isinf(ln_stirling2(3, 4)));
+        REQUIRE(ln_bell_number(0) == 0.0);
+    }
+
+    SECTION("Testing large numbers of elements") {
+        // Bell(2229) overflows long double, but not in log space
+        REQUIRE(std::isfinite(ln_bell_number(2300)));
+        REQUIRE(ln_bell_number(2300) > std::log(std::numeric_limits<double>::max()));
+        REQUIRE(ln_stirling2(2300, 1) == 0.0);
+        REQUIRE(ln_stirling2(2300, 2300) == 0.0);
+        REQUIRE(ln_stirling2(2300, 2299) == Approx(ln_n_choose_k(2300, 2)));
+    }
+
+    SECTION("Testing uniform prior normalizing constant") {
+        LogStirlingTable & table = LogStirlingTable::get_instance();
+        for (double w : {0.1, 1.0, 3.7}) {
+            double ln_z = table.get_ln_uniform_normalizing_constant(300, w);
+            // Cached value is returned for the same split weight
+            REQUIRE(table.get_ln_uniform_normalizing_constant(300, w) == ln_z);
+            double total = 0.0;
+            for (unsigned int k = 1; k <= 300; ++k) {
+                total += std::exp(ln_stirling2(300, k) +
+                        get_uniform_model_log_prior_probability(300, k, w));
+            }
+            REQUIRE(total == Approx(1.0).epsilon(1e-10));
+        }
+        REQUIRE(table.get_ln_uniform_normalizing_constant(3, 2.0) ==
+                Approx(std::log(11.0)));
+        REQUIRE(table.get_ln_uniform_normalizing_constant(3, 3.0) ==
+                Approx(std::log(19.0)));
+        REQUIRE(get_uniform_model_log_prior_probability(3, 2, 2.0) ==
+                Approx(get_uniform_model_log_prior_probability<long double>(3, 2, 2.0)));
+    }
+
+#ifdef BUILD_WITH_THREADS
+    SECTION("Testing concurrent use") {
+        std::vector< std::future<double> > results;
+        for (unsigned int i = 0; i < 4; ++i) {
+            results.push_back(std::async(std::launch::async, [i] () {
+                double sum = 0.0;
+                for (unsigned int n = 1; n <= (200 + (100 * i)); ++n) {
+                    sum += ln_bell_number(n) +
+                            get_uniform_model_log_prior_probability(n, 1, 1.0 + i);
+                }
+                return sum;
+            }));
+        }
+        for (unsigned int i = 0; i < 4; ++i) {
+            double expected = 0.0;
+            for (unsigned int n = 1; n <= (200 + (100 * i)); ++n) {
+                expected += ln_bell_number(n) +
+                        get_uniform_model_log_prior_probability(n, 1, 1.0 + i);
+            }
+            REQUIRE(results.at(i).get() == Approx(expected));
+        }
+    }
+#endif
+}
+
 TEST_CASE("Testing get_integer_partitions(2, 2)", "[math_util]") {
     SECTION("Testing get_integer_partitions") {
         std::vector< std::vector<unsigned int> > expected_partitions;
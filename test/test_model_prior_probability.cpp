@@ -0,0 +1,223 @@
+#include "catch.hpp"
+#include "ecoevolity/model_prior_probability.hpp"
+#include "ecoevolity/set_partition_index.hpp"
+#include "ecoevolity/math_util.hpp"
+#include "ecoevolity/rng.hpp"
+
+
+TEST_CASE("Testing HyperpriorQuadrature", "[ModelPriorProbabilities]") {
+
+    SECTION("Testing fixed value") {
+        HyperpriorQuadrature q(2.5);
+        REQUIRE(q.size() == 1);
+        REQUIRE(q.get_value(0) == 2.5);
+        REQUIRE(q.get_weight(0) == 1.0);
+    }
+
+    SECTION("Testing moments of priors") {
+        std::vector< std::shared_ptr<ContinuousProbabilityDistribution> > priors = {
+                std::make_shared<GammaDistribution>(1.0, 1.0),
+                std::make_shared<GammaDistribution>(0.5, 4.0),
+                std::make_shared<GammaDistribution>(200.0, 0.01),
+                std::make_shared<OffsetGammaDistribution>(2.0, 3.0, 0.5),
+                std::make_shared<ExponentialDistribution>(2.0),
+                std::make_shared<BetaDistribution>(1.0, 1.0),
+                std::make_shared<BetaDistribution>(0.5, 3.0),
+                std::make_shared<BetaDistribution>(20.0, 2.0),
+                std::make_shared<UniformDistribution>(0.5, 3.0)};
+        for (auto prior : priors) {
+            REQUIRE(HyperpriorQuadrature::can_integrate(*prior));
+            HyperpriorQuadrature q(*prior);
+            double sum = 0.0;
+            double mean = 0.0;
+            for (unsigned int i = 0; i < q.size(); ++i) {
+                REQUIRE(q.get_value(i) >= prior->get_min());
+                REQUIRE(q.get_value(i) <= prior->get_max());
+                sum += q.get_weight(i);
+                mean += q.get_weight(i) * q.get_value(i);
+            }
+            double variance = 0.0;
+            for (unsigned int i = 0; i < q.size(); ++i) {
+                variance += q.get_weight(i) *
+                        std::pow(q.get_value(i) - mean, 2);
+            }
+            REQUIRE(sum == Approx(1.0).epsilon(1e-12));
+            REQUIRE(mean == Approx(prior->get_mean()).epsilon(1e-8));
+            REQUIRE(variance == Approx(prior->get_variance()).epsilon(1e-8));
+        }
+    }
+
+    SECTION("Testing unsupported prior") {
+        ImproperPositiveUniformDistribution prior;
+        REQUIRE(! HyperpriorQuadrature::can_integrate(prior));
+        REQUIRE_THROWS_AS(HyperpriorQuadrature q(prior), EcoevolityError &);
+    }
+}
+
+TEST_CASE("Testing ModelPriorProbabilities against enumeration",
+        "[ModelPriorProbabilities]") {
+
+    SECTION("Testing fixed hyperparameters") {
+        const unsigned int n = 6;
+        SetPartitionIndex index(n);
+        ModelPriorProbabilities dpp(n, EcoevolityOptions::ModelPrior::dpp,
+                HyperpriorQuadrature(1.3));
+        ModelPriorProbabilities pyp(n, EcoevolityOptions::ModelPrior::pyp,
+                HyperpriorQuadrature(1.3), HyperpriorQuadrature(0.4));
+        ModelPriorProbabilities uniform(n, EcoevolityOptions::ModelPrior::uniform,
+                HyperpriorQuadrature(2.5));
+        std::vector<double> dpp_k(n + 1, 0.0);
+        std::vector<double> pyp_k(n + 1, 0.0);
+        std::vector<double> uniform_k(n + 1, 0.0);
+        double dpp_shared = 0.0;
+        double pyp_shared = 0.0;
+        double uniform_shared = 0.0;
+        for (std::uint64_t key = 0; key < index.get_number_of_partitions(); ++key) {
+            std::vector<unsigned int> model = index.get_model(key);
+            unsigned int k = (*std::max_element(model.begin(), model.end())) + 1;
+            double p_dpp = std::exp(get_dpp_log_prior_probability<unsigned int>(
+                    model, 1.3));
+            double p_pyp = std::exp(get_pyp_log_prior_probability<unsigned int>(
+                    model, 1.3, 0.4));
+            double p_uniform = std::exp(get_uniform_model_log_prior_probability(
+                    n, k, 2.5));
+            REQUIRE(dpp.get_model_probability(model) == Approx(p_dpp).epsilon(1e-12));
+            REQUIRE(pyp.get_model_probability(model) == Approx(p_pyp).epsilon(1e-12));
+            REQUIRE(uniform.get_model_probability(model) == Approx(p_uniform).epsilon(1e-12));
+            dpp_k.at(k) += p_dpp;
+            pyp_k.at(k) += p_pyp;
+            uniform_k.at(k) += p_uniform;
+            if ((model.at(0) == model.at(1)) && (model.at(1) == model.at(2))) {
+                dpp_shared += p_dpp;
+                pyp_shared += p_pyp;
+                uniform_shared += p_uniform;
+            }
+        }
+        for (unsigned int k = 1; k <= n; ++k) {
+            REQUIRE(dpp.get_number_of_categories_probability(k) == Approx(dpp_k.at(k)).epsilon(1e-12));
+            REQUIRE(pyp.get_number_of_categories_probability(k) == Approx(pyp_k.at(k)).epsilon(1e-12));
+            REQUIRE(uniform.get_number_of_categories_probability(k) == Approx(uniform_k.at(k)).epsilon(1e-12));
+        }
+        REQUIRE(dpp.get_shared_probability(3) == Approx(dpp_shared).epsilon(1e-12));
+        REQUIRE(pyp.get_shared_probability(3) == Approx(pyp_shared).epsilon(1e-12));
+        REQUIRE(uniform.get_shared_probability(3) == Approx(uniform_shared).epsilon(1e-12));
+        REQUIRE(dpp.get_shared_probability(1) == Approx(1.0));
+        REQUIRE(dpp.get_expected_number_of_categories() ==
+                Approx(get_dpp_expected_number_of_categories(1.3, n)));
+        REQUIRE(pyp.get_expected_number_of_categories() ==
+                Approx(get_pyp_expected_number_of_categories(1.3, 0.4, n)));
+
+        std::vector<long double> subset_probs = get_number_of_subset_probs(n, 2.5);
+        for (unsigned int k = 1; k <= n; ++k) {
+            REQUIRE(uniform.get_number_of_categories_probability(k) ==
+                    Approx(subset_probs.at(k - 1)).epsilon(1e-12));
+        }
+    }
+
+    SECTION("Testing integrated hyperparameters") {
+        const unsigned int n = 5;
+        SetPartitionIndex index(n);
+        GammaDistribution concentration_prior(2.0, 1.5);
+        BetaDistribution discount_prior(1.5, 3.0);
+        ModelPriorProbabilities pyp(n, EcoevolityOptions::ModelPrior::pyp,
+                HyperpriorQuadrature(concentration_prior),
+                HyperpriorQuadrature(discount_prior));
+        ModelPriorProbabilities uniform(n, EcoevolityOptions::ModelPrior::uniform,
+                HyperpriorQuadrature(concentration_prior));
+        double pyp_sum = 0.0;
+        double uniform_sum = 0.0;
+        std::vector<double> pyp_k(n + 1, 0.0);
+        std::vector<double> uniform_k(n + 1, 0.0);
+        for (std::uint64_t key = 0; key < index.get_number_of_partitions(); ++key) {
+            std::vector<unsigned int> model = index.get_model(key);
+            unsigned int k = (*std::max_element(model.begin(), model.end())) + 1;
+            pyp_sum += pyp.get_model_probability(model);
+            uniform_sum += uniform.get_model_probability(model);
+            pyp_k.at(k) += pyp.get_model_probability(model);
+            uniform_k.at(k) += uniform.get_model_probability(model);
+        }
+        REQUIRE(pyp_sum == Approx(1.0).epsilon(1e-12));
+        REQUIRE(uniform_sum == Approx(1.0).epsilon(1e-12));
+        for (unsigned int k = 1; k <= n; ++k) {
+            REQUIRE(pyp.get_number_of_categories_probability(k) == Approx(pyp_k.at(k)).epsilon(1e-12));
+            REQUIRE(uniform.get_number_of_categories_probability(k) == Approx(uniform_k.at(k)).epsilon(1e-12));
+        }
+    }
+}
+
+TEST_CASE("Testing ModelPriorProbabilities with hyperpriors",
+        "[ModelPriorProbabilities]") {
+
+    SECTION("Testing closed forms for two elements") {
+        // With an exponential(1) concentration, p(1 subset) = E[1/(1 + a)],
+        // which is the Euler-Gompertz constant
+        ModelPriorProbabilities dpp(2, EcoevolityOptions::ModelPrior::dpp,
+                HyperpriorQuadrature(ExponentialDistribution(1.0)));
+        REQUIRE(dpp.get_number_of_categories_probability(1) ==
+                Approx(0.596347362323194).epsilon(1e-12));
+        REQUIRE(dpp.get_shared_probability(2) ==
+                Approx(0.596347362323194).epsilon(1e-12));
+
+        // With a fixed concentration, p(1 subset) = E[1 - d] / (1 + a)
+        ModelPriorProbabilities pyp(2, EcoevolityOptions::ModelPrior::pyp,
+                HyperpriorQuadrature(1.5),
+                HyperpriorQuadrature(BetaDistribution(2.0, 3.0)));
+        REQUIRE(pyp.get_number_of_categories_probability(1) ==
+                Approx(0.6 / 2.5).epsilon(1e-12));
+
+        // Under the uniform prior, p(1 subset) = E[1 / (1 + w)]
+        ModelPriorProbabilities uniform(2, EcoevolityOptions::ModelPrior::uniform,
+                HyperpriorQuadrature(ExponentialDistribution(1.0)));
+        REQUIRE(uniform.get_number_of_categories_probability(1) ==
+                Approx(0.596347362323194).epsilon(1e-12));
+    }
+
+    SECTION("Testing against simulations") {
+        const unsigned int n = 8;
+        const unsigned int nreps = 200000;
+        GammaDistribution concentration_prior(2.0, 1.0);
+        BetaDistribution discount_prior(1.0, 2.0);
+        ModelPriorProbabilities pyp(n, EcoevolityOptions::ModelPrior::pyp,
+                HyperpriorQuadrature(concentration_prior),
+                HyperpriorQuadrature(discount_prior));
+        RandomNumberGenerator rng(1234);
+        std::vector<unsigned int> model(n, 0);
+        std::vector<unsigned int> counts(n + 1, 0);
+        unsigned int shared_count = 0;
+        for (unsigned int i = 0; i < nreps; ++i) {
+            double concentration = concentration_prior.draw(rng);
+            double discount = discount_prior.draw(rng);
+            ++counts.at(rng.pitman_yor_process(model, concentration, discount));
+            if ((model.at(0) == model.at(1)) && (model.at(1) == model.at(2))) {
+                ++shared_count;
+            }
+        }
+        for (unsigned int k = 1; k <= n; ++k) {
+            REQUIRE(pyp.get_number_of_categories_probability(k) ==
+                    Approx(counts.at(k) / (double)nreps).epsilon(0.005).scale(1.0));
+        }
+        REQUIRE(pyp.get_shared_probability(3) ==
+                Approx(shared_count / (double)nreps).epsilon(0.005).scale(1.0));
+    }
+
+    SECTION("Testing many elements") {
+        const unsigned int n = 200;
+        ModelPriorProbabilities dpp(n, EcoevolityOptions::ModelPrior::dpp,
+                HyperpriorQuadrature(3.0));
+        ModelPriorProbabilities uniform(n, EcoevolityOptions::ModelPrior::uniform,
+                HyperpriorQuadrature(GammaDistribution(1.0, 1.0)));
+        double dpp_sum = 0.0;
+        double uniform_sum = 0.0;
+        for (unsigned int k = 1; k <= n; ++k) {
+            dpp_sum += dpp.get_number_of_categories_probability(k);
+            uniform_sum += uniform.get_number_of_categories_probability(k);
+        }
+        REQUIRE(dpp_sum == Approx(1.0).epsilon(1e-10));
+        REQUIRE(uniform_sum == Approx(1.0).epsilon(1e-10));
+        REQUIRE(dpp.get_expected_number_of_categories() ==
+                Approx(get_dpp_expected_number_of_categories(3.0, n)).epsilon(1e-10));
+        std::vector<unsigned int> model(n, 0);
+        REQUIRE(std::isfinite(dpp.get_ln_model_probability(model)));
+        REQUIRE(std::isfinite(uniform.get_ln_model_probability(model)));
+    }
+}
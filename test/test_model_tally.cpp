@@ -0,0 +1,65 @@
+#include "catch.hpp"
+#include "ecoevolity/model_tally.hpp"
+#include "ecoevolity/rng.hpp"
+
+#include <map>
+
+
+TEST_CASE("Testing ModelTally", "[ModelTally]") {
+
+    SECTION("Testing small tally") {
+        ModelTally tally(3);
+        REQUIRE(tally.size() == 0);
+        REQUIRE(tally.get_total() == 0);
+        tally.add({0, 1, 0});
+        tally.add({0, 0, 0});
+        tally.add({0, 1, 0});
+        tally.add({0, 1, 2}, 5);
+        REQUIRE(tally.size() == 3);
+        REQUIRE(tally.get_total() == 8);
+        REQUIRE(tally.get_count({0, 1, 0}) == 2);
+        REQUIRE(tally.get_count({0, 0, 0}) == 1);
+        REQUIRE(tally.get_count({0, 1, 2}) == 5);
+        REQUIRE(tally.get_count({0, 0, 1}) == 0);
+
+        std::vector< std::pair<std::vector<unsigned int>, unsigned int> > expected = {
+                {{0, 0, 0}, 1},
+                {{0, 1, 0}, 2},
+                {{0, 1, 2}, 5}};
+        REQUIRE(tally.get_model_count_pairs() == expected);
+
+        REQUIRE_THROWS_AS(tally.add({0, 1}), EcoevolityError &);
+        REQUIRE_THROWS_AS(tally.get_count({0, 1, 0, 0}), EcoevolityError &);
+    }
+
+    SECTION("Testing against map") {
+        RandomNumberGenerator rng(123);
+        const unsigned int n = 12;
+        ModelTally tally1(n);
+        ModelTally tally2(n);
+        std::map<std::vector<unsigned int>, unsigned int> expected;
+        std::vector<unsigned int> model(n, 0);
+        for (unsigned int i = 0; i < 50000; ++i) {
+            rng.dirichlet_process(model, 1.5);
+            ++expected[model];
+            if (i % 3 == 0) {
+                tally1.add(model);
+            }
+            else {
+                tally2.add(model);
+            }
+        }
+        tally1.merge(tally2);
+        REQUIRE(tally1.get_total() == 50000);
+        REQUIRE(tally1.size() == expected.size());
+        std::vector< std::pair<std::vector<unsigned int>, unsigned int> > expected_pairs(
+                expected.begin(), expected.end());
+        REQUIRE(tally1.get_model_count_pairs() == expected_pairs);
+        for (auto const & kv : expected) {
+            REQUIRE(tally1.get_count(kv.first) == kv.second);
+        }
+
+        ModelTally other_size(n + 1);
+        REQUIRE_THROWS_AS(tally1.merge(other_size), EcoevolityError &);
+    }
+}
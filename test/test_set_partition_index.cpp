@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "ecoevolity/set_partition_index.hpp"
+#include "ecoevolity/rng.hpp"
+
+#include <set>
+
+TEST_CASE("Testing SetPartitionIndex enumeration", "[SetPartitionIndex]") {
+
+    SECTION("Testing every key of small sets") {
+        std::vector<std::uint64_t> bell_numbers = {1, 2, 5, 15, 52, 203, 877, 4140};
+        for (unsigned int n = 1; n <= bell_numbers.size(); ++n) {
+            SetPartitionIndex index(n);
+            REQUIRE(index.is_indexable());
+            REQUIRE(index.get_number_of_elements() == n);
+            REQUIRE(index.get_number_of_partitions() == bell_numbers.at(n - 1));
+            std::set< std::vector<unsigned int> > models;
+            std::vector<unsigned int> previous_model;
+            for (std::uint64_t key = 0; key < index.get_number_of_partitions(); ++key) {
+                std::vector<unsigned int> model = index.get_model(key);
+                REQUIRE(model.size() == n);
+                // Restricted growth string
+                unsigned int nsubsets = 0;
+                for (auto subset : model) {
+                    REQUIRE(subset <= nsubsets);
+                    if (subset == nsubsets) {
+                        ++nsubsets;
+                    }
+                }
+                // Keys follow lexicographic order
+                if (key > 0) {
+                    REQUIRE(previous_model < model);
+                }
+                previous_model = model;
+                REQUIRE(index.get_key(model) == key);
+                models.insert(model);
+            }
+            REQUIRE(models.size() == bell_numbers.at(n - 1));
+        }
+    }
+
+    SECTION("Testing first and last keys") {
+        SetPartitionIndex index(4);
+        REQUIRE(index.get_key({0, 0, 0, 0}) == 0);
+        REQUIRE(index.get_key({0, 0, 0, 1}) == 1);
+        REQUIRE(index.get_key({0, 1, 2, 3}) == 14);
+        REQUIRE(index.get_model(14) == std::vector<unsigned int>({0, 1, 2, 3}));
+    }
+}
+
+TEST_CASE("Testing SetPartitionIndex limits", "[SetPartitionIndex]") {
+
+    SECTION("Testing largest indexable set") {
+        SetPartitionIndex index(25);
+        REQUIRE(index.is_indexable());
+        REQUIRE(index.get_number_of_partitions() == 4638590332229999353ULL);
+        std::vector<unsigned int> last(25);
+        for (unsigned int i = 0; i < 25; ++i) {
+            last.at(i) = i;
+        }
+        REQUIRE(index.get_key(std::vector<unsigned int>(25, 0)) == 0);
+        REQUIRE(index.get_key(last) == 4638590332229999352ULL);
+        REQUIRE(index.get_model(4638590332229999352ULL) == last);
+
+        RandomNumberGenerator rng(123);
+        std::vector<unsigned int> model(25, 0);
+        for (unsigned int i = 0; i < 1000; ++i) {
+            rng.dirichlet_process(model, 3.0);
+            REQUIRE(index.get_model(index.get_key(model)) == model);
+        }
+    }
+
+    SECTION("Testing set too large for 64-bit keys") {
+        SetPartitionIndex index(26);
+        REQUIRE(! index.is_indexable());
+        REQUIRE_THROWS_AS(index.get_number_of_partitions(), EcoevolityError &);
+        REQUIRE_THROWS_AS(index.get_key(std::vector<unsigned int>(26, 0)),
+                EcoevolityError &);
+    }
+
+    SECTION("Testing bad models") {
+        SetPartitionIndex index(4);
+        REQUIRE_THROWS_AS(index.get_key({1, 0, 0, 0}), EcoevolityError &);
+        REQUIRE_THROWS_AS(index.get_key({0, 2, 1, 0}), EcoevolityError &);
+        REQUIRE_THROWS_AS(index.get_key({0, 0, 0}), EcoevolityError &);
+        REQUIRE_THROWS_AS(index.get_model(15), EcoevolityError &);
+        REQUIRE_THROWS_AS(SetPartitionIndex(0), EcoevolityError &);
+    }
+}
@@ -0,0 +1,150 @@
+#include "catch.hpp"
+#include "ecoevolity/sim_archive.hpp"
+#include "ecoevolity/data.hpp"
+#include "ecoevolity/settings.hpp"
+#include "ecoevolity/rng.hpp"
+
+RandomNumberGenerator _SIM_ARCHIVE_RNG = RandomNumberGenerator();
+
+
+TEST_CASE("Testing archive member paths", "[SimulationArchive]") {
+
+    SECTION("Testing parsing member paths") {
+        std::string tag = _SIM_ARCHIVE_RNG.random_string(10);
+        std::string archive_path = "data/tmp-" + tag + ".simarchive";
+        {
+            SimulationArchiveWriter writer(archive_path);
+        }
+        REQUIRE(path::isfile(archive_path));
+
+        std::string a;
+        unsigned int r;
+        std::string m;
+        REQUIRE(sim_archive::parse_member_path(archive_path + "#12/config.yml", a, r, m));
+        REQUIRE(a == archive_path);
+        REQUIRE(r == 12);
+        REQUIRE(m == "config.yml");
+        REQUIRE(sim_archive::get_member_path(archive_path, 12, "config.yml") ==
+                archive_path + "#12/config.yml");
+
+        REQUIRE(sim_archive::is_member_path(archive_path + "#0/config.yml"));
+        REQUIRE(! sim_archive::is_member_path(archive_path));
+        REQUIRE(! sim_archive::is_member_path(archive_path + "#0/"));
+        REQUIRE(! sim_archive::is_member_path(archive_path + "#/config.yml"));
+        REQUIRE(! sim_archive::is_member_path(archive_path + "#x1/config.yml"));
+        REQUIRE(! sim_archive::is_member_path(archive_path + "-missing#0/config.yml"));
+        REQUIRE(! sim_archive::is_member_path("data/hemi129.nex"));
+    }
+}
+
+TEST_CASE("Testing archive writing and reading", "[SimulationArchive]") {
+
+    SECTION("Testing round trip") {
+        std::string tag = _SIM_ARCHIVE_RNG.random_string(10);
+        std::string archive_path = "data/tmp-" + tag + ".simarchive";
+        unsigned int nreps = 12;
+        {
+            SimulationArchiveWriter writer(archive_path);
+            for (unsigned int i = 0; i < nreps; ++i) {
+                std::vector< std::pair<std::string, std::string> > members;
+                members.push_back(std::make_pair("config.yml",
+                            "config " + std::to_string(i) + "\n"));
+                members.push_back(std::make_pair("empty.txt", ""));
+                members.push_back(std::make_pair("data.txt",
+                            std::string(i * 1000, 'a' + (i % 26))));
+                writer.add_replicate(members);
+            }
+            REQUIRE(writer.get_number_of_replicates() == nreps);
+            writer.close();
+        }
+
+        SimulationArchiveReader reader(archive_path);
+        REQUIRE(reader.get_number_of_replicates() == nreps);
+        // Read out of order to make sure reads do not depend on each other
+        for (unsigned int j = 0; j < nreps; ++j) {
+            unsigned int i = (j * 5) % nreps;
+            REQUIRE(reader.read_member(i, "data.txt") ==
+                    std::string(i * 1000, 'a' + (i % 26)));
+            REQUIRE(reader.read_member(i, "config.yml") ==
+                    "config " + std::to_string(i) + "\n");
+            REQUIRE(reader.read_member(i, "empty.txt") == "");
+            std::vector< std::pair<std::string, unsigned long long> > members =
+                    reader.get_members(i);
+            REQUIRE(members.size() == 3);
+            REQUIRE(members.at(2).first == "data.txt");
+            REQUIRE(members.at(2).second == i * 1000);
+        }
+        REQUIRE(sim_archive::read_member(archive_path + "#3/config.yml") == "config 3\n");
+
+        REQUIRE_THROWS_AS(reader.read_member(nreps, "config.yml"),
+                EcoevolitySimulationArchiveError &);
+        REQUIRE_THROWS_AS(reader.read_member(0, "missing.txt"),
+                EcoevolitySimulationArchiveError &);
+    }
+
+    SECTION("Testing bad archives") {
+        std::string tag = _SIM_ARCHIVE_RNG.random_string(10);
+        std::string bad_path = "data/tmp-" + tag + "-bad.simarchive";
+        std::ofstream out(bad_path);
+        out << "not an archive\n";
+        out.close();
+        REQUIRE_THROWS_AS(SimulationArchiveReader reader(bad_path),
+                EcoevolitySimulationArchiveError &);
+        REQUIRE_THROWS_AS(SimulationArchiveReader reader("data/tmp-" + tag + "-missing"),
+                EcoevolitySimulationArchiveError &);
+
+        std::string truncated_path = "data/tmp-" + tag + "-truncated.simarchive";
+        out.open(truncated_path);
+        out << sim_archive::MAGIC << "1\n3\tx.txt\nabc";
+        out.close();
+        REQUIRE_THROWS_AS(SimulationArchiveReader reader(truncated_path),
+                EcoevolitySimulationArchiveError &);
+    }
+}
+
+TEST_CASE("Testing reading data and configs from archive", "[SimulationArchive]") {
+
+    SECTION("Testing archived YAML data and config") {
+        std::string tag = _SIM_ARCHIVE_RNG.random_string(10);
+        std::string archive_path = "data/tmp-" + tag + ".simarchive";
+
+        BiallelicData file_data;
+        file_data.init_from_yaml_path("data/diploid-dna-constant-missing.yml");
+        std::ostringstream data_stream;
+        file_data.write_yaml(data_stream);
+
+        std::ostringstream config_stream;
+        config_stream << "comparisons:\n";
+        config_stream << "- comparison:\n";
+        config_stream << "    path: alignment.yml\n";
+        {
+            SimulationArchiveWriter writer(archive_path);
+            writer.add_replicate({
+                    std::make_pair("config.yml", ""),
+                    std::make_pair("alignment.yml", "")});
+            writer.add_replicate({
+                    std::make_pair("config.yml", config_stream.str()),
+                    std::make_pair("alignment.yml", data_stream.str())});
+        }
+
+        BiallelicData archived_data;
+        archived_data.init_from_yaml_path(archive_path + "#1/alignment.yml");
+        REQUIRE(archived_data.get_number_of_patterns() == file_data.get_number_of_patterns());
+        REQUIRE(archived_data.get_number_of_sites() == file_data.get_number_of_sites());
+        REQUIRE(archived_data.get_population_labels() == file_data.get_population_labels());
+        for (unsigned int i = 0; i < file_data.get_number_of_patterns(); ++i) {
+            REQUIRE(archived_data.get_pattern_weight(i) == file_data.get_pattern_weight(i));
+            REQUIRE(archived_data.get_allele_counts(i) == file_data.get_allele_counts(i));
+            REQUIRE(archived_data.get_red_allele_counts(i) == file_data.get_red_allele_counts(i));
+        }
+
+        CollectionSettings settings(archive_path + "#1/config.yml");
+        REQUIRE(settings.get_number_of_comparisons() == 1);
+        REQUIRE(settings.get_comparison_setting(0).get_path() ==
+                archive_path + "#1/alignment.yml");
+        REQUIRE(settings.get_state_log_path() ==
+                "data/tmp-" + tag + "-1-config-state-run-1.log");
+        REQUIRE(settings.get_operator_log_path() ==
+                "data/tmp-" + tag + "-1-config-operator-run-1.log");
+    }
+}
@@ -4763,3 +4763,515 @@ TEST_CASE("Testing yaml io with dominant markers", "[SimcoevolityCLI]") {
         delete[] e_yml_cfg_path;
     }
 }
+
+TEST_CASE("Testing simcoevolity output does not depend on number of threads",
+        "[SimcoevolityCLI]") {
+
+    SECTION("Testing 1 versus 3 threads") {
+        std::string tag = _SIMCOEVOLITY_CLI_RNG.random_string(10);
+        std::string test_path = "data/tmp-config-" + tag + "-nthreads.cfg";
+        std::ofstream os;
+        os.open(test_path);
+        os << "event_time_prior:\n";
+        os << "    gamma_distribution:\n";
+        os << "        shape: 10.0\n";
+        os << "        scale: 0.001\n";
+        os << "event_model_prior:\n";
+        os << "    dirichlet_process:\n";
+        os << "        parameters:\n";
+        os << "            concentration:\n";
+        os << "                estimate: true\n";
+        os << "                prior:\n";
+        os << "                    gamma_distribution:\n";
+        os << "                        shape: 5.0\n";
+        os << "                        scale: 0.2\n";
+        os << "comparisons:\n";
+        os << "- comparison:\n";
+        os << "    path: hemi129.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 10.0\n";
+        os << "                    scale: 0.0001\n";
+        os << "        freq_1:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                beta_distribution:\n";
+        os << "                    alpha: 2.0\n";
+        os << "                    beta: 1.0\n";
+        os << "- comparison:\n";
+        os << "    path: hemi129-altname1.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 2.0\n";
+        os << "                    scale: 0.001\n";
+        os << "        mutation_rate:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 100.0\n";
+        os << "                    scale: 0.01\n";
+        os.close();
+        REQUIRE(path::exists(test_path));
+
+        unsigned int nreps = 7;
+        std::vector<std::string> nthreads_strs = {"1", "3"};
+        for (auto const & nthreads_str : nthreads_strs) {
+            std::string prefix = "tmp-" + tag + "-t" + nthreads_str + "-";
+            std::vector<std::string> args = {
+                "simcoevolity",
+                "--seed", "52938",
+                "-n", std::to_string(nreps),
+                "--prefix", prefix,
+#ifdef BUILD_WITH_THREADS
+                "--nthreads", nthreads_str,
+#endif
+                test_path
+            };
+            std::vector<char *> argv;
+            for (auto & a : args) {
+                argv.push_back(&a[0]);
+            }
+            argv.push_back(NULL);
+            int argc = (int)argv.size() - 1;
+            int ret = simcoevolity_main<CollectionSettings, ComparisonPopulationTreeCollection>(argc, argv.data());
+            REQUIRE(ret == 0);
+        }
+
+        auto read_file = [](const std::string & file_path) {
+            std::ifstream in(file_path);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        };
+        std::vector<std::string> suffixes = {
+            "true-values.txt",
+            "config.yml",
+            "hemi129.nex",
+            "hemi129-altname1.nex"
+        };
+        for (unsigned int i = 0; i < nreps; ++i) {
+            std::string rep_str = string_util::pad_int(i, 1);
+            for (auto const & suffix : suffixes) {
+                std::string path1 = "data/tmp-" + tag + "-t1-simcoevolity-sim-" + rep_str + "-" + suffix;
+                std::string path3 = "data/tmp-" + tag + "-t3-simcoevolity-sim-" + rep_str + "-" + suffix;
+                REQUIRE(path::exists(path1));
+                REQUIRE(path::exists(path3));
+                std::string contents1 = read_file(path1);
+                if (suffix == "config.yml") {
+                    // The configs point to their own alignments
+                    std::string t3 = "tmp-" + tag + "-t3-";
+                    std::string t1 = "tmp-" + tag + "-t1-";
+                    std::string contents3 = read_file(path3);
+                    std::size_t pos;
+                    while ((pos = contents3.find(t3)) != std::string::npos) {
+                        contents3.replace(pos, t3.size(), t1);
+                    }
+                    REQUIRE(contents1 == contents3);
+                }
+                else {
+                    REQUIRE(contents1 == read_file(path3));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Testing simcoevolity calibration", "[SimcoevolityCLI]") {
+
+    SECTION("Testing in-memory simulation-based calibration") {
+        std::string tag = _SIMCOEVOLITY_CLI_RNG.random_string(10);
+        std::string test_path = "data/tmp-config-" + tag + "-calibrate.cfg";
+        std::ofstream os;
+        os.open(test_path);
+        os << "event_time_prior:\n";
+        os << "    gamma_distribution:\n";
+        os << "        shape: 10.0\n";
+        os << "        scale: 0.001\n";
+        os << "event_model_prior:\n";
+        os << "    dirichlet_process:\n";
+        os << "        parameters:\n";
+        os << "            concentration:\n";
+        os << "                estimate: true\n";
+        os << "                prior:\n";
+        os << "                    gamma_distribution:\n";
+        os << "                        shape: 5.0\n";
+        os << "                        scale: 0.2\n";
+        os << "mcmc_settings:\n";
+        os << "    chain_length: 100\n";
+        os << "    sample_frequency: 10\n";
+        os << "global_comparison_settings:\n";
+        os << "    genotypes_are_diploid: false\n";
+        os << "    markers_are_dominant: false\n";
+        os << "    population_name_delimiter: \" \"\n";
+        os << "    population_name_is_prefix: true\n";
+        os << "    constant_sites_removed: false\n";
+        os << "comparisons:\n";
+        os << "- comparison:\n";
+        os << "    path: haploid-standard.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 10.0\n";
+        os << "                    scale: 0.0001\n";
+        os << "        freq_1:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                beta_distribution:\n";
+        os << "                    alpha: 2.0\n";
+        os << "                    beta: 1.0\n";
+        os << "- comparison:\n";
+        os << "    path: haploid-standard-altname1.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 2.0\n";
+        os << "                    scale: 0.001\n";
+        os << "        mutation_rate:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 100.0\n";
+        os << "                    scale: 0.01\n";
+        os.close();
+        REQUIRE(path::exists(test_path));
+
+        unsigned int nreps = 5;
+        std::string prefix = "tmp-" + tag + "-";
+        std::vector<std::string> args = {
+            "simcoevolity",
+            "--seed", "1234",
+            "-n", std::to_string(nreps),
+            "--prefix", prefix,
+            "--calibrate",
+            "--calibration-burnin", "1",
+#ifdef BUILD_WITH_THREADS
+            "--nthreads", "2",
+#endif
+            test_path
+        };
+        std::vector<char *> argv;
+        for (auto & a : args) {
+            argv.push_back(&a[0]);
+        }
+        argv.push_back(NULL);
+        int argc = (int)argv.size() - 1;
+        int ret = simcoevolity_main<CollectionSettings, ComparisonPopulationTreeCollection>(argc, argv.data());
+        REQUIRE(ret == 0);
+
+        // Nothing is written for the individual replicates
+        REQUIRE(! path::exists("data/" + prefix + "simcoevolity-sim-0-config.yml"));
+        REQUIRE(! path::exists("data/" + prefix + "simcoevolity-sim-0-true-values.txt"));
+        REQUIRE(! path::exists("data/" + prefix + "simcoevolity-model-used-for-sims.yml"));
+
+        std::string ranks_path = "data/" + prefix + "simcoevolity-calibration-ranks.txt";
+        std::string coverage_path = "data/" + prefix + "simcoevolity-calibration-coverage.txt";
+        REQUIRE(path::exists(ranks_path));
+        REQUIRE(path::exists(coverage_path));
+
+        std::vector<std::string> parameters = {
+            "number_of_events",
+            "concentration",
+            "root_height_pop1",
+            "freq_1_pop1",
+            "pop_size_pop1",
+            "pop_size_pop2",
+            "pop_size_root_pop1",
+            "root_height_pop3",
+            "mutation_rate_pop3",
+            "pop_size_pop3",
+            "pop_size_pop4",
+            "pop_size_root_pop3",
+        };
+
+        spreadsheet::Spreadsheet ranks;
+        ranks.update(ranks_path);
+        REQUIRE(ranks.get_keys().at(0) == "replicate");
+        REQUIRE(ranks.get_keys().at(1) == "number_of_samples");
+        REQUIRE(! ranks.has_key("generation"));
+        REQUIRE(! ranks.has_key("ln_likelihood"));
+        REQUIRE(! ranks.has_key("ln_likelihood_pop1"));
+        REQUIRE(! ranks.has_key("root_height_index_pop1"));
+        std::vector<unsigned int> reps = ranks.get<unsigned int>("replicate");
+        REQUIRE(reps.size() == nreps);
+        for (unsigned int i = 0; i < nreps; ++i) {
+            REQUIRE(reps.at(i) == i);
+        }
+        // 11 samples (including the initial state) minus 1 for burn in
+        std::vector<unsigned int> nsamples = ranks.get<unsigned int>("number_of_samples");
+        for (auto n : nsamples) {
+            REQUIRE(n == 10);
+        }
+        for (auto const & p : parameters) {
+            REQUIRE(ranks.has_key(p));
+            std::vector<unsigned int> r = ranks.get<unsigned int>(p);
+            REQUIRE(r.size() == nreps);
+            for (auto x : r) {
+                REQUIRE(x <= 10);
+            }
+        }
+
+        spreadsheet::Spreadsheet coverage;
+        coverage.update(coverage_path);
+        std::vector<std::string> coverage_parameters = coverage.get<std::string>("parameter");
+        REQUIRE(coverage_parameters.size() == ranks.get_keys().size() - 2);
+        for (auto const & p : parameters) {
+            REQUIRE(std::find(coverage_parameters.begin(),
+                        coverage_parameters.end(), p) != coverage_parameters.end());
+        }
+        for (auto n : coverage.get<unsigned int>("number_of_replicates")) {
+            REQUIRE(n == nreps);
+        }
+        for (auto const & k : {"mean_normalized_rank", "hpd_95_coverage", "eti_95_coverage"}) {
+            for (auto x : coverage.get<double>(k)) {
+                REQUIRE(x >= 0.0);
+                REQUIRE(x <= 1.0);
+            }
+        }
+    }
+}
+
+TEST_CASE("Testing simcoevolity archive", "[SimcoevolityCLI]") {
+
+    SECTION("Testing archive matches files and can be analyzed") {
+        std::string tag = _SIMCOEVOLITY_CLI_RNG.random_string(10);
+        std::string test_path = "data/tmp-config-" + tag + "-archive.cfg";
+        std::ofstream os;
+        os.open(test_path);
+        os << "event_time_prior:\n";
+        os << "    gamma_distribution:\n";
+        os << "        shape: 10.0\n";
+        os << "        scale: 0.001\n";
+        os << "mcmc_settings:\n";
+        os << "    chain_length: 10\n";
+        os << "    sample_frequency: 5\n";
+        os << "global_comparison_settings:\n";
+        os << "    genotypes_are_diploid: false\n";
+        os << "    markers_are_dominant: false\n";
+        os << "    population_name_delimiter: \" \"\n";
+        os << "    population_name_is_prefix: true\n";
+        os << "    constant_sites_removed: false\n";
+        os << "comparisons:\n";
+        os << "- comparison:\n";
+        os << "    path: haploid-standard.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 10.0\n";
+        os << "                    scale: 0.0001\n";
+        os << "- comparison:\n";
+        os << "    path: haploid-standard-altname1.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 2.0\n";
+        os << "                    scale: 0.001\n";
+        os.close();
+        REQUIRE(path::exists(test_path));
+
+        unsigned int nreps = 5;
+        std::vector<std::string> modes = {"files", "archive"};
+        for (auto const & mode : modes) {
+            std::string prefix = "tmp-" + tag + "-" + mode + "-";
+            std::vector<std::string> args = {
+                "simcoevolity",
+                "--seed", "3247",
+                "-n", std::to_string(nreps),
+                "--prefix", prefix,
+#ifdef BUILD_WITH_THREADS
+                "--nthreads", "2",
+#endif
+            };
+            if (mode == "archive") {
+                args.push_back("--archive");
+            }
+            args.push_back(test_path);
+            std::vector<char *> argv;
+            for (auto & a : args) {
+                argv.push_back(&a[0]);
+            }
+            argv.push_back(NULL);
+            int argc = (int)argv.size() - 1;
+            int ret = simcoevolity_main<CollectionSettings, ComparisonPopulationTreeCollection>(argc, argv.data());
+            REQUIRE(ret == 0);
+        }
+
+        std::string file_prefix = "data/tmp-" + tag + "-files-simcoevolity-";
+        std::string archive_prefix = "data/tmp-" + tag + "-archive-simcoevolity-";
+        std::string archive_path = archive_prefix + "sims.simarchive";
+        REQUIRE(path::isfile(archive_path));
+        REQUIRE(path::isfile(archive_prefix + "model-used-for-sims.yml"));
+        REQUIRE(! path::exists(archive_prefix + "sim-0-config.yml"));
+        REQUIRE(! path::exists(archive_prefix + "sim-0-true-values.txt"));
+
+        auto read_file = [](const std::string & file_path) {
+            std::ifstream in(file_path);
+            std::stringstream ss;
+            ss << in.rdbuf();
+            return ss.str();
+        };
+
+        SimulationArchiveReader reader(archive_path);
+        REQUIRE(reader.get_number_of_replicates() == nreps);
+        std::vector<std::string> suffixes = {
+            "true-values.txt",
+            "haploid-standard.nex",
+            "haploid-standard-altname1.nex"
+        };
+        for (unsigned int i = 0; i < nreps; ++i) {
+            std::string rep_str = string_util::pad_int(i, 1);
+            for (auto const & suffix : suffixes) {
+                REQUIRE(reader.read_member(i, suffix) ==
+                        read_file(file_prefix + "sim-" + rep_str + "-" + suffix));
+            }
+            // The archived configs point to the alignments by member name
+            std::string config = read_file(file_prefix + "sim-" + rep_str + "-config.yml");
+            std::string file_rep_prefix = "tmp-" + tag + "-files-simcoevolity-sim-" + rep_str + "-";
+            std::size_t pos;
+            while ((pos = config.find(file_rep_prefix)) != std::string::npos) {
+                config.erase(pos, file_rep_prefix.size());
+            }
+            REQUIRE(reader.read_member(i, "config.yml") == config);
+        }
+
+        std::string archived_config = sim_archive::get_member_path(
+                archive_path, 2, "config.yml");
+        std::vector<std::string> args = {
+            "ecoevolity",
+            "--seed", "1234",
+            "--ignore-data",
+            archived_config
+        };
+        std::vector<char *> argv;
+        for (auto & a : args) {
+            argv.push_back(&a[0]);
+        }
+        argv.push_back(NULL);
+        int argc = (int)argv.size() - 1;
+        int ret = ecoevolity_main<CollectionSettings, ComparisonPopulationTreeCollection>(argc, argv.data());
+        REQUIRE(ret == 0);
+        REQUIRE(path::isfile("data/tmp-" + tag + "-archive-simcoevolity-sims-2-config-state-run-1.log"));
+    }
+}
+
+TEST_CASE("Testing simcoevolity parameters-only output does not depend on number of threads",
+        "[SimcoevolityCLI]") {
+
+    SECTION("Testing 1 versus 3 threads") {
+        std::string tag = _SIMCOEVOLITY_CLI_RNG.random_string(10);
+        std::string test_path = "data/tmp-config-" + tag + "-params-nthreads.cfg";
+        std::ofstream os;
+        os.open(test_path);
+        os << "event_time_prior:\n";
+        os << "    gamma_distribution:\n";
+        os << "        shape: 10.0\n";
+        os << "        scale: 0.001\n";
+        os << "event_model_prior:\n";
+        os << "    dirichlet_process:\n";
+        os << "        parameters:\n";
+        os << "            concentration:\n";
+        os << "                estimate: true\n";
+        os << "                prior:\n";
+        os << "                    gamma_distribution:\n";
+        os << "                        shape: 5.0\n";
+        os << "                        scale: 0.2\n";
+        os << "global_comparison_settings:\n";
+        os << "    genotypes_are_diploid: false\n";
+        os << "    markers_are_dominant: false\n";
+        os << "    population_name_delimiter: \" \"\n";
+        os << "    population_name_is_prefix: true\n";
+        os << "    constant_sites_removed: false\n";
+        os << "comparisons:\n";
+        os << "- comparison:\n";
+        os << "    path: haploid-standard.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 10.0\n";
+        os << "                    scale: 0.0001\n";
+        os << "        freq_1:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                beta_distribution:\n";
+        os << "                    alpha: 2.0\n";
+        os << "                    beta: 1.0\n";
+        os << "- comparison:\n";
+        os << "    path: haploid-standard-altname1.nex\n";
+        os << "    parameters:\n";
+        os << "        population_size:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 2.0\n";
+        os << "                    scale: 0.001\n";
+        os << "        mutation_rate:\n";
+        os << "            estimate: true\n";
+        os << "            prior:\n";
+        os << "                gamma_distribution:\n";
+        os << "                    shape: 100.0\n";
+        os << "                    scale: 0.01\n";
+        os.close();
+        REQUIRE(path::exists(test_path));
+
+        // More than one block of draws
+        unsigned int nreps = 2345;
+        std::vector<std::string> nthreads_strs = {"1", "3"};
+        std::vector<std::string> outputs;
+        for (auto const & nthreads_str : nthreads_strs) {
+            std::vector<std::string> args = {
+                "simcoevolity",
+                "--seed", "7291",
+                "-n", std::to_string(nreps),
+                "--parameters-only",
+#ifdef BUILD_WITH_THREADS
+                "--nthreads", nthreads_str,
+#endif
+                test_path
+            };
+            std::vector<char *> argv;
+            for (auto & a : args) {
+                argv.push_back(&a[0]);
+            }
+            argv.push_back(NULL);
+            int argc = (int)argv.size() - 1;
+
+            std::ostringstream captured;
+            std::streambuf * cout_buffer = std::cout.rdbuf(captured.rdbuf());
+            int ret = simcoevolity_main<CollectionSettings, ComparisonPopulationTreeCollection>(argc, argv.data());
+            std::cout.rdbuf(cout_buffer);
+            REQUIRE(ret == 0);
+            outputs.push_back(captured.str());
+        }
+        REQUIRE(outputs.at(0) == outputs.at(1));
+
+        std::istringstream in(outputs.at(0));
+        spreadsheet::Spreadsheet prior_sample;
+        prior_sample.update(in);
+        std::vector<unsigned int> generations = prior_sample.get<unsigned int>("generation");
+        REQUIRE(generations.size() == nreps);
+        for (unsigned int i = 0; i < nreps; ++i) {
+            REQUIRE(generations.at(i) == i + 1);
+        }
+        std::vector<double> pop_sizes = prior_sample.get<double>("pop_size_root_pop1");
+        SampleSummarizer<double> pop_size_summary;
+        for (auto x : pop_sizes) {
+            pop_size_summary.add_sample(x);
+        }
+        REQUIRE(pop_size_summary.mean() == Approx(10.0 * 0.0001).epsilon(0.05));
+    }
+}
@@ -0,0 +1,140 @@
+#include "catch.hpp"
+#include "ecoevolity/site_pattern_index.hpp"
+#include "ecoevolity/rng.hpp"
+
+
+TEST_CASE("Testing default constructor of SitePatternIndex", "[SitePatternIndex]") {
+
+    SECTION("Testing empty index") {
+        SitePatternIndex s;
+        REQUIRE(s.size() == 0);
+        REQUIRE(s.empty());
+        REQUIRE(s.get_bits_per_index() == 1);
+        REQUIRE(s.get_number_of_bytes() == 0);
+        REQUIRE(s.begin() == s.end());
+        REQUIRE_THROWS_AS(s.at(0), std::out_of_range &);
+    }
+}
+
+TEST_CASE("Testing sized constructor of SitePatternIndex", "[SitePatternIndex]") {
+
+    SECTION("Testing zeros") {
+        SitePatternIndex s(100);
+        REQUIRE(s.size() == 100);
+        REQUIRE(! s.empty());
+        REQUIRE(s.get_bits_per_index() == 1);
+        REQUIRE(s.get_number_of_bytes() == 16);
+        for (unsigned int i = 0; i < 100; ++i) {
+            REQUIRE(s.at(i) == 0);
+        }
+        REQUIRE_THROWS_AS(s.at(100), std::out_of_range &);
+    }
+
+    SECTION("Testing fill value") {
+        SitePatternIndex s(100, 5);
+        REQUIRE(s.size() == 100);
+        REQUIRE(s.get_bits_per_index() == 3);
+        for (auto idx : s) {
+            REQUIRE(idx == 5);
+        }
+    }
+}
+
+TEST_CASE("Testing push_back of SitePatternIndex", "[SitePatternIndex]") {
+
+    SECTION("Testing width grows with indices") {
+        SitePatternIndex s;
+        s.push_back(0);
+        s.push_back(1);
+        REQUIRE(s.get_bits_per_index() == 1);
+        s.push_back(2);
+        REQUIRE(s.get_bits_per_index() == 2);
+        s.push_back(1000);
+        REQUIRE(s.get_bits_per_index() == 10);
+        s.push_back(3);
+        REQUIRE(s.size() == 5);
+        std::vector<unsigned int> expected = {0, 1, 2, 1000, 3};
+        REQUIRE(s.to_vector() == expected);
+    }
+
+    SECTION("Testing indices that span words") {
+        RandomNumberGenerator rng(123);
+        std::vector<unsigned int> expected;
+        SitePatternIndex s;
+        for (unsigned int i = 0; i < 5000; ++i) {
+            unsigned int max_index = (i < 2500) ? 6 : 70000;
+            unsigned int idx = rng.uniform_int(0, max_index);
+            expected.push_back(idx);
+            s.push_back(idx);
+        }
+        REQUIRE(s.size() == 5000);
+        REQUIRE(s.get_bits_per_index() == 17);
+        REQUIRE(s.to_vector() == expected);
+        for (unsigned int i = 0; i < expected.size(); ++i) {
+            REQUIRE(s.at(i) == expected.at(i));
+            REQUIRE(s[i] == expected.at(i));
+        }
+    }
+}
+
+TEST_CASE("Testing set of SitePatternIndex", "[SitePatternIndex]") {
+
+    SECTION("Testing set widens and keeps neighbors") {
+        SitePatternIndex s(70, 1);
+        s.set(63, 7);
+        s.set(64, 300);
+        REQUIRE(s.get_bits_per_index() == 9);
+        for (unsigned int i = 0; i < 70; ++i) {
+            if (i == 63) {
+                REQUIRE(s.at(i) == 7);
+            }
+            else if (i == 64) {
+                REQUIRE(s.at(i) == 300);
+            }
+            else {
+                REQUIRE(s.at(i) == 1);
+            }
+        }
+        REQUIRE_THROWS_AS(s.set(70, 1), std::out_of_range &);
+    }
+}
+
+TEST_CASE("Testing remap of SitePatternIndex", "[SitePatternIndex]") {
+
+    SECTION("Testing remap narrows width") {
+        SitePatternIndex s;
+        std::vector<unsigned int> indices = {0, 500, 3, 500, 0, 3};
+        for (auto idx : indices) {
+            s.push_back(idx);
+        }
+        REQUIRE(s.get_bits_per_index() == 9);
+        std::vector<unsigned int> new_indices(501, 0);
+        new_indices.at(3) = 1;
+        new_indices.at(500) = 2;
+        s.remap(new_indices);
+        REQUIRE(s.get_bits_per_index() == 2);
+        std::vector<unsigned int> expected = {0, 2, 1, 2, 0, 1};
+        REQUIRE(s.to_vector() == expected);
+    }
+}
+
+TEST_CASE("Testing comparison of SitePatternIndex", "[SitePatternIndex]") {
+
+    SECTION("Testing equality ignores width") {
+        SitePatternIndex s1;
+        SitePatternIndex s2;
+        s1.push_back(1);
+        s1.push_back(2);
+        s2.push_back(100);
+        s2.push_back(2);
+        REQUIRE(s1 != s2);
+        s2.set(0, 1);
+        REQUIRE(s1.get_bits_per_index() != s2.get_bits_per_index());
+        REQUIRE(s1 == s2);
+        s2.push_back(0);
+        REQUIRE(s1 != s2);
+        s1.clear();
+        REQUIRE(s1.size() == 0);
+        REQUIRE(s1.get_bits_per_index() == 1);
+    }
+}
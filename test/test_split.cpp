@@ -728,3 +728,60 @@ TEST_CASE("Testing trees with different shared orders" , "[split]") {
         REQUIRE(tree_order_1.get_splits_by_height_index() != tree_order_2.get_splits_by_height_index());
     }
 }
+
+TEST_CASE("Testing split hashes", "[split]") {
+    SECTION("Testing hashes of splits, split sets, and topologies") {
+        std::vector<Split> all_splits;
+        for (unsigned int nleaves : {5, 64, 65, 130}) {
+            for (unsigned int i = 0; i < nleaves; ++i) {
+                Split s;
+                s.resize(nleaves);
+                s.set_leaf_bit(i);
+                Split s_copy(s);
+                REQUIRE(s.get_hash() == s_copy.get_hash());
+                all_splits.push_back(s);
+                Split s2;
+                s2.resize(nleaves);
+                s2.set_leaf_bit(i);
+                s2.set_leaf_bit((i + 1) % nleaves);
+                all_splits.push_back(s2);
+            }
+        }
+        std::vector<SplitHash> hashes;
+        for (auto & s : all_splits) {
+            SplitHash h = s.get_hash();
+            REQUIRE(Split::get_hash(s) == h);
+            for (auto & other : hashes) {
+                REQUIRE(h != other);
+            }
+            hashes.push_back(h);
+        }
+
+        Split a, b, c, d;
+        a.resize(4); b.resize(4); c.resize(4); d.resize(4);
+        a.set_leaf_bit(0);
+        b.set_leaf_bit(1);
+        c.set_leaf_bit(2);
+        d.set_leaf_bit(3);
+        std::set<Split> ab = {a, b};
+        std::set<Split> ba = {b, a};
+        std::set<Split> cd = {c, d};
+        std::set<Split> ac = {a, c};
+        std::set<Split> bd = {b, d};
+        std::set<Split> just_a = {a};
+        REQUIRE(Split::get_hash(ab) == Split::get_hash(ba));
+        REQUIRE(Split::get_hash(ab) != Split::get_hash(cd));
+        REQUIRE(Split::get_hash(ab) != Split::get_hash(ac));
+        REQUIRE(Split::get_hash(just_a) != a.get_hash());
+        REQUIRE(Split::get_hash(just_a) != Split::get_hash(ab));
+
+        std::set< std::set<Split> > topo1 = {ab, cd};
+        std::set< std::set<Split> > topo1_again = {cd, ba};
+        std::set< std::set<Split> > topo2 = {ac, bd};
+        std::set< std::set<Split> > topo3 = {ab};
+        REQUIRE(Split::get_hash(topo1) == Split::get_hash(topo1_again));
+        REQUIRE(Split::get_hash(topo1) != Split::get_hash(topo2));
+        REQUIRE(Split::get_hash(topo1) != Split::get_hash(topo3));
+        REQUIRE(Split::get_hash(topo3) != Split::get_hash(ab));
+    }
+}
@@ -911,3 +911,256 @@ TEST_CASE("Testing spreadsheet.summarize", "[spreadsheet]") {
         REQUIRE(summarizer4.excess_kurtosis() == Approx(-1.2167832167832167));
     }
 }
+
+TEST_CASE("Testing parse_integer and parse_real", "[spreadsheet]") {
+
+    SECTION("Testing integers") {
+        std::vector<std::string> cells = {"0", "7", "-12", "+3",
+                "9223372036854775807", "-9223372036854775808"};
+        std::vector<long long> expected = {0, 7, -12, 3,
+                std::numeric_limits<long long>::max(),
+                std::numeric_limits<long long>::min()};
+        long long v;
+        for (unsigned int i = 0; i < cells.size(); ++i) {
+            const std::string& c = cells.at(i);
+            REQUIRE(spreadsheet::parse_integer(c.data(), c.data() + c.size(), v));
+            REQUIRE(v == expected.at(i));
+        }
+        std::vector<std::string> bad_cells = {"", "-", "1.0", "a1", "1 ",
+                "9223372036854775808"};
+        for (auto const & c : bad_cells) {
+            REQUIRE(! spreadsheet::parse_integer(c.data(), c.data() + c.size(), v));
+        }
+    }
+
+    SECTION("Testing reals against strtod") {
+        std::vector<std::string> cells = {"0", "0.0", "-0.0", "1", "-1.5",
+                "0.1", "3.14159265358979", "1e-5", "-2.5E+10", ".5", "5.",
+                "123456789012345678901234567890", "1e300", "4.9e-324",
+                "0.000000000000000000000000000123", "1.7976931348623157e308",
+                "2.2250738585072014e-308", "0.30000000000000004",
+                "9007199254740993", "inf", "-inf"};
+        double v;
+        for (auto const & c : cells) {
+            REQUIRE(spreadsheet::parse_real(c.data(), c.data() + c.size(), v));
+            REQUIRE(v == std::strtod(c.c_str(), nullptr));
+            REQUIRE(std::signbit(v) == std::signbit(std::strtod(c.c_str(), nullptr)));
+        }
+        std::string nan_cell = "nan";
+        REQUIRE(spreadsheet::parse_real(nan_cell.data(), nan_cell.data() + 3, v));
+        REQUIRE(std::isnan(v));
+
+        std::vector<std::string> bad_cells = {"", "-", ".", "e5", "1e",
+                "1.0.0", "1.0x", " 1.0", "abc"};
+        for (auto const & c : bad_cells) {
+            REQUIRE(! spreadsheet::parse_real(c.data(), c.data() + c.size(), v));
+        }
+    }
+
+    SECTION("Testing random reals against strtod") {
+        RandomNumberGenerator rng(123);
+        double v;
+        for (unsigned int i = 0; i < 10000; ++i) {
+            std::ostringstream s;
+            s.precision(rng.uniform_int(1, 17));
+            s << (rng.uniform_real() - 0.5) * std::pow(10.0, rng.uniform_int(-30, 30));
+            std::string c = s.str();
+            REQUIRE(spreadsheet::parse_real(c.data(), c.data() + c.size(), v));
+            REQUIRE(v == std::strtod(c.c_str(), nullptr));
+        }
+    }
+}
+
+TEST_CASE("Testing ColumnarSpreadsheet", "[spreadsheet]") {
+    std::string test_path1 = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+    std::string test_path2 = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+    std::string test_path3 = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+    std::ofstream os;
+    os.open(test_path1);
+    os << "gen\tlabel\tx\n";
+    for (unsigned int i = 0; i < 10; ++i) {
+        os << i << "\ta" << i << "\t" << i + 0.5 << "\n";
+    }
+    os.close();
+    os.open(test_path2);
+    os << "gen\tlabel\tx\r\n";
+    for (unsigned int i = 10; i < 20; ++i) {
+        os << i << "\tb" << i << "\t" << i + 0.5 << "\r\n";
+    }
+    os.close();
+    os.open(test_path3);
+    os << "gen\tlabel\tx\n";
+    for (unsigned int i = 20; i < 30; ++i) {
+        os << i << "\tc" << i << "\t" << i + 0.5;
+        if (i < 29) {
+            os << "\n";
+        }
+    }
+    os.close();
+    std::vector<std::string> paths = {test_path1, test_path2, test_path3};
+    std::vector<std::string> expected_header = {"gen", "label", "x"};
+
+    SECTION("Testing single file") {
+        spreadsheet::ColumnarSpreadsheet ss;
+        ss.add_column<int>("gen");
+        ss.add_column<double>("x");
+        ss.update(test_path1);
+
+        REQUIRE(ss.get_keys() == expected_header);
+        REQUIRE(ss.has_key("label"));
+        REQUIRE(! ss.has_column("label"));
+        REQUIRE(ss.get_number_of_rows() == 10);
+        std::vector<int> expected_gen = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        std::vector<double> expected_x = {0.5, 1.5, 2.5, 3.5, 4.5, 5.5, 6.5, 7.5, 8.5, 9.5};
+        REQUIRE(ss.get<int>("gen") == expected_gen);
+        REQUIRE(ss.get<double>("x") == expected_x);
+        REQUIRE(ss.get_real_column("x") == expected_x);
+        REQUIRE(ss.get<double>("gen").at(9) == 9.0);
+        REQUIRE_THROWS_AS(ss.get<int>("x"), EcoevolitySpreadsheetError &);
+        REQUIRE_THROWS_AS(ss.get<double>("label"), EcoevolitySpreadsheetError &);
+        REQUIRE_THROWS_AS(ss.add_column<double>("label"), EcoevolitySpreadsheetError &);
+
+        SampleSummarizer<double> summarizer = ss.summarize<double>("x");
+        REQUIRE(summarizer.sample_size() == 10);
+        REQUIRE(summarizer.mean() == Approx(5.0));
+    }
+
+    SECTION("Testing multiple files with offset") {
+        for (unsigned int nthreads = 1; nthreads < 5; ++nthreads) {
+            spreadsheet::ColumnarSpreadsheet ss;
+            ss.add_column<unsigned int>("gen");
+            ss.add_column<double>("x");
+            ss.update(paths, 2, '\t', nthreads);
+
+            REQUIRE(ss.get_number_of_rows() == 24);
+            std::vector<unsigned int> gen = ss.get<unsigned int>("gen");
+            std::vector<double> x = ss.get<double>("x");
+            unsigned int j = 0;
+            for (unsigned int i = 0; i < 30; ++i) {
+                if ((i % 10) < 2) {
+                    continue;
+                }
+                REQUIRE(gen.at(j) == i);
+                REQUIRE(x.at(j) == i + 0.5);
+                ++j;
+            }
+        }
+    }
+
+    SECTION("Testing matches Spreadsheet") {
+        std::vector<std::string> lf_paths = {test_path1, test_path3};
+        spreadsheet::Spreadsheet expected;
+        expected.update(lf_paths, 3);
+        spreadsheet::ColumnarSpreadsheet ss;
+        ss.add_column<long>("gen");
+        ss.add_column<double>("x");
+        ss.update(lf_paths, 3);
+        REQUIRE(ss.get<long>("gen") == expected.get<long>("gen"));
+        REQUIRE(ss.get<double>("x") == expected.get<double>("x"));
+    }
+
+    SECTION("Testing stream and repeated updates") {
+        std::stringstream stream;
+        stream << "gen\tlabel\tx\n";
+        stream << "-3\tz\t1e-3\n";
+        spreadsheet::ColumnarSpreadsheet ss;
+        ss.add_column<int>("gen");
+        ss.update(stream);
+        ss.update(test_path1, 8);
+        std::vector<int> expected_gen = {-3, 8, 9};
+        REQUIRE(ss.get<int>("gen") == expected_gen);
+        REQUIRE_THROWS_AS(ss.get<unsigned int>("gen"), EcoevolitySpreadsheetError &);
+    }
+
+    SECTION("Testing errors") {
+        std::string bad_path = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+        os.open(bad_path);
+        os << "gen\tlabel\tx\n";
+        os << "0\ta\t1.0\n";
+        os << "1\tb\n";
+        os.close();
+        std::string bad_value_path = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+        os.open(bad_value_path);
+        os << "gen\tlabel\tx\n";
+        os << "0\ta\tone\n";
+        os.close();
+        std::string other_header_path = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+        os.open(other_header_path);
+        os << "gen\tlabel\ty\n";
+        os.close();
+        std::string empty_path = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+        os.open(empty_path);
+        os.close();
+
+        spreadsheet::ColumnarSpreadsheet ss1;
+        ss1.add_column<double>("x");
+        REQUIRE_THROWS_AS(ss1.update(bad_path), EcoevolityParsingError &);
+
+        spreadsheet::ColumnarSpreadsheet ss2;
+        ss2.add_column<double>("x");
+        REQUIRE_THROWS_AS(ss2.update(bad_value_path), EcoevolityParsingError &);
+
+        spreadsheet::ColumnarSpreadsheet ss3;
+        ss3.add_column<double>("x");
+        std::vector<std::string> mixed_paths = {test_path1, other_header_path};
+        REQUIRE_THROWS_AS(ss3.update(mixed_paths, 0, '\t', 2), EcoevolityParsingError &);
+
+        spreadsheet::ColumnarSpreadsheet ss4;
+        ss4.add_column<double>("y");
+        REQUIRE_THROWS_AS(ss4.update(test_path1), EcoevolitySpreadsheetError &);
+
+        spreadsheet::ColumnarSpreadsheet ss5;
+        REQUIRE_THROWS_AS(ss5.update(empty_path), EcoevolityParsingError &);
+        std::stringstream empty_stream;
+        REQUIRE_THROWS_AS(ss5.update(empty_stream), EcoevolityParsingError &);
+    }
+}
+
+TEST_CASE("Testing ColumnarReader", "[spreadsheet]") {
+    std::string test_path = "data/tmp-" + _TEST_SPREADSHEET_RNG.random_string(10) + ".txt";
+    std::ofstream os;
+    os.open(test_path);
+    os << "gen\tlabel\tx\tn\n";
+    for (unsigned int i = 0; i < 20; ++i) {
+        os << i * 10 << "\ta" << i << "\t" << i / 4.0 << "\t" << i % 3 << "\n";
+    }
+    os.close();
+
+    SECTION("Testing rows match ColumnarSpreadsheet") {
+        spreadsheet::ColumnarSpreadsheet ss;
+        ss.add_column<int>("n");
+        ss.add_column<int>("gen");
+        ss.add_column<double>("x");
+        ss.update(test_path, 5);
+
+        spreadsheet::ColumnarReader reader({"n", "gen"}, {"x"});
+        std::vector<int> n;
+        std::vector<int> gen;
+        std::vector<double> x;
+        auto handler = [&](const std::vector<long long>& integers,
+                const std::vector<double>& reals) {
+            REQUIRE(integers.size() == 2);
+            REQUIRE(reals.size() == 1);
+            n.push_back(integers.at(0));
+            gen.push_back(integers.at(1));
+            x.push_back(reals.at(0));
+        };
+        REQUIRE(reader.read(test_path, handler, 5) == 15);
+        REQUIRE(n == ss.get<int>("n"));
+        REQUIRE(gen == ss.get<int>("gen"));
+        REQUIRE(x == ss.get<double>("x"));
+
+        std::ifstream in_stream(test_path);
+        n.clear();
+        REQUIRE(reader.read(in_stream, handler, 19) == 1);
+        REQUIRE(n.at(0) == 19 % 3);
+    }
+
+    SECTION("Testing missing column") {
+        spreadsheet::ColumnarReader reader({"y"}, {});
+        auto handler = [](const std::vector<long long>&,
+                const std::vector<double>&) { };
+        REQUIRE_THROWS_AS(reader.read(test_path, handler),
+                EcoevolitySpreadsheetError &);
+    }
+}
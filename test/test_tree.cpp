@@ -7968,9 +7968,11 @@ TEST_CASE("Testing dataset simulation", "[ComparisonPopulationTree]") {
         REQUIRE(data.markers_are_dominant() == false);
         REQUIRE(tree.get_data().markers_are_dominant() == false);
 
+        // This is a single dataset of 1217 sites; the standard deviation of
+        // the proportion of 1s across simulated datasets is about 0.012
         data.get_empirical_u_v_rates(u, v);
-        REQUIRE(u == Approx(0.8).epsilon(0.01));
-        REQUIRE(data.get_proportion_1() == Approx(0.625).epsilon(0.01));
+        REQUIRE(u == Approx(0.8).epsilon(0.03));
+        REQUIRE(data.get_proportion_1() == Approx(0.625).epsilon(0.03));
 
         std::string io_nex_path = "data/tmp-data-test1.nex";
         std::ofstream out;
@@ -7992,8 +7994,8 @@ TEST_CASE("Testing dataset simulation", "[ComparisonPopulationTree]") {
         REQUIRE(io_data.markers_are_dominant() == false);
 
         io_data.get_empirical_u_v_rates(u, v);
-        REQUIRE(u == Approx(0.8).epsilon(0.01));
-        REQUIRE(io_data.get_proportion_1() == Approx(0.625).epsilon(0.01));
+        REQUIRE(u == Approx(0.8).epsilon(0.03));
+        REQUIRE(io_data.get_proportion_1() == Approx(0.625).epsilon(0.03));
     }
 }
 
@@ -8272,7 +8274,10 @@ TEST_CASE("Testing linked dataset simulation", "[ComparisonPopulationTree]") {
             io_u_sum += u;
             io_prop_sum += data.get_proportion_1();
         }
-        REQUIRE(u_sum / nreps == Approx(0.8).epsilon(0.01));
+        // u is a reciprocal of the proportion of 1s, so its mean across
+        // these small (20 site, 4 locus) datasets is biased upward (about
+        // 0.82)
+        REQUIRE(u_sum / nreps == Approx(0.8).epsilon(0.05));
         REQUIRE(prop_sum / nreps == Approx(0.625).epsilon(0.01));
         REQUIRE(io_u_sum == Approx(u_sum));
         REQUIRE(io_prop_sum == Approx(prop_sum));
@@ -12288,8 +12293,10 @@ TEST_CASE("Testing ComparisonDirichletPopulationTree dataset simulation",
         REQUIRE(tree.get_data().markers_are_dominant() == false);
 
         data.get_empirical_u_v_rates(u, v);
-        REQUIRE(u == Approx(0.8).epsilon(0.01));
-        REQUIRE(data.get_proportion_1() == Approx(0.625).epsilon(0.01));
+        // This is a single dataset of 1217 sites; the standard deviation of
+        // the proportion of 1s across simulated datasets is about 0.012
+        REQUIRE(u == Approx(0.8).epsilon(0.03));
+        REQUIRE(data.get_proportion_1() == Approx(0.625).epsilon(0.03));
     }
 }
 
@@ -15331,8 +15338,10 @@ TEST_CASE("Testing ComparisonRelativeRootPopulationTree dataset simulation", "[C
         REQUIRE(tree.get_data().markers_are_dominant() == false);
 
         data.get_empirical_u_v_rates(u, v);
-        REQUIRE(u == Approx(0.8).epsilon(0.01));
-        REQUIRE(data.get_proportion_1() == Approx(0.625).epsilon(0.01));
+        // This is a single dataset of 1217 sites; the standard deviation of
+        // the proportion of 1s across simulated datasets is about 0.012
+        REQUIRE(u == Approx(0.8).epsilon(0.03));
+        REQUIRE(data.get_proportion_1() == Approx(0.625).epsilon(0.03));
     }
 }
 
@@ -17105,3 +17114,137 @@ TEST_CASE("Testing BaseTree::store_splits_heights_parameters()", "[BaseTree]") {
         REQUIRE(ns_heights == heights);
     }
 }
+
+TEST_CASE("Testing BasePopulationTree::copy_state_for_simulation()", "[PopulationTree]") {
+
+    SECTION("Testing copied state is independent of original") {
+        std::shared_ptr<PopulationNode> internal = std::make_shared<PopulationNode>(3, "internal 0", 0.05);
+        std::shared_ptr<PopulationNode> root = std::make_shared<PopulationNode>(4, "root", 0.1);
+        std::shared_ptr<PopulationNode> leaf0 = std::make_shared<PopulationNode>(0, "leaf 0", 0.0, 4);
+        leaf0->fix_node_height();
+        std::shared_ptr<PopulationNode> leaf1 = std::make_shared<PopulationNode>(1, "leaf 1", 0.0, 4);
+        leaf1->fix_node_height();
+        std::shared_ptr<PopulationNode> leaf2 = std::make_shared<PopulationNode>(2, "leaf 2", 0.0, 4);
+        leaf2->fix_node_height();
+        internal->add_child(leaf0);
+        internal->add_child(leaf1);
+        root->add_child(internal);
+        root->add_child(leaf2);
+
+        PopulationTree tree(root,
+                50,    // number of loci
+                20,    // length of loci
+                true); // validate data
+        tree.set_all_population_sizes(0.005);
+        tree.set_freq_1(0.3);
+
+        std::ostringstream expected;
+        RandomNumberGenerator rng = RandomNumberGenerator(1234);
+        tree.simulate_complete_biallelic_data_set(rng, 20, 1.0, true).first.write_yaml(expected);
+
+        BasePopulationTree sim_tree(tree);
+        sim_tree.copy_state_for_simulation(tree);
+
+        tree.set_all_population_sizes(0.05);
+        tree.set_freq_1(0.6);
+        tree.set_root_height(0.3);
+
+        REQUIRE(sim_tree.get_freq_1() == 0.3);
+        REQUIRE(sim_tree.get_root_height() == 0.1);
+        REQUIRE(sim_tree.get_root().get_population_size() == 0.005);
+
+        std::ostringstream simulated;
+        RandomNumberGenerator rng2 = RandomNumberGenerator(1234);
+        sim_tree.simulate_complete_biallelic_data_set(rng2, 20, 1.0, true).first.write_yaml(simulated);
+        REQUIRE(simulated.str() == expected.str());
+    }
+}
+
+TEST_CASE("Testing red allele count pattern indexing", "[PopulationTree]") {
+
+    SECTION("Testing mixed-radix patterns") {
+        std::vector<unsigned int> allele_counts = {2, 3, 1};
+        REQUIRE(BasePopulationTree::get_number_of_red_allele_count_patterns(allele_counts) == 24);
+        std::vector<unsigned int> red_allele_counts;
+        BasePopulationTree::get_red_allele_count_pattern(0, allele_counts, red_allele_counts);
+        std::vector<unsigned int> expected = {0, 0, 0};
+        REQUIRE(red_allele_counts == expected);
+        BasePopulationTree::get_red_allele_count_pattern(5, allele_counts, red_allele_counts);
+        expected = {2, 1, 0};
+        REQUIRE(red_allele_counts == expected);
+        BasePopulationTree::get_red_allele_count_pattern(23, allele_counts, red_allele_counts);
+        REQUIRE(red_allele_counts == allele_counts);
+
+        std::vector<unsigned int> big_counts(40, 100);
+        REQUIRE(BasePopulationTree::get_number_of_red_allele_count_patterns(big_counts) == 0);
+    }
+}
+
+TEST_CASE("Testing unlinked simulation from pattern probabilities", "[PopulationTree]") {
+
+    SECTION("Testing pattern probabilities match likelihoods and simulated frequencies") {
+        std::shared_ptr<PopulationNode> root = std::make_shared<PopulationNode>(4, "root", 0.02);
+        std::shared_ptr<PopulationNode> internal = std::make_shared<PopulationNode>(3, "internal 0", 0.01);
+        std::shared_ptr<PopulationNode> leaf0 = std::make_shared<PopulationNode>(0, "leaf 0", 0.0, 3);
+        leaf0->fix_node_height();
+        std::shared_ptr<PopulationNode> leaf1 = std::make_shared<PopulationNode>(1, "leaf 1", 0.0, 2);
+        leaf1->fix_node_height();
+        std::shared_ptr<PopulationNode> leaf2 = std::make_shared<PopulationNode>(2, "leaf 2", 0.0, 4);
+        leaf2->fix_node_height();
+        internal->add_child(leaf0);
+        internal->add_child(leaf1);
+        root->add_child(internal);
+        root->add_child(leaf2);
+
+        unsigned int nsites = 50000;
+        PopulationTree tree(root,
+                nsites, // number of loci
+                1,      // length of loci
+                true);  // validate data
+        tree.set_all_population_sizes(0.004);
+        tree.estimate_mutation_rate();
+        tree.set_mutation_rate(2.0);
+        tree.set_freq_1(0.3);
+
+        std::vector<unsigned int> allele_counts = {3, 2, 4};
+        std::vector<double> probs = tree.compute_red_allele_count_pattern_probabilities(
+                allele_counts);
+        REQUIRE(probs.size() == 60);
+        double sum = 0.0;
+        for (auto p : probs) {
+            sum += p;
+        }
+        REQUIRE(sum == Approx(1.0));
+
+        std::vector<unsigned int> red_allele_counts;
+        BasePopulationTree::get_red_allele_count_pattern(17, allele_counts,
+                red_allele_counts);
+        double l = compute_pattern_likelihood(tree.get_mutable_root(),
+                red_allele_counts,
+                allele_counts,
+                tree.get_u(),
+                tree.get_v(),
+                tree.get_mutation_rate(),
+                tree.get_ploidy(),
+                false);
+        REQUIRE(probs.at(17) == Approx(l));
+
+        RandomNumberGenerator rng = RandomNumberGenerator(2468);
+        BiallelicData data = tree.simulate_biallelic_data_set(rng, 1.0, false);
+        REQUIRE(data.get_number_of_sites() == nsites);
+
+        std::vector<double> freqs(probs.size(), 0.0);
+        for (unsigned int pattern_idx = 0;
+                pattern_idx < data.get_number_of_patterns();
+                ++pattern_idx) {
+            REQUIRE(data.get_allele_counts(pattern_idx) == allele_counts);
+            const std::vector<unsigned int> & reds = data.get_red_allele_counts(pattern_idx);
+            unsigned int idx = reds.at(0) + (4 * reds.at(1)) + (12 * reds.at(2));
+            freqs.at(idx) += data.get_pattern_weight(pattern_idx) / (double)nsites;
+        }
+        for (unsigned int i = 0; i < probs.size(); ++i) {
+            double sd = std::sqrt(probs.at(i) * (1.0 - probs.at(i)) / nsites);
+            REQUIRE(std::abs(freqs.at(i) - probs.at(i)) < ((5.0 * sd) + 1e-9));
+        }
+    }
+}
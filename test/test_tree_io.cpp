@@ -641,3 +641,140 @@ TEST_CASE("Testing BasePopulationTree with 3 leaves", "[treeio]") {
         REQUIRE(splits == expected_splits);
     }
 }
+
+TEST_CASE("Testing NexusTreeStream", "[treeio]") {
+    SECTION("Testing trees match those parsed by NCL") {
+        std::vector<std::string> newick_tree_strs {
+            "((spa[&height=0.0,pop_size=1.0]:0.1,spb[&height=0.0,pop_size=2.0]:0.1)[&height=0.1,height_index=0,pop_size=3.0]:0.2,spc[&height=0.0,pop_size=4.0]:0.3)[&height=0.3,height_index=1,pop_size=5.0]:0.0",
+            "(spc[&height=0.0,pop_size=4.0]:0.3,(spb[&height=0.0,pop_size=1.0]:0.1,spa[&height=0.0,pop_size=2.0]:0.1)[&height=0.1,height_index=0,pop_size=3.0]:0.2)[&height=0.3,height_index=1,pop_size=5.0]",
+            "((spa:0.1,spe:0.1):0.2,(spb:0.1,spd:0.1):0.2,spc:0.3)",
+            "((spa[&height=0,pop_size=1]:0.1,spe[&height=0,pop_size=1]:0.1)[&height_index=0,height=0.1,pop_size=1]:0.2,(spb[&height=0,pop_size=1]:0.1,spd[&height=0,pop_size=1]:0.1)[&height_index=0,height=0.1,pop_size=1]:0.2,spc[&height=0,pop_size=1]:0.3)[&height_index=1,height=0.3,pop_size=1]:0.0",
+        };
+        std::vector<std::vector<std::string> > taxa {
+            {"spa", "spb", "spc"},
+            {"spa", "spb", "spc"},
+            {"spa", "spb", "spc", "spd", "spe"},
+            {"spa", "spb", "spc", "spd", "spe"},
+        };
+        for (unsigned int i = 0; i < newick_tree_strs.size(); ++i) {
+            std::ostringstream nexus;
+            nexus << "#NEXUS\nBEGIN TAXA;\n    DIMENSIONS NTAX="
+                  << taxa.at(i).size() << ";\n    TAXLABELS\n";
+            for (auto label : taxa.at(i)) {
+                nexus << "        " << label << "\n";
+            }
+            nexus << "    ;\nEND;\n\nBEGIN TREES;\n"
+                  << "    TREE gen0 = [&R] " << newick_tree_strs.at(i) << ";\n"
+                  << "    TREE gen1 = [&R] " << newick_tree_strs.at(i) << ";\n"
+                  << "END;\n";
+            std::istringstream nexus_stream(nexus.str());
+            NexusTreeStream tree_stream(nexus_stream);
+            REQUIRE(tree_stream.get_taxon_labels() == taxa.at(i));
+            NewickTree newick_tree;
+            REQUIRE(tree_stream.next_tree(newick_tree));
+            REQUIRE(newick_tree.get_name() == "gen0");
+            REQUIRE(newick_tree.get_number_of_leaves() == taxa.at(i).size());
+            REQUIRE(newick_tree.is_ultrametric());
+
+            BaseTree<PopulationNode> tree(newick_tree, 1e-6);
+            BaseTree<PopulationNode> expected_tree(newick_tree_strs.at(i) + ";");
+            REQUIRE(tree.to_parentheses(true) == expected_tree.to_parentheses(true));
+            REQUIRE(tree.get_node_heights() == expected_tree.get_node_heights());
+
+            REQUIRE(tree_stream.next_tree(newick_tree));
+            REQUIRE(newick_tree.get_name() == "gen1");
+            REQUIRE(! tree_stream.next_tree(newick_tree));
+            REQUIRE(newick_tree.get_name() == "gen1");
+            REQUIRE(tree_stream.get_number_of_trees_read() == 2);
+        }
+    }
+
+    SECTION("Testing translations, quoted labels, skipping and missing END") {
+        std::string nexus =
+            "#NEXUS\n"
+            "[A comment with a ; in it]\n"
+            "BEGIN TAXA;\n"
+            "    DIMENSIONS NTAX=3;\n"
+            "    TAXLABELS sp_a 'sp b' spc;\n"
+            "END;\n"
+            "BEGIN ASSUMPTIONS;\n"
+            "    OPTIONS DEFTYPE=unord;\n"
+            "END;\n"
+            "BEGIN TREES;\n"
+            "    TRANSLATE 1 'sp a', 2 sp_b, 3 spc;\n"
+            "    TREE skipped = [&R] ((1:1,2:1)'x;y':1,3:2);\n"
+            "    TREE * kept = [&R] ((3[&pop_size=2]:1,'sp b':1)[&pop_size=3]:1.0e0,1:2)[&pop_size=4];\n"
+            "    TREE last = [&R] ((1:1,3:1):1,2:2);\n";
+        std::istringstream nexus_stream(nexus);
+        NexusTreeStream tree_stream(nexus_stream);
+        std::vector<std::string> expected_labels {"sp a", "sp b", "spc"};
+        REQUIRE(tree_stream.get_taxon_labels() == expected_labels);
+        REQUIRE(tree_stream.skip_tree());
+        NewickTree newick_tree;
+        REQUIRE(tree_stream.next_tree(newick_tree));
+        REQUIRE(newick_tree.get_name() == "kept");
+        REQUIRE(newick_tree.get_number_of_nodes() == 5);
+        REQUIRE(newick_tree.get_root().children.size() == 2);
+        REQUIRE(newick_tree.get_root().comments ==
+                std::vector<std::string>({"&pop_size=4"}));
+        REQUIRE(newick_tree.get_node(1).edge_length == 1.0);
+        REQUIRE(newick_tree.get_node(1).comments ==
+                std::vector<std::string>({"&pop_size=3"}));
+        REQUIRE(newick_tree.get_node(2).label == "spc");
+        REQUIRE(newick_tree.get_node(2).parent == 1);
+        REQUIRE(newick_tree.get_node(3).label == "sp b");
+        REQUIRE(newick_tree.get_node(4).label == "sp a");
+        REQUIRE(newick_tree.get_node(4).edge_length == 2.0);
+
+        BaseTree<PopulationNode> tree(newick_tree, 1e-6);
+        REQUIRE(tree.get_leaf_node_count() == 3);
+        REQUIRE(tree.get_root_ptr()->get_population_size() == 4.0);
+        REQUIRE(tree.get_height(tree.get_number_of_node_heights() - 1) == 2.0);
+
+        REQUIRE(tree_stream.next_tree(newick_tree));
+        REQUIRE(newick_tree.get_name() == "last");
+        REQUIRE(! tree_stream.next_tree(newick_tree));
+        REQUIRE(tree_stream.get_number_of_trees_read() == 3);
+    }
+
+    SECTION("Testing errors") {
+        std::string header =
+            "#NEXUS\n"
+            "BEGIN TAXA;\n"
+            "    DIMENSIONS NTAX=3;\n"
+            "    TAXLABELS a b c;\n"
+            "END;\n"
+            "BEGIN TREES;\n";
+        std::vector<std::string> bad_trees {
+            "    TREE t = ((a:1,b:1):1,d:2);\n",
+            "    TREE t = ((a:1,b:1):1,a:2);\n",
+            "    TREE t = ((a:1,b:1):1,c:2;\n",
+            "    TREE t = ((a:1,b:1):1,c:x);\n",
+            "    TREE t = ((a:1,b:1):1,c:2)",
+        };
+        for (auto bad_tree : bad_trees) {
+            std::istringstream nexus_stream(header + bad_tree);
+            NexusTreeStream tree_stream(nexus_stream);
+            NewickTree newick_tree;
+            REQUIRE_THROWS_AS(tree_stream.next_tree(newick_tree),
+                    EcoevolityParsingError &);
+        }
+
+        std::istringstream nexus_stream(header +
+                "    TREE t = ((a:1,b:1):1,c:1.5);\n" +
+                "END;\nBEGIN TREES;\nEND;\n");
+        NexusTreeStream tree_stream(nexus_stream);
+        NewickTree newick_tree;
+        REQUIRE(tree_stream.next_tree(newick_tree));
+        REQUIRE(! newick_tree.is_ultrametric());
+        REQUIRE_THROWS_AS((BaseTree<PopulationNode>(newick_tree, 1e-6)),
+                EcoevolityError &);
+        REQUIRE_THROWS_AS(tree_stream.next_tree(newick_tree),
+                EcoevolityParsingError &);
+
+        std::istringstream no_trees_stream("#NEXUS\nBEGIN TAXA;\n"
+                "    DIMENSIONS NTAX=1;\n    TAXLABELS a;\nEND;\n");
+        REQUIRE_THROWS_AS((NexusTreeStream(no_trees_stream)),
+                EcoevolityParsingError &);
+    }
+}
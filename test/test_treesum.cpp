@@ -1719,3 +1719,144 @@ TEST_CASE("Basic merged target heights summary", "[treesum]") {
         REQUIRE(sum_w_merged["merged_target_heights"][6]["older_height"].as<double>() == 0.2);
     }
 }
+
+TEST_CASE("Testing TreeSample with multiple threads", "[treesum]") {
+    SECTION("Testing TreeSample with multiple threads") {
+        std::vector<std::string> source_tree_paths {
+                "data/4-tip-trees-12-34.nex",
+                "data/4-tip-trees-12.nex",
+                "data/4-tip-trees-13-24.nex",
+                "data/4-tip-trees-14-23-shared.nex",
+                "data/4-tip-trees-34.nex",
+                "data/4-tip-trees-ladder-1234.nex",
+                "data/4-tip-trees-ladder-4321.nex"
+        };
+        treesum::TreeSample<PopulationNode> ts(source_tree_paths,
+                "nexus", 1, 1e-6, -1.0, 1);
+        treesum::TreeSample<PopulationNode> threaded_ts(source_tree_paths,
+                "nexus", 1, 1e-6, -1.0, 3);
+        REQUIRE(threaded_ts.get_sample_size() == ts.get_sample_size());
+        REQUIRE(threaded_ts.get_tree_lengths() == ts.get_tree_lengths());
+
+        std::stringstream expected;
+        ts.write_summary_of_splits(expected);
+        ts.write_summary_of_topologies(expected);
+        ts.write_summary_of_source_data(expected);
+        std::stringstream threaded;
+        threaded_ts.write_summary_of_splits(threaded);
+        threaded_ts.write_summary_of_topologies(threaded);
+        threaded_ts.write_summary_of_source_data(threaded);
+        REQUIRE(threaded.str() == expected.str());
+    }
+}
+
+TEST_CASE("Testing ConvergenceTable", "[treesum]") {
+    SECTION("Testing ConvergenceTable against TreeSample") {
+        std::vector<std::string> source_tree_paths {
+                "data/4-tip-trees-12-34.nex",
+                "data/4-tip-trees-13-24.nex",
+                "data/4-tip-trees-34.nex",
+                "data/4-tip-trees-ladder-1234.nex"
+        };
+        treesum::ConvergenceTable<PopulationNode> ct(source_tree_paths,
+                "nexus");
+        REQUIRE(ct.get_number_of_sources() == 4);
+        REQUIRE(ct.get_source_sample_size(0) == 4);
+        REQUIRE(ct.has_inter_chain_stats());
+
+        std::vector<treesum::ConvergenceTable<PopulationNode>::Row> rows =
+                ct.get_rows(1, 0.1, 0);
+        REQUIRE(rows.size() == 3);
+        for (unsigned int i = 0; i < rows.size(); ++i) {
+            treesum::TreeSample<PopulationNode> ts(source_tree_paths,
+                    "nexus",
+                    i);
+            REQUIRE(rows.at(i).burnin == i);
+            REQUIRE(rows.at(i).sample_size == ts.get_sample_size());
+            REQUIRE(rows.at(i).asdsf == Approx(
+                    ts.get_average_std_dev_of_split_freqs(0.1)));
+            REQUIRE(rows.at(i).psrf_tree_length == Approx(
+                    potential_scale_reduction_factor<double>(
+                        ts.get_tree_lengths_by_source())));
+            REQUIRE(rows.at(i).psrf_root_height == Approx(
+                    potential_scale_reduction_factor<double>(
+                        ts.get_root_parameter_values_by_source("height"))));
+            REQUIRE(rows.at(i).psrf_root_pop_size == Approx(
+                    potential_scale_reduction_factor<double>(
+                        ts.get_root_parameter_values_by_source("pop_size"))));
+            REQUIRE(rows.at(i).ess_tree_length == Approx(
+                    effective_sample_size<double>(ts.get_tree_lengths(), true)));
+            REQUIRE(rows.at(i).ess_root_height == Approx(
+                    effective_sample_size<double>(
+                        ts.get_root_parameter_values("height"), true)));
+            REQUIRE(rows.at(i).ess_root_pop_size == Approx(
+                    effective_sample_size<double>(
+                        ts.get_root_parameter_values("pop_size"), true)));
+        }
+
+        rows = ct.get_rows(1, 0.4, 0);
+        REQUIRE(rows.size() == 3);
+        for (unsigned int i = 0; i < rows.size(); ++i) {
+            treesum::TreeSample<PopulationNode> ts(source_tree_paths,
+                    "nexus",
+                    i);
+            REQUIRE(rows.at(i).asdsf == Approx(
+                    ts.get_average_std_dev_of_split_freqs(0.4)));
+        }
+
+        rows = ct.get_rows(2);
+        REQUIRE(rows.size() == 1);
+        REQUIRE(rows.at(0).burnin == 1);
+        REQUIRE(rows.at(0).sample_size == 12);
+
+        REQUIRE_THROWS_AS(ct.get_rows(0), EcoevolityError &);
+        REQUIRE_THROWS_AS(ct.get_rows(1, 0.1, 4), EcoevolityError &);
+    }
+
+    SECTION("Testing ConvergenceTable with unequal sample sizes") {
+        std::vector<std::string> source_tree_paths {
+                "data/4-tip-trees-12.nex",
+                "data/4-tip-trees-13-24.nex"
+        };
+        treesum::ConvergenceTable<PopulationNode> ct(source_tree_paths,
+                "nexus");
+        REQUIRE(ct.get_number_of_sources() == 2);
+        REQUIRE(! ct.has_inter_chain_stats());
+
+        std::vector<treesum::ConvergenceTable<PopulationNode>::Row> rows =
+                ct.get_rows(1, 0.1, 0);
+        REQUIRE(rows.size() == 3);
+        for (unsigned int i = 0; i < rows.size(); ++i) {
+            treesum::TreeSample<PopulationNode> ts(source_tree_paths,
+                    "nexus",
+                    i);
+            REQUIRE(rows.at(i).sample_size == ts.get_sample_size());
+            REQUIRE(std::isnan(rows.at(i).asdsf));
+            REQUIRE(std::isnan(rows.at(i).psrf_tree_length));
+            REQUIRE(rows.at(i).ess_tree_length == Approx(
+                    effective_sample_size<double>(ts.get_tree_lengths(), true)));
+            REQUIRE(rows.at(i).ess_root_height == Approx(
+                    effective_sample_size<double>(
+                        ts.get_root_parameter_values("height"), true)));
+        }
+
+        std::stringstream ss;
+        ct.write(ss, 1);
+        std::string line;
+        std::getline(ss, line);
+        REQUIRE(line == "burnin\tsample_size\tess_tree_length\tess_root_height\tess_root_pop_size");
+        std::getline(ss, line);
+        REQUIRE(line.substr(0, 4) == "1\t7\t");
+    }
+
+    SECTION("Testing ConvergenceTable with mismatched tip labels") {
+        std::vector<std::string> source_tree_paths {
+                "data/4-tip-trees-12-34.nex",
+                "data/4-tip-trees-comb-alt-tip-label.nex"
+        };
+        REQUIRE_THROWS_AS(
+                (treesum::ConvergenceTable<PopulationNode>(source_tree_paths,
+                        "nexus")),
+                EcoevolityError &);
+    }
+}